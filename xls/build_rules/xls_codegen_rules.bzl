@@ -195,10 +195,19 @@ def xls_ir_verilog_impl(ctx, src):
         "flop_outputs",
         "flop_outputs_kind",
         "flop_single_value_channels",
+        "elastic_pipeline",
+        "retime_registers",
         "add_idle_output",
         "module_name",
         "clock_margin_percent",
         "period_relaxation_percent",
+        "initiation_interval",
+        "scheduling_strategy",
+        "scheduling_threads",
+        "random_min_cut_orders",
+        "random_min_cut_order_time_limit",
+        "generate_all",
+        "codegen_threads",
         "reset",
         "reset_active_low",
         "reset_asynchronous",
@@ -103,7 +103,11 @@ def _get_dslx_test_cmdline(ctx, src, append_cmd_line_args = True):
     DSLX_TEST_FLAGS = (
         "bytecode",
         "compare",
+        "compare_batch_size",
+        "compare_in_background",
         "dslx_path",
+        "execute_on_jit",
+        "jobs",
     )
 
     dslx_test_args = dict(_dslx_test_args)
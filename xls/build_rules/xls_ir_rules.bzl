@@ -192,6 +192,7 @@ def _optimize_ir(ctx, src):
         "opt_level",
         "convert_array_index_to_select",
         "inline_procs",
+        "threads",
     )
 
     is_args_valid(opt_ir_args, IR_OPT_FLAGS)
@@ -391,6 +392,7 @@ def get_benchmark_ir_cmd(ctx, src, append_cmd_line_args = True):
         "show_known_bits",
         "delay_model",
         "convert_array_index_to_select",
+        "compare_scheduling_strategies",
     )
 
     benchmark_ir_args = append_default_to_args(
@@ -126,6 +126,8 @@ struct StateRegister {
   Register* reg;
   RegisterWrite* reg_write;
   RegisterRead* reg_read;
+  // The pipeline stage in which the next state is computed and written.
+  int64_t next_state_stage = 0;
 };
 
 // The collection of pipeline registers for a single stage.
@@ -289,6 +291,24 @@ static absl::StatusOr<Node*> MakeOrWithResetNode(Node* src_node,
   return result;
 }
 
+// Replaces the write of the state register with one that is enabled by
+// `load_enable`.
+static absl::Status UpdateStateRegisterLoadEnable(Node* load_enable,
+                                                  StateRegister& state_register,
+                                                  Block* block) {
+  XLS_ASSIGN_OR_RETURN(RegisterWrite * new_reg_write,
+                       block->MakeNode<RegisterWrite>(
+                           /*loc=*/state_register.reg_write->loc(),
+                           /*data=*/state_register.reg_write->data(),
+                           /*load_enable=*/load_enable,
+                           /*reset=*/state_register.reg_write->reset(),
+                           /*reg=*/state_register.reg_write->GetRegister()));
+
+  XLS_RETURN_IF_ERROR(block->RemoveNode(state_register.reg_write));
+  state_register.reg_write = new_reg_write;
+  return absl::OkStatus();
+}
+
 // Adds bubble flow control to the pipeline.
 //
 // - With bubble flow control, a pipeline stage is not stalled if
@@ -296,35 +316,90 @@ static absl::StatusOr<Node*> MakeOrWithResetNode(Node* src_node,
 // - This enabled bubbles within the pipeline to be collapsed when the
 //   output block of the pipeline is not ready to accept data.
 //
-// Returns the ready signal output by the earliest pipeline stage.
+// Receives and sends may be scheduled in any stage. An activation in stage n
+// additionally waits on stage_conditions[n] (if not null) which is true when
+// the active inputs of stage n are valid and the active outputs of stage n
+// (other than the final stage) are ready. For stage 0, it also includes that
+// the state register holds the state written by the previous activation.
+//
+// Returns the ready signal output by the earliest pipeline stage. The enable
+// signal of each stage is returned in stage_enables, and the signal that a
+// stage passes on a valid activation (i.e. data_enable below) in stage_done.
+// For the final stage, stage_done is only created if the stage has a
+// condition or writes the state register.
 //
 static absl::StatusOr<Node*> UpdatePipelineWithBubbleFlowControl(
     Node* initial_output_ready_node, const ResetInfo& reset_info,
     absl::Span<Node*> pipeline_valid_nodes,
     absl::Span<PipelineStageRegisters> pipeline_data_registers,
-    absl::optional<StateRegister>& state_register, Block* block) {
+    absl::optional<StateRegister>& state_register,
+    absl::Span<Node* const> stage_conditions,
+    std::vector<Node*>& stage_enables, std::vector<Node*>& stage_done,
+    Block* block) {
   // Create enable signals for each pipeline stage.
   //   - the last enable signal is the initial_output_ready_node.
   //     enable_signals[N] = initial_output_ready_node
-  //   - enable_signal[n-1] = enable_signal[n] || ! valid[n]
+  //   - enable_signal[n-1] = (enable_signal[n] && cond[n]) || ! valid[n]
   //
   // Data registers are gated whenever data is invalid so
-  //   - data_enable_signal[n-1] = (enable_signal[n-1] && valid[n-1]) || rst
+  //   - data_enable_signal[n-1] = (enable_signal[n-1] && valid[n-1] &&
+  //                                cond[n-1]) || rst
   //
   // State registers are gated whenever data is invalid, but
   // are not transparent during reset
-  //   - state_enable_signal = (enable_signal[0] && valid[0]).
+  //   - state_enable_signal = (enable_signal[k] && valid[k] && cond[k])
+  //     where k is the stage computing the next state.
+  //
+  // A missing condition is treated as true.
 
   int64_t stage_count = pipeline_data_registers.size();
-  std::vector<Node*> enable_n(stage_count + 1);
+  XLS_RET_CHECK_EQ(stage_conditions.size(), stage_count + 1);
+  std::vector<Node*>& enable_n = stage_enables;
+  enable_n.assign(stage_count + 1, nullptr);
   enable_n.at(stage_count) = initial_output_ready_node;
+  stage_done.assign(stage_count + 1, nullptr);
 
   // We initialize data_load_enable here so that this function
   // can return the data_load_enable for the first pipeline stage --
   // which is the last data_load_enable node created by this function.
   Node* data_load_enable = initial_output_ready_node;
 
+  // The final stage passes on its activation when its outputs are ready and
+  // its condition holds.
+  if (stage_count > 0 &&
+      (stage_conditions.at(stage_count) != nullptr ||
+       (state_register.has_value() &&
+        state_register->next_state_stage == stage_count))) {
+    std::vector<Node*> done_operands = {initial_output_ready_node,
+                                        pipeline_valid_nodes.at(stage_count)};
+    if (stage_conditions.at(stage_count) != nullptr) {
+      done_operands.push_back(stage_conditions.at(stage_count));
+    }
+    XLS_ASSIGN_OR_RETURN(
+        stage_done.at(stage_count),
+        block->MakeNodeWithName<NaryOp>(
+            absl::nullopt, done_operands, Op::kAnd,
+            PipelineSignalName("stage_done", stage_count)));
+    if (state_register.has_value() &&
+        state_register->next_state_stage == stage_count) {
+      XLS_RETURN_IF_ERROR(UpdateStateRegisterLoadEnable(
+          stage_done.at(stage_count), state_register.value(), block));
+    }
+  }
+
   for (int64_t stage = stage_count - 1; stage >= 0; --stage) {
+    // An activation leaves the next stage if that stage is enabled and its
+    // condition holds.
+    Node* np1_leaves = enable_n.at(stage + 1);
+    if (stage_conditions.at(stage + 1) != nullptr) {
+      XLS_ASSIGN_OR_RETURN(
+          np1_leaves, block->MakeNodeWithName<NaryOp>(
+                          absl::nullopt,
+                          std::vector<Node*>{enable_n.at(stage + 1),
+                                             stage_conditions.at(stage + 1)},
+                          Op::kAnd, PipelineSignalName("leaves", stage + 1)));
+    }
+
     // Create load enables for valid registers.
     XLS_ASSIGN_OR_RETURN(
         Node * not_valid_np1,
@@ -332,13 +407,25 @@ static absl::StatusOr<Node*> UpdatePipelineWithBubbleFlowControl(
             /*loc=*/absl::nullopt, pipeline_valid_nodes.at(stage + 1), Op::kNot,
             PipelineSignalName("not_valid", stage)));
 
-    std::vector<Node*> en_operands = {enable_n.at(stage + 1), not_valid_np1};
+    std::vector<Node*> en_operands = {np1_leaves, not_valid_np1};
     XLS_ASSIGN_OR_RETURN(
         Node * enable,
         block->MakeNodeWithName<NaryOp>(absl::nullopt, en_operands, Op::kOr,
                                         PipelineSignalName("enable", stage)));
     enable_n.at(stage) = enable;
 
+    // An activation in this stage is passed on only if the condition of the
+    // stage holds.
+    Node* stage_valid = pipeline_valid_nodes.at(stage);
+    if (stage_conditions.at(stage) != nullptr) {
+      XLS_ASSIGN_OR_RETURN(
+          stage_valid,
+          block->MakeNodeWithName<NaryOp>(
+              absl::nullopt,
+              std::vector<Node*>{stage_valid, stage_conditions.at(stage)},
+              Op::kAnd, PipelineSignalName("stage_valid", stage)));
+    }
+
     // Update valid registers with load enables.
     RegisterRead* valid_reg_read =
         pipeline_valid_nodes.at(stage + 1)->As<RegisterRead>();
@@ -348,19 +435,22 @@ static absl::StatusOr<Node*> UpdatePipelineWithBubbleFlowControl(
                          block->GetRegisterWrite(valid_reg));
     XLS_RETURN_IF_ERROR(block
                             ->MakeNode<RegisterWrite>(
-                                /*loc=*/absl::nullopt, valid_reg_write->data(),
+                                /*loc=*/absl::nullopt,
+                                stage_conditions.at(stage) != nullptr
+                                    ? stage_valid
+                                    : valid_reg_write->data(),
                                 /*load_enable=*/enable,
                                 /*reset=*/valid_reg_write->reset(), valid_reg)
                             .status());
     XLS_RETURN_IF_ERROR(block->RemoveNode(valid_reg_write));
 
     // Create load enables for datapath registers.
-    std::vector<Node*> data_en_operands = {enable,
-                                           pipeline_valid_nodes.at(stage)};
+    std::vector<Node*> data_en_operands = {enable, stage_valid};
     XLS_ASSIGN_OR_RETURN(Node * data_enable,
                          block->MakeNodeWithName<NaryOp>(
                              absl::nullopt, data_en_operands, Op::kAnd,
                              PipelineSignalName("data_enable", stage)));
+    stage_done.at(stage) = data_enable;
 
     // If datapath registers are reset, then adding reset to the
     // load enable is redundant.
@@ -389,22 +479,241 @@ static absl::StatusOr<Node*> UpdatePipelineWithBubbleFlowControl(
 
     // Also update the state register and share the enable signal
     // with the data registers.
-    if (stage == 0 && state_register.has_value()) {
+    if (state_register.has_value() &&
+        state_register->next_state_stage == stage) {
+      XLS_RETURN_IF_ERROR(UpdateStateRegisterLoadEnable(
+          data_enable, state_register.value(), block));
+    }
+  }
+
+  return data_load_enable;
+}
+
+// Adds a skid valid register after each pipeline stage but the last. The
+// registers are written by UpdatePipelineWithElasticFlowControl().
+//
+// The returned vector is indexed like the pipelined valid signals: element n
+// is the skid valid signal of the registers feeding stage n, and element 0 is
+// null.
+static absl::StatusOr<std::vector<Node*>> MakePipelineStagesForSkidValid(
+    int64_t pipeline_register_count, const ResetInfo& reset_info,
+    Block* block, absl::flat_hash_set<Register*>& skid_buffer_registers) {
+  Type* u1 = block->package()->GetBitsType(1);
+
+  std::vector<Node*> skid_valids(pipeline_register_count + 1, nullptr);
+  for (int64_t stage = 0; stage < pipeline_register_count; ++stage) {
+    XLS_ASSIGN_OR_RETURN(
+        Register * skid_valid_reg,
+        block->AddRegister(PipelineSignalName("valid_skid", stage), u1,
+                           reset_info.behavior));
+    skid_buffer_registers.insert(skid_valid_reg);
+    XLS_ASSIGN_OR_RETURN(skid_valids[stage + 1],
+                         block->MakeNode<RegisterRead>(
+                             /*loc=*/absl::nullopt, skid_valid_reg));
+  }
+
+  return skid_valids;
+}
+
+// Adds elastic flow control to the pipeline.
+//
+// With bubble flow control, the enable signal of each stage depends on the
+// enable signal of the next stage, so a stall at the outputs propagates
+// combinationally back to the inputs in a single cycle. With elastic flow
+// control, each pipeline register is paired with a skid register which holds
+// the activation passed on by the previous stage while the pipeline register
+// cannot accept it. A stage is then enabled whenever the skid register after
+// it is empty, so the stall signal is registered at every stage boundary and
+// the pipeline still accepts an activation every cycle.
+//
+// For the registers between stage n and n+1:
+//
+//   enable[n] = !skid_valid[n+1]
+//   done[n] = enable[n] && valid[n] && cond[n]
+//   accept[n+1] = !valid[n+1] || done[n+1]
+//   valid[n+1]' = accept[n+1] ? skid_valid[n+1] || done[n] : valid[n+1]
+//   skid_valid[n+1]' = !accept[n+1] && (skid_valid[n+1] || done[n])
+//   data[n+1]' = skid_valid[n+1] ? skid_data[n+1] : data[n]
+//     loaded when accept[n+1] && (skid_valid[n+1] || done[n])
+//   skid_data[n+1]' = data[n]
+//     loaded when !accept[n+1] && done[n]
+//
+// where enable[N] for the final stage N is initial_output_ready_node. The
+// state register is written on done[k] where k is the stage computing the
+// next state.
+//
+// Arguments and results are as for UpdatePipelineWithBubbleFlowControl(),
+// with the skid valid signals made by MakePipelineStagesForSkidValid() in
+// pipeline_skid_valid_nodes. stage_done is created for every stage.
+static absl::StatusOr<Node*> UpdatePipelineWithElasticFlowControl(
+    Node* initial_output_ready_node, const ResetInfo& reset_info,
+    absl::Span<Node*> pipeline_valid_nodes,
+    absl::Span<Node* const> pipeline_skid_valid_nodes,
+    absl::Span<PipelineStageRegisters> pipeline_data_registers,
+    absl::optional<StateRegister>& state_register,
+    absl::Span<Node* const> stage_conditions,
+    std::vector<Node*>& stage_enables, std::vector<Node*>& stage_done,
+    Block* block, absl::flat_hash_set<Register*>& skid_buffer_registers) {
+  int64_t stage_count = pipeline_data_registers.size();
+  XLS_RET_CHECK_GT(stage_count, 0);
+  XLS_RET_CHECK_EQ(stage_conditions.size(), stage_count + 1);
+  XLS_RET_CHECK_EQ(pipeline_skid_valid_nodes.size(), stage_count + 1);
+  stage_enables.assign(stage_count + 1, nullptr);
+  stage_enables.at(stage_count) = initial_output_ready_node;
+  stage_done.assign(stage_count + 1, nullptr);
+
+  auto make_stage_done = [&](int64_t stage) -> absl::StatusOr<Node*> {
+    std::vector<Node*> operands = {stage_enables.at(stage),
+                                   pipeline_valid_nodes.at(stage)};
+    if (stage_conditions.at(stage) != nullptr) {
+      operands.push_back(stage_conditions.at(stage));
+    }
+    return block->MakeNodeWithName<NaryOp>(
+        absl::nullopt, operands, Op::kAnd,
+        PipelineSignalName("stage_done", stage));
+  };
+  auto make_load_enable = [&](Node* enable, absl::string_view name)
+      -> absl::StatusOr<Node*> {
+    // If datapath registers are reset, then adding reset to the load enable
+    // is redundant.
+    if (reset_info.reset_data_path) {
+      return enable;
+    }
+    return MakeOrWithResetNode(enable, name, reset_info, block);
+  };
+
+  XLS_ASSIGN_OR_RETURN(stage_done.at(stage_count),
+                       make_stage_done(stage_count));
+  if (state_register.has_value() &&
+      state_register->next_state_stage == stage_count) {
+    XLS_RETURN_IF_ERROR(UpdateStateRegisterLoadEnable(
+        stage_done.at(stage_count), state_register.value(), block));
+  }
+
+  for (int64_t stage = stage_count - 1; stage >= 0; --stage) {
+    Node* valid_np1 = pipeline_valid_nodes.at(stage + 1);
+    Node* skid_valid_np1 = pipeline_skid_valid_nodes.at(stage + 1);
+
+    XLS_ASSIGN_OR_RETURN(
+        stage_enables.at(stage),
+        block->MakeNodeWithName<UnOp>(absl::nullopt, skid_valid_np1, Op::kNot,
+                                      PipelineSignalName("enable", stage)));
+    XLS_ASSIGN_OR_RETURN(stage_done.at(stage), make_stage_done(stage));
+    if (state_register.has_value() &&
+        state_register->next_state_stage == stage) {
+      XLS_RETURN_IF_ERROR(UpdateStateRegisterLoadEnable(
+          stage_done.at(stage), state_register.value(), block));
+    }
+
+    // The pipeline register accepts an activation if it is empty or if its
+    // activation leaves the next stage.
+    XLS_ASSIGN_OR_RETURN(
+        Node * not_valid_np1,
+        block->MakeNodeWithName<UnOp>(absl::nullopt, valid_np1, Op::kNot,
+                                      PipelineSignalName("not_valid", stage)));
+    XLS_ASSIGN_OR_RETURN(
+        Node * accept,
+        block->MakeNodeWithName<NaryOp>(
+            absl::nullopt,
+            std::vector<Node*>{not_valid_np1, stage_done.at(stage + 1)},
+            Op::kOr, PipelineSignalName("accept", stage)));
+    XLS_ASSIGN_OR_RETURN(
+        Node * not_accept,
+        block->MakeNodeWithName<UnOp>(absl::nullopt, accept, Op::kNot,
+                                      PipelineSignalName("not_accept", stage)));
+
+    // An activation is offered to the pipeline register by the skid register
+    // or, if the skid register is empty, by this stage.
+    XLS_ASSIGN_OR_RETURN(
+        Node * offered,
+        block->MakeNodeWithName<NaryOp>(
+            absl::nullopt,
+            std::vector<Node*>{skid_valid_np1, stage_done.at(stage)}, Op::kOr,
+            PipelineSignalName("offered", stage)));
+
+    // Update the valid register and write the skid valid register.
+    Register* valid_reg = valid_np1->As<RegisterRead>()->GetRegister();
+    XLS_ASSIGN_OR_RETURN(RegisterWrite * valid_reg_write,
+                         block->GetRegisterWrite(valid_reg));
+    XLS_RETURN_IF_ERROR(block
+                            ->MakeNode<RegisterWrite>(
+                                /*loc=*/absl::nullopt, offered,
+                                /*load_enable=*/accept,
+                                /*reset=*/valid_reg_write->reset(), valid_reg)
+                            .status());
+    XLS_RETURN_IF_ERROR(block->RemoveNode(valid_reg_write));
+
+    XLS_ASSIGN_OR_RETURN(
+        Node * skid_fill,
+        block->MakeNodeWithName<NaryOp>(
+            absl::nullopt, std::vector<Node*>{not_accept, offered}, Op::kAnd,
+            PipelineSignalName("skid_fill", stage)));
+    XLS_RETURN_IF_ERROR(
+        block
+            ->MakeNode<RegisterWrite>(
+                /*loc=*/absl::nullopt, skid_fill,
+                /*load_enable=*/absl::nullopt,
+                /*reset=*/reset_info.input_port,
+                skid_valid_np1->As<RegisterRead>()->GetRegister())
+            .status());
+
+    if (pipeline_data_registers.at(stage).empty()) {
+      continue;
+    }
+
+    XLS_ASSIGN_OR_RETURN(
+        Node * data_enable,
+        block->MakeNodeWithName<NaryOp>(
+            absl::nullopt, std::vector<Node*>{accept, offered}, Op::kAnd,
+            PipelineSignalName("data_enable", stage)));
+    XLS_ASSIGN_OR_RETURN(
+        Node * data_load_enable,
+        make_load_enable(data_enable, PipelineSignalName("load_en", stage)));
+    XLS_ASSIGN_OR_RETURN(
+        Node * skid_data_enable,
+        block->MakeNodeWithName<NaryOp>(
+            absl::nullopt, std::vector<Node*>{not_accept, stage_done.at(stage)},
+            Op::kAnd, PipelineSignalName("skid_data_enable", stage)));
+    XLS_ASSIGN_OR_RETURN(Node * skid_load_enable,
+                         make_load_enable(skid_data_enable,
+                                          PipelineSignalName("skid_load_en",
+                                                             stage)));
+
+    for (PipelineRegister& pipeline_reg : pipeline_data_registers.at(stage)) {
+      Node* data = pipeline_reg.reg_write->data();
+      absl::optional<Node*> reset = pipeline_reg.reg_write->reset();
+      XLS_ASSIGN_OR_RETURN(
+          Register * skid_reg,
+          block->AddRegister(absl::StrCat(pipeline_reg.reg->name(), "_skid"),
+                             pipeline_reg.reg->type(),
+                             pipeline_reg.reg->reset()));
+      skid_buffer_registers.insert(skid_reg);
+      XLS_RETURN_IF_ERROR(block
+                              ->MakeNode<RegisterWrite>(
+                                  /*loc=*/absl::nullopt, data,
+                                  /*load_enable=*/skid_load_enable, reset,
+                                  skid_reg)
+                              .status());
+      XLS_ASSIGN_OR_RETURN(
+          RegisterRead * skid_reg_read,
+          block->MakeNode<RegisterRead>(/*loc=*/absl::nullopt, skid_reg));
+      XLS_ASSIGN_OR_RETURN(
+          Node * next_data,
+          block->MakeNode<Select>(
+              /*loc=*/absl::nullopt, /*selector=*/skid_valid_np1,
+              /*cases=*/std::vector<Node*>{data, skid_reg_read},
+              /*default_value=*/absl::nullopt));
       XLS_ASSIGN_OR_RETURN(
           RegisterWrite * new_reg_write,
           block->MakeNode<RegisterWrite>(
-              /*loc=*/state_register->reg_write->loc(),
-              /*data=*/state_register->reg_write->data(),
-              /*load_enable=*/data_enable,
-              /*reset=*/state_register->reg_write->reset(),
-              /*reg=*/state_register->reg_write->GetRegister()));
-
-      XLS_RETURN_IF_ERROR(block->RemoveNode(state_register->reg_write));
-      state_register->reg_write = new_reg_write;
+              /*loc=*/absl::nullopt, next_data,
+              /*load_enable=*/data_load_enable, reset, pipeline_reg.reg));
+      XLS_RETURN_IF_ERROR(block->RemoveNode(pipeline_reg.reg_write));
+      pipeline_reg.reg_write = new_reg_write;
     }
   }
 
-  return data_load_enable;
+  return stage_done.at(0);
 }
 
 // Adds flow control when no pipeline registers are created
@@ -537,6 +846,8 @@ struct StreamingInput {
   OutputPort* port_ready;
   Channel* channel;
   absl::optional<Node*> predicate;
+  // The pipeline stage in which the receive is scheduled.
+  int64_t stage = 0;
 };
 
 struct StreamingOutput {
@@ -545,6 +856,8 @@ struct StreamingOutput {
   InputPort* port_ready;
   Channel* channel;
   absl::optional<Node*> predicate;
+  // The pipeline stage in which the send is scheduled.
+  int64_t stage = 0;
 };
 
 // Data structures holding the port representing single value inputs/outputs
@@ -572,6 +885,22 @@ struct StreamingIoPipeline {
   // are predicated true) are ready.
   // See MakeOutputReadyPortsForOutputChannels().
   absl::optional<Node*> all_active_outputs_ready;
+
+  // Nodes in block, indexed by pipeline stage, that are true when the stage
+  // passes a valid activation on to the next stage. Null for the final stage
+  // unless it has inputs or writes the state register.
+  // See UpdatePipelineWithBubbleFlowControl().
+  std::vector<Node*> stage_done;
+
+  // With elastic flow control, the skid valid signals of each stage, indexed
+  // as the pipelined valid signals. Empty otherwise.
+  // See UpdatePipelineWithElasticFlowControl().
+  std::vector<Node*> skid_valids;
+
+  // Registers which make up skid buffers: those paired with the pipeline
+  // registers by elastic flow control and those of skid (or zero-latency)
+  // buffered I/O.
+  absl::flat_hash_set<Register*> skid_buffer_registers;
 };
 
 // Update io channel metadata with latest information from block conversion.
@@ -861,7 +1190,8 @@ static absl::StatusOr<RegisterRead*> AddRegisterAfterNode(
 static absl::StatusOr<Node*> AddSkidBufferToRDVNodes(
     Node* from_data, Node* from_valid, Node* from_rdy,
     absl::string_view name_prefix, const ResetInfo& reset_info, Block* block,
-    std::vector<Node*>& valid_nodes) {
+    std::vector<Node*>& valid_nodes,
+    absl::flat_hash_set<Register*>& skid_buffer_registers) {
   XLS_CHECK_EQ(from_rdy->operand_count(), 1);
 
   // Add a node for load_enables (will be removed later).
@@ -878,6 +1208,7 @@ static absl::StatusOr<Node*> AddSkidBufferToRDVNodes(
       RegisterRead * data_skid_reg_read,
       AddRegisterAfterNode(absl::StrCat(name_prefix, "_skid"), reset_info,
                            literal_1, data_reg_read, block));
+  skid_buffer_registers.insert(data_skid_reg_read->GetRegister());
 
   XLS_ASSIGN_OR_RETURN(
       RegisterRead * data_valid_reg_read,
@@ -888,6 +1219,7 @@ static absl::StatusOr<Node*> AddSkidBufferToRDVNodes(
       RegisterRead * data_valid_skid_reg_read,
       AddRegisterAfterNode(absl::StrCat(name_prefix, "_valid_skid"), reset_info,
                            literal_1, data_valid_reg_read, block));
+  skid_buffer_registers.insert(data_valid_skid_reg_read->GetRegister());
 
   // If data_valid_skid_reg_read is 1, then data/valid outputs should
   // be selected from the skid set.
@@ -1033,7 +1365,8 @@ static absl::StatusOr<Node*> AddSkidBufferToRDVNodes(
 static absl::StatusOr<Node*> AddZeroLatencyBufferToRDVNodes(
     Node* from_data, Node* from_valid, Node* from_rdy,
     absl::string_view name_prefix, const ResetInfo& reset_info, Block* block,
-    std::vector<Node*>& valid_nodes) {
+    std::vector<Node*>& valid_nodes,
+    absl::flat_hash_set<Register*>& skid_buffer_registers) {
   XLS_CHECK_EQ(from_rdy->operand_count(), 1);
 
   // Add a node for load_enables (will be removed later).
@@ -1046,11 +1379,13 @@ static absl::StatusOr<Node*> AddZeroLatencyBufferToRDVNodes(
       RegisterRead * data_skid_reg_read,
       AddRegisterAfterNode(absl::StrCat(name_prefix, "_skid"), reset_info,
                            literal_1, from_data, block));
+  skid_buffer_registers.insert(data_skid_reg_read->GetRegister());
 
   XLS_ASSIGN_OR_RETURN(
       RegisterRead * data_valid_skid_reg_read,
       AddRegisterAfterNode(absl::StrCat(name_prefix, "_valid_skid"), reset_info,
                            literal_1, from_valid, block));
+  skid_buffer_registers.insert(data_valid_skid_reg_read->GetRegister());
 
   // If data_valid_skid_reg_read is 1, then data/valid outputs should
   // be selected from the skid set.
@@ -1209,18 +1544,20 @@ static absl::StatusOr<RegisterRead*> AddRegisterToRDVNodes(
 static absl::StatusOr<Node*> AddRegisterAfterStreamingInput(
     StreamingInput& input, const ResetInfo& reset_info,
     const CodegenOptions& options, Block* block,
-    std::vector<Node*>& valid_nodes) {
+    std::vector<Node*>& valid_nodes,
+    absl::flat_hash_set<Register*>& skid_buffer_registers) {
   if (options.flop_inputs_kind() ==
       CodegenOptions::IOKind::kZeroLatencyBuffer) {
-    return AddZeroLatencyBufferToRDVNodes(input.port, input.port_valid,
-                                          input.port_ready, input.port->name(),
-                                          reset_info, block, valid_nodes);
+    return AddZeroLatencyBufferToRDVNodes(
+        input.port, input.port_valid, input.port_ready, input.port->name(),
+        reset_info, block, valid_nodes, skid_buffer_registers);
   }
 
   if (options.flop_inputs_kind() == CodegenOptions::IOKind::kSkidBuffer) {
     return AddSkidBufferToRDVNodes(input.port, input.port_valid,
                                    input.port_ready, input.port->name(),
-                                   reset_info, block, valid_nodes);
+                                   reset_info, block, valid_nodes,
+                                   skid_buffer_registers);
   }
 
   if (options.flop_inputs_kind() == CodegenOptions::IOKind::kFlop) {
@@ -1239,7 +1576,8 @@ static absl::StatusOr<Node*> AddRegisterAfterStreamingInput(
 static absl::StatusOr<Node*> AddRegisterBeforeStreamingOutput(
     StreamingOutput& output, const ResetInfo& reset_info,
     const CodegenOptions& options, Block* block,
-    std::vector<Node*>& valid_nodes) {
+    std::vector<Node*>& valid_nodes,
+    absl::flat_hash_set<Register*>& skid_buffer_registers) {
   // Add an buffers before the data/valid output ports and after
   // the ready input port to serve as points where the
   // additional logic from AddRegisterToRDVNodes() can be inserted.
@@ -1276,13 +1614,15 @@ static absl::StatusOr<Node*> AddRegisterBeforeStreamingOutput(
       CodegenOptions::IOKind::kZeroLatencyBuffer) {
     return AddZeroLatencyBufferToRDVNodes(
         output_port_data_buf, output_port_valid_buf, output_port_ready_buf,
-        output.port->name(), reset_info, block, valid_nodes);
+        output.port->name(), reset_info, block, valid_nodes,
+        skid_buffer_registers);
   }
 
   if (options.flop_outputs_kind() == CodegenOptions::IOKind::kSkidBuffer) {
     return AddSkidBufferToRDVNodes(output_port_data_buf, output_port_valid_buf,
                                    output_port_ready_buf, output.port->name(),
-                                   reset_info, block, valid_nodes);
+                                   reset_info, block, valid_nodes,
+                                   skid_buffer_registers);
   }
 
   if (options.flop_outputs_kind() == CodegenOptions::IOKind::kFlop) {
@@ -1313,9 +1653,11 @@ static absl::Status AddInputOutputFlops(const ResetInfo& reset_info,
   // Flop streaming inputs.
   for (StreamingInput& input : streaming_io.inputs) {
     if (options.flop_inputs()) {
-      XLS_RETURN_IF_ERROR(AddRegisterAfterStreamingInput(
-                              input, reset_info, options, block, valid_nodes)
-                              .status());
+      XLS_RETURN_IF_ERROR(
+          AddRegisterAfterStreamingInput(input, reset_info, options, block,
+                                         valid_nodes,
+                                         streaming_io.skid_buffer_registers)
+              .status());
 
       handled_io_nodes.insert(input.port);
       handled_io_nodes.insert(input.port_valid);
@@ -1329,9 +1671,11 @@ static absl::Status AddInputOutputFlops(const ResetInfo& reset_info,
   // Flop streaming outputs.
   for (StreamingOutput& output : streaming_io.outputs) {
     if (options.flop_outputs()) {
-      XLS_RETURN_IF_ERROR(AddRegisterBeforeStreamingOutput(
-                              output, reset_info, options, block, valid_nodes)
-                              .status());
+      XLS_RETURN_IF_ERROR(
+          AddRegisterBeforeStreamingOutput(output, reset_info, options, block,
+                                           valid_nodes,
+                                           streaming_io.skid_buffer_registers)
+              .status());
 
       handled_io_nodes.insert(output.port);
       handled_io_nodes.insert(output.port_valid);
@@ -1525,8 +1869,14 @@ static absl::Status AddOneShotOutputLogic(const ResetInfo& reset_info,
     XLS_RETURN_IF_ERROR(
         output.port_ready->ReplaceUsesWith(output_port_ready_buf));
 
+    // The output may be sent again once its stage has passed on the
+    // activation. Unless the stage has inputs, the final stage does so
+    // whenever all its outputs are ready.
+    Node* stage_load = streaming_io.stage_done.at(output.stage) != nullptr
+                           ? streaming_io.stage_done.at(output.stage)
+                           : all_active_outputs_ready;
     XLS_RETURN_IF_ERROR(AddOneShotLogicToRVNodes(
-        output_port_valid_buf, output_port_ready_buf, all_active_outputs_ready,
+        output_port_valid_buf, output_port_ready_buf, stage_load,
         output.port->name(), reset_info, block));
   }
 
@@ -1564,6 +1914,25 @@ static absl::Status AddIdleOutput(std::vector<Node*> valid_nodes,
   return absl::OkStatus();
 }
 
+// Returns the given streaming inputs or outputs grouped by the pipeline stage
+// in which they are scheduled. `io` must be ordered by stage.
+template <typename T>
+static absl::StatusOr<std::vector<absl::Span<T>>> GroupByStage(
+    absl::Span<T> io, int64_t stage_count) {
+  std::vector<absl::Span<T>> result(stage_count);
+  int64_t begin = 0;
+  for (int64_t stage = 0; stage < stage_count; ++stage) {
+    int64_t end = begin;
+    while (end < io.size() && io[end].stage == stage) {
+      ++end;
+    }
+    result[stage] = io.subspan(begin, end - begin);
+    begin = end;
+  }
+  XLS_RET_CHECK_EQ(begin, io.size()) << "Streaming I/O is not ordered by stage";
+  return result;
+}
+
 // Adds ready/valid ports for each of the given streaming inputs/outputs. Also,
 // adds logic which propagates ready and valid signals through the block.
 //
@@ -1572,16 +1941,44 @@ static absl::Status AddIdleOutput(std::vector<Node*> valid_nodes,
 // any used input channel is invalid, the node represented by ret[0] will
 // be invalid (see MakeInputValidPortsForInputChannels() and
 // MakePipelineStagesForValid().
+//
+// Inputs and outputs of stages other than the initial and final stage,
+// respectively, hold up the activation in their stage until they are
+// valid/ready. If the next state is computed in stage k > 0, the initial stage
+// is held until stages 1 to k are empty so that it reads the state written by
+// the previous activation.
+//
+// If options.elastic_pipeline() is set, the stages are connected with elastic
+// rather than bubble flow control. See UpdatePipelineWithElasticFlowControl().
 static absl::StatusOr<std::vector<Node*>> AddBubbleFlowControl(
     const ResetInfo& reset_info, const CodegenOptions& options,
     StreamingIoPipeline& streaming_io, Block* block) {
   absl::string_view valid_suffix = options.streaming_channel_valid_suffix();
   absl::string_view ready_suffix = options.streaming_channel_ready_suffix();
 
+  int64_t stage_count = streaming_io.pipeline_registers.size() + 1;
+  int64_t final_stage = stage_count - 1;
+  XLS_ASSIGN_OR_RETURN(
+      std::vector<absl::Span<StreamingInput>> stage_inputs,
+      GroupByStage(absl::MakeSpan(streaming_io.inputs), stage_count));
   XLS_ASSIGN_OR_RETURN(
-      Node * all_active_inputs_valid,
-      MakeInputValidPortsForInputChannels(absl::MakeSpan(streaming_io.inputs),
-                                          valid_suffix, block));
+      std::vector<absl::Span<StreamingOutput>> stage_outputs,
+      GroupByStage(absl::MakeSpan(streaming_io.outputs), stage_count));
+
+  XLS_ASSIGN_OR_RETURN(Node * all_active_inputs_valid,
+                       MakeInputValidPortsForInputChannels(
+                           stage_inputs.at(0), valid_suffix, block));
+
+  // Valid signals of the inputs of each stage after the first. The inputs of
+  // the first stage are part of the initial valid signal.
+  std::vector<Node*> stage_inputs_valid(stage_count, nullptr);
+  for (int64_t stage = 1; stage < stage_count; ++stage) {
+    if (!stage_inputs.at(stage).empty()) {
+      XLS_ASSIGN_OR_RETURN(stage_inputs_valid.at(stage),
+                           MakeInputValidPortsForInputChannels(
+                               stage_inputs.at(stage), valid_suffix, block));
+    }
+  }
 
   XLS_VLOG(3) << "After Inputs";
   XLS_VLOG_LINES(3, block->DumpIr());
@@ -1591,6 +1988,15 @@ static absl::StatusOr<std::vector<Node*>> AddBubbleFlowControl(
                            all_active_inputs_valid,
                            streaming_io.pipeline_registers, reset_info, block));
 
+  bool elastic = options.elastic_pipeline() && stage_count > 1;
+  if (elastic) {
+    XLS_ASSIGN_OR_RETURN(
+        streaming_io.skid_valids,
+        MakePipelineStagesForSkidValid(streaming_io.pipeline_registers.size(),
+                                       reset_info, block,
+                                       streaming_io.skid_buffer_registers));
+  }
+
   XLS_VLOG(3) << "After Valids";
   XLS_VLOG_LINES(3, block->DumpIr());
 
@@ -1610,28 +2016,94 @@ static absl::StatusOr<std::vector<Node*>> AddBubbleFlowControl(
     XLS_VLOG_LINES(3, block->DumpIr());
   }
 
+  // The conditions, other than readiness of the outputs, for an activation to
+  // leave each stage. See UpdatePipelineWithBubbleFlowControl().
+  std::vector<Node*> stage_valid_conditions = stage_inputs_valid;
+  if (streaming_io.state_register.has_value() &&
+      streaming_io.state_register->next_state_stage > 0) {
+    std::vector<Node*> pending_state_valids(
+        pipelined_valids.begin() + 1,
+        pipelined_valids.begin() +
+            streaming_io.state_register->next_state_stage + 1);
+    if (elastic) {
+      pending_state_valids.insert(
+          pending_state_valids.end(), streaming_io.skid_valids.begin() + 1,
+          streaming_io.skid_valids.begin() +
+              streaming_io.state_register->next_state_stage + 1);
+    }
+    XLS_ASSIGN_OR_RETURN(
+        stage_valid_conditions.at(0),
+        block->MakeNodeWithName<NaryOp>(absl::nullopt, pending_state_valids,
+                                        Op::kNor, "state_ready"));
+  }
+
+  Node* final_stage_valid = pipelined_valids.back();
+  if (stage_valid_conditions.at(final_stage) != nullptr) {
+    XLS_ASSIGN_OR_RETURN(
+        final_stage_valid,
+        block->MakeNode<NaryOp>(
+            absl::nullopt,
+            std::vector<Node*>{final_stage_valid,
+                               stage_valid_conditions.at(final_stage)},
+            Op::kAnd));
+  }
   XLS_RETURN_IF_ERROR(MakeOutputValidPortsForOutputChannels(
-      pipelined_valids.back(), absl::MakeSpan(streaming_io.outputs),
-      valid_suffix, block));
+      final_stage_valid, stage_outputs.at(final_stage), valid_suffix, block));
 
   XLS_VLOG(3) << "After Outputs Valid";
   XLS_VLOG_LINES(3, block->DumpIr());
 
-  XLS_ASSIGN_OR_RETURN(
-      Node * all_active_outputs_ready,
-      MakeOutputReadyPortsForOutputChannels(
-          absl::MakeSpan(streaming_io.outputs), ready_suffix, block));
+  std::vector<Node*> stage_conditions = stage_valid_conditions;
+  for (int64_t stage = 0; stage < final_stage; ++stage) {
+    if (stage_outputs.at(stage).empty()) {
+      continue;
+    }
+    XLS_ASSIGN_OR_RETURN(Node * stage_outputs_ready,
+                         MakeOutputReadyPortsForOutputChannels(
+                             stage_outputs.at(stage), ready_suffix, block));
+    if (stage_conditions.at(stage) == nullptr) {
+      stage_conditions.at(stage) = stage_outputs_ready;
+    } else {
+      XLS_ASSIGN_OR_RETURN(
+          stage_conditions.at(stage),
+          block->MakeNode<NaryOp>(
+              absl::nullopt,
+              std::vector<Node*>{stage_conditions.at(stage),
+                                 stage_outputs_ready},
+              Op::kAnd));
+    }
+  }
+
+  XLS_ASSIGN_OR_RETURN(Node * all_active_outputs_ready,
+                       MakeOutputReadyPortsForOutputChannels(
+                           stage_outputs.at(final_stage), ready_suffix, block));
   streaming_io.all_active_outputs_ready = all_active_outputs_ready;
 
   XLS_VLOG(3) << "After Outputs Ready";
   XLS_VLOG_LINES(3, block->DumpIr());
 
-  XLS_ASSIGN_OR_RETURN(Node * input_stage_enable,
-                       UpdatePipelineWithBubbleFlowControl(
-                           all_active_outputs_ready, reset_info,
-                           absl::MakeSpan(pipelined_valids),
-                           absl::MakeSpan(streaming_io.pipeline_registers),
-                           streaming_io.state_register, block));
+  std::vector<Node*> stage_enables;
+  Node* input_stage_enable;
+  if (elastic) {
+    XLS_ASSIGN_OR_RETURN(
+        input_stage_enable,
+        UpdatePipelineWithElasticFlowControl(
+            all_active_outputs_ready, reset_info,
+            absl::MakeSpan(pipelined_valids), streaming_io.skid_valids,
+            absl::MakeSpan(streaming_io.pipeline_registers),
+            streaming_io.state_register, stage_conditions, stage_enables,
+            streaming_io.stage_done, block,
+            streaming_io.skid_buffer_registers));
+  } else {
+    XLS_ASSIGN_OR_RETURN(
+        input_stage_enable,
+        UpdatePipelineWithBubbleFlowControl(
+            all_active_outputs_ready, reset_info,
+            absl::MakeSpan(pipelined_valids),
+            absl::MakeSpan(streaming_io.pipeline_registers),
+            streaming_io.state_register, stage_conditions, stage_enables,
+            streaming_io.stage_done, block));
+  }
 
   XLS_VLOG(3) << "After Bubble Flow Control (pipeline)";
   XLS_VLOG_LINES(3, block->DumpIr());
@@ -1647,9 +2119,34 @@ static absl::StatusOr<std::vector<Node*>> AddBubbleFlowControl(
   XLS_VLOG(3) << "After Single Stage Flow Control (state)";
   XLS_VLOG_LINES(3, block->DumpIr());
 
+  // Outputs before the final stage are valid only when their stage is enabled,
+  // so that they are not sent again while the stage is stalled.
+  for (int64_t stage = 0; stage < final_stage; ++stage) {
+    if (stage_outputs.at(stage).empty()) {
+      continue;
+    }
+    std::vector<Node*> valid_operands = {pipelined_valids.at(stage),
+                                         stage_enables.at(stage)};
+    if (stage_valid_conditions.at(stage) != nullptr) {
+      valid_operands.push_back(stage_valid_conditions.at(stage));
+    }
+    XLS_ASSIGN_OR_RETURN(
+        Node * stage_outputs_valid,
+        block->MakeNode<NaryOp>(absl::nullopt, valid_operands, Op::kAnd));
+    XLS_RETURN_IF_ERROR(MakeOutputValidPortsForOutputChannels(
+        stage_outputs_valid, stage_outputs.at(stage), valid_suffix, block));
+  }
+
   XLS_RETURN_IF_ERROR(MakeOutputReadyPortsForInputChannels(
-      input_stage_enable, absl::MakeSpan(streaming_io.inputs), ready_suffix,
-      block));
+      input_stage_enable, stage_inputs.at(0), ready_suffix, block));
+  for (int64_t stage = 1; stage < stage_count; ++stage) {
+    if (stage_inputs.at(stage).empty()) {
+      continue;
+    }
+    XLS_RETURN_IF_ERROR(MakeOutputReadyPortsForInputChannels(
+        streaming_io.stage_done.at(stage), stage_inputs.at(stage),
+        ready_suffix, block));
+  }
 
   XLS_VLOG(3) << "After Ready";
   XLS_VLOG_LINES(3, block->DumpIr());
@@ -1685,8 +2182,10 @@ static absl::Status AddFlowControl(
 
 // Send/receive nodes are not cloned from the proc into the block, but the
 // network of tokens connecting these send/receive nodes *is* cloned. This
-// function removes the token operations.
-static absl::Status RemoveDeadTokenNodes(Block* block) {
+// function removes the token operations. Registers which become zero-width
+// are removed too, and dropped from `skid_buffer_registers`.
+static absl::Status RemoveDeadTokenNodes(
+    Block* block, absl::flat_hash_set<Register*>& skid_buffer_registers) {
   // Receive nodes produce a tuple of a token and a data value. In the block
   // this becomes a tuple of a token and an InputPort. Run tuple simplification
   // to disentangle the tuples so DCE can do its work and eliminate the token
@@ -1704,10 +2203,12 @@ static absl::Status RemoveDeadTokenNodes(Block* block) {
           .status());
 
   CodegenPassUnit unit(block->package(), block);
+  unit.skid_buffer_registers = std::move(skid_buffer_registers);
   CodegenPassOptions pass_options;
   XLS_RETURN_IF_ERROR(RegisterLegalizationPass()
                           .Run(&unit, pass_options, &pass_results)
                           .status());
+  skid_buffer_registers = std::move(unit.skid_buffer_registers);
   XLS_RETURN_IF_ERROR(
       DeadCodeEliminationPass()
           .RunOnFunctionBase(block, PassOptions(), &pass_results)
@@ -1814,14 +2315,13 @@ class CloneNodesIntoBlockHandler {
         }
       } else if (node->Is<Receive>()) {
         XLS_RET_CHECK(is_proc_);
-        XLS_ASSIGN_OR_RETURN(next_node, HandleReceiveNode(node));
+        XLS_ASSIGN_OR_RETURN(next_node, HandleReceiveNode(node, stage));
       } else if (node->Is<Send>()) {
         XLS_RET_CHECK(is_proc_);
-        XLS_ASSIGN_OR_RETURN(next_node, HandleSendNode(node));
+        XLS_ASSIGN_OR_RETURN(next_node, HandleSendNode(node, stage));
       } else if (node == next_state_node_) {
         XLS_RET_CHECK(is_proc_);
-        XLS_RET_CHECK_EQ(stage, 0);
-        XLS_ASSIGN_OR_RETURN(next_node, HandleNextStateNode(node));
+        XLS_ASSIGN_OR_RETURN(next_node, HandleNextStateNode(node, stage));
       } else {
         XLS_ASSIGN_OR_RETURN(next_node, HandleGeneralNode(node));
       }
@@ -1941,7 +2441,7 @@ class CloneNodesIntoBlockHandler {
 
   // Don't clone Receive operations. Instead replace with a tuple
   // containing the Receive's token operand and an InputPort operation.
-  absl::StatusOr<Node*> HandleReceiveNode(Node* node) {
+  absl::StatusOr<Node*> HandleReceiveNode(Node* node, int64_t stage) {
     Node* next_node;
 
     Receive* receive = node->As<Receive>();
@@ -1974,7 +2474,8 @@ class CloneNodesIntoBlockHandler {
     StreamingInput streaming_input{.port = input_port,
                                    .port_valid = nullptr,
                                    .port_ready = nullptr,
-                                   .channel = channel};
+                                   .channel = channel,
+                                   .stage = stage};
 
     if (receive->predicate().has_value()) {
       streaming_input.predicate = node_map_.at(receive->predicate().value());
@@ -1986,7 +2487,7 @@ class CloneNodesIntoBlockHandler {
 
   // Don't clone Send operations. Instead replace with an OutputPort
   // operation in the block.
-  absl::StatusOr<Node*> HandleSendNode(Node* node) {
+  absl::StatusOr<Node*> HandleSendNode(Node* node, int64_t stage) {
     Node* next_node;
 
     XLS_ASSIGN_OR_RETURN(Channel * channel, GetChannelUsedByNode(node));
@@ -2016,7 +2517,8 @@ class CloneNodesIntoBlockHandler {
     StreamingOutput streaming_output{.port = output_port,
                                      .port_valid = nullptr,
                                      .port_ready = nullptr,
-                                     .channel = channel};
+                                     .channel = channel,
+                                     .stage = stage};
 
     if (send->predicate().has_value()) {
       streaming_output.predicate = node_map_.at(send->predicate().value());
@@ -2028,7 +2530,7 @@ class CloneNodesIntoBlockHandler {
   }
 
   // Clone the operation and then write to the state register.
-  absl::StatusOr<Node*> HandleNextStateNode(Node* node) {
+  absl::StatusOr<Node*> HandleNextStateNode(Node* node, int64_t stage) {
     XLS_ASSIGN_OR_RETURN(Node * next_state, HandleGeneralNode(node));
 
     if (node->GetType()->GetFlatBitCount() == 0) {
@@ -2060,6 +2562,7 @@ class CloneNodesIntoBlockHandler {
                                         /*load_enable=*/absl::nullopt,
                                         /*reset=*/absl::nullopt,
                                         result_.state_register->reg));
+    result_.state_register->next_state_stage = stage;
 
     // For propagation in the fanout, the next_state data in is used
     // instead of the register.
@@ -2295,9 +2798,9 @@ absl::StatusOr<Block*> FunctionToPipelinedBlock(
   return block;
 }
 
-absl::StatusOr<Block*> ProcToPipelinedBlock(const PipelineSchedule& schedule,
-                                            const CodegenOptions& options,
-                                            Proc* proc) {
+absl::StatusOr<Block*> ProcToPipelinedBlock(
+    const PipelineSchedule& schedule, const CodegenOptions& options, Proc* proc,
+    absl::flat_hash_set<Register*>* skid_buffer_registers) {
   XLS_VLOG(3) << "Converting proc to pipelined block:";
   XLS_VLOG_LINES(3, proc->DumpIr());
 
@@ -2368,6 +2871,11 @@ absl::StatusOr<Block*> ProcToPipelinedBlock(const PipelineSchedule& schedule,
   XLS_CHECK_GE(pipelined_valids.size(), 1);
   std::vector<Node*> valid_flops(pipelined_valids.begin() + 1,
                                  pipelined_valids.end());
+  for (Node* skid_valid : streaming_io_and_pipeline.skid_valids) {
+    if (skid_valid != nullptr) {
+      valid_flops.push_back(skid_valid);
+    }
+  }
 
   if (options.flop_inputs() || options.flop_outputs()) {
     XLS_RETURN_IF_ERROR(AddInputOutputFlops(
@@ -2385,7 +2893,8 @@ absl::StatusOr<Block*> ProcToPipelinedBlock(const PipelineSchedule& schedule,
 
   // TODO(tedhong): 2021-09-23 Remove and add any missing functionality to
   //                codegen pipeline.
-  XLS_RETURN_IF_ERROR(RemoveDeadTokenNodes(block));
+  XLS_RETURN_IF_ERROR(RemoveDeadTokenNodes(
+      block, streaming_io_and_pipeline.skid_buffer_registers));
 
   XLS_VLOG(3) << "After RemoveDeadTokenNodes";
   XLS_VLOG_LINES(3, block->DumpIr());
@@ -2394,6 +2903,10 @@ absl::StatusOr<Block*> ProcToPipelinedBlock(const PipelineSchedule& schedule,
   XLS_VLOG(3) << "After UpdateChannelMetadata";
   XLS_VLOG_LINES(3, block->DumpIr());
 
+  if (skid_buffer_registers != nullptr) {
+    *skid_buffer_registers =
+        std::move(streaming_io_and_pipeline.skid_buffer_registers);
+  }
   return block;
 }
 
@@ -2482,7 +2995,8 @@ absl::StatusOr<Block*> ProcToCombinationalBlock(Proc* proc,
 
   // TODO(tedhong): 2021-09-23 Remove and add any missing functionality to
   //                codegen pipeline.
-  XLS_RETURN_IF_ERROR(RemoveDeadTokenNodes(block));
+  XLS_RETURN_IF_ERROR(
+      RemoveDeadTokenNodes(block, streaming_io.skid_buffer_registers));
   XLS_VLOG(3) << "After RemoveDeadTokenNodes";
   XLS_VLOG_LINES(3, block->DumpIr());
 
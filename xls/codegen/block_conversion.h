@@ -15,6 +15,7 @@
 #ifndef XLS_CODEGEN_BLOCK_CONVERSION_H_
 #define XLS_CODEGEN_BLOCK_CONVERSION_H_
 
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/statusor.h"
 #include "xls/codegen/codegen_options.h"
 #include "xls/ir/block.h"
@@ -39,10 +40,11 @@ absl::StatusOr<Block*> FunctionToPipelinedBlock(
 
 // Converts a proc to a pipelined (stateless) block. The pipeline is
 // constructed using the given schedule. Registers are inserted between each
-// stage.
-absl::StatusOr<Block*> ProcToPipelinedBlock(const PipelineSchedule& schedule,
-                                            const CodegenOptions& options,
-                                            Proc* proc);
+// stage. If `skid_buffer_registers` is given, it is set to the registers of the
+// block which make up skid buffers (see CodegenPassUnit).
+absl::StatusOr<Block*> ProcToPipelinedBlock(
+    const PipelineSchedule& schedule, const CodegenOptions& options, Proc* proc,
+    absl::flat_hash_set<Register*>* skid_buffer_registers = nullptr);
 
 // Converts a function into a block of the given name (the function name is
 // ignored). Function arguments become input ports, function return value
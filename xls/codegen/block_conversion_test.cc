@@ -28,6 +28,7 @@
 #include "xls/ir/function_builder.h"
 #include "xls/ir/ir_matcher.h"
 #include "xls/ir/ir_test_base.h"
+#include "xls/ir/node_iterator.h"
 #include "xls/ir/verifier.h"
 #include "xls/scheduling/pipeline_schedule.h"
 
@@ -2653,6 +2654,220 @@ INSTANTIATE_TEST_SUITE_P(
                         CodegenOptions::IOKind::kZeroLatencyBuffer)),
     MultiIOWithStatePipelinedProcTestSweepFixture::PrintToStringParamName);
 
+// Proc with I/O scheduled in stages other than the first and last, and with
+// the next state computed before the final stage:
+//
+//   in0 is received in stage 0, in1 in stage 1.
+//   next_state = st + in0 is computed and sent on out0 in stage
+//     next_state_stage.
+//   st + in1 is sent on out1 in the final stage.
+class MidStageIOPipelinedProcTest : public ProcConversionTestFixture {
+ protected:
+  absl::StatusOr<std::unique_ptr<Package>> BuildBlockInPackage(
+      int64_t stage_count, const CodegenOptions& options) override {
+    return BuildBlockInPackage(stage_count, /*next_state_stage=*/0, options);
+  }
+
+  absl::StatusOr<std::unique_ptr<Package>> BuildBlockInPackage(
+      int64_t stage_count, int64_t next_state_stage,
+      const CodegenOptions& options) {
+    auto package_ptr = std::make_unique<Package>(TestName());
+    Package& package = *package_ptr;
+
+    Type* u32 = package.GetBitsType(32);
+    XLS_ASSIGN_OR_RETURN(
+        Channel * ch_in0,
+        package.CreateStreamingChannel("in0", ChannelOps::kReceiveOnly, u32));
+    XLS_ASSIGN_OR_RETURN(
+        Channel * ch_in1,
+        package.CreateStreamingChannel("in1", ChannelOps::kReceiveOnly, u32));
+    XLS_ASSIGN_OR_RETURN(
+        Channel * ch_out0,
+        package.CreateStreamingChannel("out0", ChannelOps::kSendOnly, u32));
+    XLS_ASSIGN_OR_RETURN(
+        Channel * ch_out1,
+        package.CreateStreamingChannel("out1", ChannelOps::kSendOnly, u32));
+
+    TokenlessProcBuilder pb(TestName(), /*init_value=*/Value(UBits(0, 32)),
+                            /*token_name=*/"tkn", /*state_name=*/"st",
+                            &package);
+
+    BValue in0_val = pb.Receive(ch_in0);
+    BValue in1_val = pb.Receive(ch_in1);
+    BValue state = pb.GetStateParam();
+    BValue next_state = pb.Add(state, in0_val);
+    BValue send0 = pb.Send(ch_out0, next_state);
+    BValue send1 = pb.Send(ch_out1, pb.Add(state, in1_val));
+
+    XLS_ASSIGN_OR_RETURN(Proc * proc, pb.Build(next_state));
+
+    // Place every node as early as its operands and the pinned nodes allow.
+    absl::flat_hash_map<Node*, int64_t> pinned = {
+        {in1_val.node()->operand(0), 1},
+        {next_state.node(), next_state_stage},
+        {send0.node(), next_state_stage},
+        {send1.node(), stage_count - 1},
+    };
+    ScheduleCycleMap cycle_map;
+    for (Node* node : TopoSort(proc)) {
+      int64_t cycle = pinned.contains(node) ? pinned.at(node) : 0;
+      for (Node* operand : node->operands()) {
+        cycle = std::max(cycle, cycle_map.at(operand));
+      }
+      cycle_map[node] = cycle;
+    }
+    XLS_RET_CHECK_EQ(cycle_map.at(next_state.node()), next_state_stage);
+    PipelineSchedule schedule(proc, cycle_map, stage_count);
+    XLS_VLOG_LINES(2, schedule.ToString());
+
+    CodegenOptions codegen_options = options;
+    codegen_options.module_name(kBlockName);
+
+    XLS_RET_CHECK_OK(ProcToPipelinedBlock(schedule, codegen_options, proc));
+
+    return package_ptr;
+  }
+};
+
+// Fixture to sweep MidStageIOPipelinedProcTest
+//
+// Sweep parameters are (stage_count, next_state_stage, flop_inputs,
+// flop_outputs, flop_inputs_kind, flop_outputs_kind, elastic_pipeline).
+class MidStageIOPipelinedProcTestSweepFixture
+    : public MidStageIOPipelinedProcTest,
+      public testing::WithParamInterface<
+          std::tuple<int64_t, int64_t, bool, bool, CodegenOptions::IOKind,
+                     CodegenOptions::IOKind, bool>> {
+ public:
+  static std::string PrintToStringParamName(
+      const testing::TestParamInfo<ParamType>& info) {
+    return absl::StrFormat(
+        "stage_count_%d_next_state_stage_%d_flop_inputs_%d_flop_outputs_%d_"
+        "flop_inputs_kind_%s_flop_outputs_kind_%s_elastic_pipeline_%d",
+        std::get<0>(info.param), std::get<1>(info.param),
+        std::get<2>(info.param), std::get<3>(info.param),
+        CodegenOptions::IOKindToString(std::get<4>(info.param)),
+        CodegenOptions::IOKindToString(std::get<5>(info.param)),
+        std::get<6>(info.param));
+  }
+};
+
+TEST_P(MidStageIOPipelinedProcTestSweepFixture, RandomStalling) {
+  int64_t stage_count = std::get<0>(GetParam());
+  int64_t next_state_stage = std::get<1>(GetParam());
+  bool active_low_reset = true;
+
+  CodegenOptions options;
+  options.flop_inputs(std::get<2>(GetParam()))
+      .flop_outputs(std::get<3>(GetParam()))
+      .clock_name("clk");
+  options.flop_inputs_kind(std::get<4>(GetParam()));
+  options.flop_outputs_kind(std::get<5>(GetParam()));
+  options.elastic_pipeline(std::get<6>(GetParam()));
+  options.add_idle_output(true);
+  options.valid_control("input_valid", "output_valid");
+  options.reset("rst_n", false, /*active_low=*/active_low_reset, false);
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<Package> package,
+      BuildBlockInPackage(stage_count, next_state_stage, options));
+  XLS_ASSERT_OK_AND_ASSIGN(Block * block, package->GetBlock(kBlockName));
+
+  XLS_VLOG(2) << "Mid-stage io pipelined block";
+  XLS_VLOG_LINES(2, block->DumpIr());
+
+  const char* reset_signal = "rst_n";
+  int64_t simulation_cycle_count = 10000;
+
+  std::vector<absl::flat_hash_map<std::string, uint64_t>> non_streaming_inputs;
+  XLS_ASSERT_OK(
+      SetSignalsOverCycles(0, 9, {{reset_signal, 0}}, non_streaming_inputs));
+  XLS_ASSERT_OK(SetSignalsOverCycles(10, simulation_cycle_count - 1,
+                                     {{reset_signal, 1}},
+                                     non_streaming_inputs));
+
+  std::vector<uint64_t> in0_values(simulation_cycle_count);
+  std::iota(in0_values.begin(), in0_values.end(), 0);
+  std::vector<uint64_t> in1_values(simulation_cycle_count);
+  std::iota(in1_values.begin(), in1_values.end(), 1000);
+
+  std::vector<ChannelSource> sources{
+      ChannelSource("in0", "in0_vld", "in0_rdy", 0.5, block),
+      ChannelSource("in1", "in1_vld", "in1_rdy", 0.5, block),
+  };
+  XLS_ASSERT_OK(sources.at(0).SetDataSequence(in0_values));
+  XLS_ASSERT_OK(sources.at(1).SetDataSequence(in1_values));
+
+  std::vector<ChannelSink> sinks{
+      ChannelSink("out0", "out0_vld", "out0_rdy", 0.5, block),
+      ChannelSink("out1", "out1_vld", "out1_rdy", 0.5, block),
+  };
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      BlockIoResultsAsUint64 io_results,
+      InterpretChannelizedSequentialBlock(block, absl::MakeSpan(sources),
+                                          absl::MakeSpan(sinks),
+                                          non_streaming_inputs));
+
+  auto get_sequence = [&](absl::string_view name, SignalType data_type,
+                          SignalType ready_type)
+      -> absl::StatusOr<std::vector<CycleAndValue>> {
+    SignalType valid_type =
+        data_type == SignalType::kInput ? SignalType::kInput
+                                        : SignalType::kOutput;
+    return GetChannelSequenceFromIO(
+        {std::string(name), data_type},
+        {absl::StrCat(name, "_vld"), valid_type},
+        {absl::StrCat(name, "_rdy"), ready_type},
+        {reset_signal, SignalType::kInput, active_low_reset},
+        io_results.inputs, io_results.outputs);
+  };
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::vector<CycleAndValue> input0_sequence,
+      get_sequence("in0", SignalType::kInput, SignalType::kOutput));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::vector<CycleAndValue> input1_sequence,
+      get_sequence("in1", SignalType::kInput, SignalType::kOutput));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::vector<CycleAndValue> output0_sequence,
+      get_sequence("out0", SignalType::kOutput, SignalType::kInput));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::vector<CycleAndValue> output1_sequence,
+      get_sequence("out1", SignalType::kOutput, SignalType::kInput));
+
+  EXPECT_GT(output0_sequence.size(), 1000);
+  EXPECT_GT(output1_sequence.size(), 1000);
+
+  // Every activation consumes one value from each input, so the values of the
+  // outputs are determined by the order of the inputs alone.
+  int64_t output_count =
+      std::min(output0_sequence.size(), output1_sequence.size());
+  ASSERT_LE(output_count, input0_sequence.size());
+  ASSERT_LE(output_count, input1_sequence.size());
+  uint64_t prior_state = 0;
+  for (int64_t i = 0; i < output_count; ++i) {
+    uint64_t expected0 = prior_state + input0_sequence.at(i).value;
+    uint64_t expected1 = prior_state + input1_sequence.at(i).value;
+    EXPECT_EQ(output0_sequence.at(i).value, expected0) << "index " << i;
+    EXPECT_EQ(output1_sequence.at(i).value, expected1) << "index " << i;
+    prior_state = expected0;
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    MidStageIOPipelinedProcTestSweep, MidStageIOPipelinedProcTestSweepFixture,
+    testing::Combine(
+        testing::Values(2, 3), testing::Values(0, 1),
+        testing::Values(false, true), testing::Values(false, true),
+        testing::Values(CodegenOptions::IOKind::kFlop,
+                        CodegenOptions::IOKind::kSkidBuffer,
+                        CodegenOptions::IOKind::kZeroLatencyBuffer),
+        testing::Values(CodegenOptions::IOKind::kFlop,
+                        CodegenOptions::IOKind::kSkidBuffer,
+                        CodegenOptions::IOKind::kZeroLatencyBuffer),
+        testing::Values(false, true)),
+    MidStageIOPipelinedProcTestSweepFixture::PrintToStringParamName);
+
 TEST_F(BlockConversionTest, IOSignatureProcToPipelinedBLock) {
   Package package(TestName());
   Type* u32 = package.GetBitsType(32);
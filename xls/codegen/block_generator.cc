@@ -15,6 +15,7 @@
 #include "xls/codegen/block_generator.h"
 
 #include <deque>
+#include <sstream>
 
 #include "absl/status/status.h"
 #include "xls/codegen/block_conversion.h"
@@ -709,9 +710,9 @@ absl::StatusOr<std::vector<Block*>> GatherInstantiatedBlocks(Block* top) {
 
 }  // namespace
 
-absl::StatusOr<std::string> GenerateVerilog(Block* top,
-                                            const CodegenOptions& options,
-                                            VerilogLineMap* verilog_line_map) {
+absl::Status GenerateVerilog(Block* top, const CodegenOptions& options,
+                             std::ostream& os,
+                             VerilogLineMap* verilog_line_map) {
   XLS_VLOG(2) << absl::StreamFormat(
       "Generating Verilog for packge with with top level block `%s`:",
       top->name());
@@ -729,7 +730,7 @@ absl::StatusOr<std::string> GenerateVerilog(Block* top,
   }
 
   LineInfo line_info;
-  std::string text = file.Emit(&line_info);
+  file.Emit(os, &line_info);
   if (verilog_line_map != nullptr) {
     for (const auto& [vast_node, partial_spans] : line_info.Spans()) {
       std::optional<std::vector<LineSpan>> spans =
@@ -754,6 +755,19 @@ absl::StatusOr<std::string> GenerateVerilog(Block* top,
     }
   }
 
+  if (!os) {
+    return absl::InternalError("Failed to write Verilog output stream");
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::string> GenerateVerilog(Block* top,
+                                            const CodegenOptions& options,
+                                            VerilogLineMap* verilog_line_map) {
+  std::ostringstream os;
+  XLS_RETURN_IF_ERROR(GenerateVerilog(top, options, os, verilog_line_map));
+  std::string text = os.str();
+
   XLS_VLOG(2) << "Verilog output:";
   XLS_VLOG_LINES(2, text);
 
@@ -15,6 +15,10 @@
 #ifndef XLS_CODEGEN_BLOCK_GENERATOR_H_
 #define XLS_CODEGEN_BLOCK_GENERATOR_H_
 
+#include <ostream>
+#include <string>
+
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "xls/codegen/codegen_options.h"
 #include "xls/codegen/vast.h"
@@ -31,6 +35,13 @@ absl::StatusOr<std::string> GenerateVerilog(
     Block* top, const CodegenOptions& options,
     VerilogLineMap* verilog_line_map = nullptr);
 
+// As above, but writes the text to the given stream as it is emitted rather
+// than building it in memory. Modules are written one top-level item at a
+// time, so the peak memory use does not grow with the size of the output.
+absl::Status GenerateVerilog(Block* top, const CodegenOptions& options,
+                             std::ostream& os,
+                             VerilogLineMap* verilog_line_map = nullptr);
+
 }  // namespace verilog
 }  // namespace xls
 
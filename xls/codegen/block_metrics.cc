@@ -33,6 +33,19 @@ int64_t GenerateFlopCount(Block* block) {
   return count;
 }
 
+int64_t GenerateSkidBufferFlopCount(
+    Block* block, const absl::flat_hash_set<Register*>& skid_buffer_registers) {
+  int64_t count = 0;
+
+  for (Register* reg : block->GetRegisters()) {
+    if (skid_buffer_registers.contains(reg)) {
+      count += reg->type()->GetFlatBitCount();
+    }
+  }
+
+  return count;
+}
+
 // Returns true if there is a combinational feedthrough path from an input port
 // to an output port.
 bool HasFeedthroughPass(Block* block) {
@@ -324,9 +337,12 @@ absl::Status GenerateBom(Block* block, BlockMetricsProto* proto) {
 }  // namespace
 
 absl::StatusOr<BlockMetricsProto> GenerateBlockMetrics(
-    Block* block, std::optional<const DelayEstimator*> delay_estimator) {
+    Block* block, std::optional<const DelayEstimator*> delay_estimator,
+    const absl::flat_hash_set<Register*>& skid_buffer_registers) {
   BlockMetricsProto proto;
   proto.set_flop_count(GenerateFlopCount(block));
+  proto.set_skid_buffer_flop_count(
+      GenerateSkidBufferFlopCount(block, skid_buffer_registers));
   proto.set_feedthrough_path_exists(HasFeedthroughPass(block));
 
   if (delay_estimator.has_value()) {
@@ -15,6 +15,7 @@
 #ifndef XLS_CODEGEN_BLOCK_METRICS_GENERATOR_H_
 #define XLS_CODEGEN_BLOCK_METRICS_GENERATOR_H_
 
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/statusor.h"
 #include "xls/codegen/xls_metrics.pb.h"
 #include "xls/delay_model/delay_estimator.h"
@@ -23,12 +24,14 @@
 namespace xls::verilog {
 
 // Collects and generate metrics related to the contents of the block.
-// (ex. flop count, number of operations, etc...).
+// (ex. flop count, number of operations, etc...). The flops of
+// `skid_buffer_registers` are also counted separately.
 //
 // TODO(tedhong): 2022-01-28 Add a class around the proto.
 absl::StatusOr<BlockMetricsProto> GenerateBlockMetrics(
     Block* block,
-    std::optional<const DelayEstimator*> delay_estimator = std::nullopt);
+    std::optional<const DelayEstimator*> delay_estimator = std::nullopt,
+    const absl::flat_hash_set<Register*>& skid_buffer_registers = {});
 
 }  // namespace xls::verilog
 
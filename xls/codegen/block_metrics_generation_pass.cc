@@ -14,6 +14,8 @@
 
 #include "xls/codegen/block_metrics_generation_pass.h"
 
+#include <optional>
+
 #include "absl/strings/str_format.h"
 #include "xls/codegen/block_metrics.h"
 #include "xls/common/status/status_macros.h"
@@ -31,7 +33,12 @@ absl::StatusOr<bool> BlockMetricsGenerationPass::RunInternal(
   }
 
   XLS_ASSIGN_OR_RETURN(BlockMetricsProto block_metrics,
-                       GenerateBlockMetrics(unit->block));
+                       GenerateBlockMetrics(unit->block, std::nullopt,
+                                            unit->skid_buffer_registers));
+  if (unit->signature->proto().has_pipeline()) {
+    block_metrics.set_initiation_interval(
+        unit->signature->proto().pipeline().initiation_interval());
+  }
   XLS_RETURN_IF_ERROR(unit->signature->ReplaceBlockMetrics(block_metrics));
 
   return true;
@@ -15,6 +15,7 @@
 #include "xls/codegen/block_metrics.h"
 
 #include "gtest/gtest.h"
+#include "absl/container/flat_hash_set.h"
 #include "xls/codegen/block_conversion.h"
 #include "xls/codegen/codegen_options.h"
 #include "xls/codegen/xls_metrics.pb.h"
@@ -81,6 +82,31 @@ TEST(BlockMetricsGeneratorTest, PipelineRegisters) {
   EXPECT_EQ(proto.flop_count(), 64);
 }
 
+TEST(BlockMetricsGeneratorTest, SkidBufferRegistersAreGivenNotNamed) {
+  Package package("test");
+
+  Type* u32 = package.GetBitsType(32);
+  BlockBuilder bb("test_block", &package);
+  XLS_ASSERT_OK(bb.block()->AddClockPort("clk"));
+  BValue a = bb.InputPort("a", u32);
+  // A user value which merely happens to be named like a skid register.
+  BValue p0_a = bb.InsertRegister("p0_a_skid", a);
+  BValue p1_a = bb.InsertRegister("p1_a", p0_a);
+  bb.OutputPort("z", p1_a);
+  XLS_ASSERT_OK_AND_ASSIGN(Block * block, bb.Build());
+
+  XLS_ASSERT_OK_AND_ASSIGN(BlockMetricsProto proto,
+                           GenerateBlockMetrics(block));
+  EXPECT_EQ(proto.flop_count(), 64);
+  EXPECT_EQ(proto.skid_buffer_flop_count(), 0);
+
+  XLS_ASSERT_OK_AND_ASSIGN(Register * p1_reg, block->GetRegister("p1_a"));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      proto, GenerateBlockMetrics(block, std::nullopt,
+                                  /*skid_buffer_registers=*/{p1_reg}));
+  EXPECT_EQ(proto.skid_buffer_flop_count(), 32);
+}
+
 TEST(BlockMetricsGeneratorTest, PipelineRegistersCount) {
   Package package("test");
 
@@ -426,6 +452,65 @@ TEST(BlockMetricsGeneratorTest, DelayMetrics) {
   }
 }
 
+TEST(BlockMetricsGeneratorTest, ElasticPipeline) {
+  XLS_ASSERT_OK_AND_ASSIGN(DelayEstimator * delay_estimator,
+                           GetDelayEstimator("unit"));
+
+  // Returns the metrics of an eight stage pipelined proc with the given
+  // flow control.
+  auto generate_metrics =
+      [&](bool elastic_pipeline) -> absl::StatusOr<BlockMetricsProto> {
+    Package package("test");
+    Type* u32 = package.GetBitsType(32);
+    XLS_ASSIGN_OR_RETURN(
+        Channel * in_ch,
+        package.CreateStreamingChannel("in", ChannelOps::kReceiveOnly, u32));
+    XLS_ASSIGN_OR_RETURN(
+        Channel * out_ch,
+        package.CreateStreamingChannel("out", ChannelOps::kSendOnly, u32));
+    TokenlessProcBuilder pb("test_proc", /*init_value=*/Value::Tuple({}),
+                            /*token_name=*/"tkn", /*state_name=*/"st",
+                            &package);
+    BValue x = pb.Receive(in_ch);
+    for (int64_t i = 0; i < 8; ++i) {
+      x = pb.Add(x, pb.Literal(UBits(i, 32)));
+    }
+    pb.Send(out_ch, x);
+    XLS_ASSIGN_OR_RETURN(Proc * proc, pb.Build(pb.GetStateParam()));
+
+    XLS_ASSIGN_OR_RETURN(
+        PipelineSchedule schedule,
+        PipelineSchedule::Run(proc, *delay_estimator,
+                              SchedulingOptions().pipeline_stages(8)));
+    absl::flat_hash_set<Register*> skid_buffer_registers;
+    XLS_ASSIGN_OR_RETURN(
+        Block * block,
+        ProcToPipelinedBlock(schedule,
+                             CodegenOptions()
+                                 .flop_inputs(false)
+                                 .flop_outputs(false)
+                                 .clock_name("clk")
+                                 .reset("rst", false, false, false)
+                                 .elastic_pipeline(elastic_pipeline),
+                             proc, &skid_buffer_registers));
+    return GenerateBlockMetrics(block, delay_estimator, skid_buffer_registers);
+  };
+
+  XLS_ASSERT_OK_AND_ASSIGN(BlockMetricsProto bubble, generate_metrics(false));
+  XLS_ASSERT_OK_AND_ASSIGN(BlockMetricsProto elastic, generate_metrics(true));
+
+  EXPECT_EQ(bubble.skid_buffer_flop_count(), 0);
+  EXPECT_GT(elastic.skid_buffer_flop_count(), 0);
+  EXPECT_EQ(elastic.flop_count(),
+            bubble.flop_count() + elastic.skid_buffer_flop_count());
+
+  // The ready signal of the output passes through every stage of the bubble
+  // pipeline before reaching the registers of the first stage, but only
+  // through the final stage of the elastic pipeline.
+  EXPECT_LT(elastic.max_input_to_reg_delay_ps(),
+            bubble.max_input_to_reg_delay_ps());
+}
+
 }  // namespace
 }  // namespace verilog
 }  // namespace xls
@@ -21,6 +21,11 @@ namespace xls::verilog {
 absl::Status CodegenChecker::Run(CodegenPassUnit* unit,
                                  const CodegenPassOptions& options,
                                  PassResults* results) const {
+  // While blocks of the package are being generated concurrently only the
+  // block of this unit may be inspected.
+  if (unit->package->IsConcurrentlyModified()) {
+    return VerifyBlock(unit->block);
+  }
   return VerifyPackage(unit->package);
 }
 
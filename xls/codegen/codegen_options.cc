@@ -115,6 +115,16 @@ CodegenOptions& CodegenOptions::flop_single_value_channels(bool value) {
   return *this;
 }
 
+CodegenOptions& CodegenOptions::elastic_pipeline(bool value) {
+  elastic_pipeline_ = value;
+  return *this;
+}
+
+CodegenOptions& CodegenOptions::retime_registers(bool value) {
+  retime_registers_ = value;
+  return *this;
+}
+
 CodegenOptions& CodegenOptions::split_outputs(bool value) {
   split_outputs_ = value;
   return *this;
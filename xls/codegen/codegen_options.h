@@ -139,6 +139,21 @@ class CodegenOptions {
     return flop_single_value_channels_;
   }
 
+  // Whether to pair each pipeline register of a pipelined proc with a skid
+  // buffer. Each stage then accepts a new activation based on the state of a
+  // register rather than on the readiness of the stages after it, which breaks
+  // the combinational path of the stall signal through the pipeline at the
+  // cost of doubling the number of pipeline registers.
+  CodegenOptions& elastic_pipeline(bool value);
+  bool elastic_pipeline() const { return elastic_pipeline_; }
+
+  // Whether to retime registers across logic which has no delay (bit slices,
+  // concats with constants, extensions) and to merge registers holding the
+  // same value, in order to reduce the number of flops. See
+  // RegisterRetimingPass.
+  CodegenOptions& retime_registers(bool value);
+  bool retime_registers() const { return retime_registers_; }
+
   // If the output is tuple-typed, generate an output port for each element of
   // the output tuple.
   CodegenOptions& split_outputs(bool value);
@@ -257,6 +272,8 @@ class CodegenOptions {
   bool split_outputs_ = false;
   bool add_idle_output_ = false;
   bool flop_single_value_channels_ = false;
+  bool elastic_pipeline_ = false;
+  bool retime_registers_ = false;
   absl::optional<std::string> assert_format_;
   absl::optional<std::string> gate_format_;
   bool emit_as_pipeline_ = false;
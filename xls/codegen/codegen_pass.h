@@ -15,9 +15,11 @@
 #ifndef XLS_CODEGEN_CODEGEN_PASS_H_
 #define XLS_CODEGEN_CODEGEN_PASS_H_
 
+#include "absl/container/flat_hash_set.h"
 #include "absl/types/optional.h"
 #include "xls/codegen/codegen_options.h"
 #include "xls/codegen/module_signature.h"
+#include "xls/delay_model/delay_estimator.h"
 #include "xls/ir/block.h"
 #include "xls/ir/package.h"
 #include "xls/passes/pass_base.h"
@@ -36,6 +38,10 @@ struct CodegenPassOptions : public PassOptions {
   // Optional schedule. If given, a feedforward pipeline is generated based on
   // the schedule.
   absl::optional<PipelineSchedule> schedule;
+
+  // Optional delay estimator. If given, passes which move logic across
+  // registers only move operations with zero estimated delay.
+  const DelayEstimator* delay_estimator = nullptr;
 };
 
 // Data structure operated on by codegen passes. Contains the IR and associated
@@ -57,6 +63,12 @@ struct CodegenPassUnit {
   // out-of-sync with the IR.
   absl::optional<ModuleSignature> signature;
 
+  // Registers of the block which make up skid buffers, added by block
+  // conversion for elastic pipelines and skid-buffered I/O. Their cost is
+  // reported separately in the block metrics. Passes which remove or replace
+  // registers keep this up to date.
+  absl::flat_hash_set<Register*> skid_buffer_registers;
+
   // These methods are required by CompoundPassBase.
   std::string DumpIr() const;
   const std::string& name() const { return block->name(); }
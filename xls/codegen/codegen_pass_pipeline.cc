@@ -22,6 +22,7 @@
 #include "xls/codegen/codegen_wrapper_pass.h"
 #include "xls/codegen/port_legalization_pass.h"
 #include "xls/codegen/register_legalization_pass.h"
+#include "xls/codegen/register_retiming_pass.h"
 #include "xls/codegen/signature_generation_pass.h"
 #include "xls/passes/dce_pass.h"
 
@@ -49,6 +50,9 @@ std::unique_ptr<CodegenCompoundPass> CreateCodegenPassPipeline() {
   // Remove zero-width registers.
   top->Add<RegisterLegalizationPass>();
 
+  // Optionally reduce the number of flops by retiming and merging registers.
+  top->Add<RegisterRetimingPass>();
+
   // Final dead-code elimination pass to remove cruft left from earlier passes.
   top->Add<CodegenWrapperPass>(std::make_unique<DeadCodeEliminationPass>());
 
@@ -14,6 +14,8 @@
 
 #include "xls/codegen/combinational_generator.h"
 
+#include <sstream>
+
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -64,6 +66,16 @@ absl::StatusOr<ModuleGeneratorResult> GenerateCombinationalModule(
 
 absl::StatusOr<ModuleGeneratorResult> GenerateCombinationalModule(
     FunctionBase* module, const CodegenOptions& options) {
+  std::ostringstream os;
+  XLS_ASSIGN_OR_RETURN(ModuleGeneratorResult result,
+                       GenerateCombinationalModule(module, options, os));
+  result.verilog_text = os.str();
+  return result;
+}
+
+absl::StatusOr<ModuleGeneratorResult> GenerateCombinationalModule(
+    FunctionBase* module, const CodegenOptions& options,
+    std::ostream& verilog_stream) {
   std::string module_name(
       options.module_name().value_or(SanitizeIdentifier(module->name())));
 
@@ -91,11 +103,10 @@ absl::StatusOr<ModuleGeneratorResult> GenerateCombinationalModule(
                           .status());
   XLS_RET_CHECK(unit.signature.has_value());
   VerilogLineMap verilog_line_map;
-  XLS_ASSIGN_OR_RETURN(std::string verilog,
-                       GenerateVerilog(block, options, &verilog_line_map));
+  XLS_RETURN_IF_ERROR(
+      GenerateVerilog(block, options, verilog_stream, &verilog_line_map));
 
-  return ModuleGeneratorResult{verilog, verilog_line_map,
-                               unit.signature.value()};
+  return ModuleGeneratorResult{"", verilog_line_map, unit.signature.value()};
 }
 
 }  // namespace verilog
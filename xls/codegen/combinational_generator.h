@@ -15,6 +15,7 @@
 #ifndef XLS_CODEGEN_COMBINATIONAL_GENERATOR_H_
 #define XLS_CODEGEN_COMBINATIONAL_GENERATOR_H_
 
+#include <ostream>
 #include <string>
 
 #include "absl/container/flat_hash_map.h"
@@ -44,6 +45,12 @@ absl::StatusOr<ModuleGeneratorResult> GenerateCombinationalModule(
 absl::StatusOr<ModuleGeneratorResult> GenerateCombinationalModule(
     FunctionBase* module, const CodegenOptions& options);
 
+// As above, but the Verilog text is written to `verilog_stream` as it is
+// emitted and the verilog_text field of the returned result is left empty.
+absl::StatusOr<ModuleGeneratorResult> GenerateCombinationalModule(
+    FunctionBase* module, const CodegenOptions& options,
+    std::ostream& verilog_stream);
+
 }  // namespace verilog
 }  // namespace xls
 
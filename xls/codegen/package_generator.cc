@@ -0,0 +1,210 @@
+// Copyright 2022 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/codegen/package_generator.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+#include "absl/cleanup/cleanup.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "xls/codegen/block_conversion.h"
+#include "xls/codegen/block_generator.h"
+#include "xls/codegen/codegen_pass.h"
+#include "xls/codegen/codegen_pass_pipeline.h"
+#include "xls/codegen/vast.h"
+#include "xls/codegen/verilog_line_map.pb.h"
+#include "xls/codegen/xls_metrics.pb.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/common/thread_pool.h"
+#include "xls/ir/function.h"
+#include "xls/ir/proc.h"
+
+namespace xls {
+namespace verilog {
+namespace {
+
+// Adds the metrics of a single block to the aggregate metrics `total`.
+void AccumulateBlockMetrics(const BlockMetricsProto& metrics,
+                            BlockMetricsProto* total) {
+  total->set_flop_count(total->flop_count() + metrics.flop_count());
+  total->set_skid_buffer_flop_count(total->skid_buffer_flop_count() +
+                                    metrics.skid_buffer_flop_count());
+  total->set_feedthrough_path_exists(total->feedthrough_path_exists() ||
+                                     metrics.feedthrough_path_exists());
+  if (metrics.has_delay_model()) {
+    total->set_delay_model(metrics.delay_model());
+  }
+  if (metrics.has_max_reg_to_reg_delay_ps()) {
+    total->set_max_reg_to_reg_delay_ps(std::max(
+        total->max_reg_to_reg_delay_ps(), metrics.max_reg_to_reg_delay_ps()));
+  }
+  if (metrics.has_max_input_to_reg_delay_ps()) {
+    total->set_max_input_to_reg_delay_ps(
+        std::max(total->max_input_to_reg_delay_ps(),
+                 metrics.max_input_to_reg_delay_ps()));
+  }
+  if (metrics.has_max_reg_to_output_delay_ps()) {
+    total->set_max_reg_to_output_delay_ps(
+        std::max(total->max_reg_to_output_delay_ps(),
+                 metrics.max_reg_to_output_delay_ps()));
+  }
+  if (metrics.has_max_feedthrough_path_delay_ps()) {
+    total->set_max_feedthrough_path_delay_ps(
+        std::max(total->max_feedthrough_path_delay_ps(),
+                 metrics.max_feedthrough_path_delay_ps()));
+  }
+}
+
+// Converts the given function or proc to a block. Sets the options with which
+// the codegen passes should be run on the block in `pass_options`. The delay
+// estimator (if any) is passed on to the codegen passes. The registers of the
+// block which make up skid buffers are stored in `skid_buffer_registers`.
+absl::StatusOr<Block*> ConvertToBlock(
+    FunctionBase* f, const absl::optional<PipelineSchedule>& schedule,
+    const CodegenOptions& options, const DelayEstimator* delay_estimator,
+    CodegenPassOptions* pass_options,
+    absl::flat_hash_set<Register*>* skid_buffer_registers) {
+  pass_options->codegen_options = options;
+  pass_options->delay_estimator = delay_estimator;
+  if (schedule.has_value()) {
+    pass_options->schedule = schedule;
+    if (f->IsFunction()) {
+      return FunctionToPipelinedBlock(schedule.value(), options,
+                                      f->AsFunctionOrDie());
+    }
+    // As in ToPipelineModuleText, procs are not emitted with the pipeline
+    // pretty-printer.
+    pass_options->codegen_options.emit_as_pipeline(false);
+    return ProcToPipelinedBlock(schedule.value(), options, f->AsProcOrDie(),
+                                skid_buffer_registers);
+  }
+
+  std::string module_name(
+      options.module_name().value_or(SanitizeIdentifier(f->name())));
+  if (f->IsFunction()) {
+    return FunctionToCombinationalBlock(f->AsFunctionOrDie(), module_name);
+  }
+  return ProcToCombinationalBlock(f->AsProcOrDie(), module_name, options);
+}
+
+}  // namespace
+
+absl::StatusOr<PackageGeneratorResult> GeneratePackageModules(
+    Package* package, const PackageGeneratorOptions& options) {
+  std::vector<FunctionBase*> function_bases;
+  for (FunctionBase* f : package->GetFunctionBases()) {
+    if (f->IsFunction() || f->IsProc()) {
+      function_bases.push_back(f);
+    }
+  }
+  if (options.codegen_options.module_name().has_value() &&
+      function_bases.size() > 1) {
+    return absl::InvalidArgumentError(
+        "A module name cannot be specified when generating modules for "
+        "multiple functions and procs.");
+  }
+  XLS_RET_CHECK(!options.scheduling_options.has_value() ||
+                options.delay_estimator != nullptr);
+  int64_t count = function_bases.size();
+
+  // Scheduling only reads the IR so all of the functions and procs can be
+  // scheduled concurrently.
+  std::vector<absl::optional<PipelineSchedule>> schedules(count);
+  if (options.scheduling_options.has_value()) {
+    XLS_RETURN_IF_ERROR(ParallelFor(
+        count, options.thread_count, [&](int64_t i) -> absl::Status {
+          XLS_VLOG(2) << "Scheduling " << function_bases[i]->name();
+          XLS_ASSIGN_OR_RETURN(
+              schedules[i],
+              PipelineSchedule::Run(function_bases[i], *options.delay_estimator,
+                                    options.scheduling_options.value()));
+          return absl::OkStatus();
+        }));
+  }
+
+  // Block conversion adds blocks to the package so it is done sequentially.
+  std::vector<FunctionBase*> blocks;
+  std::vector<CodegenPassOptions> pass_options(count);
+  std::vector<absl::flat_hash_set<Register*>> skid_buffer_registers(count);
+  for (int64_t i = 0; i < count; ++i) {
+    XLS_ASSIGN_OR_RETURN(
+        Block * block,
+        ConvertToBlock(function_bases[i], schedules[i], options.codegen_options,
+                       options.delay_estimator, &pass_options[i],
+                       &skid_buffer_registers[i]));
+    blocks.push_back(block);
+  }
+
+  // The codegen passes only modify the block they are run on.
+  std::vector<CodegenPassUnit> units;
+  units.reserve(count);
+  for (int64_t i = 0; i < count; ++i) {
+    units.emplace_back(package, blocks[i]->AsBlockOrDie());
+    units.back().skid_buffer_registers = std::move(skid_buffer_registers[i]);
+  }
+  {
+    package->BeginConcurrentModification(blocks);
+    auto end_modification =
+        absl::MakeCleanup([package] { package->EndConcurrentModification(); });
+    XLS_RETURN_IF_ERROR(ParallelFor(
+        count, options.thread_count, [&](int64_t i) -> absl::Status {
+          PassResults results;
+          XLS_RETURN_IF_ERROR(CreateCodegenPassPipeline()
+                                  ->Run(&units[i], pass_options[i], &results)
+                                  .status());
+          XLS_RET_CHECK(units[i].signature.has_value());
+          return absl::OkStatus();
+        }));
+  }
+
+  // Verilog is emitted after the final node ids have been assigned because
+  // the names of unnamed nodes are derived from their ids.
+  std::vector<std::string> verilog(count);
+  std::vector<VerilogLineMap> line_maps(count);
+  XLS_RETURN_IF_ERROR(ParallelFor(
+      count, options.thread_count, [&](int64_t i) -> absl::Status {
+        XLS_ASSIGN_OR_RETURN(verilog[i],
+                             GenerateVerilog(units[i].block,
+                                             pass_options[i].codegen_options,
+                                             &line_maps[i]));
+        return absl::OkStatus();
+      }));
+
+  PackageGeneratorResult result;
+  BlockMetricsProto total_metrics;
+  for (int64_t i = 0; i < count; ++i) {
+    const ModuleSignature& signature = units[i].signature.value();
+    *result.signature.add_module_signatures() = signature.proto();
+    if (signature.proto().metrics().has_block_metrics()) {
+      AccumulateBlockMetrics(signature.proto().metrics().block_metrics(),
+                             &total_metrics);
+    }
+    result.modules.push_back(PackageModule{
+        function_bases[i], units[i].block, std::move(schedules[i]),
+        ModuleGeneratorResult{std::move(verilog[i]), std::move(line_maps[i]),
+                              signature}});
+  }
+  *result.signature.mutable_metrics()->mutable_block_metrics() =
+      std::move(total_metrics);
+  return result;
+}
+
+}  // namespace verilog
+}  // namespace xls
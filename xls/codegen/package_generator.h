@@ -0,0 +1,81 @@
+// Copyright 2022 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_CODEGEN_PACKAGE_GENERATOR_H_
+#define XLS_CODEGEN_PACKAGE_GENERATOR_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/types/optional.h"
+#include "xls/codegen/codegen_options.h"
+#include "xls/codegen/module_signature.h"
+#include "xls/codegen/module_signature.pb.h"
+#include "xls/delay_model/delay_estimator.h"
+#include "xls/ir/block.h"
+#include "xls/ir/function_base.h"
+#include "xls/ir/package.h"
+#include "xls/scheduling/pipeline_schedule.h"
+
+namespace xls {
+namespace verilog {
+
+// Options for generating a Verilog module for every function and proc of a
+// package.
+struct PackageGeneratorOptions {
+  // Options applied to every module. The module name option may only be set if
+  // the package contains a single function or proc.
+  CodegenOptions codegen_options;
+
+  // If given, each function and proc is scheduled with these options and
+  // emitted as a pipelined module. Otherwise each is emitted as a
+  // combinational module.
+  absl::optional<SchedulingOptions> scheduling_options;
+
+  // The delay estimator used for scheduling. Required if scheduling_options is
+  // given.
+  const DelayEstimator* delay_estimator = nullptr;
+
+  // The number of threads on which to schedule and generate modules. The
+  // generated Verilog and the resulting IR do not depend on the thread count.
+  int64_t thread_count = 1;
+};
+
+// The module generated for a single function or proc of a package.
+struct PackageModule {
+  FunctionBase* function_base;
+  Block* block;
+  // The schedule of the function or proc if the module is pipelined.
+  absl::optional<PipelineSchedule> schedule;
+  ModuleGeneratorResult result;
+};
+
+struct PackageGeneratorResult {
+  // The generated modules in the order of Package::GetFunctionBases.
+  std::vector<PackageModule> modules;
+  PackageSignatureProto signature;
+};
+
+// Generates a Verilog module for every function and proc in the package.
+// Scheduling, the codegen pass pipeline, and Verilog emission of the different
+// functions and procs run concurrently on up to options.thread_count threads;
+// only block conversion, which adds the blocks to the package, is sequential.
+absl::StatusOr<PackageGeneratorResult> GeneratePackageModules(
+    Package* package, const PackageGeneratorOptions& options);
+
+}  // namespace verilog
+}  // namespace xls
+
+#endif  // XLS_CODEGEN_PACKAGE_GENERATOR_H_
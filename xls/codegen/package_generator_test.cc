@@ -0,0 +1,194 @@
+// Copyright 2022 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/codegen/package_generator.h"
+
+#include <memory>
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+#include "xls/codegen/pipeline_generator.h"
+#include "xls/common/status/matchers.h"
+#include "xls/delay_model/delay_estimator.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/package.h"
+#include "xls/scheduling/pipeline_schedule.h"
+
+namespace xls {
+namespace verilog {
+namespace {
+
+using status_testing::StatusIs;
+using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+
+class TestDelayEstimator : public DelayEstimator {
+ public:
+  TestDelayEstimator() : DelayEstimator("test") {}
+
+  absl::StatusOr<int64_t> GetOperationDelayInPs(Node* node) const override {
+    switch (node->op()) {
+      case Op::kParam:
+      case Op::kLiteral:
+      case Op::kBitSlice:
+      case Op::kConcat:
+        return 0;
+      default:
+        return 1;
+    }
+  }
+};
+
+class PackageGeneratorTest : public IrTestBase {
+ protected:
+  // Builds a package containing two functions and, optionally, a stateless
+  // proc.
+  std::unique_ptr<Package> BuildPackage(bool with_proc) {
+    auto p = CreatePackage();
+    {
+      FunctionBuilder fb("f", p.get());
+      BValue x = fb.Param("x", p->GetBitsType(32));
+      BValue y = fb.Param("y", p->GetBitsType(32));
+      fb.UMul(fb.Add(x, y), fb.Subtract(x, y));
+      XLS_CHECK_OK(fb.Build().status());
+    }
+    {
+      FunctionBuilder fb("g", p.get());
+      BValue a = fb.Param("a", p->GetBitsType(8));
+      fb.Negate(fb.Not(fb.Negate(a)));
+      XLS_CHECK_OK(fb.Build().status());
+    }
+    if (with_proc) {
+      Type* u32 = p->GetBitsType(32);
+      Channel* in =
+          p->CreateStreamingChannel("in", ChannelOps::kReceiveOnly, u32)
+              .value();
+      Channel* out =
+          p->CreateStreamingChannel("out", ChannelOps::kSendOnly, u32).value();
+      TokenlessProcBuilder pb("p", /*init_value=*/Value::Tuple({}),
+                              /*token_name=*/"tkn", /*state_name=*/"st",
+                              p.get());
+      pb.Send(out, pb.Not(pb.Receive(in)));
+      XLS_CHECK_OK(pb.Build(pb.GetStateParam()).status());
+    }
+    return p;
+  }
+
+  PackageGeneratorOptions PipelineOptions(int64_t thread_count) {
+    PackageGeneratorOptions options;
+    options.codegen_options = BuildPipelineOptions();
+    options.scheduling_options = SchedulingOptions().pipeline_stages(3);
+    options.delay_estimator = &delay_estimator_;
+    options.thread_count = thread_count;
+    return options;
+  }
+
+  TestDelayEstimator delay_estimator_;
+};
+
+TEST_F(PackageGeneratorTest, CombinationalModules) {
+  std::unique_ptr<Package> p = BuildPackage(/*with_proc=*/true);
+  PackageGeneratorOptions options;
+  options.thread_count = 4;
+  XLS_ASSERT_OK_AND_ASSIGN(PackageGeneratorResult result,
+                           GeneratePackageModules(p.get(), options));
+
+  ASSERT_EQ(result.modules.size(), 3);
+  EXPECT_EQ(result.modules[0].block->name(), "f");
+  EXPECT_EQ(result.modules[1].block->name(), "g");
+  EXPECT_EQ(result.modules[2].block->name(), "p");
+  for (const PackageModule& module : result.modules) {
+    EXPECT_FALSE(module.schedule.has_value());
+    EXPECT_TRUE(module.result.signature.proto().has_combinational());
+    EXPECT_THAT(module.result.verilog_text,
+                HasSubstr(absl::StrCat("module ", module.block->name())));
+  }
+  EXPECT_EQ(result.signature.module_signatures_size(), 3);
+  EXPECT_EQ(result.signature.metrics().block_metrics().flop_count(), 0);
+  EXPECT_TRUE(
+      result.signature.metrics().block_metrics().feedthrough_path_exists());
+}
+
+TEST_F(PackageGeneratorTest, MatchesSingleModuleGenerators) {
+  std::unique_ptr<Package> p = BuildPackage(/*with_proc=*/false);
+  XLS_ASSERT_OK_AND_ASSIGN(PackageGeneratorResult result,
+                           GeneratePackageModules(p.get(), PipelineOptions(2)));
+  ASSERT_EQ(result.modules.size(), 2);
+
+  // Each function is scheduled exactly as it would be in a package of its own.
+  int64_t total_flops = 0;
+  for (int64_t i = 0; i < 2; ++i) {
+    std::unique_ptr<Package> single = BuildPackage(/*with_proc=*/false);
+    Function* f = single->functions()[i].get();
+    XLS_ASSERT_OK(single->RemoveFunction(single->functions()[1 - i].get()));
+    XLS_ASSERT_OK_AND_ASSIGN(
+        PipelineSchedule schedule,
+        PipelineSchedule::Run(f, delay_estimator_,
+                              SchedulingOptions().pipeline_stages(3)));
+    XLS_ASSERT_OK_AND_ASSIGN(ModuleGeneratorResult expected,
+                             ToPipelineModuleText(schedule, f));
+
+    const PackageModule& module = result.modules[i];
+    EXPECT_EQ(module.function_base->name(), f->name());
+    ASSERT_TRUE(module.schedule.has_value());
+    EXPECT_EQ(module.schedule->ToProto().DebugString(),
+              schedule.ToProto().DebugString());
+    EXPECT_EQ(module.result.signature.proto().pipeline().DebugString(),
+              expected.signature.proto().pipeline().DebugString());
+    EXPECT_EQ(module.result.signature.proto().data_ports_size(),
+              expected.signature.proto().data_ports_size());
+    total_flops +=
+        module.result.signature.proto().metrics().block_metrics().flop_count();
+  }
+  EXPECT_GT(total_flops, 0);
+  EXPECT_EQ(result.signature.metrics().block_metrics().flop_count(),
+            total_flops);
+}
+
+TEST_F(PackageGeneratorTest, ResultDoesNotDependOnThreadCount) {
+  std::unique_ptr<Package> sequential = BuildPackage(/*with_proc=*/false);
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PackageGeneratorResult sequential_result,
+      GeneratePackageModules(sequential.get(), PipelineOptions(1)));
+  std::unique_ptr<Package> parallel = BuildPackage(/*with_proc=*/false);
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PackageGeneratorResult parallel_result,
+      GeneratePackageModules(parallel.get(), PipelineOptions(8)));
+
+  ASSERT_EQ(parallel_result.modules.size(), sequential_result.modules.size());
+  for (int64_t i = 0; i < parallel_result.modules.size(); ++i) {
+    EXPECT_EQ(parallel_result.modules[i].result.verilog_text,
+              sequential_result.modules[i].result.verilog_text);
+  }
+  EXPECT_EQ(parallel->DumpIr(), sequential->DumpIr());
+  EXPECT_EQ(parallel_result.signature.DebugString(),
+            sequential_result.signature.DebugString());
+}
+
+TEST_F(PackageGeneratorTest, ModuleNameRequiresSingleEntity) {
+  std::unique_ptr<Package> p = BuildPackage(/*with_proc=*/false);
+  PackageGeneratorOptions options = PipelineOptions(2);
+  options.codegen_options.module_name("foo");
+  EXPECT_THAT(GeneratePackageModules(p.get(), options),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("module name cannot be specified")));
+  EXPECT_THAT(p->blocks(), IsEmpty());
+}
+
+}  // namespace
+}  // namespace verilog
+}  // namespace xls
@@ -15,7 +15,9 @@
 #include "xls/codegen/pipeline_generator.h"
 
 #include <algorithm>
+#include <sstream>
 
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
 #include "xls/codegen/block_conversion.h"
@@ -33,23 +35,37 @@ namespace verilog {
 
 absl::StatusOr<ModuleGeneratorResult> ToPipelineModuleText(
     const PipelineSchedule& schedule, Function* func,
-    const CodegenOptions& options) {
+    const CodegenOptions& options, const DelayEstimator* delay_estimator) {
   return ToPipelineModuleText(schedule, static_cast<FunctionBase*>(func),
-                              options);
+                              options, delay_estimator);
 }
 
 absl::StatusOr<ModuleGeneratorResult> ToPipelineModuleText(
     const PipelineSchedule& schedule, FunctionBase* module,
-    const CodegenOptions& options) {
+    const CodegenOptions& options, const DelayEstimator* delay_estimator) {
+  std::ostringstream os;
+  XLS_ASSIGN_OR_RETURN(
+      ModuleGeneratorResult result,
+      ToPipelineModuleText(schedule, module, options, os, delay_estimator));
+  result.verilog_text = os.str();
+  return result;
+}
+
+absl::StatusOr<ModuleGeneratorResult> ToPipelineModuleText(
+    const PipelineSchedule& schedule, FunctionBase* module,
+    const CodegenOptions& options, std::ostream& verilog_stream,
+    const DelayEstimator* delay_estimator) {
   XLS_VLOG(2) << "Generating pipelined module for module:";
   XLS_VLOG_LINES(2, module->DumpIr());
   XLS_VLOG_LINES(2, schedule.ToString());
 
   Block* block;
+  absl::flat_hash_set<Register*> skid_buffer_registers;
 
   CodegenPassOptions pass_options;
   pass_options.codegen_options = options;
   pass_options.schedule = schedule;
+  pass_options.delay_estimator = delay_estimator;
 
   XLS_RET_CHECK(module->IsProc() || module->IsFunction());
   // Convert to block and add in pipe stages according to schedule.
@@ -59,7 +75,8 @@ absl::StatusOr<ModuleGeneratorResult> ToPipelineModuleText(
                          FunctionToPipelinedBlock(schedule, options, func));
   } else {
     Proc* proc = module->AsProcOrDie();
-    XLS_ASSIGN_OR_RETURN(block, ProcToPipelinedBlock(schedule, options, proc));
+    XLS_ASSIGN_OR_RETURN(block, ProcToPipelinedBlock(schedule, options, proc,
+                                                     &skid_buffer_registers));
 
     // Force using non-pretty printed codegen when generating procs.
     // TODO(tedhong): 2021-09-25 - Update pretty-printer to support
@@ -68,17 +85,16 @@ absl::StatusOr<ModuleGeneratorResult> ToPipelineModuleText(
   }
 
   CodegenPassUnit unit(module->package(), block);
+  unit.skid_buffer_registers = std::move(skid_buffer_registers);
   PassResults results;
   XLS_RETURN_IF_ERROR(
       CreateCodegenPassPipeline()->Run(&unit, pass_options, &results).status());
   XLS_RET_CHECK(unit.signature.has_value());
   VerilogLineMap verilog_line_map;
-  XLS_ASSIGN_OR_RETURN(
-      std::string verilog,
-      GenerateVerilog(block, pass_options.codegen_options, &verilog_line_map));
+  XLS_RETURN_IF_ERROR(GenerateVerilog(block, pass_options.codegen_options,
+                                      verilog_stream, &verilog_line_map));
 
-  return ModuleGeneratorResult{verilog, verilog_line_map,
-                               unit.signature.value()};
+  return ModuleGeneratorResult{"", verilog_line_map, unit.signature.value()};
 }
 
 }  // namespace verilog
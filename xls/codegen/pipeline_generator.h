@@ -15,6 +15,7 @@
 #ifndef XLS_CODEGEN_PIPELINE_GENERATOR_H_
 #define XLS_CODEGEN_PIPELINE_GENERATOR_H_
 
+#include <ostream>
 #include <string>
 
 #include "absl/status/statusor.h"
@@ -24,6 +25,7 @@
 #include "xls/codegen/module_signature.pb.h"
 #include "xls/codegen/name_to_bit_count.h"
 #include "xls/codegen/vast.h"
+#include "xls/delay_model/delay_estimator.h"
 #include "xls/ir/function.h"
 #include "xls/scheduling/pipeline_schedule.h"
 
@@ -41,17 +43,28 @@ inline CodegenOptions BuildPipelineOptions() {
 
 // Emits the given function as a verilog module which follows the given
 // schedule. The module is pipelined with a latency and initiation interval
-// given in the signature.
+// given in the signature. `delay_estimator`, if given, is used by codegen
+// passes which consider delay (e.g. register retiming); it should be the
+// estimator the schedule was computed with.
 absl::StatusOr<ModuleGeneratorResult> ToPipelineModuleText(
     const PipelineSchedule& schedule, Function* func,
-    const CodegenOptions& options = BuildPipelineOptions());
+    const CodegenOptions& options = BuildPipelineOptions(),
+    const DelayEstimator* delay_estimator = nullptr);
 
 // Emits the given function or proc as a verilog module which follows the given
 // schedule. The module is pipelined with a latency and initiation interval
 // given in the signature.
 absl::StatusOr<ModuleGeneratorResult> ToPipelineModuleText(
     const PipelineSchedule& schedule, FunctionBase* module,
-    const CodegenOptions& options = BuildPipelineOptions());
+    const CodegenOptions& options = BuildPipelineOptions(),
+    const DelayEstimator* delay_estimator = nullptr);
+
+// As above, but the Verilog text is written to `verilog_stream` as it is
+// emitted and the verilog_text field of the returned result is left empty.
+absl::StatusOr<ModuleGeneratorResult> ToPipelineModuleText(
+    const PipelineSchedule& schedule, FunctionBase* module,
+    const CodegenOptions& options, std::ostream& verilog_stream,
+    const DelayEstimator* delay_estimator = nullptr);
 
 }  // namespace verilog
 }  // namespace xls
@@ -932,6 +932,32 @@ TEST_P(PipelineGeneratorTest, AddNegateFlopNeitherInputsNorOutputs) {
               IsOkAndHolds(UBits(91, 8)));
 }
 
+TEST_P(PipelineGeneratorTest, RetimingUsesDelayEstimator) {
+  Package package(TestBaseName());
+  FunctionBuilder fb(TestBaseName(), &package);
+  BValue x = fb.Param("x", package.GetBitsType(8));
+  fb.Negate(fb.ZeroExtend(x, 32));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * func, fb.Build());
+
+  TestDelayEstimator delay_estimator;
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PipelineSchedule schedule,
+      PipelineSchedule::Run(func, delay_estimator,
+                            SchedulingOptions().clock_period_ps(1)));
+  CodegenOptions options = BuildPipelineOptions()
+                               .retime_registers(true)
+                               .use_system_verilog(UseSystemVerilog());
+
+  // Without an estimator the register after the zero-extend is retimed across
+  // it, but the test estimator gives zero-extends a nonzero delay.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      ModuleGeneratorResult with_estimator,
+      ToPipelineModuleText(schedule, func, options, &delay_estimator));
+  XLS_ASSERT_OK_AND_ASSIGN(ModuleGeneratorResult without_estimator,
+                           ToPipelineModuleText(schedule, func, options));
+  EXPECT_NE(with_estimator.verilog_text, without_estimator.verilog_text);
+}
+
 TEST_P(PipelineGeneratorTest, EmitsCoverpoints) {
   Package package(TestBaseName());
   FunctionBuilder fb(TestBaseName(), &package);
@@ -43,6 +43,7 @@ absl::StatusOr<bool> RegisterLegalizationPass::RunInternal(
       XLS_RETURN_IF_ERROR(block->RemoveNode(reg_read));
       XLS_RETURN_IF_ERROR(block->RemoveNode(reg_write));
       XLS_RETURN_IF_ERROR(block->RemoveRegister(reg));
+      unit->skid_buffer_registers.erase(reg);
       changed = true;
     }
   }
@@ -0,0 +1,460 @@
+// Copyright 2022 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/codegen/register_retiming_pass.h"
+
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/types/optional.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/bits_ops.h"
+#include "xls/ir/block.h"
+#include "xls/ir/node_util.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/value_helpers.h"
+
+namespace xls::verilog {
+namespace {
+
+// Returns whether moving `node` across a register leaves the delay of every
+// combinational path in the block unchanged.
+absl::StatusOr<bool> HasNoDelay(Node* node,
+                                const DelayEstimator* delay_estimator) {
+  if (delay_estimator == nullptr) {
+    return node->OpIn({Op::kBitSlice, Op::kConcat, Op::kZeroExt, Op::kSignExt});
+  }
+  XLS_ASSIGN_OR_RETURN(int64_t delay,
+                       delay_estimator->GetOperationDelayInPs(node));
+  return delay == 0;
+}
+
+struct RegisterNodes {
+  RegisterRead* read;
+  RegisterWrite* write;
+};
+
+// Returns the read and write of the given register, or nullopt if the
+// register does not have exactly one of each.
+absl::optional<RegisterNodes> GetRegisterNodes(Block* block, Register* reg) {
+  absl::StatusOr<RegisterRead*> read = block->GetRegisterRead(reg);
+  absl::StatusOr<RegisterWrite*> write = block->GetRegisterWrite(reg);
+  if (!read.ok() || !write.ok()) {
+    return absl::nullopt;
+  }
+  return RegisterNodes{read.value(), write.value()};
+}
+
+// Replaces `reg` with a register of the same name which is loaded with
+// `new_data` under the same load enable and reset conditions and which resets
+// to `new_reset_value` (if `reg` has a reset). The uses of the read of `reg`
+// are first redirected to a placeholder node; `replace_uses` must replace all
+// uses of the placeholder in terms of the read of the new register.
+absl::Status ReplaceRegister(
+    Block* block, Register* reg, Node* new_data,
+    absl::optional<Value> new_reset_value,
+    const std::function<absl::Status(Node*, RegisterRead*)>& replace_uses) {
+  XLS_ASSIGN_OR_RETURN(RegisterRead * read, block->GetRegisterRead(reg));
+  XLS_ASSIGN_OR_RETURN(RegisterWrite * write, block->GetRegisterWrite(reg));
+  absl::optional<SourceLocation> read_loc = read->loc();
+  absl::optional<SourceLocation> write_loc = write->loc();
+  absl::optional<Node*> load_enable = write->load_enable();
+  absl::optional<Node*> reset_signal = write->reset();
+  std::string name = reg->name();
+  absl::optional<xls::Reset> reset = reg->reset();
+  if (reset.has_value()) {
+    XLS_RET_CHECK(new_reset_value.has_value());
+    reset->reset_value = new_reset_value.value();
+  }
+
+  // The old register must be removed before the new register of the same
+  // name can be added, so the uses of the old read are parked on a
+  // placeholder in the meantime.
+  XLS_ASSIGN_OR_RETURN(
+      Node * placeholder,
+      block->MakeNode<xls::Literal>(read_loc, ZeroOfType(reg->type())));
+  XLS_RETURN_IF_ERROR(read->ReplaceUsesWith(placeholder));
+  XLS_RETURN_IF_ERROR(block->RemoveNode(write));
+  XLS_RETURN_IF_ERROR(block->RemoveNode(read));
+  XLS_RETURN_IF_ERROR(block->RemoveRegister(reg));
+
+  XLS_ASSIGN_OR_RETURN(Register * new_reg,
+                       block->AddRegister(name, new_data->GetType(), reset));
+  XLS_RETURN_IF_ERROR(block
+                          ->MakeNode<RegisterWrite>(write_loc, new_data,
+                                                    load_enable, reset_signal,
+                                                    new_reg)
+                          .status());
+  XLS_ASSIGN_OR_RETURN(RegisterRead * new_read,
+                       block->MakeNode<RegisterRead>(read_loc, new_reg));
+  XLS_RETURN_IF_ERROR(replace_uses(placeholder, new_read));
+  XLS_RET_CHECK(placeholder->users().empty());
+  return block->RemoveNode(placeholder);
+}
+
+// Replaces a register which is reset to the literal it is loaded with by that
+// literal.
+absl::StatusOr<bool> ReplaceConstantRegister(Block* block, Register* reg,
+                                             const RegisterNodes& nodes) {
+  Node* data = nodes.write->data();
+  if (!data->Is<xls::Literal>() || !reg->reset().has_value() ||
+      reg->reset()->reset_value != data->As<xls::Literal>()->value()) {
+    return false;
+  }
+  XLS_RETURN_IF_ERROR(
+      nodes.read
+          ->ReplaceUsesWithNew<xls::Literal>(data->As<xls::Literal>()->value())
+          .status());
+  XLS_RETURN_IF_ERROR(block->RemoveNode(nodes.write));
+  XLS_RETURN_IF_ERROR(block->RemoveNode(nodes.read));
+  XLS_RETURN_IF_ERROR(block->RemoveRegister(reg));
+  return true;
+}
+
+// If the read of the register is only used by bit slices, narrows the
+// register to the range of bits which are sliced.
+absl::StatusOr<bool> NarrowToSlicedBits(Block* block, Register* reg,
+                                        const RegisterNodes& nodes,
+                                        const DelayEstimator* delay_estimator) {
+  if (!reg->type()->IsBits() || nodes.read->users().empty()) {
+    return false;
+  }
+  int64_t width = reg->type()->GetFlatBitCount();
+  int64_t lo = width;
+  int64_t hi = 0;
+  for (Node* user : nodes.read->users()) {
+    if (!user->Is<BitSlice>()) {
+      return false;
+    }
+    XLS_ASSIGN_OR_RETURN(bool no_delay, HasNoDelay(user, delay_estimator));
+    if (!no_delay) {
+      return false;
+    }
+    BitSlice* slice = user->As<BitSlice>();
+    lo = std::min(lo, slice->start());
+    hi = std::max(hi, slice->start() + slice->width());
+  }
+  // Zero-width registers are not supported so a register of which no bits
+  // are used is left for dead code elimination.
+  if (hi <= lo || hi - lo == width) {
+    return false;
+  }
+
+  XLS_ASSIGN_OR_RETURN(Node * new_data,
+                       block->MakeNode<BitSlice>(nodes.write->loc(),
+                                                 nodes.write->data(), lo,
+                                                 hi - lo));
+  absl::optional<Value> new_reset_value;
+  if (reg->reset().has_value()) {
+    new_reset_value =
+        Value(reg->reset()->reset_value.bits().Slice(lo, hi - lo));
+  }
+  XLS_RETURN_IF_ERROR(ReplaceRegister(
+      block, reg, new_data, new_reset_value,
+      [&](Node* placeholder, RegisterRead* new_read) -> absl::Status {
+        std::vector<Node*> slices(placeholder->users().begin(),
+                                  placeholder->users().end());
+        for (Node* node : slices) {
+          BitSlice* slice = node->As<BitSlice>();
+          if (slice->start() == lo && slice->width() == hi - lo) {
+            XLS_RETURN_IF_ERROR(slice->ReplaceUsesWith(new_read));
+          } else {
+            XLS_RETURN_IF_ERROR(slice
+                                    ->ReplaceUsesWithNew<BitSlice>(
+                                        new_read, slice->start() - lo,
+                                        slice->width())
+                                    .status());
+          }
+          XLS_RETURN_IF_ERROR(block->RemoveNode(slice));
+        }
+        return absl::OkStatus();
+      }));
+  return true;
+}
+
+// If the register holds a zero or sign extension, the register instead holds
+// the operand of the extension and the extension is applied to the read of
+// the register.
+absl::StatusOr<bool> MoveExtensionAfterRegister(Block* block, Register* reg,
+                                                const RegisterNodes& nodes) {
+  Node* data = nodes.write->data();
+  Node* arg = data->operand(0);
+  int64_t width = data->BitCountOrDie();
+  int64_t arg_width = arg->BitCountOrDie();
+  if (arg_width == 0 || arg_width == width) {
+    return false;
+  }
+  absl::optional<Value> new_reset_value;
+  if (reg->reset().has_value()) {
+    const Bits& reset_bits = reg->reset()->reset_value.bits();
+    Bits arg_reset_bits = reset_bits.Slice(0, arg_width);
+    Bits extended = data->op() == Op::kZeroExt
+                        ? bits_ops::ZeroExtend(arg_reset_bits, width)
+                        : bits_ops::SignExtend(arg_reset_bits, width);
+    if (extended != reset_bits) {
+      return false;
+    }
+    new_reset_value = Value(arg_reset_bits);
+  }
+  Op op = data->op();
+  XLS_RETURN_IF_ERROR(ReplaceRegister(
+      block, reg, arg, new_reset_value,
+      [&](Node* placeholder, RegisterRead* new_read) {
+        return placeholder->ReplaceUsesWithNew<ExtendOp>(new_read, width, op)
+            .status();
+      }));
+  return true;
+}
+
+// If the register holds a concat some of whose operands are literals, the
+// register instead holds only the non-literal operands and the concat is
+// rebuilt from the read of the register.
+absl::StatusOr<bool> MoveConstantConcatOperandsAfterRegister(
+    Block* block, Register* reg, const RegisterNodes& nodes) {
+  Node* data = nodes.write->data();
+  absl::optional<Bits> reset_bits;
+  if (reg->reset().has_value()) {
+    reset_bits = reg->reset()->reset_value.bits();
+  }
+
+  // The operands of a concat are ordered from most to least significant.
+  std::vector<Node*> variable_operands;
+  std::vector<Bits> variable_reset_bits;
+  int64_t variable_width = 0;
+  int64_t offset = data->BitCountOrDie();
+  for (Node* operand : data->operands()) {
+    int64_t operand_width = operand->BitCountOrDie();
+    offset -= operand_width;
+    if (operand->Is<xls::Literal>()) {
+      if (reset_bits.has_value() &&
+          reset_bits->Slice(offset, operand_width) !=
+              operand->As<xls::Literal>()->value().bits()) {
+        return false;
+      }
+      continue;
+    }
+    variable_operands.push_back(operand);
+    variable_width += operand_width;
+    if (reset_bits.has_value()) {
+      variable_reset_bits.push_back(reset_bits->Slice(offset, operand_width));
+    }
+  }
+  // All checks happen before any node is created so that the block is left
+  // unmodified when the transformation does not apply.
+  if (variable_operands.empty() ||
+      variable_operands.size() == data->operand_count() ||
+      variable_width == 0) {
+    return false;
+  }
+  Node* new_data = variable_operands.front();
+  if (variable_operands.size() > 1) {
+    XLS_ASSIGN_OR_RETURN(
+        new_data, block->MakeNode<xls::Concat>(data->loc(), variable_operands));
+  }
+  absl::optional<Value> new_reset_value;
+  if (reset_bits.has_value()) {
+    new_reset_value = Value(bits_ops::Concat(variable_reset_bits));
+  }
+
+  std::vector<Node*> operands(data->operands().begin(),
+                              data->operands().end());
+  absl::optional<SourceLocation> loc = data->loc();
+  XLS_RETURN_IF_ERROR(ReplaceRegister(
+      block, reg, new_data, new_reset_value,
+      [&](Node* placeholder, RegisterRead* new_read) -> absl::Status {
+        std::vector<Node*> elements;
+        int64_t new_offset = new_read->BitCountOrDie();
+        for (Node* operand : operands) {
+          if (operand->Is<xls::Literal>()) {
+            XLS_ASSIGN_OR_RETURN(
+                Node * literal,
+                block->MakeNode<xls::Literal>(loc,
+                                         operand->As<xls::Literal>()->value()));
+            elements.push_back(literal);
+            continue;
+          }
+          int64_t operand_width = operand->BitCountOrDie();
+          new_offset -= operand_width;
+          if (operand_width == new_read->BitCountOrDie()) {
+            elements.push_back(new_read);
+            continue;
+          }
+          XLS_ASSIGN_OR_RETURN(
+              Node * slice, block->MakeNode<BitSlice>(loc, new_read, new_offset,
+                                                      operand_width));
+          elements.push_back(slice);
+        }
+        return placeholder->ReplaceUsesWithNew<xls::Concat>(elements).status();
+      }));
+  return true;
+}
+
+// Applies the first applicable retiming transformation to the register.
+absl::StatusOr<bool> RetimeRegister(Block* block, Register* reg,
+                                    const DelayEstimator* delay_estimator) {
+  absl::optional<RegisterNodes> nodes = GetRegisterNodes(block, reg);
+  if (!nodes.has_value()) {
+    return false;
+  }
+  XLS_ASSIGN_OR_RETURN(bool changed,
+                       ReplaceConstantRegister(block, reg, *nodes));
+  if (changed) {
+    return true;
+  }
+  XLS_ASSIGN_OR_RETURN(
+      changed, NarrowToSlicedBits(block, reg, *nodes, delay_estimator));
+  if (changed) {
+    return true;
+  }
+  Node* data = nodes->write->data();
+  if (!data->OpIn({Op::kZeroExt, Op::kSignExt, Op::kConcat})) {
+    return false;
+  }
+  XLS_ASSIGN_OR_RETURN(bool no_delay, HasNoDelay(data, delay_estimator));
+  if (!no_delay) {
+    return false;
+  }
+  if (data->op() == Op::kConcat) {
+    return MoveConstantConcatOperandsAfterRegister(block, reg, *nodes);
+  }
+  return MoveExtensionAfterRegister(block, reg, *nodes);
+}
+
+// Returns whether the two nodes are known to compute the same value.
+bool IsSameValue(Node* a, Node* b) {
+  return a == b ||
+         (a->operands() == b->operands() && a->IsDefinitelyEqualTo(b));
+}
+
+// Returns whether the two registers always hold the same value.
+bool AreEquivalentRegisters(Register* a, const RegisterNodes& a_nodes,
+                            Register* b, const RegisterNodes& b_nodes) {
+  if (!a->type()->IsEqualTo(b->type()) ||
+      a_nodes.write->load_enable() != b_nodes.write->load_enable() ||
+      a_nodes.write->reset() != b_nodes.write->reset() ||
+      a->reset().has_value() != b->reset().has_value()) {
+    return false;
+  }
+  if (a->reset().has_value() &&
+      (a->reset()->reset_value != b->reset()->reset_value ||
+       a->reset()->asynchronous != b->reset()->asynchronous ||
+       a->reset()->active_low != b->reset()->active_low)) {
+    return false;
+  }
+  return IsSameValue(a_nodes.write->data(), b_nodes.write->data());
+}
+
+// Merges registers which always hold the same value into the first such
+// register.
+absl::StatusOr<bool> MergeEquivalentRegisters(Block* block) {
+  // Candidates for merging are bucketed by the operation and operands of
+  // their data and by their load enable and reset signals.
+  using Key = std::tuple<Op, std::vector<Node*>, Node*, Node*>;
+  absl::flat_hash_map<Key, std::vector<std::pair<Register*, RegisterNodes>>>
+      buckets;
+  bool changed = false;
+  std::vector<Register*> registers(block->GetRegisters().begin(),
+                                   block->GetRegisters().end());
+  for (Register* reg : registers) {
+    absl::optional<RegisterNodes> nodes = GetRegisterNodes(block, reg);
+    if (!nodes.has_value()) {
+      continue;
+    }
+    Node* data = nodes->write->data();
+    Key key(data->op(),
+            std::vector<Node*>(data->operands().begin(),
+                               data->operands().end()),
+            nodes->write->load_enable().value_or(nullptr),
+            nodes->write->reset().value_or(nullptr));
+    if (data->operand_count() == 0) {
+      // Nodes without operands (e.g., ports) are distinguished by identity.
+      std::get<1>(key).push_back(data);
+    }
+    std::vector<std::pair<Register*, RegisterNodes>>& bucket = buckets[key];
+    auto it = std::find_if(
+        bucket.begin(), bucket.end(),
+        [&](const std::pair<Register*, RegisterNodes>& candidate) {
+          return AreEquivalentRegisters(candidate.first, candidate.second, reg,
+                                        *nodes);
+        });
+    if (it == bucket.end()) {
+      bucket.push_back({reg, *nodes});
+      continue;
+    }
+    XLS_VLOG(3) << absl::StreamFormat("Merging register %s into %s",
+                                      reg->name(), it->first->name());
+    XLS_RETURN_IF_ERROR(nodes->read->ReplaceUsesWith(it->second.read));
+    XLS_RETURN_IF_ERROR(block->RemoveNode(nodes->write));
+    XLS_RETURN_IF_ERROR(block->RemoveNode(nodes->read));
+    XLS_RETURN_IF_ERROR(block->RemoveRegister(reg));
+    changed = true;
+  }
+  return changed;
+}
+
+}  // namespace
+
+absl::StatusOr<bool> RegisterRetimingPass::RunInternal(
+    CodegenPassUnit* unit, const CodegenPassOptions& options,
+    PassResults* results) const {
+  if (!options.codegen_options.retime_registers()) {
+    return false;
+  }
+  Block* block = unit->block;
+
+  // Retiming replaces registers with new ones of the same name, so skid buffer
+  // registers are tracked by name while the pass runs.
+  absl::flat_hash_set<std::string> skid_buffer_register_names;
+  for (Register* reg : unit->skid_buffer_registers) {
+    skid_buffer_register_names.insert(reg->name());
+  }
+
+  // Each transformation reduces the number of register bits, and may enable
+  // further transformations of the registers before or after it in a
+  // pipeline, so iterate to a fixed point.
+  bool changed = false;
+  bool changed_this_iteration = true;
+  while (changed_this_iteration) {
+    changed_this_iteration = false;
+    std::vector<Register*> registers(block->GetRegisters().begin(),
+                                     block->GetRegisters().end());
+    for (Register* reg : registers) {
+      XLS_ASSIGN_OR_RETURN(bool reg_changed,
+                           RetimeRegister(block, reg, options.delay_estimator));
+      changed_this_iteration |= reg_changed;
+    }
+    XLS_ASSIGN_OR_RETURN(bool merged, MergeEquivalentRegisters(block));
+    changed_this_iteration |= merged;
+    changed |= changed_this_iteration;
+  }
+
+  unit->skid_buffer_registers.clear();
+  for (Register* reg : block->GetRegisters()) {
+    if (skid_buffer_register_names.contains(reg->name())) {
+      unit->skid_buffer_registers.insert(reg);
+    }
+  }
+  return changed;
+}
+
+}  // namespace xls::verilog
@@ -0,0 +1,52 @@
+// Copyright 2022 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_CODEGEN_REGISTER_RETIMING_PASS_H_
+#define XLS_CODEGEN_REGISTER_RETIMING_PASS_H_
+
+#include "absl/status/statusor.h"
+#include "xls/codegen/codegen_pass.h"
+
+namespace xls::verilog {
+
+// Reduces the number of flops in the block by moving logic without delay across
+// registers and by merging registers which hold the same value. Specifically:
+//
+//  * A register whose read is only used by bit slices is narrowed to the bits
+//    which are sliced; the slice is moved before the register.
+//  * A register holding a zero or sign extension, or a concat some of whose
+//    operands are literals, instead holds the non-constant bits; the extension
+//    or concat is moved after the register.
+//  * A register which is reset to the literal it is always loaded with is
+//    replaced by the literal.
+//  * Registers with the same data, load enable, and reset are merged.
+//
+// Logic is only moved if its delay is zero according to the delay estimator
+// of the pass options (or, without an estimator, if it is pure wiring), so no
+// combinational path becomes longer. Registers keep their names. The pass does
+// nothing unless the retime_registers codegen option is set.
+class RegisterRetimingPass : public CodegenPass {
+ public:
+  RegisterRetimingPass()
+      : CodegenPass("register_retiming", "Retime and merge registers") {}
+  ~RegisterRetimingPass() override {}
+
+  absl::StatusOr<bool> RunInternal(CodegenPassUnit* unit,
+                                   const CodegenPassOptions& options,
+                                   PassResults* results) const override;
+};
+
+}  // namespace xls::verilog
+
+#endif  // XLS_CODEGEN_REGISTER_RETIMING_PASS_H_
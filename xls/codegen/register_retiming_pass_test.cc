@@ -0,0 +1,287 @@
+// Copyright 2022 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/codegen/register_retiming_pass.h"
+
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
+#include "xls/codegen/codegen_pass.h"
+#include "xls/common/status/matchers.h"
+#include "xls/delay_model/delay_estimator.h"
+#include "xls/interpreter/block_interpreter.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_test_base.h"
+
+namespace xls::verilog {
+namespace {
+
+using status_testing::IsOkAndHolds;
+
+// A delay estimator under which every operation has a non-zero delay.
+class UnitDelayEstimator : public DelayEstimator {
+ public:
+  UnitDelayEstimator() : DelayEstimator("unit") {}
+
+  absl::StatusOr<int64_t> GetOperationDelayInPs(Node* node) const override {
+    return 1;
+  }
+};
+
+class RegisterRetimingPassTest : public IrTestBase {
+ protected:
+  absl::StatusOr<bool> Run(Block* block,
+                           const DelayEstimator* delay_estimator = nullptr,
+                           bool enabled = true) {
+    PassResults results;
+    CodegenPassUnit unit(block->package(), block);
+    CodegenPassOptions options;
+    options.codegen_options.retime_registers(enabled);
+    options.delay_estimator = delay_estimator;
+    return RegisterRetimingPass().Run(&unit, options, &results);
+  }
+
+  // Builds two copies of a block with the given builder function, runs the
+  // pass on one of them, and checks that both produce the same outputs for a
+  // sequence of random inputs. The first cycle asserts the reset signal "rst"
+  // if the block has one. Returns the retimed block.
+  absl::StatusOr<Block*> RetimeAndCheckEquivalence(
+      const std::function<void(BlockBuilder&, Package*)>& build) {
+    original_package_ = CreatePackage();
+    retimed_package_ = CreatePackage();
+    std::vector<Block*> blocks;
+    for (Package* p : {original_package_.get(), retimed_package_.get()}) {
+      BlockBuilder bb(TestName(), p);
+      XLS_RETURN_IF_ERROR(bb.block()->AddClockPort("clk"));
+      build(bb, p);
+      XLS_ASSIGN_OR_RETURN(Block * block, bb.Build());
+      blocks.push_back(block);
+    }
+    Block* original = blocks[0];
+    Block* retimed = blocks[1];
+    XLS_ASSIGN_OR_RETURN(bool changed, Run(retimed));
+    EXPECT_TRUE(changed);
+
+    std::minstd_rand engine;
+    std::vector<absl::flat_hash_map<std::string, uint64_t>> inputs;
+    for (int64_t cycle = 0; cycle < 32; ++cycle) {
+      absl::flat_hash_map<std::string, uint64_t> cycle_inputs;
+      for (InputPort* port : original->GetInputPorts()) {
+        uint64_t value = engine();
+        if (port->GetName() == "rst") {
+          value = cycle == 0 ? 1 : 0;
+        } else if (port->GetType()->GetFlatBitCount() < 64) {
+          value &= Mask(port->GetType()->GetFlatBitCount());
+        }
+        cycle_inputs[port->GetName()] = value;
+      }
+      inputs.push_back(cycle_inputs);
+    }
+    XLS_ASSIGN_OR_RETURN(auto expected,
+                         InterpretSequentialBlock(original, inputs));
+    XLS_ASSIGN_OR_RETURN(auto actual,
+                         InterpretSequentialBlock(retimed, inputs));
+    // Outputs are undefined until the registers have been reset or loaded.
+    for (int64_t cycle = 1; cycle < inputs.size(); ++cycle) {
+      EXPECT_EQ(actual[cycle], expected[cycle]) << "cycle " << cycle;
+    }
+    return retimed;
+  }
+
+  int64_t RegisterBitCount(Block* block) {
+    int64_t count = 0;
+    for (Register* reg : block->GetRegisters()) {
+      count += reg->type()->GetFlatBitCount();
+    }
+    return count;
+  }
+
+  std::unique_ptr<Package> original_package_;
+  std::unique_ptr<Package> retimed_package_;
+};
+
+TEST_F(RegisterRetimingPassTest, NarrowsRegisterToSlicedBits) {
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Block * block, RetimeAndCheckEquivalence([](BlockBuilder& bb,
+                                                  Package* p) {
+        BValue a = bb.InputPort("a", p->GetBitsType(32));
+        BValue a_reg = bb.InsertRegister("a_reg", a);
+        bb.OutputPort("x", bb.BitSlice(a_reg, /*start=*/4, /*width=*/8));
+        bb.OutputPort("y", bb.BitSlice(a_reg, /*start=*/10, /*width=*/6));
+      }));
+  XLS_ASSERT_OK_AND_ASSIGN(Register * reg, block->GetRegister("a_reg"));
+  EXPECT_EQ(reg->type(), block->package()->GetBitsType(12));
+  EXPECT_THAT(Run(block), IsOkAndHolds(false));
+}
+
+TEST_F(RegisterRetimingPassTest, MovesExtensionsAfterRegisters) {
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Block * block,
+      RetimeAndCheckEquivalence([](BlockBuilder& bb, Package* p) {
+        BValue a = bb.InputPort("a", p->GetBitsType(8));
+        BValue b = bb.InputPort("b", p->GetBitsType(8));
+        BValue rst = bb.InputPort("rst", p->GetBitsType(1));
+        BValue a_reg = bb.InsertRegister(
+            "a_reg", bb.ZeroExtend(a, 32), rst,
+            xls::Reset{Value(UBits(5, 32)), /*asynchronous=*/false,
+                  /*active_low=*/false});
+        BValue b_reg = bb.InsertRegister("b_reg", bb.SignExtend(b, 16));
+        // A pipeline of registers after the extension is retimed as a whole.
+        BValue b_reg2 = bb.InsertRegister("b_reg2", b_reg);
+        bb.OutputPort("x", bb.Add(a_reg, a_reg));
+        bb.OutputPort("y", b_reg2);
+      }));
+  EXPECT_EQ(RegisterBitCount(block), 24);
+  XLS_ASSERT_OK_AND_ASSIGN(Register * a_reg, block->GetRegister("a_reg"));
+  ASSERT_TRUE(a_reg->reset().has_value());
+  EXPECT_EQ(a_reg->reset()->reset_value, Value(UBits(5, 8)));
+}
+
+TEST_F(RegisterRetimingPassTest, MovesConstantConcatOperandsAfterRegister) {
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Block * block,
+      RetimeAndCheckEquivalence([](BlockBuilder& bb, Package* p) {
+        BValue a = bb.InputPort("a", p->GetBitsType(8));
+        BValue b = bb.InputPort("b", p->GetBitsType(4));
+        BValue data = bb.Concat({bb.Literal(UBits(3, 2)), a,
+                                 bb.Literal(UBits(0, 4)), b});
+        bb.OutputPort("x", bb.InsertRegister("reg", data));
+      }));
+  EXPECT_EQ(RegisterBitCount(block), 12);
+}
+
+TEST_F(RegisterRetimingPassTest, ZeroWidthVariableConcatOperandsAreUnchanged) {
+  auto p = CreatePackage();
+  BlockBuilder bb(TestName(), p.get());
+  XLS_ASSERT_OK(bb.block()->AddClockPort("clk"));
+  BValue a = bb.InputPort("a", p->GetBitsType(0));
+  BValue b = bb.InputPort("b", p->GetBitsType(0));
+  BValue data = bb.Concat({bb.Literal(UBits(3, 8)), a, b});
+  bb.OutputPort("x", bb.InsertRegister("reg", data));
+  XLS_ASSERT_OK_AND_ASSIGN(Block * block, bb.Build());
+  int64_t node_count = block->node_count();
+  EXPECT_THAT(Run(block), IsOkAndHolds(false));
+  EXPECT_EQ(block->node_count(), node_count);
+}
+
+TEST_F(RegisterRetimingPassTest, ResetValueMustMatchConstantBits) {
+  auto p = CreatePackage();
+  BlockBuilder bb(TestName(), p.get());
+  XLS_ASSERT_OK(bb.block()->AddClockPort("clk"));
+  BValue a = bb.InputPort("a", p->GetBitsType(8));
+  BValue rst = bb.InputPort("rst", p->GetBitsType(1));
+  // The reset value has a one in the bits which are otherwise zero.
+  BValue a_reg = bb.InsertRegister(
+      "a_reg", bb.ZeroExtend(a, 16), rst,
+      xls::Reset{Value(UBits(0x100, 16)), /*asynchronous=*/false,
+            /*active_low=*/false});
+  bb.OutputPort("x", a_reg);
+  XLS_ASSERT_OK_AND_ASSIGN(Block * block, bb.Build());
+  EXPECT_THAT(Run(block), IsOkAndHolds(false));
+  EXPECT_EQ(RegisterBitCount(block), 16);
+}
+
+TEST_F(RegisterRetimingPassTest, ReplacesConstantRegisterWithLiteral) {
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Block * block,
+      RetimeAndCheckEquivalence([](BlockBuilder& bb, Package* p) {
+        BValue a = bb.InputPort("a", p->GetBitsType(8));
+        BValue rst = bb.InputPort("rst", p->GetBitsType(1));
+        BValue c_reg = bb.InsertRegister(
+            "c_reg", bb.Literal(UBits(42, 8)), rst,
+            xls::Reset{Value(UBits(42, 8)), /*asynchronous=*/false,
+                  /*active_low=*/false});
+        bb.OutputPort("x", bb.Add(bb.InsertRegister("a_reg", a), c_reg));
+      }));
+  EXPECT_EQ(RegisterBitCount(block), 8);
+  EXPECT_FALSE(block->GetRegister("c_reg").ok());
+}
+
+TEST_F(RegisterRetimingPassTest, MergesEquivalentRegisters) {
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Block * block,
+      RetimeAndCheckEquivalence([](BlockBuilder& bb, Package* p) {
+        BValue a = bb.InputPort("a", p->GetBitsType(16));
+        BValue en = bb.InputPort("en", p->GetBitsType(1));
+        BValue x_reg = bb.InsertRegister("x_reg", bb.Not(a), en);
+        BValue y_reg = bb.InsertRegister("y_reg", bb.Not(a), en);
+        // A register with a different load enable is not merged.
+        BValue z_reg = bb.InsertRegister("z_reg", bb.Not(a));
+        // Registers which become identical after retiming are merged.
+        BValue s0 = bb.InsertRegister("s0", a);
+        BValue s1 = bb.InsertRegister("s1", a);
+        bb.OutputPort("x", bb.Add(x_reg, y_reg));
+        bb.OutputPort("z", z_reg);
+        bb.OutputPort("s", bb.Concat({bb.BitSlice(s0, 0, 4),
+                                      bb.BitSlice(s1, 0, 4)}));
+      }));
+  EXPECT_EQ(RegisterBitCount(block), 16 + 16 + 4);
+  EXPECT_TRUE(block->GetRegister("x_reg").ok());
+  EXPECT_FALSE(block->GetRegister("y_reg").ok());
+  EXPECT_TRUE(block->GetRegister("s0").ok());
+  EXPECT_FALSE(block->GetRegister("s1").ok());
+}
+
+TEST_F(RegisterRetimingPassTest, TracksReplacedSkidBufferRegisters) {
+  auto p = CreatePackage();
+  BlockBuilder bb(TestName(), p.get());
+  XLS_ASSERT_OK(bb.block()->AddClockPort("clk"));
+  BValue a = bb.InputPort("a", p->GetBitsType(8));
+  BValue a_skid = bb.InsertRegister("a_skid", bb.ZeroExtend(a, 32));
+  bb.OutputPort("x", a_skid);
+  XLS_ASSERT_OK_AND_ASSIGN(Block * block, bb.Build());
+  XLS_ASSERT_OK_AND_ASSIGN(Register * skid_reg, block->GetRegister("a_skid"));
+
+  PassResults results;
+  CodegenPassUnit unit(p.get(), block);
+  unit.skid_buffer_registers.insert(skid_reg);
+  CodegenPassOptions options;
+  options.codegen_options.retime_registers(true);
+  EXPECT_THAT(RegisterRetimingPass().Run(&unit, options, &results),
+              IsOkAndHolds(true));
+
+  XLS_ASSERT_OK_AND_ASSIGN(Register * retimed_reg,
+                           block->GetRegister("a_skid"));
+  EXPECT_EQ(retimed_reg->type(), p->GetBitsType(8));
+  EXPECT_EQ(unit.skid_buffer_registers.size(), 1);
+  EXPECT_TRUE(unit.skid_buffer_registers.contains(retimed_reg));
+}
+
+TEST_F(RegisterRetimingPassTest, RespectsDelayEstimator) {
+  auto p = CreatePackage();
+  BlockBuilder bb(TestName(), p.get());
+  XLS_ASSERT_OK(bb.block()->AddClockPort("clk"));
+  BValue a = bb.InputPort("a", p->GetBitsType(8));
+  BValue a_reg = bb.InsertRegister("a_reg", bb.ZeroExtend(a, 32));
+  bb.OutputPort("x", bb.BitSlice(a_reg, 0, 4));
+  XLS_ASSERT_OK_AND_ASSIGN(Block * block, bb.Build());
+
+  UnitDelayEstimator delay_estimator;
+  EXPECT_THAT(Run(block, &delay_estimator), IsOkAndHolds(false));
+  EXPECT_THAT(Run(block, /*delay_estimator=*/nullptr, /*enabled=*/false),
+              IsOkAndHolds(false));
+  EXPECT_EQ(RegisterBitCount(block), 32);
+  EXPECT_THAT(Run(block), IsOkAndHolds(true));
+  EXPECT_EQ(RegisterBitCount(block), 4);
+}
+
+}  // namespace
+}  // namespace xls::verilog
@@ -409,7 +409,8 @@ SequentialModuleBuilder::GenerateLoopBodyPipeline() {
   std::unique_ptr<ModuleGeneratorResult> result =
       std::make_unique<ModuleGeneratorResult>();
   XLS_ASSIGN_OR_RETURN(
-      *result, ToPipelineModuleText(schedule, loop_body_function, options));
+      *result, ToPipelineModuleText(schedule, loop_body_function, options,
+                                    sequential_options_.delay_estimator()));
   return std::move(result);
 }
 
@@ -145,9 +145,17 @@ absl::StatusOr<ModuleSignature> GenerateSignature(
       pipeline_control = PipelineControl();
       *(pipeline_control->mutable_valid()) = options.valid_control().value();
     }
-    // We assume initiation-interval of one because that is all we generate at
-    // the moment.
-    b.WithPipelineInterface(register_levels, /*initiation_interval=*/1,
+    // A pipelined proc starts an activation only once the state computed by
+    // the previous activation has been written. Otherwise, an activation can
+    // start every cycle.
+    int64_t initiation_interval = 1;
+    if (schedule.has_value() && schedule->function_base()->IsProc()) {
+      Proc* proc = schedule->function_base()->AsProcOrDie();
+      if (proc->StateType()->GetFlatBitCount() > 0) {
+        initiation_interval = schedule->cycle(proc->NextState()) + 1;
+      }
+    }
+    b.WithPipelineInterface(register_levels, initiation_interval,
                             pipeline_control);
   }
 
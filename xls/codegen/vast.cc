@@ -14,6 +14,8 @@
 
 #include "xls/codegen/vast.h"
 
+#include <sstream>
+
 #include "absl/flags/flag.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/ascii.h"
@@ -109,6 +111,27 @@ std::optional<std::vector<LineSpan>> LineInfo::LookupNode(
   return spans_.at(node).completed_spans;
 }
 
+void IndentedOstream::Write(absl::string_view text) {
+  // Don't indent empty lines to avoid creating trailing white space.
+  while (!text.empty()) {
+    size_t newline = text.find('\n');
+    absl::string_view line = text.substr(0, newline);
+    if (!line.empty()) {
+      if (at_line_start_) {
+        os_ << indent_;
+      }
+      os_ << line;
+      at_line_start_ = false;
+    }
+    if (newline == absl::string_view::npos) {
+      return;
+    }
+    os_ << '\n';
+    at_line_start_ = true;
+    text.remove_prefix(newline + 1);
+  }
+}
+
 std::string SanitizeIdentifier(absl::string_view name) {
   if (name.empty()) {
     return "_";
@@ -210,21 +233,22 @@ DataType* VerilogFile::UnpackedArrayType(int64_t element_bit_count,
 }
 
 std::string VerilogFile::Emit(LineInfo* line_info) const {
-  auto file_member_str = [=](const FileMember& member) -> std::string {
-    return absl::visit(
-        Visitor{[=](Include* m) -> std::string { return m->Emit(line_info); },
-                [=](Module* m) -> std::string { return m->Emit(line_info); },
-                [=](BlankLine* m) -> std::string { return m->Emit(line_info); },
-                [=](Comment* m) -> std::string { return m->Emit(line_info); }},
-        member);
-  };
+  std::ostringstream os;
+  Emit(os, line_info);
+  return os.str();
+}
 
-  std::string out;
+void VerilogFile::Emit(std::ostream& os, LineInfo* line_info) const {
   for (const FileMember& member : members_) {
-    absl::StrAppend(&out, file_member_str(member), "\n");
+    absl::visit(
+        Visitor{[&](Include* m) { os << m->Emit(line_info); },
+                [&](Module* m) { m->Emit(os, line_info); },
+                [&](BlankLine* m) { os << m->Emit(line_info); },
+                [&](Comment* m) { os << m->Emit(line_info); }},
+        member);
+    os << "\n";
     LineInfoIncrease(line_info, 1);
   }
-  return out;
 }
 
 LocalParamItemRef* LocalParam::AddItem(absl::string_view name,
@@ -546,22 +570,36 @@ std::string EmitModuleMember(LineInfo* line_info, const ModuleMember& member) {
 }  // namespace
 
 std::string ModuleSection::Emit(LineInfo* line_info) const {
+  std::ostringstream os;
+  IndentedOstream out(os, /*spaces=*/0);
+  Emit(out, line_info);
+  return os.str();
+}
+
+void ModuleSection::Emit(IndentedOstream& out, LineInfo* line_info) const {
   LineInfoStart(line_info, this);
-  std::vector<std::string> elements;
+  bool empty = true;
   for (const ModuleMember& member : members_) {
     if (absl::holds_alternative<ModuleSection*>(member)) {
       if (absl::get<ModuleSection*>(member)->members_.empty()) {
         continue;
       }
     }
-    elements.push_back(EmitModuleMember(line_info, member));
+    if (!empty) {
+      out.Write("\n");
+    }
+    empty = false;
+    if (absl::holds_alternative<ModuleSection*>(member)) {
+      absl::get<ModuleSection*>(member)->Emit(out, line_info);
+    } else {
+      out.Write(EmitModuleMember(line_info, member));
+    }
     LineInfoIncrease(line_info, 1);
   }
-  if (!elements.empty()) {
+  if (!empty) {
     LineInfoIncrease(line_info, -1);
   }
   LineInfoEnd(line_info, this);
-  return absl::StrJoin(elements, "\n");
 }
 
 std::string ContinuousAssignment::Emit(LineInfo* line_info) const {
@@ -656,6 +694,12 @@ std::string SystemFunctionCall::Emit(LineInfo* line_info) const {
 }
 
 std::string Module::Emit(LineInfo* line_info) const {
+  std::ostringstream os;
+  Emit(os, line_info);
+  return os.str();
+}
+
+void Module::Emit(std::ostream& os, LineInfo* line_info) const {
   LineInfoStart(line_info, this);
   std::string result = absl::StrCat("module ", name_);
   if (ports_.empty()) {
@@ -674,11 +718,13 @@ std::string Module::Emit(LineInfo* line_info) const {
     absl::StrAppend(&result, "\n);\n");
     LineInfoIncrease(line_info, 1);
   }
-  absl::StrAppend(&result, Indent(top_.Emit(line_info)), "\n");
+  os << result;
+  IndentedOstream body(os, /*spaces=*/2);
+  top_.Emit(body, line_info);
+  os << "\n";
   LineInfoIncrease(line_info, 1);
-  absl::StrAppend(&result, "endmodule");
+  os << "endmodule";
   LineInfoEnd(line_info, this);
-  return result;
 }
 
 std::string Literal::Emit(LineInfo* line_info) const {
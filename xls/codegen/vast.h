@@ -20,6 +20,7 @@
 
 #include <limits>
 #include <memory>
+#include <ostream>
 #include <string>
 #include <utility>
 #include <vector>
@@ -138,6 +139,23 @@ class LineInfo {
   absl::flat_hash_map<const VastNode*, PartialLineSpans> spans_;
 };
 
+// Writes emitted Verilog text to a std::ostream, indenting each non-empty line
+// by a fixed number of spaces. Writing text in pieces produces the same output
+// as writing Indent() of the concatenated text, so large constructs can be
+// emitted piece by piece rather than built as a single string.
+class IndentedOstream {
+ public:
+  IndentedOstream(std::ostream& os, int64_t spaces)
+      : os_(os), indent_(spaces, ' ') {}
+
+  void Write(absl::string_view text);
+
+ private:
+  std::ostream& os_;
+  std::string indent_;
+  bool at_line_start_ = true;
+};
+
 // Returns a sanitized identifier string based on the given name. Invalid
 // characters are replaced with '_'.
 std::string SanitizeIdentifier(absl::string_view name);
@@ -1436,6 +1454,10 @@ class ModuleSection : public VastNode {
 
   std::string Emit(LineInfo* line_info) const override;
 
+  // Emits the section to `out` one member at a time. Equivalent to writing the
+  // result of Emit().
+  void Emit(IndentedOstream& out, LineInfo* line_info) const;
+
  private:
   std::vector<ModuleMember> members_;
 };
@@ -1502,6 +1524,11 @@ class Module : public VastNode {
 
   std::string Emit(LineInfo* line_info) const override;
 
+  // Emits the module to `os` one member at a time, so that the text of the
+  // entire module is never held in memory. Equivalent to writing the result of
+  // Emit().
+  void Emit(std::ostream& os, LineInfo* line_info) const;
+
  private:
   // Add the given Def as a port on the module.
   LogicRef* AddPortDef(Direction direction, Def* def,
@@ -1560,6 +1587,11 @@ class VerilogFile {
 
   std::string Emit(LineInfo* line_info = nullptr) const;
 
+  // Emits the file to `os`. Modules are written one member at a time so the
+  // memory required is bounded by the largest module member rather than the
+  // size of the file. Equivalent to writing the result of Emit().
+  void Emit(std::ostream& os, LineInfo* line_info = nullptr) const;
+
   verilog::Slice* Slice(IndexableExpression* subject, Expression* hi,
                         Expression* lo, std::optional<SourceLocation> loc) {
     return Make<verilog::Slice>(loc, subject, hi, lo);
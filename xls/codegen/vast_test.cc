@@ -14,6 +14,8 @@
 
 #include "xls/codegen/vast.h"
 
+#include <sstream>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/strings/str_cat.h"
@@ -1092,6 +1094,50 @@ endmodule)");
             std::vector<LineSpan>{LineSpan(7, 7)});
 }
 
+TEST_P(VastTest, EmitToStream) {
+  VerilogFile f(UseSystemVerilog());
+  f.AddInclude("foo.v", std::nullopt);
+  f.Add(f.Make<BlankLine>(std::nullopt));
+  Module* m0 = f.AddModule("m0", std::nullopt);
+  LogicRef* a = m0->AddInput("a", f.BitVectorType(8, std::nullopt),
+                             std::nullopt);
+  LogicRef* b = m0->AddOutput("b", f.BitVectorType(8, std::nullopt),
+                              std::nullopt);
+  ModuleSection* section = m0->Add<ModuleSection>(std::nullopt);
+  // An empty nested section and a section containing only empty sections.
+  section->Add<ModuleSection>(std::nullopt);
+  section->Add<ModuleSection>(std::nullopt)->Add<ModuleSection>(std::nullopt);
+  LogicRef* c = m0->AddWire("c", f.BitVectorType(8, std::nullopt),
+                            std::nullopt, section);
+  AlwaysComb* ac = section->Add<AlwaysComb>(std::nullopt);
+  ac->statements()->Add<BlockingAssignment>(std::nullopt, c, a);
+  m0->Add<Comment>(std::nullopt, "multi-line\ncomment");
+  m0->Add<BlankLine>(std::nullopt);
+  m0->Add<ContinuousAssignment>(std::nullopt, b, c);
+  f.AddModule("m1", std::nullopt);
+
+  LineInfo string_line_info;
+  std::string text = f.Emit(&string_line_info);
+
+  std::ostringstream os;
+  LineInfo stream_line_info;
+  f.Emit(os, &stream_line_info);
+  EXPECT_EQ(os.str(), text);
+  EXPECT_THAT(text, HasSubstr(R"(  always_comb begin
+    c = a;
+  end
+  // multi-line
+  // comment
+
+  assign b = c;
+endmodule)"));
+
+  for (const VastNode* node : std::vector<const VastNode*>{m0, section, ac}) {
+    EXPECT_EQ(stream_line_info.LookupNode(node),
+              string_line_info.LookupNode(node));
+  }
+}
+
 TEST_P(VastTest, VerilogFunction) {
   VerilogFile f(UseSystemVerilog());
   Module* m = f.AddModule("top", std::nullopt);
@@ -0,0 +1,95 @@
+// Copyright 2022 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/common/thread_pool.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/status_macros.h"
+
+namespace xls {
+
+ThreadPool::ThreadPool(int64_t thread_count) {
+  XLS_CHECK_GT(thread_count, 0);
+  threads_.reserve(thread_count);
+  for (int64_t i = 0; i < thread_count; ++i) {
+    threads_.push_back(std::make_unique<Thread>([this] { WorkLoop(); }));
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    absl::MutexLock lock(&mutex_);
+    shutting_down_ = true;
+  }
+  for (std::unique_ptr<Thread>& thread : threads_) {
+    thread->Join();
+  }
+}
+
+void ThreadPool::Schedule(std::function<void()> fn) {
+  absl::MutexLock lock(&mutex_);
+  XLS_CHECK(!shutting_down_);
+  queue_.push_back(std::move(fn));
+  ++outstanding_;
+}
+
+void ThreadPool::WaitForIdle() {
+  absl::MutexLock lock(&mutex_);
+  mutex_.Await(absl::Condition(this, &ThreadPool::IsIdle));
+}
+
+void ThreadPool::WorkLoop() {
+  while (true) {
+    std::function<void()> fn;
+    {
+      absl::MutexLock lock(&mutex_);
+      mutex_.Await(absl::Condition(this, &ThreadPool::HasWorkOrShutdown));
+      // Closures scheduled before shutdown are still run.
+      if (queue_.empty()) {
+        return;
+      }
+      fn = std::move(queue_.front());
+      queue_.pop_front();
+    }
+    fn();
+    absl::MutexLock lock(&mutex_);
+    --outstanding_;
+  }
+}
+
+absl::Status ParallelFor(int64_t count, int64_t thread_count,
+                         const std::function<absl::Status(int64_t)>& fn) {
+  if (thread_count <= 1 || count <= 1) {
+    for (int64_t i = 0; i < count; ++i) {
+      XLS_RETURN_IF_ERROR(fn(i));
+    }
+    return absl::OkStatus();
+  }
+  std::vector<absl::Status> statuses(count);
+  {
+    ThreadPool pool(std::min(thread_count, count));
+    for (int64_t i = 0; i < count; ++i) {
+      pool.Schedule([&fn, &statuses, i] { statuses[i] = fn(i); });
+    }
+  }
+  for (absl::Status& status : statuses) {
+    XLS_RETURN_IF_ERROR(status);
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace xls
@@ -0,0 +1,80 @@
+// Copyright 2022 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_COMMON_THREAD_POOL_H_
+#define XLS_COMMON_THREAD_POOL_H_
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+#include "xls/common/thread.h"
+
+namespace xls {
+
+// A fixed-size pool of threads which execute scheduled closures in the order
+// in which they were scheduled.
+class ThreadPool {
+ public:
+  // Creates a pool with the given number of threads, which must be positive.
+  explicit ThreadPool(int64_t thread_count);
+
+  // Waits for all scheduled closures to complete and joins the threads.
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  int64_t thread_count() const { return threads_.size(); }
+
+  // Schedules the given closure for execution on one of the threads.
+  void Schedule(std::function<void()> fn);
+
+  // Blocks until all closures scheduled so far have completed.
+  void WaitForIdle();
+
+ private:
+  void WorkLoop();
+
+  bool IsIdle() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return outstanding_ == 0;
+  }
+  bool HasWorkOrShutdown() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return !queue_.empty() || shutting_down_;
+  }
+
+  absl::Mutex mutex_;
+  std::deque<std::function<void()>> queue_ ABSL_GUARDED_BY(mutex_);
+  // The number of scheduled closures which have not completed.
+  int64_t outstanding_ ABSL_GUARDED_BY(mutex_) = 0;
+  bool shutting_down_ ABSL_GUARDED_BY(mutex_) = false;
+  std::vector<std::unique_ptr<Thread>> threads_;
+};
+
+// Calls `fn` for each index in [0, count) using up to `thread_count`
+// threads. If `thread_count` is at most one, the calls are made sequentially
+// on the calling thread and stop at the first error. Otherwise all calls are
+// made and the error of the lowest failing index is returned, so the result
+// does not depend on thread scheduling.
+absl::Status ParallelFor(int64_t count, int64_t thread_count,
+                         const std::function<absl::Status(int64_t)>& fn);
+
+}  // namespace xls
+
+#endif  // XLS_COMMON_THREAD_POOL_H_
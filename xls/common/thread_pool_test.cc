@@ -0,0 +1,72 @@
+// Copyright 2022 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/common/thread_pool.h"
+
+#include <atomic>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "xls/common/status/matchers.h"
+
+namespace xls {
+namespace {
+
+using status_testing::StatusIs;
+
+TEST(ThreadPoolTest, RunsAllScheduledClosures) {
+  std::atomic<int64_t> sum = 0;
+  {
+    ThreadPool pool(4);
+    EXPECT_EQ(pool.thread_count(), 4);
+    for (int64_t i = 1; i <= 100; ++i) {
+      pool.Schedule([&sum, i] { sum += i; });
+    }
+    pool.WaitForIdle();
+    EXPECT_EQ(sum, 5050);
+    pool.Schedule([&sum] { sum += 1; });
+  }
+  EXPECT_EQ(sum, 5051);
+}
+
+TEST(ThreadPoolTest, ParallelForVisitsEveryIndex) {
+  for (int64_t thread_count : {1, 2, 8}) {
+    std::vector<int64_t> visited(37, 0);
+    XLS_ASSERT_OK(ParallelFor(visited.size(), thread_count, [&](int64_t i) {
+      ++visited[i];
+      return absl::OkStatus();
+    }));
+    EXPECT_THAT(visited, ::testing::Each(1));
+  }
+}
+
+TEST(ThreadPoolTest, ParallelForReturnsErrorOfLowestIndex) {
+  for (int64_t thread_count : {1, 4}) {
+    EXPECT_THAT(ParallelFor(20, thread_count,
+                            [](int64_t i) {
+                              if (i == 7 || i == 13) {
+                                return absl::InternalError(
+                                    absl::StrCat("failed ", i));
+                              }
+                              return absl::OkStatus();
+                            }),
+                StatusIs(absl::StatusCode::kInternal, "failed 7"));
+  }
+}
+
+}  // namespace
+}  // namespace xls
@@ -14,7 +14,9 @@
 
 #include "xls/data_structures/binary_decision_diagram.h"
 
+#include <algorithm>
 #include <limits>
+#include <utility>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -27,49 +29,100 @@
 
 namespace xls {
 
+namespace {
+
+// Bounds on the number of entries in the computed table.
+constexpr int64_t kMinIteCacheSize = int64_t{1} << 10;
+constexpr int64_t kMaxIteCacheSize = int64_t{1} << 20;
+
+int32_t SaturatingPathCount(int64_t a, int64_t b) {
+  // Use int64s to avoid overflowing and saturate at INT32_MAX.
+  return std::min(a + b,
+                  static_cast<int64_t>(std::numeric_limits<int32_t>::max()));
+}
+
+}  // namespace
+
 BinaryDecisionDiagram::BinaryDecisionDiagram() {
-  // Leaf node 0.
-  nodes_.push_back(BddNode(BddVariable(-1), BddNodeIndex(-1), BddNodeIndex(-1),
-                           /*p=*/1));
-  // Leaf node 1.
+  // Leaf node 1. Leaf node 0 is its complement.
   nodes_.push_back(BddNode(BddVariable(-1), BddNodeIndex(-1), BddNodeIndex(-1),
                            /*p=*/1));
+  ResetIteCache();
+}
+
+void BinaryDecisionDiagram::ResetIteCache() {
+  int64_t cache_size = kMinIteCacheSize;
+  while (cache_size < size() && cache_size < kMaxIteCacheSize) {
+    cache_size *= 2;
+  }
+  ite_cache_.assign(cache_size, IteCacheEntry());
+}
+
+BinaryDecisionDiagram::IteCacheEntry& BinaryDecisionDiagram::GetIteCacheEntry(
+    BddNodeIndex cond, BddNodeIndex if_true, BddNodeIndex if_false) {
+  uint64_t hash = static_cast<uint64_t>(cond.value()) * 0x9E3779B97F4A7C15ULL;
+  hash ^= static_cast<uint64_t>(if_true.value()) * 0xC2B2AE3D27D4EB4FULL;
+  hash ^= static_cast<uint64_t>(if_false.value()) * 0x165667B19E3779F9ULL;
+  return ite_cache_[(hash >> 20) & (ite_cache_.size() - 1)];
 }
 
 BddNodeIndex BinaryDecisionDiagram::GetOrCreateNode(BddVariable var,
                                                     BddNodeIndex high,
                                                     BddNodeIndex low) {
+  if (low == high) {
+    return low;
+  }
+  // Canonicalize so that the high edge is never complemented.
+  if (IsComplemented(high)) {
+    return Not(GetOrCreateNode(var, Not(high), Not(low)));
+  }
   NodeKey key = std::make_tuple(var, high, low);
   auto it = node_map_.find(key);
   if (it != node_map_.end()) {
     return it->second;
   }
-  if (low == high) {
-    return low;
-  }
   // Compute the number of paths that the new node will have to the terminal
-  // nodes 0 and 1. Use int64s to avoid overflowing and saturate at INT32_MAX.
-  int32_t paths = std::min(
-      static_cast<int64_t>(GetNode(low).path_count) + GetNode(high).path_count,
-      static_cast<int64_t>(std::numeric_limits<int32_t>::max()));
-  nodes_.emplace_back(var, high, low, paths);
-  BddNodeIndex node_index = BddNodeIndex(nodes_.size() - 1);
+  // nodes 0 and 1.
+  int32_t paths =
+      SaturatingPathCount(GetNode(low).path_count, GetNode(high).path_count);
+  int64_t index;
+  if (free_nodes_.empty()) {
+    index = nodes_.size();
+    nodes_.emplace_back(var, high, low, paths);
+  } else {
+    index = free_nodes_.back();
+    free_nodes_.pop_back();
+    nodes_[index] = BddNode(var, high, low, paths);
+  }
+  BddNodeIndex node_index = EdgeToNode(index);
   node_map_[key] = node_index;
+  if (sifting_) {
+    if (index >= ref_counts_.size()) {
+      ref_counts_.resize(index + 1, 0);
+    }
+    ref_counts_[index] = 0;
+    Ref(high);
+    Ref(low);
+    created_nodes_.push_back(index);
+  } else if (size() > 2 * ite_cache_.size() &&
+             ite_cache_.size() < kMaxIteCacheSize) {
+    ResetIteCache();
+  }
   return node_index;
 }
 
-BddNodeIndex BinaryDecisionDiagram::Restrict(BddNodeIndex expr, BddVariable var,
-                                             bool value) {
-  if (expr == zero() || expr == one()) {
+BddNodeIndex BinaryDecisionDiagram::Restrict(BddNodeIndex expr, int64_t level,
+                                             bool value) const {
+  if (IsTerminal(expr)) {
     return expr;
   }
-
-  const BddNode& node = GetNode(expr);
-  XLS_CHECK_LE(var, node.variable);
-  if (node.variable == var) {
-    return value ? node.high : node.low;
+  XLS_CHECK_LE(level, Level(expr));
+  if (Level(expr) != level) {
+    return expr;
   }
-  return expr;
+  const BddNode& node = GetNode(expr);
+  BddNodeIndex child = value ? node.high : node.low;
+  return IsComplemented(expr) ? Not(child) : child;
 }
 
 BddNodeIndex BinaryDecisionDiagram::IfThenElse(BddNodeIndex cond,
@@ -81,64 +134,87 @@ BddNodeIndex BinaryDecisionDiagram::IfThenElse(BddNodeIndex cond,
   if (cond == zero()) {
     return if_false;
   }
-  if (if_true == one() && if_false == zero()) {
-    return cond;
+  // Simplify the branches which are equal to the condition or its inverse.
+  if (if_true == cond) {
+    if_true = one();
+  } else if (if_true == Not(cond)) {
+    if_true = zero();
+  }
+  if (if_false == cond) {
+    if_false = zero();
+  } else if (if_false == Not(cond)) {
+    if_false = one();
   }
   if (if_true == if_false) {
     return if_true;
   }
-  auto key = std::make_tuple(cond, if_true, if_false);
-  auto it = ite_map_.find(key);
-  if (it != ite_map_.end()) {
-    return it->second;
+  if (if_true == one() && if_false == zero()) {
+    return cond;
+  }
+  if (if_true == zero() && if_false == one()) {
+    return Not(cond);
+  }
+
+  // Normalize the expression so that the condition and the if-true branch are
+  // not complemented. This improves the hit rate of the computed table.
+  if (IsComplemented(cond)) {
+    cond = Not(cond);
+    std::swap(if_true, if_false);
+  }
+  bool complement_result = false;
+  if (IsComplemented(if_true)) {
+    if_true = Not(if_true);
+    if_false = Not(if_false);
+    complement_result = true;
+  }
+  auto maybe_complement = [&](BddNodeIndex expr) {
+    return complement_result ? Not(expr) : expr;
+  };
+
+  const IteCacheEntry& entry = GetIteCacheEntry(cond, if_true, if_false);
+  if (entry.cond == cond && entry.if_true == if_true &&
+      entry.if_false == if_false) {
+    return maybe_complement(entry.result);
   }
 
   // The expression is non-trivial and has not been computed before. Recursively
   // decompose the expression by peeling away the first variable and performing
   // a Shannon decomposition.
 
-  // First, find the lowest-index variable amongst all expressions. In all paths
-  // through the BDD the variable indices are strictly increasing.
-  BddVariable min_var = GetNode(cond).variable;
-  // Only non-leaf nodes (not zero or one) have associated variables.
-  if (if_true != zero() && if_true != one()) {
-    min_var = std::min(min_var, GetNode(if_true).variable);
-  }
-  if (if_false != zero() && if_false != one()) {
-    min_var = std::min(min_var, GetNode(if_false).variable);
-  }
+  // First, find the top-most variable amongst all expressions. In all paths
+  // through the BDD the variable levels are strictly increasing.
+  int64_t min_level =
+      std::min({Level(cond), Level(if_true), Level(if_false)});
 
   // Perform a Shannon expansion about the variable where Shannon expansion is
   // the identity:
   //
   //   F(x0, x1, ..) = !x0 && F(0, x1, ...) + x0 && F(1, x1, ...)
   //
-  BddNodeIndex true_cofactor = IfThenElse(Restrict(cond, min_var, true),
-                                          Restrict(if_true, min_var, true),
-                                          Restrict(if_false, min_var, true));
-  BddNodeIndex false_cofactor = IfThenElse(Restrict(cond, min_var, false),
-                                           Restrict(if_true, min_var, false),
-                                           Restrict(if_false, min_var, false));
-
-  if (true_cofactor == false_cofactor) {
-    ite_map_[key] = true_cofactor;
-    return true_cofactor;
-  }
-  BddNodeIndex expr = GetOrCreateNode(min_var, true_cofactor, false_cofactor);
-  ite_map_[key] = expr;
-  return expr;
+  BddNodeIndex true_cofactor = IfThenElse(Restrict(cond, min_level, true),
+                                          Restrict(if_true, min_level, true),
+                                          Restrict(if_false, min_level, true));
+  BddNodeIndex false_cofactor =
+      IfThenElse(Restrict(cond, min_level, false),
+                 Restrict(if_true, min_level, false),
+                 Restrict(if_false, min_level, false));
+  BddNodeIndex expr = GetOrCreateNode(variables_by_level_[min_level],
+                                      true_cofactor, false_cofactor);
+  // The recursive calls may have resized the computed table so look up the
+  // entry again.
+  GetIteCacheEntry(cond, if_true, if_false) =
+      IteCacheEntry{cond, if_true, if_false, expr};
+  return maybe_complement(expr);
 }
 
 BddNodeIndex BinaryDecisionDiagram::NewVariable() {
   BddVariable var = next_var_;
   ++next_var_;
+  levels_.push_back(variables_by_level_.size());
+  variables_by_level_.push_back(var);
   return GetOrCreateNode(var, one(), zero());
 }
 
-BddNodeIndex BinaryDecisionDiagram::Not(BddNodeIndex expr) {
-  return IfThenElse(expr, zero(), one());
-}
-
 BddNodeIndex BinaryDecisionDiagram::Or(BddNodeIndex a, BddNodeIndex b) {
   return IfThenElse(a, one(), b);
 }
@@ -147,6 +223,245 @@ BddNodeIndex BinaryDecisionDiagram::And(BddNodeIndex a, BddNodeIndex b) {
   return IfThenElse(a, b, zero());
 }
 
+std::vector<bool> BinaryDecisionDiagram::MarkReachable(
+    absl::Span<const BddNodeIndex> roots) const {
+  std::vector<bool> marked(nodes_.size(), false);
+  std::vector<BddNodeIndex> worklist(roots.begin(), roots.end());
+  for (BddVariable var(0); var < next_var_; ++var) {
+    worklist.push_back(GetVariableBaseNode(var));
+  }
+  marked[0] = true;
+  while (!worklist.empty()) {
+    int64_t index = worklist.back().value() >> 1;
+    worklist.pop_back();
+    if (marked[index]) {
+      continue;
+    }
+    marked[index] = true;
+    worklist.push_back(nodes_[index].high);
+    worklist.push_back(nodes_[index].low);
+  }
+  return marked;
+}
+
+int64_t BinaryDecisionDiagram::GarbageCollect(
+    absl::Span<const BddNodeIndex> roots) {
+  std::vector<bool> marked = MarkReachable(roots);
+  int64_t reclaimed = 0;
+  for (int64_t i = 1; i < nodes_.size(); ++i) {
+    const BddNode& node = nodes_[i];
+    if (marked[i] || node.path_count == 0) {
+      continue;
+    }
+    node_map_.erase(std::make_tuple(node.variable, node.high, node.low));
+    nodes_[i] = BddNode();
+    free_nodes_.push_back(i);
+    ++reclaimed;
+  }
+  // The computed table may refer to reclaimed nodes.
+  ResetIteCache();
+  XLS_VLOG(2) << absl::StreamFormat(
+      "BDD garbage collection reclaimed %d nodes, %d nodes remain", reclaimed,
+      size());
+  return reclaimed;
+}
+
+void BinaryDecisionDiagram::Ref(BddNodeIndex expr) {
+  if (!IsTerminal(expr)) {
+    ++ref_counts_[expr.value() >> 1];
+  }
+}
+
+void BinaryDecisionDiagram::Deref(BddNodeIndex expr) {
+  if (IsTerminal(expr)) {
+    return;
+  }
+  int64_t index = expr.value() >> 1;
+  XLS_DCHECK_GT(ref_counts_[index], 0);
+  if (--ref_counts_[index] > 0) {
+    return;
+  }
+  BddNode node = nodes_[index];
+  node_map_.erase(std::make_tuple(node.variable, node.high, node.low));
+  nodes_[index] = BddNode();
+  free_nodes_.push_back(index);
+  Deref(node.high);
+  Deref(node.low);
+}
+
+void BinaryDecisionDiagram::SwapAdjacentLevels(int64_t level) {
+  BddVariable x = variables_by_level_[level];
+  BddVariable y = variables_by_level_[level + 1];
+  std::swap(variables_by_level_[level], variables_by_level_[level + 1]);
+  levels_[x.value()] = level + 1;
+  levels_[y.value()] = level;
+
+  // Returns the cofactors of `expr` with respect to `y`.
+  auto y_cofactors =
+      [&](BddNodeIndex expr) -> std::pair<BddNodeIndex, BddNodeIndex> {
+    if (IsTerminal(expr) || GetNode(expr).variable != y) {
+      return {expr, expr};
+    }
+    const BddNode& node = GetNode(expr);
+    if (IsComplemented(expr)) {
+      return {Not(node.high), Not(node.low)};
+    }
+    return {node.high, node.low};
+  };
+
+  std::vector<int64_t> candidates = nodes_by_variable_[x.value()];
+  int64_t x_node_count = candidates.size();
+  candidates.insert(candidates.end(), nodes_by_variable_[y.value()].begin(),
+                    nodes_by_variable_[y.value()].end());
+  created_nodes_.clear();
+  for (int64_t i = 0; i < x_node_count; ++i) {
+    int64_t index = candidates[i];
+    // Copy the node as creating nodes may reallocate the node vector.
+    BddNode node = nodes_[index];
+    bool high_is_y = !IsTerminal(node.high) && GetNode(node.high).variable == y;
+    bool low_is_y = !IsTerminal(node.low) && GetNode(node.low).variable == y;
+    if (!high_is_y && !low_is_y) {
+      // The node does not depend on `y` and simply moves down a level.
+      continue;
+    }
+    // Rewrite the node F = x ? (y ? F11 : F10) : (y ? F01 : F00) in place as
+    // y ? (x ? F11 : F01) : (x ? F10 : F00).
+    auto [f11, f10] = y_cofactors(node.high);
+    auto [f01, f00] = y_cofactors(node.low);
+    BddNodeIndex new_high = GetOrCreateNode(x, f11, f01);
+    Ref(new_high);
+    BddNodeIndex new_low = GetOrCreateNode(x, f10, f00);
+    Ref(new_low);
+    XLS_DCHECK(!IsComplemented(new_high));
+    node_map_.erase(std::make_tuple(x, node.high, node.low));
+    nodes_[index].variable = y;
+    nodes_[index].high = new_high;
+    nodes_[index].low = new_low;
+    node_map_[std::make_tuple(y, new_high, new_low)] = EdgeToNode(index);
+    Deref(node.high);
+    Deref(node.low);
+  }
+
+  // Rebuild the lists of the nodes of each variable. Reclaimed nodes may have
+  // been reused so remove duplicates.
+  candidates.insert(candidates.end(), created_nodes_.begin(),
+                    created_nodes_.end());
+  std::sort(candidates.begin(), candidates.end());
+  candidates.erase(std::unique(candidates.begin(), candidates.end()),
+                   candidates.end());
+  nodes_by_variable_[x.value()].clear();
+  nodes_by_variable_[y.value()].clear();
+  for (int64_t index : candidates) {
+    const BddNode& node = nodes_[index];
+    if (node.path_count == 0) {
+      continue;
+    }
+    if (node.variable == x || node.variable == y) {
+      nodes_by_variable_[node.variable.value()].push_back(index);
+    }
+  }
+}
+
+void BinaryDecisionDiagram::RecomputePathCounts() {
+  std::vector<int64_t> live_nodes;
+  for (int64_t i = 1; i < nodes_.size(); ++i) {
+    if (nodes_[i].path_count != 0) {
+      live_nodes.push_back(i);
+    }
+  }
+  // Children are at higher levels than their parents.
+  std::sort(live_nodes.begin(), live_nodes.end(), [&](int64_t a, int64_t b) {
+    return levels_[nodes_[a].variable.value()] >
+           levels_[nodes_[b].variable.value()];
+  });
+  for (int64_t index : live_nodes) {
+    BddNode& node = nodes_[index];
+    node.path_count = SaturatingPathCount(GetNode(node.high).path_count,
+                                          GetNode(node.low).path_count);
+  }
+}
+
+void BinaryDecisionDiagram::Sift(absl::Span<const BddNodeIndex> roots,
+                                 double max_growth) {
+  GarbageCollect(roots);
+  if (variable_count() < 2) {
+    return;
+  }
+  int64_t initial_size = size();
+
+  // Set up the reference counts and the lists of nodes of each variable.
+  sifting_ = true;
+  ref_counts_.assign(nodes_.size(), 0);
+  nodes_by_variable_.assign(variable_count(), {});
+  for (int64_t i = 1; i < nodes_.size(); ++i) {
+    const BddNode& node = nodes_[i];
+    if (node.path_count == 0) {
+      continue;
+    }
+    Ref(node.high);
+    Ref(node.low);
+    nodes_by_variable_[node.variable.value()].push_back(i);
+  }
+  for (BddNodeIndex root : roots) {
+    Ref(root);
+  }
+  for (BddVariable var(0); var < next_var_; ++var) {
+    Ref(GetVariableBaseNode(var));
+  }
+
+  // Sift the variables with the most nodes first.
+  std::vector<BddVariable> order(variables_by_level_);
+  std::stable_sort(order.begin(), order.end(),
+                   [&](BddVariable a, BddVariable b) {
+                     return nodes_by_variable_[a.value()].size() >
+                            nodes_by_variable_[b.value()].size();
+                   });
+  int64_t level_count = levels_.size();
+  for (BddVariable var : order) {
+    int64_t level = levels_[var.value()];
+    int64_t best_size = size();
+    int64_t best_level = level;
+    auto exceeds_growth = [&]() {
+      if (size() < best_size) {
+        best_size = size();
+        best_level = level;
+      }
+      return size() > max_growth * best_size;
+    };
+    while (level < level_count - 1) {
+      SwapAdjacentLevels(level);
+      ++level;
+      if (exceeds_growth()) {
+        break;
+      }
+    }
+    while (level > 0) {
+      SwapAdjacentLevels(level - 1);
+      --level;
+      if (exceeds_growth()) {
+        break;
+      }
+    }
+    while (level < best_level) {
+      SwapAdjacentLevels(level);
+      ++level;
+    }
+    while (level > best_level) {
+      SwapAdjacentLevels(level - 1);
+      --level;
+    }
+  }
+
+  sifting_ = false;
+  ref_counts_.clear();
+  nodes_by_variable_.clear();
+  created_nodes_.clear();
+  RecomputePathCounts();
+  ResetIteCache();
+  XLS_VLOG(2) << absl::StreamFormat("BDD sifting: %d nodes => %d nodes",
+                                    initial_size, size());
+}
+
 absl::StatusOr<bool> BinaryDecisionDiagram::Evaluate(
     BddNodeIndex expr,
     const absl::flat_hash_map<BddNodeIndex, bool>& variable_values) const {
@@ -165,15 +480,16 @@ absl::StatusOr<bool> BinaryDecisionDiagram::Evaluate(
                   << variable_values.at(node);
     }
   }
-  while (result != zero() && result != one()) {
-    BddNodeIndex var_node = GetVariableBaseNode(GetNode(result).variable);
+  while (!IsTerminal(result)) {
+    const BddNode& node = GetNode(result);
+    BddNodeIndex var_node = GetVariableBaseNode(node.variable);
     if (!variable_values.contains(var_node)) {
       return absl::InvalidArgumentError(
           absl::StrFormat("Missing value for BDD variable %d (node index %d)",
-                          GetNode(result).variable.value(), var_node.value()));
+                          node.variable.value(), var_node.value()));
     }
-    result = variable_values.at(var_node) ? GetNode(result).high
-                                          : GetNode(result).low;
+    BddNodeIndex child = variable_values.at(var_node) ? node.high : node.low;
+    result = IsComplemented(result) ? Not(child) : child;
   }
   XLS_VLOG(2) << "  result = " << (result == one() ? true : false);
   return result == one();
@@ -205,10 +521,12 @@ void BinaryDecisionDiagram::ToStringDnfHelper(BddNodeIndex expr,
   }
 
   const BddNode& node = GetNode(expr);
+  BddNodeIndex high = IsComplemented(expr) ? Not(node.high) : node.high;
+  BddNodeIndex low = IsComplemented(expr) ? Not(node.low) : node.low;
   terms->push_back(absl::StrCat("x", node.variable.value()));
-  ToStringDnfHelper(node.high, minterms_to_emit, terms, str);
+  ToStringDnfHelper(high, minterms_to_emit, terms, str);
   terms->back() = absl::StrCat("!x", node.variable.value());
-  ToStringDnfHelper(node.low, minterms_to_emit, terms, str);
+  ToStringDnfHelper(low, minterms_to_emit, terms, str);
   terms->pop_back();
 }
 
@@ -16,9 +16,13 @@
 #define XLS_DATA_STRUCTURES_BINARY_DECISION_DIAGRAM_H_
 
 #include <cstdint>
+#include <string>
+#include <tuple>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "xls/common/strong_int.h"
 
 namespace xls {
@@ -34,6 +38,13 @@ namespace xls {
 
 // For efficiency variables and nodes are referred to by indices into vector
 // data members in the BDD.
+//
+// The BDD uses complement edges: the least significant bit of a BddNodeIndex
+// indicates whether the edge is complemented (i.e., refers to the inverse of
+// the expression of the node) and the remaining bits are the index of the node
+// in the BDD. Negation is therefore a constant-time operation which does not
+// create any nodes. To keep the representation canonical, the high edge of a
+// node is never complemented.
 DEFINE_STRONG_INT_TYPE(BddVariable, int32_t);
 DEFINE_STRONG_INT_TYPE(BddNodeIndex, int32_t);
 
@@ -51,30 +62,33 @@ struct BddNode {
 
   // Number of paths from this node to the terminal nodes 0 and 1. Used to limit
   // the growth of the BDD by halting evaluation if the number of paths gets too
-  // large. Saturates at INT32_MAX.
+  // large. Saturates at INT32_MAX. Zero for nodes which have been reclaimed by
+  // garbage collection.
   int32_t path_count;
 };
 
 class BinaryDecisionDiagram {
  public:
-  // Creates an empty BDD. Initialize the BDD contains only the nodes
-  // corresponding to zero and one.
+  // Creates an empty BDD. Initially the BDD contains only the terminal node one
+  // (zero is its complement).
   BinaryDecisionDiagram();
 
   // Adds a new variable to the BDD and returns the node corresponding the
-  // variable's value.
+  // variable's value. New variables are ordered after all existing variables.
   BddNodeIndex NewVariable();
 
   // Returns the inverse of the given expression.
-  BddNodeIndex Not(BddNodeIndex expr);
+  BddNodeIndex Not(BddNodeIndex expr) const {
+    return BddNodeIndex(expr.value() ^ 1);
+  }
 
   // Returns the OR/AND of the given expressions.
   BddNodeIndex And(BddNodeIndex a, BddNodeIndex b);
   BddNodeIndex Or(BddNodeIndex a, BddNodeIndex b);
 
   // Returns the leaf node corresponding to zero or one.
-  BddNodeIndex zero() const { return BddNodeIndex(0); }
-  BddNodeIndex one() const { return BddNodeIndex(1); }
+  BddNodeIndex zero() const { return BddNodeIndex(1); }
+  BddNodeIndex one() const { return BddNodeIndex(0); }
 
   // Evaluates the given expression with the given variable values. The keys in
   // the map are the *node* indices of the respective variable (value returned
@@ -84,13 +98,15 @@ class BinaryDecisionDiagram {
       BddNodeIndex expr,
       const absl::flat_hash_map<BddNodeIndex, bool>& variable_values) const;
 
-  // Returns the BDD node with the given index.
+  // Returns the BDD node referred to by the given (possibly complemented)
+  // edge. The children of the node are relative to the uncomplemented
+  // expression.
   const BddNode& GetNode(BddNodeIndex node_index) const {
-    return nodes_.at(node_index.value());
+    return nodes_.at(node_index.value() >> 1);
   }
 
-  // Returns the number of nodes in the graph.
-  int64_t size() const { return nodes_.size(); }
+  // Returns the number of (live) nodes in the graph.
+  int64_t size() const { return nodes_.size() - free_nodes_.size(); }
 
   // Returns the number of variables in the graph.
   int64_t variable_count() const { return next_var_.value(); }
@@ -109,10 +125,57 @@ class BinaryDecisionDiagram {
   // variable. The expression of a base node is exactly equal to the value of
   // the variable.
   bool IsVariableBaseNode(BddNodeIndex expr) const {
-    return GetNode(expr).high == one() && GetNode(expr).low == zero();
+    return !IsComplemented(expr) && GetNode(expr).high == one() &&
+           GetNode(expr).low == zero();
+  }
+
+  // Reclaims all nodes which are not reachable from the given expressions and
+  // returns the number of nodes reclaimed. The variable base nodes are always
+  // retained. Expressions not reachable from `roots` are invalidated.
+  int64_t GarbageCollect(absl::Span<const BddNodeIndex> roots);
+
+  // Reorders the variables of the BDD using Rudell's sifting algorithm to
+  // reduce the number of nodes required to represent the given expressions.
+  // Each variable in turn is moved through all positions in the order and
+  // placed where the BDD is smallest. Moving a variable in one direction stops
+  // early once the BDD grows beyond `max_growth` times the smallest size seen.
+  // All expressions not reachable from `roots` are reclaimed. The BddNodeIndex
+  // values of the remaining expressions are unchanged, but their path counts
+  // and DNF representations reflect the new order.
+  void Sift(absl::Span<const BddNodeIndex> roots, double max_growth = 1.2);
+
+  // Returns the position of the given variable in the variable order. Variables
+  // with lower levels are closer to the root of the BDD.
+  int64_t GetVariableLevel(BddVariable variable) const {
+    return levels_.at(variable.value());
   }
 
  private:
+  // Entry in the computed table caching the results of if-then-else
+  // operations.
+  struct IteCacheEntry {
+    BddNodeIndex cond = BddNodeIndex(-1);
+    BddNodeIndex if_true;
+    BddNodeIndex if_false;
+    BddNodeIndex result;
+  };
+
+  static bool IsComplemented(BddNodeIndex expr) { return expr.value() & 1; }
+  static BddNodeIndex Regular(BddNodeIndex expr) {
+    return BddNodeIndex(expr.value() & ~1);
+  }
+  static BddNodeIndex EdgeToNode(int64_t node) {
+    return BddNodeIndex(static_cast<int32_t>(node << 1));
+  }
+  bool IsTerminal(BddNodeIndex expr) const { return expr.value() >> 1 == 0; }
+
+  // Returns the level of the variable of the given expression. Terminal nodes
+  // are below all variables.
+  int64_t Level(BddNodeIndex expr) const {
+    return IsTerminal(expr) ? levels_.size()
+                            : levels_[GetNode(expr).variable.value()];
+  }
+
   // Helper for constructing a DNF string respresentation.
   void ToStringDnfHelper(BddNodeIndex expr, int64_t* minterms_to_emit,
                          std::vector<std::string>* terms,
@@ -123,9 +186,9 @@ class BinaryDecisionDiagram {
   BddNodeIndex GetOrCreateNode(BddVariable var, BddNodeIndex high,
                                BddNodeIndex low);
 
-  // Returns the node equal to given expression with the given variable
-  // set to the given value.
-  BddNodeIndex Restrict(BddNodeIndex expr, BddVariable var, bool value);
+  // Returns the node equal to given expression with the variable at the given
+  // level set to the given value.
+  BddNodeIndex Restrict(BddNodeIndex expr, int64_t level, bool value) const;
 
   // Returns the node corresponding to the given if-then-else expression.
   BddNodeIndex IfThenElse(BddNodeIndex cond, BddNodeIndex if_true,
@@ -136,24 +199,66 @@ class BinaryDecisionDiagram {
     return node_map_.at({variable, one(), zero()});
   }
 
+  // Returns the slot in the computed table for the given if-then-else
+  // expression.
+  IteCacheEntry& GetIteCacheEntry(BddNodeIndex cond, BddNodeIndex if_true,
+                                  BddNodeIndex if_false);
+
+  // Clears the computed table, resizing it to track the size of the BDD.
+  void ResetIteCache();
+
+  // Marks all nodes reachable from `roots` and the variable base nodes.
+  std::vector<bool> MarkReachable(absl::Span<const BddNodeIndex> roots) const;
+
+  // Helpers for sifting which maintain the reference counts in `ref_counts_`.
+  void Ref(BddNodeIndex expr);
+  void Deref(BddNodeIndex expr);
+
+  // Swaps the variables at the given level and the level below it in the
+  // variable order. Nodes of the upper variable are rewritten in place so
+  // existing BddNodeIndex values continue to refer to the same expressions.
+  // Requires reference counts to be valid.
+  void SwapAdjacentLevels(int64_t level);
+
+  // Recomputes the path counts of all nodes, e.g., after reordering.
+  void RecomputePathCounts();
+
   // The numeric id to use for the next created variable. Increments with each
   // call to NewVariable which
   BddVariable next_var_ = BddVariable(0);
 
-  // The vector of all the nodes in the BDD.
+  // The vector of all the nodes in the BDD. The node at index 0 is the terminal
+  // node one. The terminal node zero is the complement of one.
   std::vector<BddNode> nodes_;
 
+  // Indices of nodes reclaimed by garbage collection which can be reused.
+  std::vector<int64_t> free_nodes_;
+
+  // The level of each variable in the variable order, and the inverse mapping.
+  std::vector<int64_t> levels_;
+  std::vector<BddVariable> variables_by_level_;
+
   // A map from BDD node content (variable id, high child, low child) to the
   // index of the respective node. This map is used to ensure that no duplicate
   // nodes are created.
   using NodeKey = std::tuple<BddVariable, BddNodeIndex, BddNodeIndex>;
   absl::flat_hash_map<NodeKey, BddNodeIndex> node_map_;
 
-  // A map from if-then-else expression to the node corresponding to that
-  // expression. The key elements are (condition, if-true, if-false). This map
-  // enables fast lookup for expressions.
-  using IteKey = std::tuple<BddNodeIndex, BddNodeIndex, BddNodeIndex>;
-  absl::flat_hash_map<IteKey, BddNodeIndex> ite_map_;
+  // The computed table: a lossy, direct-mapped cache of if-then-else results.
+  // Its size is a power of two which grows with the size of the BDD up to a
+  // fixed limit so the memory used by the cache is bounded.
+  std::vector<IteCacheEntry> ite_cache_;
+
+  // Reference counts of the nodes and the nodes of each variable. Only
+  // maintained during sifting.
+  std::vector<int64_t> ref_counts_;
+  std::vector<std::vector<int64_t>> nodes_by_variable_;
+
+  // Nodes created during the current level swap.
+  std::vector<int64_t> created_nodes_;
+
+  // Whether the BDD is being reordered.
+  bool sifting_ = false;
 };
 
 }  // namespace xls
@@ -306,5 +306,114 @@ TEST(BinaryDecisionDiagramTest, ThreeVariableExhaustive) {
   }
 }
 
+TEST(BinaryDecisionDiagramTest, ComplementEdges) {
+  BinaryDecisionDiagram bdd;
+  BddNodeIndex x = bdd.NewVariable();
+  BddNodeIndex y = bdd.NewVariable();
+  BddNodeIndex x_and_y = bdd.And(x, y);
+
+  // Negation does not create any nodes.
+  int64_t before_size = bdd.size();
+  BddNodeIndex nand = bdd.Not(x_and_y);
+  EXPECT_EQ(bdd.size(), before_size);
+  EXPECT_EQ(bdd.Not(nand), x_and_y);
+  EXPECT_EQ(bdd.Not(bdd.one()), bdd.zero());
+
+  // De Morgan's law holds structurally.
+  EXPECT_EQ(bdd.Or(bdd.Not(x), bdd.Not(y)), nand);
+  EXPECT_EQ(bdd.size(), before_size);
+
+  EXPECT_TRUE(bdd.IsVariableBaseNode(x));
+  EXPECT_FALSE(bdd.IsVariableBaseNode(bdd.Not(x)));
+  EXPECT_EQ(bdd.ToStringDnf(nand), "x0.!x1 + !x0");
+  EXPECT_THAT(bdd.Evaluate(nand, {{x, true}, {y, true}}), IsOkAndHolds(false));
+  EXPECT_THAT(bdd.Evaluate(nand, {{x, true}, {y, false}}), IsOkAndHolds(true));
+}
+
+TEST(BinaryDecisionDiagramTest, GarbageCollection) {
+  BinaryDecisionDiagram bdd;
+  std::vector<BddNodeIndex> vars;
+  for (int64_t i = 0; i < 8; ++i) {
+    vars.push_back(bdd.NewVariable());
+  }
+  int64_t base_size = bdd.size();
+
+  BddNodeIndex keep = bdd.Or(bdd.And(vars[0], vars[1]), vars[7]);
+  BddNodeIndex temp = bdd.zero();
+  for (int64_t i = 0; i < 8; ++i) {
+    temp = bdd.Or(bdd.And(temp, bdd.Not(vars[i])),
+                  bdd.And(bdd.Not(temp), vars[i]));
+  }
+  int64_t before_size = bdd.size();
+  EXPECT_GT(bdd.GarbageCollect({keep}), 0);
+  EXPECT_LT(bdd.size(), before_size);
+  EXPECT_GT(bdd.size(), base_size);
+
+  // The retained expression and the variables are still valid.
+  EXPECT_EQ(bdd.ToStringDnf(keep), "x0.x1 + x0.!x1.x7 + !x0.x7");
+  EXPECT_EQ(bdd.Or(bdd.And(vars[0], vars[1]), vars[7]), keep);
+  EXPECT_THAT(bdd.Evaluate(keep, {{vars[0], true},
+                                  {vars[1], false},
+                                  {vars[7], true}}),
+              IsOkAndHolds(true));
+
+  // Collecting with no roots leaves only the variables.
+  bdd.GarbageCollect({});
+  EXPECT_EQ(bdd.size(), base_size);
+}
+
+TEST(BinaryDecisionDiagramTest, Sifting) {
+  // The expression a0.b0 + a1.b1 + a2.b2 + a3.b3 has a BDD which is
+  // exponential in size with the order a0, a1, a2, a3, b0, b1, b2, b3 and
+  // linear with an interleaved order.
+  BinaryDecisionDiagram bdd;
+  std::vector<BddNodeIndex> a;
+  std::vector<BddNodeIndex> b;
+  for (int64_t i = 0; i < 4; ++i) {
+    a.push_back(bdd.NewVariable());
+  }
+  for (int64_t i = 0; i < 4; ++i) {
+    b.push_back(bdd.NewVariable());
+  }
+  BddNodeIndex expr = bdd.zero();
+  for (int64_t i = 0; i < 4; ++i) {
+    expr = bdd.Or(expr, bdd.And(a[i], b[i]));
+  }
+  BddNodeIndex not_expr = bdd.Not(expr);
+  bdd.GarbageCollect({expr});
+  int64_t before_size = bdd.size();
+  int64_t before_paths = bdd.path_count(expr);
+
+  bdd.Sift({expr, not_expr});
+  EXPECT_LT(bdd.size(), before_size);
+  EXPECT_LT(bdd.path_count(expr), before_paths);
+  EXPECT_EQ(bdd.Not(expr), not_expr);
+  for (int64_t i = 0; i < 4; ++i) {
+    EXPECT_EQ(std::abs(bdd.GetVariableLevel(bdd.GetNode(a[i]).variable) -
+                       bdd.GetVariableLevel(bdd.GetNode(b[i]).variable)),
+              1);
+  }
+
+  // The expression and the variables are unchanged by reordering.
+  for (int64_t value = 0; value < 256; ++value) {
+    absl::flat_hash_map<BddNodeIndex, bool> values;
+    bool expected = false;
+    for (int64_t i = 0; i < 4; ++i) {
+      values[a[i]] = (value >> i) & 1;
+      values[b[i]] = (value >> (i + 4)) & 1;
+      expected |= values[a[i]] && values[b[i]];
+    }
+    EXPECT_THAT(bdd.Evaluate(expr, values), IsOkAndHolds(expected));
+    EXPECT_THAT(bdd.Evaluate(not_expr, values), IsOkAndHolds(!expected));
+  }
+
+  // New expressions are constructed consistently with the new order.
+  BddNodeIndex rebuilt = bdd.zero();
+  for (int64_t i = 3; i >= 0; --i) {
+    rebuilt = bdd.Or(bdd.And(b[i], a[i]), rebuilt);
+  }
+  EXPECT_EQ(rebuilt, expr);
+}
+
 }  // namespace
 }  // namespace xls
@@ -0,0 +1,317 @@
+// Copyright 2022 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/data_structures/difference_constraints.h"
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_format.h"
+#include "xls/common/logging/logging.h"
+
+namespace xls {
+namespace {
+
+constexpr int64_t kInfinity = std::numeric_limits<int64_t>::max() / 4;
+
+// The residual network of an uncapacitated min-cost flow problem augmented
+// with a super source and super sink. Arcs are stored in pairs so that the
+// reverse of arc `e` is arc `e ^ 1`.
+class FlowNetwork {
+ public:
+  explicit FlowNetwork(int64_t node_count)
+      : arcs_by_node_(node_count), potential_(node_count, 0) {}
+
+  void AddArc(int64_t from, int64_t to, int64_t capacity, int64_t cost) {
+    arcs_by_node_[from].push_back(arcs_.size());
+    arcs_.push_back(Arc{to, capacity, cost});
+    arcs_by_node_[to].push_back(arcs_.size());
+    arcs_.push_back(Arc{from, 0, -cost});
+  }
+
+  int64_t potential(int64_t node) const { return potential_[node]; }
+
+  // Initializes the node potentials such that every arc with residual
+  // capacity has a non-negative reduced cost (Bellman-Ford from a virtual root
+  // adjacent to every node). Returns false if there is a negative-cost cycle.
+  bool InitializePotentials();
+
+  // Sends up to `amount` units of flow from `source` to `sink` along shortest
+  // paths, updating potentials as it goes. Returns the amount of flow sent,
+  // which is less than `amount` only if no further path exists.
+  int64_t SendFlow(int64_t source, int64_t sink, int64_t amount);
+
+ private:
+  struct Arc {
+    int64_t to;
+    int64_t capacity;
+    int64_t cost;
+  };
+
+  int64_t node_count() const { return arcs_by_node_.size(); }
+  int64_t from(int64_t arc) const { return arcs_[arc ^ 1].to; }
+  int64_t ReducedCost(int64_t arc) const {
+    return arcs_[arc].cost + potential_[from(arc)] -
+           potential_[arcs_[arc].to];
+  }
+
+  // Computes shortest distances from `source` under the reduced costs and
+  // shifts the potentials by them (capped at the distance of `sink`) so that
+  // shortest paths to `sink` consist of zero reduced cost arcs. Returns false
+  // if `sink` is unreachable.
+  bool UpdatePotentials(int64_t source, int64_t sink);
+
+  // Sends up to `amount` units of flow along zero reduced cost arcs (a
+  // blocking flow of the admissible network). Returns the amount sent.
+  int64_t SendAdmissibleFlow(int64_t source, int64_t sink, int64_t amount);
+
+  std::vector<Arc> arcs_;
+  std::vector<std::vector<int64_t>> arcs_by_node_;
+  std::vector<int64_t> potential_;
+};
+
+bool FlowNetwork::InitializePotentials() {
+  // Queue-based Bellman-Ford. All distances start at zero, which is
+  // equivalent to a virtual root with a zero-cost arc to every node.
+  std::deque<int64_t> queue;
+  std::vector<bool> in_queue(node_count(), true);
+  std::vector<int64_t> relaxations(node_count(), 0);
+  for (int64_t node = 0; node < node_count(); ++node) {
+    queue.push_back(node);
+  }
+  while (!queue.empty()) {
+    int64_t node = queue.front();
+    queue.pop_front();
+    in_queue[node] = false;
+    for (int64_t arc : arcs_by_node_[node]) {
+      if (arcs_[arc].capacity == 0) {
+        continue;
+      }
+      int64_t to = arcs_[arc].to;
+      if (potential_[node] + arcs_[arc].cost < potential_[to]) {
+        potential_[to] = potential_[node] + arcs_[arc].cost;
+        if (++relaxations[to] > node_count()) {
+          return false;
+        }
+        if (!in_queue[to]) {
+          in_queue[to] = true;
+          queue.push_back(to);
+        }
+      }
+    }
+  }
+  return true;
+}
+
+bool FlowNetwork::UpdatePotentials(int64_t source, int64_t sink) {
+  std::vector<int64_t> distance(node_count(), kInfinity);
+  using QueueEntry = std::pair<int64_t, int64_t>;
+  std::priority_queue<QueueEntry, std::vector<QueueEntry>,
+                      std::greater<QueueEntry>>
+      queue;
+  distance[source] = 0;
+  queue.push({0, source});
+  while (!queue.empty()) {
+    auto [node_distance, node] = queue.top();
+    queue.pop();
+    if (node_distance > distance[node]) {
+      continue;
+    }
+    for (int64_t arc : arcs_by_node_[node]) {
+      if (arcs_[arc].capacity == 0) {
+        continue;
+      }
+      int64_t to = arcs_[arc].to;
+      int64_t to_distance = node_distance + ReducedCost(arc);
+      if (to_distance < distance[to]) {
+        distance[to] = to_distance;
+        queue.push({to_distance, to});
+      }
+    }
+  }
+  if (distance[sink] == kInfinity) {
+    return false;
+  }
+  // Capping the shift at the sink distance keeps all reduced costs
+  // non-negative, including those of arcs out of nodes farther than the sink.
+  for (int64_t node = 0; node < node_count(); ++node) {
+    potential_[node] += std::min(distance[node], distance[sink]);
+  }
+  return true;
+}
+
+int64_t FlowNetwork::SendAdmissibleFlow(int64_t source, int64_t sink,
+                                        int64_t amount) {
+  int64_t sent = 0;
+  std::vector<int64_t> level(node_count());
+  std::vector<int64_t> next_arc(node_count());
+  auto admissible = [&](int64_t arc) {
+    return arcs_[arc].capacity > 0 && ReducedCost(arc) == 0;
+  };
+  while (sent < amount) {
+    // Level the admissible network by breadth-first search so that the
+    // search for augmenting paths cannot cycle through zero-cost cycles.
+    std::fill(level.begin(), level.end(), -1);
+    std::deque<int64_t> queue = {source};
+    level[source] = 0;
+    while (!queue.empty()) {
+      int64_t node = queue.front();
+      queue.pop_front();
+      for (int64_t arc : arcs_by_node_[node]) {
+        if (admissible(arc) && level[arcs_[arc].to] < 0) {
+          level[arcs_[arc].to] = level[node] + 1;
+          queue.push_back(arcs_[arc].to);
+        }
+      }
+    }
+    if (level[sink] < 0) {
+      break;
+    }
+    std::fill(next_arc.begin(), next_arc.end(), 0);
+
+    // Iterative depth-first search for augmenting paths.
+    std::vector<int64_t> path;
+    int64_t node = source;
+    while (sent < amount) {
+      if (node == sink) {
+        int64_t bottleneck = amount - sent;
+        for (int64_t arc : path) {
+          bottleneck = std::min(bottleneck, arcs_[arc].capacity);
+        }
+        for (int64_t arc : path) {
+          arcs_[arc].capacity -= bottleneck;
+          arcs_[arc ^ 1].capacity += bottleneck;
+        }
+        sent += bottleneck;
+        path.clear();
+        node = source;
+        continue;
+      }
+      std::vector<int64_t>& arcs = arcs_by_node_[node];
+      int64_t& i = next_arc[node];
+      while (i < arcs.size() &&
+             !(admissible(arcs[i]) &&
+               level[arcs_[arcs[i]].to] == level[node] + 1)) {
+        ++i;
+      }
+      if (i < arcs.size()) {
+        path.push_back(arcs[i]);
+        node = arcs_[arcs[i]].to;
+        continue;
+      }
+      // Dead end; retreat.
+      level[node] = -1;
+      if (path.empty()) {
+        break;
+      }
+      node = from(path.back());
+      path.pop_back();
+      ++next_arc[node];
+    }
+  }
+  return sent;
+}
+
+int64_t FlowNetwork::SendFlow(int64_t source, int64_t sink, int64_t amount) {
+  int64_t sent = 0;
+  while (sent < amount && UpdatePotentials(source, sink)) {
+    sent += SendAdmissibleFlow(source, sink, amount - sent);
+  }
+  return sent;
+}
+
+}  // namespace
+
+int64_t DifferenceConstraintSystem::AddVariable(int64_t objective_coefficient) {
+  objective_.push_back(objective_coefficient);
+  return objective_.size() - 1;
+}
+
+void DifferenceConstraintSystem::AddToObjective(int64_t variable,
+                                                int64_t coefficient) {
+  objective_.at(variable) += coefficient;
+}
+
+void DifferenceConstraintSystem::AddConstraint(int64_t from, int64_t to,
+                                               int64_t difference) {
+  XLS_CHECK_LT(from, variable_count());
+  XLS_CHECK_LT(to, variable_count());
+  constraints_.push_back(Constraint{from, to, difference});
+}
+
+absl::StatusOr<std::vector<int64_t>> DifferenceConstraintSystem::Minimize(
+    int64_t anchor) const {
+  if (anchor < 0 || anchor >= variable_count()) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Invalid anchor variable %d", anchor));
+  }
+  int64_t coefficient_sum = 0;
+  for (int64_t coefficient : objective_) {
+    coefficient_sum += coefficient;
+  }
+  if (coefficient_sum != 0) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Objective is unbounded; coefficients sum to %d rather than zero",
+        coefficient_sum));
+  }
+
+  // In the dual flow problem each constraint x_j - x_i >= d is an
+  // uncapacitated arc i -> j of cost -d, and each variable with objective
+  // coefficient c has a net inflow of c, provided by the super source (c < 0)
+  // or drained to the super sink (c > 0).
+  const int64_t source = variable_count();
+  const int64_t sink = variable_count() + 1;
+  FlowNetwork network(variable_count() + 2);
+  for (const Constraint& constraint : constraints_) {
+    network.AddArc(constraint.from, constraint.to, kInfinity,
+                   -constraint.difference);
+  }
+  int64_t total_supply = 0;
+  for (int64_t variable = 0; variable < variable_count(); ++variable) {
+    int64_t coefficient = objective_[variable];
+    if (coefficient < 0) {
+      network.AddArc(source, variable, -coefficient, 0);
+      total_supply -= coefficient;
+    } else if (coefficient > 0) {
+      network.AddArc(variable, sink, coefficient, 0);
+    }
+  }
+
+  if (!network.InitializePotentials()) {
+    return absl::InvalidArgumentError(
+        "Difference constraints are infeasible; they contain a cycle with "
+        "positive total difference");
+  }
+  if (network.SendFlow(source, sink, total_supply) != total_supply) {
+    return absl::InvalidArgumentError("Objective is unbounded");
+  }
+
+  // By complementary slackness the negated potentials are an optimal
+  // solution: every constraint arc has a non-negative reduced cost, i.e.,
+  // (-p_j) - (-p_i) >= d, with equality on arcs carrying flow.
+  std::vector<int64_t> solution(variable_count());
+  for (int64_t variable = 0; variable < variable_count(); ++variable) {
+    solution[variable] =
+        network.potential(anchor) - network.potential(variable);
+  }
+  return solution;
+}
+
+}  // namespace xls
@@ -0,0 +1,75 @@
+// Copyright 2022 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_DATA_STRUCTURES_DIFFERENCE_CONSTRAINTS_H_
+#define XLS_DATA_STRUCTURES_DIFFERENCE_CONSTRAINTS_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/status/statusor.h"
+
+namespace xls {
+
+// A linear program over integer variables in which every constraint bounds
+// the difference of two variables (a "system of difference constraints"):
+//
+//   minimize    sum_i c_i * x_i
+//   subject to  x_j - x_i >= d_ij   for each constraint (i, j)
+//
+// The constraint matrix of such a program is totally unimodular, so an optimal
+// solution of the LP relaxation is integral. The program is solved exactly as
+// the dual of an uncapacitated min-cost flow problem (one flow node per
+// variable, one arc per constraint, with the objective coefficients as
+// demands) using the primal-dual (successive shortest path) method; the
+// optimal node potentials give the values of the variables.
+//
+// Solutions are invariant to adding a constant to every variable, so the
+// objective coefficients must sum to zero for the program to be bounded, and
+// the solution is reported relative to an anchor variable fixed at zero.
+class DifferenceConstraintSystem {
+ public:
+  // Adds a variable with the given objective coefficient and returns its
+  // index. Variables are numbered sequentially from zero.
+  int64_t AddVariable(int64_t objective_coefficient = 0);
+
+  // Adds `coefficient` to the objective coefficient of the given variable.
+  void AddToObjective(int64_t variable, int64_t coefficient);
+
+  // Adds the constraint x_to - x_from >= difference.
+  void AddConstraint(int64_t from, int64_t to, int64_t difference);
+
+  int64_t variable_count() const { return objective_.size(); }
+  int64_t constraint_count() const { return constraints_.size(); }
+
+  // Returns an optimal assignment of the variables with x_anchor == 0, indexed
+  // by variable. Returns an InvalidArgumentError if the constraints are
+  // infeasible (they contain a cycle of positive total difference) or if the
+  // objective is unbounded.
+  absl::StatusOr<std::vector<int64_t>> Minimize(int64_t anchor) const;
+
+ private:
+  struct Constraint {
+    int64_t from;
+    int64_t to;
+    int64_t difference;
+  };
+
+  std::vector<int64_t> objective_;
+  std::vector<Constraint> constraints_;
+};
+
+}  // namespace xls
+
+#endif  // XLS_DATA_STRUCTURES_DIFFERENCE_CONSTRAINTS_H_
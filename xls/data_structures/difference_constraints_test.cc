@@ -0,0 +1,178 @@
+// Copyright 2022 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/data_structures/difference_constraints.h"
+
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "xls/common/status/matchers.h"
+
+namespace xls {
+namespace {
+
+using status_testing::IsOkAndHolds;
+using status_testing::StatusIs;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+
+TEST(DifferenceConstraintsTest, NoObjective) {
+  DifferenceConstraintSystem system;
+  int64_t a = system.AddVariable();
+  int64_t b = system.AddVariable();
+  int64_t c = system.AddVariable();
+  system.AddConstraint(a, b, 2);
+  system.AddConstraint(b, c, 3);
+  XLS_ASSERT_OK_AND_ASSIGN(std::vector<int64_t> solution, system.Minimize(a));
+  EXPECT_EQ(solution[a], 0);
+  EXPECT_GE(solution[b] - solution[a], 2);
+  EXPECT_GE(solution[c] - solution[b], 3);
+}
+
+TEST(DifferenceConstraintsTest, MinimizeSpan) {
+  // Minimize c - a subject to b >= a + 2, c >= b + 3, c >= a + 4.
+  DifferenceConstraintSystem system;
+  int64_t a = system.AddVariable(-1);
+  int64_t b = system.AddVariable();
+  int64_t c = system.AddVariable(1);
+  system.AddConstraint(a, b, 2);
+  system.AddConstraint(b, c, 3);
+  system.AddConstraint(a, c, 4);
+  XLS_ASSERT_OK_AND_ASSIGN(std::vector<int64_t> solution, system.Minimize(a));
+  EXPECT_THAT(solution, ElementsAre(0, 2, 5));
+}
+
+TEST(DifferenceConstraintsTest, PullTowardsUpperBound) {
+  // Maximize b with 0 <= b <= 7 relative to a.
+  DifferenceConstraintSystem system;
+  int64_t a = system.AddVariable(1);
+  int64_t b = system.AddVariable(-1);
+  system.AddConstraint(a, b, 0);
+  system.AddConstraint(b, a, -7);
+  EXPECT_THAT(system.Minimize(a), IsOkAndHolds(ElementsAre(0, 7)));
+}
+
+TEST(DifferenceConstraintsTest, Infeasible) {
+  DifferenceConstraintSystem system;
+  int64_t a = system.AddVariable();
+  int64_t b = system.AddVariable();
+  system.AddConstraint(a, b, 1);
+  system.AddConstraint(b, a, 0);
+  EXPECT_THAT(system.Minimize(a), StatusIs(absl::StatusCode::kInvalidArgument,
+                                           HasSubstr("infeasible")));
+}
+
+TEST(DifferenceConstraintsTest, Unbounded) {
+  DifferenceConstraintSystem system;
+  int64_t a = system.AddVariable(1);
+  int64_t b = system.AddVariable(-1);
+  system.AddConstraint(a, b, 0);
+  EXPECT_THAT(system.Minimize(a), StatusIs(absl::StatusCode::kInvalidArgument,
+                                           HasSubstr("unbounded")));
+
+  DifferenceConstraintSystem unbalanced;
+  unbalanced.AddVariable(1);
+  EXPECT_THAT(unbalanced.Minimize(0),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("unbounded")));
+}
+
+// Compares against exhaustive enumeration on small random systems in which
+// every variable is constrained to [0, kRange] relative to variable zero.
+TEST(DifferenceConstraintsTest, MatchesExhaustiveSearch) {
+  constexpr int64_t kRange = 3;
+  std::mt19937_64 rng(0);
+  for (int64_t trial = 0; trial < 300; ++trial) {
+    int64_t variable_count = 2 + trial % 4;
+    DifferenceConstraintSystem system;
+    std::vector<int64_t> objective(variable_count);
+    int64_t sum = 0;
+    for (int64_t i = 1; i < variable_count; ++i) {
+      objective[i] = static_cast<int64_t>(rng() % 11) - 5;
+      sum += objective[i];
+    }
+    objective[0] = -sum;
+    for (int64_t i = 0; i < variable_count; ++i) {
+      system.AddVariable(objective[i]);
+    }
+    struct Constraint {
+      int64_t from;
+      int64_t to;
+      int64_t difference;
+    };
+    std::vector<Constraint> constraints;
+    for (int64_t i = 1; i < variable_count; ++i) {
+      constraints.push_back({0, i, 0});
+      constraints.push_back({i, 0, -kRange});
+    }
+    for (int64_t i = 0; i < 1 + trial % 5; ++i) {
+      constraints.push_back({static_cast<int64_t>(rng() % variable_count),
+                             static_cast<int64_t>(rng() % variable_count),
+                             static_cast<int64_t>(rng() % 5) - 2});
+    }
+    for (const Constraint& c : constraints) {
+      system.AddConstraint(c.from, c.to, c.difference);
+    }
+
+    auto feasible = [&](const std::vector<int64_t>& x) {
+      for (const Constraint& c : constraints) {
+        if (x[c.to] - x[c.from] < c.difference) {
+          return false;
+        }
+      }
+      return true;
+    };
+    auto cost = [&](const std::vector<int64_t>& x) {
+      int64_t result = 0;
+      for (int64_t i = 0; i < variable_count; ++i) {
+        result += objective[i] * x[i];
+      }
+      return result;
+    };
+    int64_t best_cost = std::numeric_limits<int64_t>::max();
+    std::vector<int64_t> x(variable_count, 0);
+    while (true) {
+      if (feasible(x)) {
+        best_cost = std::min(best_cost, cost(x));
+      }
+      int64_t i = 1;
+      while (i < variable_count && x[i] == kRange) {
+        x[i++] = 0;
+      }
+      if (i == variable_count) {
+        break;
+      }
+      ++x[i];
+    }
+
+    absl::StatusOr<std::vector<int64_t>> solution = system.Minimize(0);
+    if (best_cost == std::numeric_limits<int64_t>::max()) {
+      EXPECT_THAT(solution, StatusIs(absl::StatusCode::kInvalidArgument,
+                                     HasSubstr("infeasible")));
+      continue;
+    }
+    XLS_ASSERT_OK(solution.status());
+    EXPECT_EQ(solution->at(0), 0);
+    EXPECT_TRUE(feasible(*solution));
+    EXPECT_EQ(cost(*solution), best_cost) << "trial " << trial;
+  }
+}
+
+}  // namespace
+}  // namespace xls
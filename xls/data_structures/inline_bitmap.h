@@ -106,6 +106,16 @@ class InlineBitmap {
     return data_[wordno];
   }
 
+  // Fast path for users of the InlineBitmap to set the 64-bit word that backs a
+  // group of 64 bits. Bits of the word beyond bit_count() are masked off.
+  void SetWord(int64_t wordno, uint64_t value) {
+    XLS_DCHECK_LT(wordno, word_count());
+    data_[wordno] = value & MaskForWord(wordno);
+  }
+
+  // Returns the number of 64-bit words backing the bitmap.
+  int64_t word_count() const { return data_.size(); }
+
   // Sets a byte in the data underlying the bitmap.
   //
   // Setting byte i as {b_7, b_6, b_5, ..., b_0} sets the bit at i*8 to b_0, the
@@ -182,7 +192,6 @@ class InlineBitmap {
  private:
   static constexpr int64_t kWordBits = 64;
   static constexpr int64_t kWordBytes = 8;
-  int64_t word_count() const { return data_.size(); }
 
   void MaskLastWord() {
     int64_t last_wordno = word_count() - 1;
@@ -189,6 +189,19 @@ TEST(InlineBitmapTest, BytesAndWords) {
   }
 }
 
+TEST(InlineBitmapTest, SetWord) {
+  InlineBitmap b(/*bit_count=*/100);
+  EXPECT_EQ(b.word_count(), 2);
+  b.SetWord(0, 0x123456789abcdef0);
+  b.SetWord(1, 0xFFFFFFFFFFFFFFFFULL);
+  EXPECT_EQ(b.GetWord(0), 0x123456789abcdef0);
+  // Bits beyond the bit count are masked off.
+  EXPECT_EQ(b.GetWord(1), 0xFFFFFFFFFULL);
+  EXPECT_TRUE(b.Get(99));
+  EXPECT_FALSE(b.Get(0));
+  EXPECT_TRUE(b.Get(4));
+}
+
 TEST(InlineBitmapTest, UnsignedComparisons) {
   {
     InlineBitmap a(/*bit_count=*/0);
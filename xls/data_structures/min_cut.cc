@@ -14,13 +14,15 @@
 
 #include "xls/data_structures/min_cut.h"
 
+#include <algorithm>
 #include <deque>
+#include <limits>
 #include <set>
 
-#include "absl/container/flat_hash_set.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
+#include "absl/types/optional.h"
 #include "xls/common/logging/log_lines.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/logging/vlog_is_on.h"
@@ -267,9 +269,12 @@ int64_t AugmentFlow(const Graph& graph, NodeId source, NodeId sink,
   return 0;
 }
 
-}  // namespace
-
-GraphCut MinCutBetweenNodes(const Graph& graph, NodeId source, NodeId sink) {
+// Computes a maximum flow with the augmenting path method and returns whether
+// each node (indexed by NodeId) is reachable from the source in the residual
+// graph.
+std::vector<bool> AugmentingPathReachableFromSource(const Graph& graph,
+                                                    NodeId source,
+                                                    NodeId sink) {
   // This loop is the core of the Ford-Fulkerson method. Starting with zero flow
   // on all edges, flow is increased along a path from source to sink with
   // residual capacity (called an augmenting path). When no further augmenting
@@ -281,34 +286,378 @@ GraphCut MinCutBetweenNodes(const Graph& graph, NodeId source, NodeId sink) {
 
   // Once a maximum flow is found, walk the residual graph from the source. All
   // reachable nodes form one partition.
-  absl::flat_hash_set<NodeId> reachable_from_source;
+  std::vector<bool> reachable_from_source(graph.node_count(), false);
   std::deque<NodeId> frontier = {source};
-  reachable_from_source.insert(source);
+  reachable_from_source[int64_t{source}] = true;
   while (!frontier.empty()) {
     NodeId node = frontier.front();
     frontier.pop_front();
     for (EdgeId successor_edge_id : residual_graph.successors(node)) {
       const ResidualEdge& edge = residual_graph.edge(successor_edge_id);
-      if (edge.capacity > 0 && !reachable_from_source.contains(edge.to)) {
-        reachable_from_source.insert(edge.to);
+      if (edge.capacity > 0 && !reachable_from_source[int64_t{edge.to}]) {
+        reachable_from_source[int64_t{edge.to}] = true;
         frontier.push_back(edge.to);
       }
     }
   }
-  XLS_CHECK(!reachable_from_source.contains(sink));
+  return reachable_from_source;
+}
+
+// Returns the capacity to which edge weights are clamped for the push-relabel
+// algorithm, or nullopt if the weights are too large to run it without risk of
+// overflow. Edge weights are often std::numeric_limits<int64_t>::max() to
+// model edges which cannot be cut. Clamping such weights to one more than the
+// sum of all other weights leaves the minimum cuts unchanged (provided the min
+// cut is finite) and bounds the excess which can accumulate at any node.
+absl::optional<int64_t> PushRelabelCapacityLimit(const Graph& graph,
+                                                 NodeId source) {
+  constexpr int64_t kMaxWeight = std::numeric_limits<int64_t>::max();
+  int64_t finite_weight_sum = 0;
+  for (EdgeId edge_id = EdgeId{0}; edge_id <= graph.max_edge_id();
+       edge_id += EdgeId{1}) {
+    int64_t weight = graph.edge(edge_id).weight;
+    if (weight == kMaxWeight) {
+      continue;
+    }
+    if (finite_weight_sum > kMaxWeight - weight - 1) {
+      return absl::nullopt;
+    }
+    finite_weight_sum += weight;
+  }
+  // All flow originates at the source so the excess at any node is bounded by
+  // the total capacity of the edges extending from the source.
+  int64_t limit = finite_weight_sum + 1;
+  if (limit > kMaxWeight / (graph.successors(source).size() + 1)) {
+    return absl::nullopt;
+  }
+  return limit;
+}
+
+// Computes a maximum flow using the highest-label push-relabel algorithm.
+//
+// The residual graph is stored in compressed sparse row form: the residual
+// edges (arcs) extending from node v are the indices [first_arc_[v],
+// first_arc_[v + 1]) of the arc arrays. Each edge of the input graph yields a
+// forward arc and a reverse arc which refer to each other through
+// arc_reverse_.
+//
+// Flow is computed in two phases. The first computes a maximum preflow by
+// discharging active nodes (nodes with positive excess) with height below the
+// node count, highest first. Heights are bounded below by the distance to the
+// sink in the residual graph, and a node with height at least the node count
+// cannot reach the sink. The gap heuristic lifts all nodes above an emptied
+// height to the node count, and a periodic global relabel sets heights to
+// exact distances to the sink. The second phase returns the remaining excess
+// to the source, turning the preflow into a flow.
+class PushRelabelMaxFlow {
+ public:
+  PushRelabelMaxFlow(const Graph& graph, NodeId source, NodeId sink,
+                     int64_t capacity_limit)
+      : node_count_(graph.node_count()),
+        source_(int64_t{source}),
+        sink_(int64_t{sink}) {
+    first_arc_.assign(node_count_ + 1, 0);
+    for (EdgeId edge_id = EdgeId{0}; edge_id <= graph.max_edge_id();
+         edge_id += EdgeId{1}) {
+      const Edge& edge = graph.edge(edge_id);
+      ++first_arc_[int64_t{edge.from} + 1];
+      ++first_arc_[int64_t{edge.to} + 1];
+    }
+    for (int32_t v = 0; v < node_count_; ++v) {
+      first_arc_[v + 1] += first_arc_[v];
+    }
+    int64_t arc_count = 2 * graph.edge_count();
+    arc_head_.resize(arc_count);
+    arc_capacity_.resize(arc_count);
+    arc_reverse_.resize(arc_count);
+    std::vector<int32_t> next_arc(first_arc_.begin(), first_arc_.end() - 1);
+    for (EdgeId edge_id = EdgeId{0}; edge_id <= graph.max_edge_id();
+         edge_id += EdgeId{1}) {
+      const Edge& edge = graph.edge(edge_id);
+      int32_t forward = next_arc[int64_t{edge.from}]++;
+      int32_t backward = next_arc[int64_t{edge.to}]++;
+      arc_head_[forward] = int64_t{edge.to};
+      arc_capacity_[forward] = std::min(edge.weight, capacity_limit);
+      arc_reverse_[forward] = backward;
+      arc_head_[backward] = int64_t{edge.from};
+      arc_capacity_[backward] = 0;
+      arc_reverse_[backward] = forward;
+    }
+  }
+
+  void Run() {
+    height_.assign(node_count_, 0);
+    excess_.assign(node_count_, 0);
+    current_arc_.assign(first_arc_.begin(), first_arc_.end() - 1);
+    active_.assign(2 * node_count_, {});
+    nodes_at_height_.assign(node_count_, {});
+    node_position_.assign(node_count_, 0);
+
+    // Saturate the arcs extending from the source.
+    height_[source_] = node_count_;
+    for (int32_t arc = first_arc_[source_]; arc < first_arc_[source_ + 1];
+         ++arc) {
+      if (arc_head_[arc] != source_) {
+        excess_[arc_head_[arc]] += arc_capacity_[arc];
+        PushAlongArc(arc, arc_capacity_[arc]);
+      }
+    }
+
+    // Phase one: compute a maximum preflow.
+    GlobalRelabel();
+    height_limit_ = node_count_;
+    DischargeActiveNodes(/*global_relabels=*/true);
+
+    // Phase two: return excess to the source.
+    height_limit_ = 2 * node_count_;
+    max_active_height_ = height_limit_ - 1;
+    DischargeActiveNodes(/*global_relabels=*/false);
+  }
+
+  // Returns whether each node is reachable from the source in the residual
+  // graph.
+  std::vector<bool> ReachableFromSource() const {
+    std::vector<bool> reachable(node_count_, false);
+    std::vector<int32_t> stack = {source_};
+    reachable[source_] = true;
+    while (!stack.empty()) {
+      int32_t v = stack.back();
+      stack.pop_back();
+      for (int32_t arc = first_arc_[v]; arc < first_arc_[v + 1]; ++arc) {
+        if (arc_capacity_[arc] > 0 && !reachable[arc_head_[arc]]) {
+          reachable[arc_head_[arc]] = true;
+          stack.push_back(arc_head_[arc]);
+        }
+      }
+    }
+    return reachable;
+  }
+
+ private:
+  // Moves `amount` units of flow along the given arc. Excess is accounted for
+  // by the caller.
+  void PushAlongArc(int32_t arc, int64_t amount) {
+    arc_capacity_[arc] -= amount;
+    arc_capacity_[arc_reverse_[arc]] += amount;
+  }
+
+  // Adds `v` to the set of active nodes at its height.
+  void Activate(int32_t v) {
+    active_[height_[v]].push_back(v);
+    if (height_[v] < height_limit_) {
+      max_active_height_ = std::max(max_active_height_, height_[v]);
+    }
+  }
+
+  void AddToHeightBucket(int32_t v) {
+    if (height_[v] < node_count_) {
+      node_position_[v] = nodes_at_height_[height_[v]].size();
+      nodes_at_height_[height_[v]].push_back(v);
+      max_bucket_height_ = std::max(max_bucket_height_, height_[v]);
+    }
+  }
+
+  void RemoveFromHeightBucket(int32_t v) {
+    std::vector<int32_t>& bucket = nodes_at_height_[height_[v]];
+    int32_t last = bucket.back();
+    bucket[node_position_[v]] = last;
+    node_position_[last] = node_position_[v];
+    bucket.pop_back();
+  }
+
+  // Sets the height of every node below the node count to its distance to the
+  // sink in the residual graph, or to the node count if the sink is
+  // unreachable.
+  void GlobalRelabel() {
+    constexpr int32_t kUnvisited = -1;
+    std::vector<int32_t> distance(node_count_, kUnvisited);
+    std::vector<int32_t> queue = {sink_};
+    distance[sink_] = 0;
+    for (int64_t i = 0; i < queue.size(); ++i) {
+      int32_t v = queue[i];
+      for (int32_t arc = first_arc_[v]; arc < first_arc_[v + 1]; ++arc) {
+        int32_t w = arc_head_[arc];
+        if (distance[w] == kUnvisited && w != source_ &&
+            arc_capacity_[arc_reverse_[arc]] > 0) {
+          distance[w] = distance[v] + 1;
+          queue.push_back(w);
+        }
+      }
+    }
+    for (std::vector<int32_t>& bucket : active_) {
+      bucket.clear();
+    }
+    for (std::vector<int32_t>& bucket : nodes_at_height_) {
+      bucket.clear();
+    }
+    max_active_height_ = -1;
+    max_bucket_height_ = 0;
+    for (int32_t v = 0; v < node_count_; ++v) {
+      if (v == source_) {
+        continue;
+      }
+      if (height_[v] < node_count_) {
+        height_[v] = distance[v] == kUnvisited ? node_count_ : distance[v];
+      }
+      current_arc_[v] = first_arc_[v];
+      AddToHeightBucket(v);
+      if (v != sink_ && excess_[v] > 0) {
+        Activate(v);
+      }
+    }
+    relabels_since_global_relabel_ = 0;
+  }
+
+  // Lifts all nodes with heights in (height, node_count_) to node_count_.
+  void Gap(int32_t height) {
+    for (int32_t h = height + 1; h <= max_bucket_height_; ++h) {
+      for (int32_t v : nodes_at_height_[h]) {
+        height_[v] = node_count_;
+        current_arc_[v] = first_arc_[v];
+        if (excess_[v] > 0) {
+          Activate(v);
+        }
+      }
+      nodes_at_height_[h].clear();
+    }
+    max_bucket_height_ = height - 1;
+  }
+
+  void Relabel(int32_t v) {
+    ++relabels_since_global_relabel_;
+    int32_t old_height = height_[v];
+    int32_t new_height = 2 * node_count_;
+    for (int32_t arc = first_arc_[v]; arc < first_arc_[v + 1]; ++arc) {
+      if (arc_capacity_[arc] > 0) {
+        new_height = std::min(new_height, height_[arc_head_[arc]] + 1);
+      }
+    }
+    // A node with excess always has a residual arc back towards the source.
+    XLS_DCHECK_LT(new_height, 2 * node_count_);
+    if (old_height < node_count_) {
+      RemoveFromHeightBucket(v);
+      if (nodes_at_height_[old_height].empty()) {
+        // No node remains at the old height so no node above it can reach the
+        // sink.
+        Gap(old_height);
+        new_height = std::max(new_height, node_count_);
+      }
+    }
+    height_[v] = new_height;
+    current_arc_[v] = first_arc_[v];
+    AddToHeightBucket(v);
+  }
+
+  // Pushes the excess of `v` to neighbors, relabeling it as necessary, until
+  // its excess is zero or its height reaches the height limit.
+  void Discharge(int32_t v) {
+    while (excess_[v] > 0) {
+      if (current_arc_[v] == first_arc_[v + 1]) {
+        Relabel(v);
+        if (height_[v] >= height_limit_) {
+          Activate(v);
+          return;
+        }
+        continue;
+      }
+      int32_t arc = current_arc_[v];
+      int32_t w = arc_head_[arc];
+      if (arc_capacity_[arc] > 0 && height_[v] == height_[w] + 1) {
+        int64_t amount = std::min(excess_[v], arc_capacity_[arc]);
+        PushAlongArc(arc, amount);
+        excess_[v] -= amount;
+        if (w != source_ && w != sink_ && excess_[w] == 0) {
+          Activate(w);
+        }
+        excess_[w] += amount;
+      } else {
+        ++current_arc_[v];
+      }
+    }
+  }
+
+  // Discharges active nodes with heights below the height limit, highest
+  // first, until none remain.
+  void DischargeActiveNodes(bool global_relabels) {
+    while (max_active_height_ >= 0) {
+      std::vector<int32_t>& bucket = active_[max_active_height_];
+      if (bucket.empty()) {
+        --max_active_height_;
+        continue;
+      }
+      int32_t v = bucket.back();
+      bucket.pop_back();
+      // Nodes lifted by the gap heuristic leave stale entries behind.
+      if (height_[v] != max_active_height_ || excess_[v] == 0) {
+        continue;
+      }
+      Discharge(v);
+      if (global_relabels && relabels_since_global_relabel_ >= node_count_) {
+        GlobalRelabel();
+      }
+    }
+  }
+
+  int32_t node_count_;
+  int32_t source_;
+  int32_t sink_;
+
+  // The residual graph.
+  std::vector<int32_t> first_arc_;
+  std::vector<int32_t> arc_head_;
+  std::vector<int64_t> arc_capacity_;
+  std::vector<int32_t> arc_reverse_;
+
+  std::vector<int32_t> height_;
+  std::vector<int64_t> excess_;
+  // The next arc to consider pushing flow along for each node.
+  std::vector<int32_t> current_arc_;
+
+  // Active nodes indexed by height. May contain stale entries.
+  std::vector<std::vector<int32_t>> active_;
+  int32_t max_active_height_ = -1;
+  int32_t height_limit_ = 0;
+
+  // Nodes other than the source indexed by height, for heights below the node
+  // count, and the position of each node within its bucket.
+  std::vector<std::vector<int32_t>> nodes_at_height_;
+  std::vector<int32_t> node_position_;
+  int32_t max_bucket_height_ = 0;
+
+  int64_t relabels_since_global_relabel_ = 0;
+};
+
+}  // namespace
+
+GraphCut MinCutBetweenNodes(const Graph& graph, NodeId source, NodeId sink,
+                            MaxFlowAlgorithm algorithm) {
+  absl::optional<int64_t> capacity_limit;
+  if (algorithm == MaxFlowAlgorithm::kPushRelabel) {
+    capacity_limit = PushRelabelCapacityLimit(graph, source);
+  }
+  std::vector<bool> reachable_from_source;
+  if (capacity_limit.has_value()) {
+    PushRelabelMaxFlow max_flow(graph, source, sink, *capacity_limit);
+    max_flow.Run();
+    reachable_from_source = max_flow.ReachableFromSource();
+  } else {
+    reachable_from_source =
+        AugmentingPathReachableFromSource(graph, source, sink);
+  }
+  XLS_CHECK(!reachable_from_source[int64_t{sink}]);
 
   GraphCut min_cut;
   min_cut.weight = 0;
   for (NodeId node_id = NodeId(0); node_id <= graph.max_node_id(); ++node_id) {
-    if (reachable_from_source.contains(node_id)) {
+    if (reachable_from_source[int64_t{node_id}]) {
       min_cut.source_partition.push_back(node_id);
     } else {
       min_cut.sink_partition.push_back(node_id);
     }
     for (EdgeId edge_id : graph.successors(node_id)) {
       const Edge& edge = graph.edge(edge_id);
-      if (reachable_from_source.contains(edge.from) &&
-          !reachable_from_source.contains(edge.to)) {
+      if (reachable_from_source[int64_t{edge.from}] &&
+          !reachable_from_source[int64_t{edge.to}]) {
         min_cut.weight += edge.weight;
       }
     }
@@ -94,12 +94,28 @@ struct GraphCut {
   std::string ToString(const Graph& graph) const;
 };
 
+// The algorithm used to compute the maximum flow from which a min cut is
+// derived. The resulting cut is the same for every algorithm.
+enum class MaxFlowAlgorithm {
+  // The Ford-Fulkerson method augmenting along shortest paths found by BFS
+  // (Edmonds-Karp). Worst case run time of O(V * E^2).
+  kAugmentingPath,
+
+  // Highest-label push-relabel with the gap and global relabeling heuristics
+  // over a compressed sparse row representation of the residual graph. Worst
+  // case run time of O(V^2 * sqrt(E)), and typically much faster than
+  // augmenting paths on large graphs.
+  kPushRelabel,
+};
+
 // Computes a minimum cut of the given graph where source and sink are in
 // different partitions. The cut is returned as a partitioning of the nodes of
-// the graph into two sets of nodes on either side of the cut. The min cut is
-// found via the Ford-Fulkerson method using Dinic's algorithm. This results in
-// a worst case run time of O(V^2 * E).
-GraphCut MinCutBetweenNodes(const Graph& graph, NodeId source, NodeId sink);
+// the graph into two sets of nodes on either side of the cut. Of all minimum
+// cuts, the one with the smallest source partition is returned (the nodes
+// reachable from the source in the residual graph of a maximum flow).
+GraphCut MinCutBetweenNodes(
+    const Graph& graph, NodeId source, NodeId sink,
+    MaxFlowAlgorithm algorithm = MaxFlowAlgorithm::kPushRelabel);
 
 }  // namespace min_cut
 }  // namespace xls
@@ -355,6 +355,70 @@ TEST(MinCutTest, ResidualGraphTraversalTest) {
   EXPECT_EQ(min_cut.weight, 2);
 }
 
+// Expects the two max flow algorithms to produce the same cut.
+void ExpectAlgorithmsAgree(const Graph& graph, NodeId source, NodeId sink) {
+  GraphCut augmenting_path = MinCutBetweenNodes(
+      graph, source, sink, MaxFlowAlgorithm::kAugmentingPath);
+  GraphCut push_relabel =
+      MinCutBetweenNodes(graph, source, sink, MaxFlowAlgorithm::kPushRelabel);
+  EXPECT_EQ(augmenting_path.weight, push_relabel.weight);
+  EXPECT_EQ(augmenting_path.source_partition, push_relabel.source_partition);
+  EXPECT_EQ(augmenting_path.sink_partition, push_relabel.sink_partition);
+}
+
+TEST(MinCutTest, AlgorithmsAgreeOnLargeGraphs) {
+  for (bool acyclic : {false, true}) {
+    for (int64_t layer_count = 5; layer_count < 40; layer_count += 7) {
+      for (int64_t nodes_in_layer = 5; nodes_in_layer < 40;
+           nodes_in_layer += 7) {
+        NodeId source;
+        NodeId sink;
+        Graph graph = MakeLargeGraph(acyclic, &source, &sink, layer_count,
+                                     nodes_in_layer);
+        ExpectAlgorithmsAgree(graph, source, sink);
+      }
+    }
+  }
+}
+
+TEST(MinCutTest, AlgorithmsAgreeOnRandomGraphs) {
+  // Small dense graphs with parallel edges, self loops and edges into the
+  // source and out of the sink exercise the gap and global relabeling
+  // heuristics of push-relabel.
+  std::mt19937 gen;
+  for (int64_t trial = 0; trial < 500; ++trial) {
+    int64_t node_count = std::uniform_int_distribution<int64_t>(2, 12)(gen);
+    int64_t edge_count = std::uniform_int_distribution<int64_t>(0, 40)(gen);
+    std::uniform_int_distribution<int64_t> node_dis(0, node_count - 1);
+    std::uniform_int_distribution<int64_t> weight_dis(0, 5);
+    Graph graph;
+    for (int64_t i = 0; i < node_count; ++i) {
+      graph.AddNode();
+    }
+    for (int64_t i = 0; i < edge_count; ++i) {
+      graph.AddEdge(NodeId(node_dis(gen)), NodeId(node_dis(gen)),
+                    weight_dis(gen));
+    }
+    ExpectAlgorithmsAgree(graph, NodeId(0), NodeId(node_count - 1));
+  }
+}
+
+TEST(MinCutTest, PushRelabelWithHugeWeights) {
+  // Finite weights too large to bound the flow without overflow.
+  Graph graph;
+  NodeId s = graph.AddNode("s");
+  NodeId a = graph.AddNode("a");
+  NodeId t = graph.AddNode("t");
+  graph.AddEdge(s, a, std::numeric_limits<int64_t>::max() / 2);
+  graph.AddEdge(s, t, std::numeric_limits<int64_t>::max() / 4);
+  graph.AddEdge(a, t, std::numeric_limits<int64_t>::max() / 4);
+  GraphCut min_cut =
+      MinCutBetweenNodes(graph, s, t, MaxFlowAlgorithm::kPushRelabel);
+  EXPECT_EQ(min_cut.weight, 2 * (std::numeric_limits<int64_t>::max() / 4));
+  EXPECT_THAT(min_cut.source_partition, UnorderedElementsAre(s, a));
+  EXPECT_THAT(min_cut.sink_partition, UnorderedElementsAre(t));
+}
+
 }  // namespace
 }  // namespace min_cut
 }  // namespace xls
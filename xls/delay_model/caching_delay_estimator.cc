@@ -0,0 +1,108 @@
+// Copyright 2022 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "xls/delay_model/caching_delay_estimator.h"
+
+#include <tuple>
+
+#include "absl/hash/hash.h"
+#include "absl/strings/str_format.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/op.h"
+
+namespace xls {
+namespace {
+
+// Returns a value describing the operand of `node` at `index` for the purposes
+// of delay specialization: the index of the first operand which is the same
+// node and whether the operand is a literal.
+int64_t OperandClass(Node* node, int64_t index) {
+  Node* operand = node->operand(index);
+  int64_t first = 0;
+  while (node->operand(first) != operand) {
+    ++first;
+  }
+  return 2 * first + (operand->Is<Literal>() ? 1 : 0);
+}
+
+}  // namespace
+
+size_t CachingDelayEstimator::SignatureHash::operator()(Node* node) const {
+  size_t hash = absl::Hash<std::tuple<Op, int64_t, int64_t>>()(
+      {node->op(), node->GetType()->GetFlatBitCount(), node->operand_count()});
+  for (int64_t i = 0; i < node->operand_count(); ++i) {
+    hash = absl::Hash<std::tuple<size_t, int64_t, int64_t>>()(
+        {hash, node->operand(i)->GetType()->GetFlatBitCount(),
+         OperandClass(node, i)});
+  }
+  return hash;
+}
+
+bool CachingDelayEstimator::SignatureEq::operator()(Node* a, Node* b) const {
+  // IsDefinitelyEqualTo compares the op, attributes and operand and result
+  // types, and returns false for side-effecting operations.
+  if (!a->IsDefinitelyEqualTo(b)) {
+    return false;
+  }
+  for (int64_t i = 0; i < a->operand_count(); ++i) {
+    if (OperandClass(a, i) != OperandClass(b, i)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+CachingDelayEstimator::CachingDelayEstimator(const DelayEstimator& base)
+    : DelayEstimator(absl::StrFormat("%s_cached", base.name())),
+      base_(&base) {}
+
+absl::StatusOr<int64_t> CachingDelayEstimator::GetOperationDelayInPs(
+    Node* node) const {
+  {
+    absl::MutexLock lock(&mutex_);
+    auto node_it = node_delays_.find(node);
+    if (node_it != node_delays_.end()) {
+      return node_it->second;
+    }
+    auto signature_it = signature_delays_.find(node);
+    if (signature_it != signature_delays_.end()) {
+      node_delays_[node] = signature_it->second;
+      return signature_it->second;
+    }
+  }
+  // Estimate outside of the lock. Concurrent misses on the same signature may
+  // estimate the same delay more than once, which is harmless.
+  XLS_ASSIGN_OR_RETURN(int64_t delay, base_->GetOperationDelayInPs(node));
+  absl::MutexLock lock(&mutex_);
+  ++base_estimate_count_;
+  node_delays_[node] = delay;
+  signature_delays_.insert({node, delay});
+  return delay;
+}
+
+absl::Status CachingDelayEstimator::PrecomputeDelays(FunctionBase* f) const {
+  for (Node* node : f->nodes()) {
+    XLS_RETURN_IF_ERROR(GetOperationDelayInPs(node).status());
+  }
+  return absl::OkStatus();
+}
+
+int64_t CachingDelayEstimator::base_estimate_count() const {
+  absl::MutexLock lock(&mutex_);
+  return base_estimate_count_;
+}
+
+}  // namespace xls
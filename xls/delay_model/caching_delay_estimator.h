@@ -0,0 +1,77 @@
+// Copyright 2022 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef XLS_DELAY_MODEL_CACHING_DELAY_ESTIMATOR_H_
+#define XLS_DELAY_MODEL_CACHING_DELAY_ESTIMATOR_H_
+
+#include <cstdint>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "xls/delay_model/delay_estimator.h"
+#include "xls/ir/function_base.h"
+#include "xls/ir/node.h"
+
+namespace xls {
+
+// A delay estimator which memoizes the delays computed by another estimator.
+// Delays are cached per node and, across nodes, per operation signature: the
+// op, its attributes, the operand and result types, and the operand properties
+// which delay models specialize on (which operands are identical and which are
+// literals). Nodes with the same signature are assumed to have the same delay;
+// this holds for the model-based and logical-effort estimators. Side-effecting
+// operations are only cached per node.
+//
+// Intended to be scoped to a single analysis (e.g., a scheduling run): cached
+// nodes must not be modified or removed while the estimator is in use.
+// Thread-safe.
+class CachingDelayEstimator : public DelayEstimator {
+ public:
+  explicit CachingDelayEstimator(const DelayEstimator& base);
+
+  absl::StatusOr<int64_t> GetOperationDelayInPs(Node* node) const override;
+
+  // Computes the delays of all nodes in `f`. Returns an error if the delay of
+  // any node cannot be estimated.
+  absl::Status PrecomputeDelays(FunctionBase* f) const;
+
+  // Returns the number of delays computed by the underlying estimator.
+  int64_t base_estimate_count() const;
+
+ private:
+  // Hash and equality of nodes by operation signature.
+  struct SignatureHash {
+    size_t operator()(Node* node) const;
+  };
+  struct SignatureEq {
+    bool operator()(Node* a, Node* b) const;
+  };
+
+  const DelayEstimator* base_;
+  mutable absl::Mutex mutex_;
+  mutable absl::flat_hash_map<Node*, int64_t> node_delays_
+      ABSL_GUARDED_BY(mutex_);
+  // Maps a representative node of each signature to its delay.
+  mutable absl::flat_hash_map<Node*, int64_t, SignatureHash, SignatureEq>
+      signature_delays_ ABSL_GUARDED_BY(mutex_);
+  mutable int64_t base_estimate_count_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+}  // namespace xls
+
+#endif  // XLS_DELAY_MODEL_CACHING_DELAY_ESTIMATOR_H_
@@ -0,0 +1,147 @@
+// Copyright 2022 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "xls/delay_model/caching_delay_estimator.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/statusor.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_test_base.h"
+
+namespace xls {
+namespace {
+
+using status_testing::IsOkAndHolds;
+using status_testing::StatusIs;
+
+// A test delay estimator which counts the number of delays it computes. The
+// delay of a node is its result width plus one for each literal operand; delays
+// of multiplies cannot be estimated.
+class CountingDelayEstimator : public DelayEstimator {
+ public:
+  CountingDelayEstimator() : DelayEstimator("counting") {}
+
+  absl::StatusOr<int64_t> GetOperationDelayInPs(Node* node) const override {
+    ++call_count_;
+    if (node->op() == Op::kUMul) {
+      return absl::UnimplementedError("No delay for multiplies");
+    }
+    int64_t delay = node->GetType()->GetFlatBitCount();
+    for (Node* operand : node->operands()) {
+      delay += operand->Is<Literal>() ? 1 : 0;
+    }
+    return delay;
+  }
+
+  int64_t call_count() const { return call_count_; }
+
+ private:
+  mutable int64_t call_count_ = 0;
+};
+
+class CachingDelayEstimatorTest : public IrTestBase {};
+
+TEST_F(CachingDelayEstimatorTest, SharesDelaysBetweenIdenticalSignatures) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue y = fb.Param("y", p->GetBitsType(8));
+  BValue z = fb.Param("z", p->GetBitsType(16));
+  BValue add0 = fb.Add(x, y);
+  BValue add1 = fb.Add(add0, y);
+  BValue add_wide = fb.Add(z, z);
+  XLS_ASSERT_OK(fb.Build().status());
+
+  CountingDelayEstimator base;
+  CachingDelayEstimator caching(base);
+  EXPECT_THAT(caching.GetOperationDelayInPs(add0.node()), IsOkAndHolds(8));
+  EXPECT_THAT(caching.GetOperationDelayInPs(add1.node()), IsOkAndHolds(8));
+  EXPECT_THAT(caching.GetOperationDelayInPs(add0.node()), IsOkAndHolds(8));
+  EXPECT_EQ(base.call_count(), 1);
+
+  EXPECT_THAT(caching.GetOperationDelayInPs(add_wide.node()),
+              IsOkAndHolds(16));
+  EXPECT_EQ(base.call_count(), 2);
+  EXPECT_EQ(caching.base_estimate_count(), 2);
+}
+
+TEST_F(CachingDelayEstimatorTest, DistinguishesSpecializationsAndAttributes) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue y = fb.Param("y", p->GetBitsType(8));
+  BValue add = fb.Add(x, y);
+  BValue add_identical = fb.Add(x, x);
+  BValue add_literal = fb.Add(x, fb.Literal(UBits(1, 8)));
+  BValue slice_low = fb.BitSlice(x, /*start=*/0, /*width=*/4);
+  BValue slice_high = fb.BitSlice(x, /*start=*/4, /*width=*/4);
+  XLS_ASSERT_OK(fb.Build().status());
+
+  CountingDelayEstimator base;
+  CachingDelayEstimator caching(base);
+  EXPECT_THAT(caching.GetOperationDelayInPs(add.node()), IsOkAndHolds(8));
+  EXPECT_THAT(caching.GetOperationDelayInPs(add_identical.node()),
+              IsOkAndHolds(8));
+  EXPECT_THAT(caching.GetOperationDelayInPs(add_literal.node()),
+              IsOkAndHolds(9));
+  EXPECT_THAT(caching.GetOperationDelayInPs(slice_low.node()),
+              IsOkAndHolds(4));
+  EXPECT_THAT(caching.GetOperationDelayInPs(slice_high.node()),
+              IsOkAndHolds(4));
+  EXPECT_EQ(base.call_count(), 5);
+}
+
+TEST_F(CachingDelayEstimatorTest, PrecomputeDelays) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue y = fb.Param("y", p->GetBitsType(8));
+  BValue sub = fb.Subtract(fb.Add(x, y), fb.Add(y, x));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  CountingDelayEstimator base;
+  CachingDelayEstimator caching(base);
+  XLS_ASSERT_OK(caching.PrecomputeDelays(f));
+  // Params are side-effecting so are estimated individually. The two adds share
+  // a signature.
+  EXPECT_EQ(base.call_count(), 4);
+  for (Node* node : f->nodes()) {
+    EXPECT_THAT(caching.GetOperationDelayInPs(node), IsOkAndHolds(8));
+  }
+  EXPECT_THAT(caching.GetOperationDelayInPs(sub.node()), IsOkAndHolds(8));
+  EXPECT_EQ(base.call_count(), 4);
+}
+
+TEST_F(CachingDelayEstimatorTest, ErrorsAreNotCached) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  fb.UMul(x, x);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  CountingDelayEstimator base;
+  CachingDelayEstimator caching(base);
+  EXPECT_THAT(caching.GetOperationDelayInPs(f->return_value()),
+              StatusIs(absl::StatusCode::kUnimplemented));
+  EXPECT_THAT(caching.PrecomputeDelays(f),
+              StatusIs(absl::StatusCode::kUnimplemented));
+  EXPECT_EQ(base.call_count(), 3);
+  EXPECT_EQ(caching.base_estimate_count(), 1);
+}
+
+}  // namespace
+}  // namespace xls
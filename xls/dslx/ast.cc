@@ -14,6 +14,8 @@
 
 #include "xls/dslx/ast.h"
 
+#include <algorithm>
+
 #include "absl/status/statusor.h"
 #include "absl/strings/strip.h"
 #include "xls/common/indent.h"
@@ -505,6 +507,28 @@ Param::Param(Module* owner, NameDef* name_def, TypeAnnotation* type_annotation)
 
 // -- class Module
 
+// Blocks grow geometrically up to this size so that small modules stay small
+// and large ones don't pay for a block per handful of nodes.
+constexpr size_t kMaxArenaBlockSize = 1 << 20;
+
+void* Module::Allocate(size_t size) {
+  constexpr size_t kAlign = alignof(std::max_align_t);
+  size = (size + kAlign - 1) & ~(kAlign - 1);
+  if (size > arena_remaining_) {
+    size_t block_size = std::max(size, arena_next_block_size_);
+    // Deliberately not value-initialized; every node constructs its own bytes.
+    arena_blocks_.push_back(std::unique_ptr<char[]>(new char[block_size]));
+    arena_cursor_ = arena_blocks_.back().get();
+    arena_remaining_ = block_size;
+    arena_next_block_size_ =
+        std::min(arena_next_block_size_ * 2, kMaxArenaBlockSize);
+  }
+  void* result = arena_cursor_;
+  arena_cursor_ += size;
+  arena_remaining_ -= size;
+  return result;
+}
+
 absl::StatusOr<Function*> Module::GetFunctionOrError(
     absl::string_view target_name) {
   for (ModuleMember& member : top_) {
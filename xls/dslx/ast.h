@@ -15,6 +15,10 @@
 #ifndef XLS_DSLX_AST_H_
 #define XLS_DSLX_AST_H_
 
+#include <cstddef>
+#include <memory>
+#include <new>
+
 #include "absl/container/btree_set.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
@@ -2566,8 +2570,16 @@ class Module : public AstNode {
 
   ~Module() {
     XLS_VLOG(3) << "Destroying module \"" << name_ << "\" @ " << this;
+    // Nodes live in arena blocks, so they're destroyed in place (newest first,
+    // mirroring the order a stack of owning pointers would unwind in).
+    for (auto it = nodes_.rbegin(); it != nodes_.rend(); ++it) {
+      (*it)->~AstNode();
+    }
   }
 
+  Module(const Module&) = delete;
+  Module& operator=(const Module&) = delete;
+
   AstNodeKind kind() const override { return AstNodeKind::kModule; }
 
   absl::Status Accept(AstNodeVisitor* v) override {
@@ -2599,12 +2611,16 @@ class Module : public AstNode {
     return absl::StrFormat("Module(name='%s', id=%p)", name(), this);
   }
 
+  // Creates a node of type T owned by this module. Nodes are bump-allocated
+  // out of module-owned blocks: an AST is built once and freed all at once, so
+  // per-node heap allocations only cost time and scatter the tree in memory.
   template <typename T, typename... Args>
   T* Make(Args&&... args) {
-    std::unique_ptr<T> node =
-        std::make_unique<T>(this, std::forward<Args>(args)...);
-    T* ptr = node.get();
-    nodes_.push_back(std::move(node));
+    static_assert(alignof(T) <= alignof(std::max_align_t),
+                  "AST node is over-aligned for the module arena.");
+    void* storage = Allocate(sizeof(T));
+    T* ptr = new (storage) T(this, std::forward<Args>(args)...);
+    nodes_.push_back(ptr);
     return ptr;
   }
 
@@ -2693,16 +2709,19 @@ class Module : public AstNode {
   const std::string& name() const { return name_; }
 
   const AstNode* FindNode(AstNodeKind kind, const Span& span) const {
-    for (const auto& node : nodes_) {
+    for (const AstNode* node : nodes_) {
       if (node->kind() == kind && node->GetSpan().has_value() &&
           node->GetSpan().value() == span) {
-        return node.get();
+        return node;
       }
     }
     return nullptr;
   }
 
  private:
+  // Returns max_align_t-aligned storage for "size" bytes out of the arena.
+  void* Allocate(size_t size);
+
   // Returns all of the elements of top_ that have the given variant type T.
   template <typename T>
   std::vector<T*> GetTopWithT() const {
@@ -2731,7 +2750,14 @@ class Module : public AstNode {
 
   std::string name_;               // Name of this module.
   std::vector<ModuleMember> top_;  // Top-level members of this module.
-  std::vector<std::unique_ptr<AstNode>> nodes_;  // Lifetime-owned AST nodes.
+  std::vector<AstNode*> nodes_;    // Lifetime-owned AST nodes.
+
+  // Arena storage for nodes_; "arena_cursor_" is the next free byte of the
+  // last block and "arena_remaining_" the number of bytes left after it.
+  std::vector<std::unique_ptr<char[]>> arena_blocks_;
+  char* arena_cursor_ = nullptr;
+  size_t arena_remaining_ = 0;
+  size_t arena_next_block_size_ = 4096;
 };
 
 // Helper for determining whether an AST node is constant (e.g. can be
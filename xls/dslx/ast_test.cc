@@ -16,6 +16,7 @@
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
 #include "xls/common/status/matchers.h"
 
 namespace xls::dslx {
@@ -39,6 +40,27 @@ TEST(CppAst, ModuleWithConstant) {
   EXPECT_EQ(m.ToString(), "const MOL = 42;");
 }
 
+TEST(CppAst, ManyNodesSpanningArenaBlocks) {
+  // Enough nodes to need several arena blocks, including the largest size.
+  constexpr int64_t kNodeCount = 50000;
+  Module m("test");
+  std::vector<NameDef*> name_defs;
+  for (int64_t i = 0; i < kNodeCount; ++i) {
+    const Span span(Pos("test.x", i, 0), Pos("test.x", i, 1));
+    name_defs.push_back(
+        m.Make<NameDef>(span, absl::StrCat("x", i), /*definer=*/nullptr));
+  }
+  for (int64_t i = 0; i < kNodeCount; i += 997) {
+    EXPECT_EQ(name_defs[i]->identifier(), absl::StrCat("x", i));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(name_defs[i]) %
+                  alignof(std::max_align_t),
+              0);
+  }
+  const Span last_span(Pos("test.x", kNodeCount - 1, 0),
+                       Pos("test.x", kNodeCount - 1, 1));
+  EXPECT_EQ(m.FindNode(AstNodeKind::kNameDef, last_span), name_defs.back());
+}
+
 TEST(CppAst, GetNumberAsInt64) {
   struct Example {
     std::string text;
@@ -16,8 +16,10 @@
 
 #include "absl/strings/str_split.h"
 #include "absl/types/variant.h"
+#include "xls/common/logging/logging.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/dslx/ast.h"
+#include "xls/dslx/lowered_bytecode.h"
 #include "xls/ir/bits_ops.h"
 #include "xls/ir/number_parser.h"
 #include "re2/re2.h"
@@ -68,6 +70,9 @@ absl::StatusOr<Bytecode::Op> OpFromString(std::string_view s) {
   if (s == "negate") {
     return Bytecode::Op::kNegate;
   }
+  if (s == "channel") {
+    return Bytecode::Op::kChannel;
+  }
   if (s == "recv") {
     return Bytecode::Op::kRecv;
   }
@@ -117,6 +122,8 @@ std::string OpToString(Bytecode::Op op) {
       return "call";
     case Bytecode::Op::kCast:
       return "cast";
+    case Bytecode::Op::kChannel:
+      return "channel";
     case Bytecode::Op::kConcat:
       return "concat";
     case Bytecode::Op::kCreateArray:
@@ -181,6 +188,8 @@ std::string OpToString(Bytecode::Op op) {
       return "shr";
     case Bytecode::Op::kSlice:
       return "slice";
+    case Bytecode::Op::kSpawn:
+      return "spawn";
     case Bytecode::Op::kStore:
       return "store";
     case Bytecode::Op::kSub:
@@ -308,6 +317,7 @@ std::string Bytecode::MatchArmItem::ToString() const {
     return Bytecode(span, Op::k##OP_NAME);                   \
   }
 
+DEF_UNARY_BUILDER(Channel);
 DEF_UNARY_BUILDER(Dup);
 DEF_UNARY_BUILDER(Invert);
 DEF_UNARY_BUILDER(JumpDest);
@@ -394,6 +404,17 @@ absl::StatusOr<Bytecode::SlotIndex> Bytecode::slot_index() const {
   return absl::get<SlotIndex>(data_.value());
 }
 
+absl::StatusOr<const Bytecode::SpawnData*> Bytecode::spawn_data() const {
+  if (!data_.has_value()) {
+    return absl::InvalidArgumentError("Bytecode does not hold data.");
+  }
+  if (!absl::holds_alternative<SpawnData>(data_.value())) {
+    return absl::InvalidArgumentError("Bytecode data is not a SpawnData.");
+  }
+
+  return &absl::get<SpawnData>(data_.value());
+}
+
 absl::StatusOr<Bytecode::InvocationData> Bytecode::invocation_data() const {
   if (!data_.has_value()) {
     return absl::InvalidArgumentError("Bytecode does not hold data.");
@@ -463,6 +484,8 @@ std::string Bytecode::ToString(bool source_locs) const {
       } else {
         data_string = iv.invocation->ToString();
       }
+    } else if (absl::holds_alternative<SpawnData>(data_.value())) {
+      data_string = absl::get<SpawnData>(data_.value()).proc->identifier();
     } else if (absl::holds_alternative<InterpValue>(data_.value())) {
       data_string = absl::get<InterpValue>(data_.value()).ToString();
     } else if (absl::holds_alternative<NumElements>(data_.value())) {
@@ -576,6 +599,22 @@ BytecodeFunction::BytecodeFunction(Module* owner, const TypeInfo* type_info,
                                    std::vector<Bytecode> bytecodes)
     : owner_(owner), type_info_(type_info), bytecodes_(std::move(bytecodes)) {}
 
+BytecodeFunction::~BytecodeFunction() = default;
+
+const LoweredBytecodeFunction* BytecodeFunction::lowered() const {
+  absl::call_once(lowered_once_, [this] {
+    absl::StatusOr<std::unique_ptr<LoweredBytecodeFunction>> lowered =
+        LoweredBytecodeFunction::Lower(this);
+    if (lowered.ok()) {
+      lowered_ = std::move(lowered).value();
+    } else {
+      XLS_VLOG(1) << "Could not lower bytecode function: "
+                  << lowered.status();
+    }
+  });
+  return lowered_.get();
+}
+
 absl::Status BytecodeFunction::Init() {
   num_slots_ = 0;
   for (const auto& bc : bytecodes_) {
@@ -18,6 +18,7 @@
 #include <string>
 #include <vector>
 
+#include "absl/base/call_once.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/types/variant.h"
@@ -50,6 +51,9 @@ class Bytecode {
     // Casts the element on top of the stack to the type given in the optional
     // arg.
     kCast,
+    // Creates a new channel and pushes it as a (producer, consumer) tuple; both
+    // ends refer to the same underlying queue.
+    kChannel,
     // Concatenates TOS1 and TOS0, with TOS1 comprising the most significant
     // bits of the result.
     kConcat,
@@ -112,11 +116,13 @@ class Bytecode {
     kNegate,
     // Performs a bitwise OR of the top two values on the stack.
     kOr,
-    // Pulls a value off of the channel at TOS0, or "blocks" if empty:
-    // terminates execution at the opcode's PC. The interpreter can be
-    // resumed/retried if/when a value becomes available.
+    // Pulls a value off of the channel at TOS0 and replaces it and the token at
+    // TOS1 with a (token, value) tuple, or "blocks" if empty: terminates
+    // execution at the opcode's PC with the stack unchanged. The interpreter
+    // can be resumed/retried if/when a value becomes available.
     kRecv,
-    // Inserts the value at TOS0 into the channel at TOS1.
+    // Inserts the value at TOS0 into the channel at TOS1, leaving the token at
+    // TOS2 as the result.
     kSend,
     // Performs a left shift of the second-to-top stack element by the
     // top element's number.
@@ -128,6 +134,11 @@ class Bytecode {
     // Slices out a subset of the bits-typed value on TOS2,
     // starting at index TOS1 and ending at index TOS0.
     kSlice,
+    // Spawns the proc described by the SpawnData in the data argument. The
+    // config args followed by the initial state (i.e., the next args) are given
+    // on the stack in order, with the last next arg at TOS0. Only valid while
+    // instantiating a proc network (see ProcInstance).
+    kSpawn,
     // Stores the value at stack top into the arg-data-specified slot.
     kStore,
     // Subtracts the Nth value from the N-1th value on the stack.
@@ -168,6 +179,16 @@ class Bytecode {
     absl::optional<SymbolicBindings> bindings;
   };
 
+  // Data needed to instantiate a spawned proc: the spawn itself, the proc it
+  // resolves to, and the callee bindings of its config and next functions (if
+  // the proc is parametric).
+  struct SpawnData {
+    Spawn* spawn;
+    Proc* proc;
+    absl::optional<SymbolicBindings> config_bindings;
+    absl::optional<SymbolicBindings> next_bindings;
+  };
+
   // Encapsulates an element in a MatchArm's NameDefTree. For literals, a
   // this is an InterpValue. For NameRefs, this is the associated SlotIndex. For
   // NameDefs (i.e., assignments to a name from the value to match), this is the
@@ -211,7 +232,7 @@ class Bytecode {
   using TraceData = std::vector<FormatStep>;
   using Data = absl::variant<InterpValue, JumpTarget, NumElements, SlotIndex,
                              std::unique_ptr<ConcreteType>, InvocationData,
-                             MatchArmItem, TraceData>;
+                             MatchArmItem, TraceData, SpawnData>;
 
   static Bytecode MakeDup(Span span);
   static Bytecode MakeFail(Span span, std::string);
@@ -224,6 +245,7 @@ class Bytecode {
   static Bytecode MakeLogicalOr(Span span);
   static Bytecode MakeMatchArm(Span span, MatchArmItem item);
   static Bytecode MakePop(Span span);
+  static Bytecode MakeChannel(Span span);
   static Bytecode MakeRecv(Span span);
   static Bytecode MakeStore(Span span, SlotIndex slot_index);
   static Bytecode MakeSwap(Span span);
@@ -251,6 +273,7 @@ class Bytecode {
   absl::StatusOr<const MatchArmItem*> match_arm_item() const;
   absl::StatusOr<NumElements> num_elements() const;
   absl::StatusOr<SlotIndex> slot_index() const;
+  absl::StatusOr<const SpawnData*> spawn_data() const;
   absl::StatusOr<const TraceData*> trace_data() const;
   absl::StatusOr<const ConcreteType*> type_data() const;
   absl::StatusOr<InterpValue> value_data() const;
@@ -281,6 +304,8 @@ class Bytecode {
 
 std::string OpToString(Bytecode::Op op);
 
+class LoweredBytecodeFunction;
+
 // Holds all the bytecode implementing a function along with useful metadata.
 class BytecodeFunction {
  public:
@@ -291,12 +316,19 @@ class BytecodeFunction {
   static absl::StatusOr<std::unique_ptr<BytecodeFunction>> Create(
       Module* owner, const TypeInfo* type_info, std::vector<Bytecode> bytecode);
 
+  ~BytecodeFunction();
+
   Module* owner() const { return owner_; }
   const TypeInfo* type_info() const { return type_info_; }
   const std::vector<Bytecode>& bytecodes() const { return bytecodes_; }
   // Returns the total number of binding "slots" used by the bytecodes.
   int64_t num_slots() const { return num_slots_; }
 
+  // Returns the lowered form of this function (see lowered_bytecode.h),
+  // lowering it on first use. Returns nullptr if the bytecode can't be lowered,
+  // in which case it must be executed one Bytecode at a time. Thread-safe.
+  const LoweredBytecodeFunction* lowered() const;
+
   // Creates and returns a [caller-owned] copy of the internal bytecodes.
   std::vector<Bytecode> CloneBytecodes() const;
 
@@ -311,6 +343,9 @@ class BytecodeFunction {
   const TypeInfo* type_info_;
   std::vector<Bytecode> bytecodes_;
   int64_t num_slots_;
+
+  mutable absl::once_flag lowered_once_;
+  mutable std::unique_ptr<LoweredBytecodeFunction> lowered_;
 };
 
 // Converts the given sequence of bytecodes to a more human-readable string,
@@ -0,0 +1,174 @@
+// Copyright 2022 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// Benchmarks the dispatch modes of the DSLX bytecode interpreter on the unit
+// tests of DSLX modules, e.g. those in xls/dslx/stdlib and xls/modules.
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_split.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/init_xls.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/dslx/bytecode.h"
+#include "xls/dslx/bytecode_emitter.h"
+#include "xls/dslx/bytecode_interpreter.h"
+#include "xls/dslx/command_line_utils.h"
+#include "xls/dslx/create_import_data.h"
+#include "xls/dslx/default_dslx_stdlib_path.h"
+#include "xls/dslx/import_data.h"
+#include "xls/dslx/parse_and_typecheck.h"
+
+const char kUsage[] = R"(
+Benchmarks the DSLX bytecode interpreter by running the unit tests of the given
+modules with Bytecode-at-a-time dispatch and with lowered, threaded dispatch.
+
+Expected invocation:
+  bytecode_benchmark_main <DSLX file>...
+
+Example invocation:
+  bytecode_benchmark_main xls/dslx/stdlib/apfloat.x xls/modules/fp32_fma.x
+)";
+
+ABSL_FLAG(std::string, dslx_path, "",
+          "Additional paths to search for modules (colon delimited).");
+ABSL_FLAG(std::string, dslx_stdlib_path, xls::kDefaultDslxStdlibPath,
+          "Path to DSLX standard library");
+ABSL_FLAG(int64_t, repetitions, 5,
+          "Number of times to run each test. The minimum time is reported.");
+
+namespace xls::dslx {
+namespace {
+
+using Dispatch = BytecodeInterpreter::Dispatch;
+
+// Returns the minimum time taken by `f` over the configured number of
+// repetitions, after one untimed run which populates the bytecode cache and
+// lowers the functions involved.
+absl::StatusOr<absl::Duration> MinimumTime(
+    const std::function<absl::Status()>& f) {
+  XLS_RETURN_IF_ERROR(f());
+  absl::Duration best = absl::InfiniteDuration();
+  for (int64_t i = 0; i < absl::GetFlag(FLAGS_repetitions); ++i) {
+    absl::Time start = absl::Now();
+    XLS_RETURN_IF_ERROR(f());
+    best = std::min(best, absl::Now() - start);
+  }
+  return best;
+}
+
+absl::Status BenchmarkModule(
+    absl::string_view path,
+    absl::Span<const std::filesystem::path> dslx_paths,
+    absl::Duration* total_bytecode, absl::Duration* total_lowered) {
+  XLS_ASSIGN_OR_RETURN(std::string program, GetFileContents(path));
+  XLS_ASSIGN_OR_RETURN(std::string module_name, PathToName(path));
+  ImportData import_data(
+      CreateImportData(absl::GetFlag(FLAGS_dslx_stdlib_path), dslx_paths));
+  XLS_ASSIGN_OR_RETURN(
+      TypecheckedModule tm,
+      ParseAndTypecheck(program, path, module_name, &import_data));
+
+  for (const std::string& test_name : tm.module->GetTestNames()) {
+    // Test procs are not supported by the bytecode interpreter.
+    absl::StatusOr<TestFunction*> test = tm.module->GetTest(test_name);
+    if (!test.ok()) {
+      continue;
+    }
+    XLS_ASSIGN_OR_RETURN(
+        std::unique_ptr<BytecodeFunction> bf,
+        BytecodeEmitter::Emit(&import_data, tm.type_info, (*test)->fn(),
+                              absl::nullopt));
+    auto run = [&](Dispatch dispatch) {
+      return BytecodeInterpreter::Interpret(&import_data, bf.get(),
+                                            /*args=*/{}, dispatch)
+          .status();
+    };
+    absl::StatusOr<absl::Duration> bytecode_time =
+        MinimumTime([&] { return run(Dispatch::kBytecode); });
+    absl::StatusOr<absl::Duration> lowered_time =
+        MinimumTime([&] { return run(Dispatch::kLowered); });
+    if (!bytecode_time.ok() || !lowered_time.ok()) {
+      std::cout << absl::StreamFormat(
+          "%-48s failed: %s\n", absl::StrCat(module_name, ".", test_name),
+          (bytecode_time.ok() ? lowered_time : bytecode_time)
+              .status()
+              .ToString());
+      continue;
+    }
+    *total_bytecode += *bytecode_time;
+    *total_lowered += *lowered_time;
+    std::cout << absl::StreamFormat(
+        "%-48s %12.3fms %12.3fms %8.2fx\n",
+        absl::StrCat(module_name, ".", test_name),
+        absl::ToDoubleMilliseconds(*bytecode_time),
+        absl::ToDoubleMilliseconds(*lowered_time),
+        absl::FDivDuration(*bytecode_time, *lowered_time));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status RealMain(absl::Span<const absl::string_view> paths) {
+  std::vector<std::filesystem::path> dslx_paths;
+  for (absl::string_view path : absl::StrSplit(absl::GetFlag(FLAGS_dslx_path),
+                                               ':', absl::SkipEmpty())) {
+    dslx_paths.push_back(std::filesystem::path(path));
+  }
+
+  std::cout << absl::StreamFormat("%-48s %14s %14s %9s\n", "test", "bytecode",
+                                  "lowered", "speedup");
+  absl::Duration total_bytecode;
+  absl::Duration total_lowered;
+  for (absl::string_view path : paths) {
+    XLS_RETURN_IF_ERROR(
+        BenchmarkModule(path, dslx_paths, &total_bytecode, &total_lowered));
+  }
+  if (total_lowered > absl::ZeroDuration()) {
+    std::cout << absl::StreamFormat(
+        "%-48s %12.3fms %12.3fms %8.2fx\n", "total",
+        absl::ToDoubleMilliseconds(total_bytecode),
+        absl::ToDoubleMilliseconds(total_lowered),
+        absl::FDivDuration(total_bytecode, total_lowered));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+}  // namespace xls::dslx
+
+int main(int argc, char** argv) {
+  std::vector<absl::string_view> positional_arguments =
+      xls::InitXls(kUsage, argc, argv);
+  if (positional_arguments.empty()) {
+    XLS_LOG(QFATAL) << "Expected at least one DSLX file; usage:\n" << kUsage;
+  }
+  XLS_QCHECK_OK(xls::dslx::RealMain(positional_arguments));
+  return EXIT_SUCCESS;
+}
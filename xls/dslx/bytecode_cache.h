@@ -16,7 +16,9 @@
 
 #include <memory>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
 #include "xls/dslx/ast.h"
 #include "xls/dslx/bytecode.h"
 #include "xls/dslx/bytecode_cache_interface.h"
@@ -25,6 +27,8 @@
 
 namespace xls::dslx {
 
+// Emits bytecode functions on demand and retains them for the lifetime of the
+// cache. Safe to use from multiple interpreters running concurrently.
 class BytecodeCache : public BytecodeCacheInterface {
  public:
   BytecodeCache(ImportData* import_data);
@@ -37,7 +41,9 @@ class BytecodeCache : public BytecodeCacheInterface {
                          absl::optional<SymbolicBindings>>;
 
   ImportData* import_data_;
-  absl::flat_hash_map<Key, std::unique_ptr<BytecodeFunction>> cache_;
+  absl::Mutex mutex_;
+  absl::flat_hash_map<Key, std::unique_ptr<BytecodeFunction>> cache_
+      ABSL_GUARDED_BY(mutex_);
 };
 
 }  // namespace xls::dslx
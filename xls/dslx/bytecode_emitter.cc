@@ -25,6 +25,7 @@
 #include "xls/dslx/ast_utils.h"
 #include "xls/dslx/concrete_type.h"
 #include "xls/dslx/interp_value.h"
+#include "xls/dslx/interp_value_helpers.h"
 
 // TODO(rspringer): 2022-03-01: Verify that, for all valid programs (or at least
 // some subset that we test), interpretation terminates with only a single value
@@ -484,7 +485,9 @@ void BytecodeEmitter::HandleCast(Cast* node) {
 }
 
 void BytecodeEmitter::HandleChannelDecl(ChannelDecl* node) {
-  Add(Bytecode::MakeLiteral(node->span(), InterpValue::MakeChannel()));
+  // A literal would share one channel between all executions of the config
+  // function, so each execution creates its own.
+  Add(Bytecode::MakeChannel(node->span()));
 }
 
 absl::StatusOr<InterpValue> BytecodeEmitter::HandleColonRefToEnum(
@@ -1058,6 +1061,58 @@ void BytecodeEmitter::HandleRecv(Recv* node) {
   Add(Bytecode::MakeRecv(node->span()));
 }
 
+void BytecodeEmitter::HandleRecvIf(RecvIf* node) {
+  if (!status_.ok()) {
+    return;
+  }
+
+  // If the condition is false, the result holds the zero value of the payload
+  // type instead of a received value.
+  absl::StatusOr<TupleType*> type_or = type_info_->GetItemAs<TupleType>(node);
+  if (!type_or.ok()) {
+    status_ = type_or.status();
+    return;
+  }
+  absl::StatusOr<InterpValue> zero_or =
+      CreateZeroValueFromType(*type_or.value()->members().at(1));
+  if (!zero_or.ok()) {
+    status_ = zero_or.status();
+    return;
+  }
+
+  // Structure is:
+  //
+  //  $token
+  //  $condition
+  //  jump_if =>recv
+  //  literal $zero
+  //  create_tuple 2
+  //  jump =>join
+  // recv:
+  //  jump_dest
+  //  $channel
+  //  recv
+  // join:
+  //  jump_dest
+  node->token()->AcceptExpr(this);
+  node->condition()->AcceptExpr(this);
+  size_t jump_if_index = bytecode_.size();
+  Add(Bytecode::MakeJumpRelIf(node->span(), Bytecode::kPlaceholderJumpAmount));
+  Add(Bytecode::MakeLiteral(node->span(), zero_or.value()));
+  Add(Bytecode(node->span(), Bytecode::Op::kCreateTuple,
+               Bytecode::NumElements(2)));
+  size_t jump_index = bytecode_.size();
+  Add(Bytecode::MakeJumpRel(node->span(), Bytecode::kPlaceholderJumpAmount));
+  size_t recv_index = bytecode_.size();
+  Add(Bytecode::MakeJumpDest(node->span()));
+  node->channel()->AcceptExpr(this);
+  Add(Bytecode::MakeRecv(node->span()));
+  size_t join_index = bytecode_.size();
+  Add(Bytecode::MakeJumpDest(node->span()));
+  bytecode_.at(jump_if_index).PatchJumpTarget(recv_index - jump_if_index);
+  bytecode_.at(jump_index).PatchJumpTarget(join_index - jump_index);
+}
+
 void BytecodeEmitter::HandleSend(Send* node) {
   node->token()->AcceptExpr(this);
   node->channel()->AcceptExpr(this);
@@ -1065,6 +1120,114 @@ void BytecodeEmitter::HandleSend(Send* node) {
   Add(Bytecode::MakeSend(node->span()));
 }
 
+void BytecodeEmitter::HandleSendIf(SendIf* node) {
+  if (!status_.ok()) {
+    return;
+  }
+
+  // Structure is:
+  //
+  //  $token
+  //  $condition
+  //  jump_if =>send
+  //  jump =>join
+  // send:
+  //  jump_dest
+  //  $channel
+  //  $payload
+  //  send
+  // join:
+  //  jump_dest
+  //
+  // Either way, the token is left on the stack as the result.
+  node->token()->AcceptExpr(this);
+  node->condition()->AcceptExpr(this);
+  size_t jump_if_index = bytecode_.size();
+  Add(Bytecode::MakeJumpRelIf(node->span(), Bytecode::kPlaceholderJumpAmount));
+  size_t jump_index = bytecode_.size();
+  Add(Bytecode::MakeJumpRel(node->span(), Bytecode::kPlaceholderJumpAmount));
+  size_t send_index = bytecode_.size();
+  Add(Bytecode::MakeJumpDest(node->span()));
+  node->channel()->AcceptExpr(this);
+  node->payload()->AcceptExpr(this);
+  Add(Bytecode::MakeSend(node->span()));
+  size_t join_index = bytecode_.size();
+  Add(Bytecode::MakeJumpDest(node->span()));
+  bytecode_.at(jump_if_index).PatchJumpTarget(send_index - jump_if_index);
+  bytecode_.at(jump_index).PatchJumpTarget(join_index - jump_index);
+}
+
+void BytecodeEmitter::HandleJoin(Join* node) {
+  // Tokens carry no data, so the operands are only evaluated for their effects.
+  for (Expr* token : node->tokens()) {
+    token->AcceptExpr(this);
+    Add(Bytecode::MakePop(node->span()));
+  }
+  Add(Bytecode::MakeLiteral(node->span(), InterpValue::MakeToken()));
+}
+
+// Returns the proc that the callee of a spawn refers to, which may live in an
+// imported module.
+static absl::StatusOr<Proc*> ResolveProc(Expr* callee,
+                                         const TypeInfo* type_info) {
+  if (auto* colon_ref = dynamic_cast<ColonRef*>(callee)) {
+    absl::optional<Import*> import = colon_ref->ResolveImportSubject();
+    XLS_RET_CHECK(import.has_value())
+        << "ColonRef did not refer to an import: " << colon_ref->ToString();
+    absl::optional<const ImportedInfo*> imported_info =
+        type_info->GetImported(*import);
+    XLS_RET_CHECK(imported_info.has_value());
+    return imported_info.value()->module->GetProcOrError(colon_ref->attr());
+  }
+  auto* name_ref = dynamic_cast<NameRef*>(callee);
+  XLS_RET_CHECK(name_ref != nullptr);
+  return callee->owner()->GetProcOrError(name_ref->identifier());
+}
+
+void BytecodeEmitter::HandleSpawn(Spawn* node) {
+  if (!status_.ok()) {
+    return;
+  }
+
+  absl::StatusOr<Proc*> proc_or = ResolveProc(node->callee(), type_info_);
+  if (!proc_or.ok()) {
+    status_ = proc_or.status();
+    return;
+  }
+
+  for (Expr* arg : node->config()->args()) {
+    arg->AcceptExpr(this);
+  }
+  for (Expr* arg : node->next()->args()) {
+    arg->AcceptExpr(this);
+  }
+
+  SymbolicBindings caller_bindings =
+      caller_bindings_.has_value() ? caller_bindings_.value()
+                                   : SymbolicBindings();
+  auto get_callee_bindings =
+      [&](Invocation* invocation) -> absl::optional<SymbolicBindings> {
+    absl::optional<const SymbolicBindings*> bindings =
+        type_info_->GetInstantiationCalleeBindings(invocation,
+                                                   caller_bindings);
+    if (!bindings.has_value()) {
+      return absl::nullopt;
+    }
+    return *bindings.value();
+  };
+  Add(Bytecode(node->span(), Bytecode::Op::kSpawn,
+               Bytecode::SpawnData{node, proc_or.value(),
+                                   get_callee_bindings(node->config()),
+                                   get_callee_bindings(node->next())}));
+
+  // Like a let, the spawn is followed by the rest of the enclosing block.
+  if (node->body() != nullptr) {
+    node->body()->AcceptExpr(this);
+  } else {
+    Add(Bytecode::MakeLiteral(node->span(), InterpValue::MakeUnit()));
+  }
+}
+
 void BytecodeEmitter::HandleString(String* node) {
   if (!status_.ok()) {
     return;
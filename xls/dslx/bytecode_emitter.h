@@ -72,7 +72,7 @@ class BytecodeEmitter : public ExprVisitor {
   void HandleFormatMacro(FormatMacro* node) override;
   void HandleIndex(Index* node) override;
   void HandleInvocation(Invocation* node) override;
-  void HandleJoin(Join* node) override { DefaultHandler(node); }
+  void HandleJoin(Join* node) override;
   void HandleLet(Let* node) override;
   void HandleMatch(Match* node) override;
   void HandleNameRef(NameRef* node) override;
@@ -81,10 +81,10 @@ class BytecodeEmitter : public ExprVisitor {
   void HandleNumber(Number* node) override;
   absl::StatusOr<InterpValue> HandleNumberInternal(Number* node);
   void HandleRecv(Recv* node) override;
-  void HandleRecvIf(RecvIf* node) override { DefaultHandler(node); }
+  void HandleRecvIf(RecvIf* node) override;
   void HandleSend(Send* node) override;
-  void HandleSendIf(SendIf* node) override { DefaultHandler(node); }
-  void HandleSpawn(Spawn* node) override { DefaultHandler(node); }
+  void HandleSendIf(SendIf* node) override;
+  void HandleSpawn(Spawn* node) override;
   void HandleString(String* node) override;
   void HandleStructInstance(StructInstance* node) override;
   void HandleSplatStructInstance(SplatStructInstance* node) override;
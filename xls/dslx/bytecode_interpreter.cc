@@ -14,7 +14,10 @@
 
 #include "xls/dslx/bytecode_interpreter.h"
 
+#include "absl/base/macros.h"
+#include "absl/memory/memory.h"
 #include "absl/status/status.h"
+#include "xls/common/logging/vlog_is_on.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/dslx/ast.h"
@@ -41,69 +44,295 @@ void BytecodeInterpreter::Frame::StoreSlot(Bytecode::SlotIndex slot,
                                            InterpValue value) {
   // Slots are assigned in ascending order of use, which means that we'll only
   // ever need to add one slot.
-  if (slots_.size() <= slot.value()) {
-    slots_.push_back(InterpValue::MakeToken());
+  if (slots_.size() == slot.value()) {
+    slots_.push_back(std::move(value));
+    return;
   }
 
-  slots_.at(slot.value()) = value;
+  slots_.at(slot.value()) = std::move(value);
 }
 
 /* static */ absl::StatusOr<InterpValue> BytecodeInterpreter::Interpret(
     ImportData* import_data, BytecodeFunction* bf,
-    std::vector<InterpValue> args) {
-  BytecodeInterpreter interpreter(import_data, bf, std::move(args));
+    std::vector<InterpValue> args, Dispatch dispatch) {
+  BytecodeInterpreter interpreter(import_data, bf, std::move(args), dispatch);
   XLS_RETURN_IF_ERROR(interpreter.Run());
-  return interpreter.stack_.back();
+  if (interpreter.blocked_) {
+    return absl::UnavailableError("Channel is empty.");
+  }
+  return std::move(interpreter.stack_.back());
 }
 
-BytecodeInterpreter::BytecodeInterpreter(ImportData* import_data,
-                                         BytecodeFunction* bf,
-                                         std::vector<InterpValue> args)
-    : import_data_(import_data) {
+BytecodeInterpreter::BytecodeInterpreter(
+    ImportData* import_data, BytecodeFunction* bf,
+    std::vector<InterpValue> args, Dispatch dispatch,
+    const TypeInfo* type_info, const absl::optional<SymbolicBindings>& bindings)
+    : import_data_(import_data), dispatch_(dispatch) {
   // In "mission mode" we expect type_info to be non-null in the frame, but for
   // bytecode-level testing we may not have an AST.
-  TypeInfo* type_info = nullptr;
-  if (bf->owner()) {
+  if (type_info == nullptr && bf->owner()) {
     type_info = import_data_->GetRootTypeInfo(bf->owner()).value();
   }
-  frames_.push_back(Frame(bf, std::move(args), type_info, absl::nullopt));
+  frames_.push_back(Frame(bf, std::move(args), type_info, bindings));
 }
 
 absl::Status BytecodeInterpreter::Run() {
+  blocked_ = false;
   while (!frames_.empty()) {
-    Frame* frame = &frames_.back();
-    while (frame->pc() < frame->bf()->bytecodes().size()) {
-      const std::vector<Bytecode>& bytecodes = frame->bf()->bytecodes();
-      const Bytecode& bytecode = bytecodes.at(frame->pc());
-      XLS_VLOG(2) << std::hex << "PC: " << frame->pc() << " : "
-                  << bytecode.ToString();
-      if (!stack_.empty()) {
-        XLS_VLOG(2) << " - TOS: " << stack_.back().ToString();
-      }
-      int64_t old_pc = frame->pc();
-      XLS_RETURN_IF_ERROR(EvalNextInstruction());
-      if (!stack_.empty()) {
-        XLS_VLOG(2) << " - TOS: " << stack_.back().ToString();
-      }
+    int64_t depth = frames_.size();
+    const LoweredBytecodeFunction* lowered = nullptr;
+    if (dispatch_ == Dispatch::kLowered && !XLS_VLOG_IS_ON(2)) {
+      lowered = frames_.back().bf()->lowered();
+    }
+    if (lowered != nullptr) {
+      XLS_RETURN_IF_ERROR(RunLowered(*lowered));
+    } else {
+      XLS_RETURN_IF_ERROR(RunBytecodes());
+    }
+    if (blocked_) {
+      return absl::OkStatus();
+    }
+
+    // If the frame called a function, run the callee first; otherwise we've
+    // reached the end of a function. Time to load the next frame up!
+    if (frames_.size() == depth) {
+      frames_.pop_back();
+    }
+  }
+
+  return absl::OkStatus();
+}
+
+absl::Status BytecodeInterpreter::RunBytecodes() {
+  int64_t depth = frames_.size();
+  Frame* frame = &frames_.back();
+  while (frame->pc() < frame->bf()->bytecodes().size()) {
+    const std::vector<Bytecode>& bytecodes = frame->bf()->bytecodes();
+    const Bytecode& bytecode = bytecodes.at(frame->pc());
+    XLS_VLOG(2) << std::hex << "PC: " << frame->pc() << " : "
+                << bytecode.ToString();
+    if (!stack_.empty()) {
+      XLS_VLOG(2) << " - TOS: " << stack_.back().ToString();
+    }
+    int64_t old_pc = frame->pc();
+    XLS_RETURN_IF_ERROR(EvalNextInstruction());
+    if (blocked_) {
+      return absl::OkStatus();
+    }
+    if (!stack_.empty()) {
+      XLS_VLOG(2) << " - TOS: " << stack_.back().ToString();
+    }
 
-      if (bytecode.op() == Bytecode::Op::kCall) {
-        frame = &frames_.back();
-      } else if (frame->pc() != old_pc + 1) {
-        XLS_RET_CHECK(bytecodes.at(frame->pc()).op() == Bytecode::Op::kJumpDest)
-            << "Jumping from PC " << old_pc << " to PC: " << frame->pc()
-            << " bytecode: " << bytecodes.at(frame->pc()).ToString()
-            << " not a jump_dest or old bytecode: " << bytecode.ToString()
-            << " was not a call op.";
+    if (bytecode.op() == Bytecode::Op::kCall) {
+      if (frames_.size() > depth) {
+        return absl::OkStatus();
       }
+    } else if (frame->pc() != old_pc + 1) {
+      XLS_RET_CHECK(bytecodes.at(frame->pc()).op() == Bytecode::Op::kJumpDest)
+          << "Jumping from PC " << old_pc << " to PC: " << frame->pc()
+          << " bytecode: " << bytecodes.at(frame->pc()).ToString()
+          << " not a jump_dest or old bytecode: " << bytecode.ToString()
+          << " was not a call op.";
     }
+  }
+  return absl::OkStatus();
+}
+
+// Threaded dispatch: each instruction handler jumps directly to the handler of
+// the next instruction through a table of label addresses, which gives the
+// branch predictor one indirect branch per handler to learn. Falls back to a
+// switch where the labels-as-values extension is unavailable.
+#if defined(__GNUC__)
+#define XLS_DSLX_COMPUTED_GOTO 1
+#else
+#define XLS_DSLX_COMPUTED_GOTO 0
+#endif
+
+absl::Status BytecodeInterpreter::RunLowered(
+    const LoweredBytecodeFunction& lowered) {
+  using Instruction = LoweredBytecodeFunction::Instruction;
+  using Op = LoweredBytecodeFunction::Op;
 
-    // We've reached the end of a function. Time to load the next frame up!
-    frames_.pop_back();
+  const int64_t depth = frames_.size();
+  Frame* frame = &frames_.back();
+  std::vector<InterpValue>& slots = frame->slots();
+  absl::Span<const Instruction> instructions = lowered.instructions();
+  int64_t start = lowered.InstructionIndexAt(frame->pc());
+  XLS_RET_CHECK_GE(start, 0) << "PC " << frame->pc()
+                             << " is not at a lowered instruction boundary.";
+  const Instruction* ip = &instructions[start];
+
+  auto slot = [&](int64_t index) -> absl::StatusOr<const InterpValue*> {
+    if (slots.size() <= index) {
+      return absl::InternalError(absl::StrFormat(
+          "Attempted to access local data in slot %d, which is out of range.",
+          index));
+    }
+    return &slots[index];
+  };
+  auto load = [&](int64_t index) -> absl::Status {
+    XLS_ASSIGN_OR_RETURN(const InterpValue* value, slot(index));
+    stack_.push_back(*value);
+    return absl::OkStatus();
+  };
+  auto store = [&](int64_t index) -> absl::Status {
+    if (stack_.empty()) {
+      return absl::InvalidArgumentError(
+          "Attempted to store value from empty stack.");
+    }
+    frame->StoreSlot(Bytecode::SlotIndex(index), std::move(stack_.back()));
+    stack_.pop_back();
+    return absl::OkStatus();
+  };
+
+#if XLS_DSLX_COMPUTED_GOTO
+  // Must be in the same order as LoweredBytecodeFunction::Op.
+  static void* const kDispatchTable[] = {
+      &&kGeneric,      &&kLoad,          &&kStore,         &&kLiteral,
+      &&kDup,          &&kPop,           &&kSwap,          &&kJump,
+      &&kJumpIf,       &&kBinop,         &&kLoadLoad,      &&kLoadLiteral,
+      &&kStoreLoad,    &&kBinopLoad,     &&kBinopLiteral,  &&kLoadBinopLoad,
+      &&kLoadBinopLiteral, &&kEnd,
+  };
+  static_assert(ABSL_ARRAYSIZE(kDispatchTable) ==
+                static_cast<int>(Op::kEnd) + 1);
+#define DISPATCH() goto* kDispatchTable[static_cast<int>(ip->op)]
+#define TARGET(op) op:
+  DISPATCH();
+#else
+#define DISPATCH() goto dispatch
+#define TARGET(op) case Op::op:
+dispatch:
+  switch (ip->op) {
+#endif
+
+  TARGET(kGeneric) {
+    frame->set_pc(ip->pc);
+    XLS_RETURN_IF_ERROR(EvalNextInstruction());
+    if (frames_.size() > depth || blocked_) {
+      // Called a function, in which case the frame's PC holds the return
+      // address, or blocked at the current PC.
+      return absl::OkStatus();
+    }
+    int64_t next = lowered.InstructionIndexAt(frame->pc());
+    XLS_RET_CHECK_GE(next, 0) << "PC " << frame->pc()
+                              << " is not at a lowered instruction boundary.";
+    ip = &instructions[next];
+    DISPATCH();
+  }
+  TARGET(kLoad) {
+    XLS_RETURN_IF_ERROR(load(ip->a));
+    ++ip;
+    DISPATCH();
+  }
+  TARGET(kStore) {
+    XLS_RETURN_IF_ERROR(store(ip->a));
+    ++ip;
+    DISPATCH();
+  }
+  TARGET(kLiteral) {
+    stack_.push_back(*ip->literal);
+    ++ip;
+    DISPATCH();
+  }
+  TARGET(kDup) {
+    XLS_RET_CHECK(!stack_.empty());
+    stack_.push_back(stack_.back());
+    ++ip;
+    DISPATCH();
+  }
+  TARGET(kPop) {
+    XLS_RETURN_IF_ERROR(Pop().status());
+    ++ip;
+    DISPATCH();
+  }
+  TARGET(kSwap) {
+    XLS_RET_CHECK_GE(stack_.size(), 2);
+    std::swap(stack_[stack_.size() - 1], stack_[stack_.size() - 2]);
+    ++ip;
+    DISPATCH();
+  }
+  TARGET(kJump) {
+    ip = &instructions[ip->a];
+    DISPATCH();
+  }
+  TARGET(kJumpIf) {
+    XLS_ASSIGN_OR_RETURN(InterpValue top, Pop());
+    ip = top.IsTrue() ? &instructions[ip->a] : ip + 1;
+    DISPATCH();
+  }
+  TARGET(kBinop) {
+    XLS_RET_CHECK_GE(stack_.size(), 2);
+    XLS_ASSIGN_OR_RETURN(
+        InterpValue result,
+        ip->binop(stack_[stack_.size() - 2], stack_[stack_.size() - 1]));
+    stack_.pop_back();
+    stack_.back() = std::move(result);
+    ++ip;
+    DISPATCH();
+  }
+  TARGET(kLoadLoad) {
+    XLS_RETURN_IF_ERROR(load(ip->a));
+    XLS_RETURN_IF_ERROR(load(ip->b));
+    ++ip;
+    DISPATCH();
+  }
+  TARGET(kLoadLiteral) {
+    XLS_RETURN_IF_ERROR(load(ip->a));
+    stack_.push_back(*ip->literal);
+    ++ip;
+    DISPATCH();
+  }
+  TARGET(kStoreLoad) {
+    XLS_RETURN_IF_ERROR(store(ip->a));
+    XLS_RETURN_IF_ERROR(load(ip->b));
+    ++ip;
+    DISPATCH();
+  }
+  TARGET(kBinopLoad) {
+    XLS_RET_CHECK(!stack_.empty());
+    XLS_ASSIGN_OR_RETURN(const InterpValue* rhs, slot(ip->a));
+    XLS_ASSIGN_OR_RETURN(stack_.back(), ip->binop(stack_.back(), *rhs));
+    ++ip;
+    DISPATCH();
+  }
+  TARGET(kBinopLiteral) {
+    XLS_RET_CHECK(!stack_.empty());
+    XLS_ASSIGN_OR_RETURN(stack_.back(),
+                         ip->binop(stack_.back(), *ip->literal));
+    ++ip;
+    DISPATCH();
+  }
+  TARGET(kLoadBinopLoad) {
+    XLS_ASSIGN_OR_RETURN(const InterpValue* lhs, slot(ip->a));
+    XLS_ASSIGN_OR_RETURN(const InterpValue* rhs, slot(ip->b));
+    XLS_ASSIGN_OR_RETURN(InterpValue result, ip->binop(*lhs, *rhs));
+    stack_.push_back(std::move(result));
+    ++ip;
+    DISPATCH();
+  }
+  TARGET(kLoadBinopLiteral) {
+    XLS_ASSIGN_OR_RETURN(const InterpValue* lhs, slot(ip->a));
+    XLS_ASSIGN_OR_RETURN(InterpValue result, ip->binop(*lhs, *ip->literal));
+    stack_.push_back(std::move(result));
+    ++ip;
+    DISPATCH();
+  }
+  TARGET(kEnd) {
+    frame->set_pc(lowered.source()->bytecodes().size());
+    return absl::OkStatus();
   }
 
-  return absl::OkStatus();
+#if !XLS_DSLX_COMPUTED_GOTO
+  }
+  return absl::InternalError("Invalid lowered bytecode op.");
+#endif
+#undef DISPATCH
+#undef TARGET
 }
 
+#undef XLS_DSLX_COMPUTED_GOTO
+
 absl::Status BytecodeInterpreter::EvalNextInstruction() {
   Frame* frame = &frames_.back();
   const std::vector<Bytecode>& bytecodes = frame->bf()->bytecodes();
@@ -132,6 +361,10 @@ absl::Status BytecodeInterpreter::EvalNextInstruction() {
       XLS_RETURN_IF_ERROR(EvalCast(bytecode));
       break;
     }
+    case Bytecode::Op::kChannel: {
+      XLS_RETURN_IF_ERROR(EvalChannel(bytecode));
+      break;
+    }
     case Bytecode::Op::kConcat: {
       XLS_RETURN_IF_ERROR(EvalConcat(bytecode));
       break;
@@ -246,6 +479,10 @@ absl::Status BytecodeInterpreter::EvalNextInstruction() {
     }
     case Bytecode::Op::kRecv: {
       XLS_RETURN_IF_ERROR(EvalRecv(bytecode));
+      if (blocked_) {
+        // Stay at the recv so that it's retried when resumed.
+        return absl::OkStatus();
+      }
       break;
     }
     case Bytecode::Op::kSend: {
@@ -264,6 +501,10 @@ absl::Status BytecodeInterpreter::EvalNextInstruction() {
       XLS_RETURN_IF_ERROR(EvalSlice(bytecode));
       break;
     }
+    case Bytecode::Op::kSpawn: {
+      XLS_RETURN_IF_ERROR(EvalSpawn(bytecode));
+      break;
+    }
     case Bytecode::Op::kStore: {
       XLS_RETURN_IF_ERROR(EvalStore(bytecode));
       break;
@@ -312,9 +553,10 @@ absl::Status BytecodeInterpreter::EvalUnop(
   return absl::OkStatus();
 }
 
-absl::Status BytecodeInterpreter::EvalBinop(
-    const std::function<absl::StatusOr<InterpValue>(
-        const InterpValue& lhs, const InterpValue& rhs)>& op) {
+absl::Status BytecodeInterpreter::EvalBinop(const Bytecode& bytecode) {
+  LoweredBytecodeFunction::BinopFn op =
+      LoweredBytecodeFunction::GetBinop(bytecode.op());
+  XLS_RET_CHECK(op != nullptr) << bytecode.ToString();
   XLS_RET_CHECK_GE(stack_.size(), 2);
   XLS_ASSIGN_OR_RETURN(InterpValue rhs, Pop());
   XLS_ASSIGN_OR_RETURN(InterpValue lhs, Pop());
@@ -324,45 +566,49 @@ absl::Status BytecodeInterpreter::EvalBinop(
 }
 
 absl::Status BytecodeInterpreter::EvalAdd(const Bytecode& bytecode) {
-  return EvalBinop([](const InterpValue& lhs, const InterpValue& rhs) {
-    return lhs.Add(rhs);
-  });
+  return EvalBinop(bytecode);
 }
 
 absl::Status BytecodeInterpreter::EvalAnd(const Bytecode& bytecode) {
-  return EvalBinop([](const InterpValue& lhs, const InterpValue& rhs) {
-    return lhs.BitwiseAnd(rhs);
-  });
+  return EvalBinop(bytecode);
 }
 
-absl::StatusOr<BytecodeFunction*> BytecodeInterpreter::GetBytecodeFn(
-    Function* f, Invocation* invocation,
-    const absl::optional<SymbolicBindings>& caller_bindings) {
-  const Frame& frame = frames_.back();
-  const TypeInfo* type_info = frame.type_info();
-
-  BytecodeCacheInterface* cache = import_data_->bytecode_cache();
-  if (cache == nullptr) {
-    return absl::InvalidArgumentError("Bytecode cache is NULL.");
-  }
-
+/* static */ absl::StatusOr<const TypeInfo*>
+BytecodeInterpreter::GetInvocationTypeInfo(
+    ImportData* import_data, const TypeInfo* caller_type_info, Function* f,
+    Invocation* invocation, const absl::optional<SymbolicBindings>& bindings) {
   if (f->IsParametric()) {
-    XLS_RET_CHECK(caller_bindings.has_value());
+    XLS_RET_CHECK(bindings.has_value());
     absl::optional<TypeInfo*> maybe_type_info =
-        type_info->GetInstantiationTypeInfo(invocation,
-                                            caller_bindings.value());
+        caller_type_info->GetInstantiationTypeInfo(invocation,
+                                                   bindings.value());
     if (!maybe_type_info.has_value()) {
       return absl::InternalError(absl::StrCat(
           "Could not find type info for invocation ", invocation->ToString(),
           " : ", invocation->span().ToString()));
     }
-    type_info = maybe_type_info.value();
-  } else if (f->owner() != type_info->module()) {
+    return maybe_type_info.value();
+  }
+  if (f->owner() != caller_type_info->module()) {
     // If the new function is in a different module and it's NOT parametric,
     // then we need the root TypeInfo for the new module.
-    XLS_ASSIGN_OR_RETURN(type_info, import_data_->GetRootTypeInfo(f->owner()));
+    return import_data->GetRootTypeInfo(f->owner());
+  }
+  return caller_type_info;
+}
+
+absl::StatusOr<BytecodeFunction*> BytecodeInterpreter::GetBytecodeFn(
+    Function* f, Invocation* invocation,
+    const absl::optional<SymbolicBindings>& caller_bindings) {
+  BytecodeCacheInterface* cache = import_data_->bytecode_cache();
+  if (cache == nullptr) {
+    return absl::InvalidArgumentError("Bytecode cache is NULL.");
   }
 
+  XLS_ASSIGN_OR_RETURN(
+      const TypeInfo* type_info,
+      GetInvocationTypeInfo(import_data_, frames_.back().type_info(), f,
+                            invocation, caller_bindings));
   return cache->GetOrCreateBytecodeFunction(f, type_info, caller_bindings);
 }
 
@@ -393,7 +639,7 @@ absl::Status BytecodeInterpreter::EvalCall(const Bytecode& bytecode) {
   std::vector<InterpValue> args(num_args, InterpValue::MakeToken());
   for (int i = 0; i < num_args; i++) {
     XLS_ASSIGN_OR_RETURN(InterpValue arg, Pop());
-    args[num_args - i - 1] = arg;
+    args[num_args - i - 1] = std::move(arg);
   }
 
   frames_.push_back(Frame(bf, std::move(args), bf->type_info(), data.bindings));
@@ -401,6 +647,14 @@ absl::Status BytecodeInterpreter::EvalCall(const Bytecode& bytecode) {
   return absl::OkStatus();
 }
 
+absl::Status BytecodeInterpreter::EvalChannel(const Bytecode& bytecode) {
+  // Both ends refer to the same queue; typechecking has already enforced the
+  // direction in which each end is used.
+  InterpValue channel = InterpValue::MakeChannel();
+  stack_.push_back(InterpValue::MakeTuple({channel, channel}));
+  return absl::OkStatus();
+}
+
 absl::Status BytecodeInterpreter::EvalCast(const Bytecode& bytecode) {
   if (!bytecode.data().has_value() ||
       !absl::holds_alternative<std::unique_ptr<ConcreteType>>(
@@ -424,7 +678,7 @@ absl::Status BytecodeInterpreter::EvalCast(const Bytecode& bytecode) {
           "Array types can only be cast to bits.");
     }
     XLS_ASSIGN_OR_RETURN(InterpValue converted, from.Flatten());
-    stack_.push_back(converted);
+    stack_.push_back(std::move(converted));
     return absl::OkStatus();
   }
 
@@ -456,14 +710,14 @@ absl::Status BytecodeInterpreter::EvalCast(const Bytecode& bytecode) {
           from_bit_count, to_bit_count));
     }
     XLS_ASSIGN_OR_RETURN(InterpValue casted, CastBitsToArray(from, *to_array));
-    stack_.push_back(casted);
+    stack_.push_back(std::move(casted));
     return absl::OkStatus();
   }
 
   // From bits to enum.
   if (EnumType* to_enum = dynamic_cast<EnumType*>(to); to_enum != nullptr) {
     XLS_ASSIGN_OR_RETURN(InterpValue converted, CastBitsToEnum(from, *to_enum));
-    stack_.push_back(converted);
+    stack_.push_back(std::move(converted));
     return absl::OkStatus();
   }
 
@@ -492,15 +746,13 @@ absl::Status BytecodeInterpreter::EvalCast(const Bytecode& bytecode) {
   }
   InterpValue result = InterpValue::MakeBits(to_bits->is_signed(), result_bits);
 
-  stack_.push_back(result);
+  stack_.push_back(std::move(result));
 
   return absl::OkStatus();
 }
 
 absl::Status BytecodeInterpreter::EvalConcat(const Bytecode& bytecode) {
-  return EvalBinop([](const InterpValue& lhs, const InterpValue& rhs) {
-    return lhs.Concat(rhs);
-  });
+  return EvalBinop(bytecode);
 }
 
 absl::Status BytecodeInterpreter::EvalCreateArray(const Bytecode& bytecode) {
@@ -512,12 +764,13 @@ absl::Status BytecodeInterpreter::EvalCreateArray(const Bytecode& bytecode) {
   elements.reserve(array_size.value());
   for (int64_t i = 0; i < array_size.value(); i++) {
     XLS_ASSIGN_OR_RETURN(InterpValue value, Pop());
-    elements.push_back(value);
+    elements.push_back(std::move(value));
   }
 
   std::reverse(elements.begin(), elements.end());
-  XLS_ASSIGN_OR_RETURN(InterpValue array, InterpValue::MakeArray(elements));
-  stack_.push_back(array);
+  XLS_ASSIGN_OR_RETURN(InterpValue array,
+                       InterpValue::MakeArray(std::move(elements)));
+  stack_.push_back(std::move(array));
   return absl::OkStatus();
 }
 
@@ -530,19 +783,17 @@ absl::Status BytecodeInterpreter::EvalCreateTuple(const Bytecode& bytecode) {
   elements.reserve(tuple_size.value());
   for (int64_t i = 0; i < tuple_size.value(); i++) {
     XLS_ASSIGN_OR_RETURN(InterpValue value, Pop());
-    elements.push_back(value);
+    elements.push_back(std::move(value));
   }
 
   std::reverse(elements.begin(), elements.end());
 
-  stack_.push_back(InterpValue::MakeTuple(elements));
+  stack_.push_back(InterpValue::MakeTuple(std::move(elements)));
   return absl::OkStatus();
 }
 
 absl::Status BytecodeInterpreter::EvalDiv(const Bytecode& bytecode) {
-  return EvalBinop([](const InterpValue& lhs, const InterpValue& rhs) {
-    return lhs.FloorDiv(rhs);
-  });
+  return EvalBinop(bytecode);
 }
 
 absl::Status BytecodeInterpreter::EvalDup(const Bytecode& bytecode) {
@@ -552,13 +803,11 @@ absl::Status BytecodeInterpreter::EvalDup(const Bytecode& bytecode) {
 }
 
 absl::Status BytecodeInterpreter::EvalEq(const Bytecode& bytecode) {
-  return EvalBinop([](const InterpValue& lhs, const InterpValue& rhs) {
-    return InterpValue::MakeBool(lhs.Eq(rhs));
-  });
+  return EvalBinop(bytecode);
 }
 
 absl::Status BytecodeInterpreter::EvalExpandTuple(const Bytecode& bytecode) {
-  InterpValue tuple = stack_.back();
+  InterpValue tuple = std::move(stack_.back());
   stack_.pop_back();
   if (!tuple.IsTuple()) {
     return FailureErrorStatus(
@@ -573,7 +822,7 @@ absl::Status BytecodeInterpreter::EvalExpandTuple(const Bytecode& bytecode) {
   for (int64_t i = tuple_size - 1; i >= 0; i--) {
     XLS_ASSIGN_OR_RETURN(InterpValue element,
                          tuple.Index(InterpValue::MakeUBits(64, i)));
-    stack_.push_back(element);
+    stack_.push_back(std::move(element));
   }
 
   return absl::OkStatus();
@@ -587,15 +836,11 @@ absl::Status BytecodeInterpreter::EvalFail(const Bytecode& bytecode) {
 }
 
 absl::Status BytecodeInterpreter::EvalGe(const Bytecode& bytecode) {
-  return EvalBinop([](const InterpValue& lhs, const InterpValue& rhs) {
-    return lhs.Ge(rhs);
-  });
+  return EvalBinop(bytecode);
 }
 
 absl::Status BytecodeInterpreter::EvalGt(const Bytecode& bytecode) {
-  return EvalBinop([](const InterpValue& lhs, const InterpValue& rhs) {
-    return lhs.Gt(rhs);
-  });
+  return EvalBinop(bytecode);
 }
 
 absl::Status BytecodeInterpreter::EvalIndex(const Bytecode& bytecode) {
@@ -620,14 +865,12 @@ absl::Status BytecodeInterpreter::EvalInvert(const Bytecode& bytecode) {
 }
 
 absl::Status BytecodeInterpreter::EvalLe(const Bytecode& bytecode) {
-  return EvalBinop([](const InterpValue& lhs, const InterpValue& rhs) {
-    return lhs.Le(rhs);
-  });
+  return EvalBinop(bytecode);
 }
 
 absl::Status BytecodeInterpreter::EvalLiteral(const Bytecode& bytecode) {
   XLS_ASSIGN_OR_RETURN(InterpValue value, bytecode.value_data());
-  stack_.push_back(value);
+  stack_.push_back(std::move(value));
   return absl::OkStatus();
 }
 
@@ -659,7 +902,7 @@ absl::Status BytecodeInterpreter::EvalLogicalAnd(const Bytecode& bytecode) {
   }
 
   XLS_ASSIGN_OR_RETURN(InterpValue result, lhs.BitwiseAnd(rhs));
-  stack_.push_back(result);
+  stack_.push_back(std::move(result));
   return absl::OkStatus();
 }
 
@@ -680,14 +923,12 @@ absl::Status BytecodeInterpreter::EvalLogicalOr(const Bytecode& bytecode) {
   }
 
   XLS_ASSIGN_OR_RETURN(InterpValue result, lhs.BitwiseOr(rhs));
-  stack_.push_back(result);
+  stack_.push_back(std::move(result));
   return absl::OkStatus();
 }
 
 absl::Status BytecodeInterpreter::EvalLt(const Bytecode& bytecode) {
-  return EvalBinop([](const InterpValue& lhs, const InterpValue& rhs) {
-    return lhs.Lt(rhs);
-  });
+  return EvalBinop(bytecode);
 }
 
 absl::StatusOr<bool> BytecodeInterpreter::MatchArmEqualsInterpValue(
@@ -754,28 +995,22 @@ absl::Status BytecodeInterpreter::EvalMatchArm(const Bytecode& bytecode) {
 }
 
 absl::Status BytecodeInterpreter::EvalMul(const Bytecode& bytecode) {
-  return EvalBinop([](const InterpValue& lhs, const InterpValue& rhs) {
-    return lhs.Mul(rhs);
-  });
+  return EvalBinop(bytecode);
 }
 
 absl::Status BytecodeInterpreter::EvalNe(const Bytecode& bytecode) {
-  return EvalBinop([](const InterpValue& lhs, const InterpValue& rhs) {
-    return InterpValue::MakeBool(lhs.Ne(rhs));
-  });
+  return EvalBinop(bytecode);
 }
 
 absl::Status BytecodeInterpreter::EvalNegate(const Bytecode& bytecode) {
   XLS_ASSIGN_OR_RETURN(InterpValue operand, Pop());
   XLS_ASSIGN_OR_RETURN(InterpValue result, operand.ArithmeticNegate());
-  stack_.push_back(result);
+  stack_.push_back(std::move(result));
   return absl::OkStatus();
 }
 
 absl::Status BytecodeInterpreter::EvalOr(const Bytecode& bytecode) {
-  return EvalBinop([](const InterpValue& lhs, const InterpValue& rhs) {
-    return lhs.BitwiseOr(rhs);
-  });
+  return EvalBinop(bytecode);
 }
 
 absl::Status BytecodeInterpreter::EvalPop(const Bytecode& bytecode) {
@@ -787,10 +1022,16 @@ absl::Status BytecodeInterpreter::EvalRecv(const Bytecode& bytecode) {
   XLS_ASSIGN_OR_RETURN(InterpValue channel_value, Pop());
   XLS_ASSIGN_OR_RETURN(auto channel, channel_value.GetChannel());
   if (channel->empty()) {
-    return absl::UnavailableError("Channel is empty.");
+    // Leave the stack as it was, so the recv can be retried.
+    stack_.push_back(std::move(channel_value));
+    blocked_ = true;
+    return absl::OkStatus();
   }
-  stack_.push_back(channel->front());
+  XLS_ASSIGN_OR_RETURN(InterpValue token, Pop());
+  stack_.push_back(
+      InterpValue::MakeTuple({std::move(token), std::move(channel->front())}));
   channel->pop_front();
+  ++channel_ops_;
   return absl::OkStatus();
 }
 
@@ -798,23 +1039,56 @@ absl::Status BytecodeInterpreter::EvalSend(const Bytecode& bytecode) {
   XLS_ASSIGN_OR_RETURN(InterpValue payload, Pop());
   XLS_ASSIGN_OR_RETURN(InterpValue channel_value, Pop());
   XLS_ASSIGN_OR_RETURN(auto channel, channel_value.GetChannel());
-  channel->push_back(payload);
+  channel->push_back(std::move(payload));
+  ++channel_ops_;
   return absl::OkStatus();
 }
 
+absl::Status BytecodeInterpreter::EvalSpawn(const Bytecode& bytecode) {
+  XLS_ASSIGN_OR_RETURN(const Bytecode::SpawnData* spawn_data,
+                       bytecode.spawn_data());
+  if (proc_instances_ == nullptr) {
+    return absl::FailedPreconditionError(absl::StrCat(
+        "Procs can only be spawned while instantiating a proc network: ",
+        bytecode.source_span().ToString()));
+  }
+
+  Spawn* spawn = spawn_data->spawn;
+  auto pop_args = [this](int64_t count)
+      -> absl::StatusOr<std::vector<InterpValue>> {
+    std::vector<InterpValue> args(count, InterpValue::MakeToken());
+    for (int64_t i = count - 1; i >= 0; --i) {
+      XLS_ASSIGN_OR_RETURN(args[i], Pop());
+    }
+    return args;
+  };
+  XLS_ASSIGN_OR_RETURN(std::vector<InterpValue> initial_state,
+                       pop_args(spawn->next()->args().size()));
+  XLS_ASSIGN_OR_RETURN(std::vector<InterpValue> config_args,
+                       pop_args(spawn->config()->args().size()));
+
+  Proc* proc = spawn_data->proc;
+  const TypeInfo* type_info = frames_.back().type_info();
+  XLS_ASSIGN_OR_RETURN(
+      const TypeInfo* config_type_info,
+      GetInvocationTypeInfo(import_data_, type_info, proc->config(),
+                            spawn->config(), spawn_data->config_bindings));
+  XLS_ASSIGN_OR_RETURN(
+      const TypeInfo* next_type_info,
+      GetInvocationTypeInfo(import_data_, type_info, proc->next(),
+                            spawn->next(), spawn_data->next_bindings));
+  return SpawnProc(import_data_, proc, config_type_info,
+                   spawn_data->config_bindings, next_type_info,
+                   spawn_data->next_bindings, std::move(config_args),
+                   std::move(initial_state), proc_instances_);
+}
+
 absl::Status BytecodeInterpreter::EvalShl(const Bytecode& bytecode) {
-  return EvalBinop([](const InterpValue& lhs, const InterpValue& rhs) {
-    return lhs.Shl(rhs);
-  });
+  return EvalBinop(bytecode);
 }
 
 absl::Status BytecodeInterpreter::EvalShr(const Bytecode& bytecode) {
-  return EvalBinop([](const InterpValue& lhs, const InterpValue& rhs) {
-    if (lhs.IsSigned()) {
-      return lhs.Shra(rhs);
-    }
-    return lhs.Shrl(rhs);
-  });
+  return EvalBinop(bytecode);
 }
 
 absl::Status BytecodeInterpreter::EvalSlice(const Bytecode& bytecode) {
@@ -867,7 +1141,7 @@ absl::Status BytecodeInterpreter::EvalSlice(const Bytecode& bytecode) {
   start = InterpValue::MakeBits(/*is_signed=*/false, start.GetBitsOrDie());
   length = InterpValue::MakeBits(/*is_signed=*/false, length.GetBitsOrDie());
   XLS_ASSIGN_OR_RETURN(InterpValue result, basis.Slice(start, length));
-  stack_.push_back(result);
+  stack_.push_back(std::move(result));
   return absl::OkStatus();
 }
 
@@ -879,7 +1153,7 @@ absl::Status BytecodeInterpreter::EvalStore(const Bytecode& bytecode) {
   }
 
   XLS_ASSIGN_OR_RETURN(InterpValue value, Pop());
-  frames_.back().StoreSlot(slot, value);
+  frames_.back().StoreSlot(slot, std::move(value));
   return absl::OkStatus();
 }
 
@@ -895,17 +1169,12 @@ absl::StatusOr<std::optional<int64_t>> BytecodeInterpreter::EvalJumpRelIf(
 }
 
 absl::Status BytecodeInterpreter::EvalSub(const Bytecode& bytecode) {
-  return EvalBinop([](const InterpValue& lhs, const InterpValue& rhs) {
-    return lhs.Sub(rhs);
-  });
+  return EvalBinop(bytecode);
 }
 
 absl::Status BytecodeInterpreter::EvalSwap(const Bytecode& bytecode) {
   XLS_RET_CHECK_GE(stack_.size(), 2);
-  XLS_ASSIGN_OR_RETURN(InterpValue tos0, Pop());
-  XLS_ASSIGN_OR_RETURN(InterpValue tos1, Pop());
-  stack_.push_back(tos0);
-  stack_.push_back(tos1);
+  std::swap(stack_[stack_.size() - 1], stack_[stack_.size() - 2]);
   return absl::OkStatus();
 }
 
@@ -956,7 +1225,7 @@ absl::Status BytecodeInterpreter::EvalWidthSlice(const Bytecode& bytecode) {
   InterpValue oob_value(InterpValue::MakeUBits(width_value, /*value=*/0));
   XLS_ASSIGN_OR_RETURN(InterpValue start, Pop());
   if (!start.FitsInUint64()) {
-    stack_.push_back(oob_value);
+    stack_.push_back(std::move(oob_value));
     return absl::OkStatus();
   }
   XLS_ASSIGN_OR_RETURN(uint64_t start_index, start.GetBitValueUint64());
@@ -967,7 +1236,7 @@ absl::Status BytecodeInterpreter::EvalWidthSlice(const Bytecode& bytecode) {
   InterpValue width = InterpValue::MakeUBits(64, width_value);
 
   if (start_index >= basis_width) {
-    stack_.push_back(oob_value);
+    stack_.push_back(std::move(oob_value));
     return absl::OkStatus();
   }
 
@@ -980,14 +1249,12 @@ absl::Status BytecodeInterpreter::EvalWidthSlice(const Bytecode& bytecode) {
       bits_type->is_signed() ? InterpValueTag::kSBits : InterpValueTag::kUBits;
   XLS_ASSIGN_OR_RETURN(InterpValue result,
                        InterpValue::MakeBits(tag, result_bits));
-  stack_.push_back(result);
+  stack_.push_back(std::move(result));
   return absl::OkStatus();
 }
 
 absl::Status BytecodeInterpreter::EvalXor(const Bytecode& bytecode) {
-  return EvalBinop([](const InterpValue& lhs, const InterpValue& rhs) {
-    return lhs.BitwiseXor(rhs);
-  });
+  return EvalBinop(bytecode);
 }
 
 absl::Status BytecodeInterpreter::RunBuiltinFn(const Bytecode& bytecode,
@@ -1057,7 +1324,7 @@ absl::Status BytecodeInterpreter::RunBuiltinAddWithCarry(
   XLS_ASSIGN_OR_RETURN(InterpValue lhs, Pop());
   XLS_ASSIGN_OR_RETURN(InterpValue rhs, Pop());
   XLS_ASSIGN_OR_RETURN(InterpValue result, lhs.AddWithCarry(rhs));
-  stack_.push_back(result);
+  stack_.push_back(std::move(result));
   return absl::OkStatus();
 }
 
@@ -1201,8 +1468,9 @@ absl::Status BytecodeInterpreter::RunBuiltinEnumerate(
     elements.push_back(
         InterpValue::MakeTuple({InterpValue::MakeU32(i), values->at(i)}));
   }
-  XLS_ASSIGN_OR_RETURN(InterpValue result, InterpValue::MakeArray(elements));
-  stack_.push_back(result);
+  XLS_ASSIGN_OR_RETURN(InterpValue result,
+                       InterpValue::MakeArray(std::move(elements)));
+  stack_.push_back(std::move(result));
   return absl::OkStatus();
 }
 
@@ -1356,7 +1624,7 @@ absl::Status BytecodeInterpreter::RunBuiltinRange(const Bytecode& bytecode) {
           XLS_ASSIGN_OR_RETURN(cur, cur.Add(one));
           XLS_ASSIGN_OR_RETURN(done, cur.Ge(end));
         }
-        return InterpValue::MakeArray(elements);
+        return InterpValue::MakeArray(std::move(elements));
       });
 }
 
@@ -1426,7 +1694,7 @@ absl::Status BytecodeInterpreter::RunBinaryBuiltin(
   XLS_ASSIGN_OR_RETURN(InterpValue b, Pop());
   XLS_ASSIGN_OR_RETURN(InterpValue a, Pop());
   XLS_ASSIGN_OR_RETURN(InterpValue result, fn(a, b));
-  stack_.push_back(result);
+  stack_.push_back(std::move(result));
   return absl::OkStatus();
 }
 
@@ -1439,8 +1707,143 @@ absl::Status BytecodeInterpreter::RunTernaryBuiltin(
   XLS_ASSIGN_OR_RETURN(InterpValue b, Pop());
   XLS_ASSIGN_OR_RETURN(InterpValue a, Pop());
   XLS_ASSIGN_OR_RETURN(InterpValue result, fn(a, b, c));
-  stack_.push_back(result);
+  stack_.push_back(std::move(result));
+  return absl::OkStatus();
+}
+
+/* static */ absl::Status BytecodeInterpreter::SpawnProc(
+    ImportData* import_data, Proc* proc, const TypeInfo* config_type_info,
+    const absl::optional<SymbolicBindings>& config_bindings,
+    const TypeInfo* next_type_info,
+    const absl::optional<SymbolicBindings>& next_bindings,
+    std::vector<InterpValue> config_args,
+    std::vector<InterpValue> initial_state,
+    std::vector<ProcInstance>* proc_instances) {
+  // Reserve the parent's position before running its config, so that the
+  // parent precedes any procs spawned there.
+  int64_t index = proc_instances->size();
+
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<BytecodeFunction> config_fn,
+                       BytecodeEmitter::Emit(import_data, config_type_info,
+                                             proc->config(), config_bindings));
+  BytecodeInterpreter config_interpreter(
+      import_data, config_fn.get(), std::move(config_args),
+      Dispatch::kLowered, config_type_info, config_bindings);
+  config_interpreter.proc_instances_ = proc_instances;
+  XLS_RETURN_IF_ERROR(config_interpreter.Run());
+  if (config_interpreter.blocked_) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Config function of proc ", proc->identifier(),
+                     " blocked on a receive."));
+  }
+  XLS_ASSIGN_OR_RETURN(const std::vector<InterpValue>* members,
+                       config_interpreter.stack_.back().GetValues());
+
+  std::vector<NameDef*> member_defs;
+  member_defs.reserve(proc->members().size());
+  for (const Param* member : proc->members()) {
+    member_defs.push_back(member->name_def());
+  }
+  XLS_ASSIGN_OR_RETURN(
+      std::unique_ptr<BytecodeFunction> next_fn,
+      BytecodeEmitter::EmitProcNext(import_data, next_type_info, proc->next(),
+                                    next_bindings, member_defs));
+  proc_instances->insert(
+      proc_instances->begin() + index,
+      ProcInstance(import_data, proc, std::move(next_fn), next_bindings,
+                   *members, std::move(initial_state)));
+  return absl::OkStatus();
+}
+
+/* static */ absl::Status BytecodeInterpreter::InitializeProcNetwork(
+    ImportData* import_data, const TypeInfo* type_info, TestProc* test_proc,
+    InterpValue terminator, std::vector<ProcInstance>* proc_instances) {
+  std::vector<InterpValue> initial_state;
+  for (Expr* arg : test_proc->next_args()) {
+    XLS_ASSIGN_OR_RETURN(
+        std::unique_ptr<BytecodeFunction> bf,
+        BytecodeEmitter::EmitExpression(import_data, type_info, arg, /*env=*/{},
+                                        /*caller_bindings=*/absl::nullopt));
+    XLS_ASSIGN_OR_RETURN(InterpValue value,
+                         Interpret(import_data, bf.get(), /*args=*/{}));
+    initial_state.push_back(std::move(value));
+  }
+
+  return SpawnProc(import_data, test_proc->proc(), type_info,
+                   /*config_bindings=*/absl::nullopt, type_info,
+                   /*next_bindings=*/absl::nullopt, {std::move(terminator)},
+                   std::move(initial_state), proc_instances);
+}
+
+/* static */ absl::Status BytecodeInterpreter::RunTestProc(
+    ImportData* import_data, const TypeInfo* type_info, TestProc* test_proc) {
+  InterpValue terminator = InterpValue::MakeChannel();
+  XLS_ASSIGN_OR_RETURN(std::shared_ptr<InterpValue::Channel> channel,
+                       terminator.GetChannel());
+  std::vector<ProcInstance> proc_instances;
+  XLS_RETURN_IF_ERROR(InitializeProcNetwork(import_data, type_info, test_proc,
+                                            terminator, &proc_instances));
+
+  while (channel->empty()) {
+    bool progress_made = false;
+    for (ProcInstance& instance : proc_instances) {
+      XLS_ASSIGN_OR_RETURN(ProcRunResult result, instance.Run());
+      progress_made |= result.progress_made;
+    }
+    if (!progress_made && channel->empty()) {
+      return FailureErrorStatus(
+          test_proc->proc()->span(),
+          "Proc network is deadlocked: no proc can make progress.");
+    }
+  }
+
+  if (!channel->front().IsTrue()) {
+    return FailureErrorStatus(test_proc->proc()->next()->span(),
+                              "Terminator returned false/failure.");
+  }
   return absl::OkStatus();
 }
 
+ProcInstance::ProcInstance(ImportData* import_data, Proc* proc,
+                           std::unique_ptr<BytecodeFunction> next_fn,
+                           absl::optional<SymbolicBindings> next_bindings,
+                           std::vector<InterpValue> members,
+                           std::vector<InterpValue> state)
+    : import_data_(import_data),
+      proc_(proc),
+      next_fn_(std::move(next_fn)),
+      next_bindings_(std::move(next_bindings)),
+      members_(std::move(members)),
+      state_(std::move(state)) {}
+
+absl::StatusOr<ProcRunResult> ProcInstance::Run() {
+  if (interpreter_ == nullptr) {
+    std::vector<InterpValue> args = members_;
+    args.push_back(InterpValue::MakeToken());
+    args.insert(args.end(), state_.begin(), state_.end());
+    interpreter_ = absl::WrapUnique(new BytecodeInterpreter(
+        import_data_, next_fn_.get(), std::move(args),
+        BytecodeInterpreter::Dispatch::kLowered, next_fn_->type_info(),
+        next_bindings_));
+  }
+
+  int64_t channel_ops = interpreter_->channel_ops_;
+  XLS_RETURN_IF_ERROR(interpreter_->Run());
+  if (interpreter_->blocked_) {
+    // A blocked activation can only affect other procs through its channels;
+    // it may well block at the same recv again after getting through a loop
+    // iteration that received and sent values.
+    return ProcRunResult{
+        /*completed=*/false,
+        /*progress_made=*/interpreter_->channel_ops_ != channel_ops};
+  }
+
+  // The next function returns the new state as a tuple.
+  XLS_ASSIGN_OR_RETURN(const std::vector<InterpValue>* new_state,
+                       interpreter_->stack_.back().GetValues());
+  state_ = *new_state;
+  interpreter_.reset();
+  return ProcRunResult{/*completed=*/true, /*progress_made=*/true};
+}
+
 }  // namespace xls::dslx
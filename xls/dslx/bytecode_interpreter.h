@@ -14,15 +14,21 @@
 #ifndef XLS_DSLX_BYTECODE_INTERPRETER_H_
 #define XLS_DSLX_BYTECODE_INTERPRETER_H_
 
+#include <memory>
+#include <vector>
+
 #include "xls/common/status/ret_check.h"
 #include "xls/dslx/ast.h"
 #include "xls/dslx/builtins.h"
 #include "xls/dslx/bytecode.h"
 #include "xls/dslx/import_data.h"
+#include "xls/dslx/lowered_bytecode.h"
 #include "xls/dslx/symbolic_bindings.h"
 
 namespace xls::dslx {
 
+class ProcInstance;
+
 // Bytecode interpreter for DSLX. Accepts sequence of "bytecode" "instructions"
 // and a set of initial environmental bindings (key/value pairs) and executes
 // until end result.
@@ -30,14 +36,43 @@ namespace xls::dslx {
 // TODO(rspringer): Finish adding the rest of the opcodes, etc.
 class BytecodeInterpreter {
  public:
+  // Selects how instructions are dispatched.
+  enum class Dispatch {
+    // Functions are executed in their lowered form (see lowered_bytecode.h)
+    // with threaded dispatch, falling back to kBytecode for functions which
+    // can't be lowered. Per-Bytecode logging at --v=2 also uses kBytecode.
+    kLowered,
+    // Bytecodes are executed one at a time by switching on their op. This is
+    // the reference implementation.
+    kBytecode,
+  };
+
   // Takes ownership of `args`.
-  static absl::StatusOr<InterpValue> Interpret(ImportData* import_data,
-                                               BytecodeFunction* bf,
-                                               std::vector<InterpValue> args);
+  static absl::StatusOr<InterpValue> Interpret(
+      ImportData* import_data, BytecodeFunction* bf,
+      std::vector<InterpValue> args, Dispatch dispatch = Dispatch::kLowered);
+
+  // Instantiates the network of procs rooted at `test_proc`: runs the config
+  // function of the test proc (with `terminator` as its sole argument) and of
+  // every proc it transitively spawns, appending an instance of each to
+  // `proc_instances` in spawn order, with the test proc first.
+  static absl::Status InitializeProcNetwork(
+      ImportData* import_data, const TypeInfo* type_info, TestProc* test_proc,
+      InterpValue terminator, std::vector<ProcInstance>* proc_instances);
+
+  // Runs the test proc `test_proc` to completion: ticks every proc in its
+  // network in turn until the test proc sends a value on its terminator
+  // channel, which is the result of the test. Returns an error if the network
+  // deadlocks, i.e., no proc can make progress.
+  static absl::Status RunTestProc(ImportData* import_data,
+                                  const TypeInfo* type_info,
+                                  TestProc* test_proc);
 
   const std::vector<InterpValue>& stack() { return stack_; }
 
  private:
+  friend class ProcInstance;
+
   // Represents a frame on the function stack: holds the program counter, local
   // storage, and instructions to execute.
   class Frame {
@@ -73,11 +108,33 @@ class BytecodeInterpreter {
     std::unique_ptr<BytecodeFunction> bf_holder_;
   };
 
-  BytecodeInterpreter(ImportData* import_data, BytecodeFunction* bf,
-                      std::vector<InterpValue> args);
+  // If `type_info` is null, the root type info of `bf`'s module is used.
+  BytecodeInterpreter(
+      ImportData* import_data, BytecodeFunction* bf,
+      std::vector<InterpValue> args, Dispatch dispatch,
+      const TypeInfo* type_info = nullptr,
+      const absl::optional<SymbolicBindings>& bindings = absl::nullopt);
+
+  // Runs the config function of `proc` on `config_args` and adds an instance of
+  // `proc` with the resulting members and the given initial state to
+  // `proc_instances`, ahead of the procs its config spawns. The type infos and
+  // bindings are those of the config and next functions of this instance.
+  static absl::Status SpawnProc(
+      ImportData* import_data, Proc* proc, const TypeInfo* config_type_info,
+      const absl::optional<SymbolicBindings>& config_bindings,
+      const TypeInfo* next_type_info,
+      const absl::optional<SymbolicBindings>& next_bindings,
+      std::vector<InterpValue> config_args,
+      std::vector<InterpValue> initial_state,
+      std::vector<ProcInstance>* proc_instances);
 
   absl::Status Run();
 
+  // Executes the top frame until it reaches the end of its function or calls
+  // another function (i.e., pushes a new frame).
+  absl::Status RunBytecodes();
+  absl::Status RunLowered(const LoweredBytecodeFunction& lowered);
+
   // Runs the next instruction in the current frame. Returns an error if called
   // when the PC is already pointing to the end of the bytecode.
   absl::Status EvalNextInstruction();
@@ -86,6 +143,7 @@ class BytecodeInterpreter {
   absl::Status EvalAnd(const Bytecode& bytecode);
   absl::Status EvalCall(const Bytecode& bytecode);
   absl::Status EvalCast(const Bytecode& bytecode);
+  absl::Status EvalChannel(const Bytecode& bytecode);
   absl::Status EvalConcat(const Bytecode& bytecode);
   absl::Status EvalCreateArray(const Bytecode& bytecode);
   absl::Status EvalCreateTuple(const Bytecode& bytecode);
@@ -115,6 +173,7 @@ class BytecodeInterpreter {
   absl::Status EvalShl(const Bytecode& bytecode);
   absl::Status EvalShr(const Bytecode& bytecode);
   absl::Status EvalSlice(const Bytecode& bytecode);
+  absl::Status EvalSpawn(const Bytecode& bytecode);
   absl::Status EvalStore(const Bytecode& bytecode);
   absl::Status EvalSub(const Bytecode& bytecode);
   absl::Status EvalSwap(const Bytecode& bytecode);
@@ -125,9 +184,14 @@ class BytecodeInterpreter {
   absl::Status EvalUnop(
       const std::function<absl::StatusOr<InterpValue>(const InterpValue& arg)>&
           op);
-  absl::Status EvalBinop(
-      const std::function<absl::StatusOr<InterpValue>(
-          const InterpValue& lhs, const InterpValue& rhs)>& op);
+  // Evaluates a binary op using its implementation shared with the lowered
+  // form (see LoweredBytecodeFunction::GetBinop).
+  absl::Status EvalBinop(const Bytecode& bytecode);
+  // Returns the type info for running `f` when invoked via `invocation` with
+  // callee `bindings` from a function whose type info is `caller_type_info`.
+  static absl::StatusOr<const TypeInfo*> GetInvocationTypeInfo(
+      ImportData* import_data, const TypeInfo* caller_type_info, Function* f,
+      Invocation* invocation, const absl::optional<SymbolicBindings>& bindings);
   absl::StatusOr<BytecodeFunction*> GetBytecodeFn(
       Function* function, Invocation* invocation,
       const absl::optional<SymbolicBindings>& caller_bindings);
@@ -174,9 +238,63 @@ class BytecodeInterpreter {
   absl::StatusOr<InterpValue> Pop();
 
   ImportData* import_data_;
+  Dispatch dispatch_;
   std::vector<InterpValue> stack_;
 
   std::vector<Frame> frames_;
+
+  // Set when a recv finds its channel empty: Run() then returns with the
+  // frames and stack intact and the PC at the recv, so that it can be resumed
+  // (see ProcInstance).
+  bool blocked_ = false;
+
+  // The number of values sent or received so far; used to tell whether a
+  // resumed proc activation made progress.
+  int64_t channel_ops_ = 0;
+
+  // The network that procs spawned by the running function are added to; only
+  // set while running proc config functions.
+  std::vector<ProcInstance>* proc_instances_ = nullptr;
+};
+
+// Reports what a call to ProcInstance::Run() accomplished.
+struct ProcRunResult {
+  // True if the activation ran to completion; false if it blocked on a recv
+  // from an empty channel.
+  bool completed;
+  // True if the run could have unblocked another proc: the activation
+  // completed (updating the state) or sent or received a value.
+  bool progress_made;
+};
+
+// A proc in a network being run by the bytecode interpreter: its next function,
+// the member values produced by its config function, and its recurrent state.
+class ProcInstance {
+ public:
+  ProcInstance(ImportData* import_data, Proc* proc,
+               std::unique_ptr<BytecodeFunction> next_fn,
+               absl::optional<SymbolicBindings> next_bindings,
+               std::vector<InterpValue> members,
+               std::vector<InterpValue> state);
+
+  // Runs an activation of the next function, resuming the previous one if that
+  // blocked. When the activation completes, the state is updated with its
+  // result.
+  absl::StatusOr<ProcRunResult> Run();
+
+  Proc* proc() const { return proc_; }
+  const std::vector<InterpValue>& state() const { return state_; }
+
+ private:
+  ImportData* import_data_;
+  Proc* proc_;
+  std::unique_ptr<BytecodeFunction> next_fn_;
+  absl::optional<SymbolicBindings> next_bindings_;
+  std::vector<InterpValue> members_;
+  std::vector<InterpValue> state_;
+
+  // The activation in progress, if the previous Run() blocked.
+  std::unique_ptr<BytecodeInterpreter> interpreter_;
 };
 
 }  // namespace xls::dslx
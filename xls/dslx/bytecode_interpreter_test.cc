@@ -27,6 +27,7 @@
 namespace xls::dslx {
 namespace {
 
+using status_testing::IsOkAndHolds;
 using status_testing::StatusIs;
 using testing::HasSubstr;
 
@@ -1187,5 +1188,291 @@ fn main(p: bool, x: u32) -> u32 {
   EXPECT_EQ(int_value, 0x0);
 }
 
+// Runs a program with calls, loops, conditionals and builtins with both
+// dispatch modes; the lowered form fuses many of its bytecodes.
+TEST(BytecodeInterpreterTest, LoweredDispatchMatchesBytecodeDispatch) {
+  constexpr absl::string_view kProgram = R"(
+fn square(x: u32) -> u32 { x * x }
+
+fn main(n: u32) -> u32 {
+  let a = for (i, acc): (u32, u32) in range(u32:0, u32:8) {
+    let t = if i < n { square(i) } else { i + u32:1 };
+    acc + (t ^ i)
+  }(u32:0);
+  let b = map(u32[3]:[1, 2, 3], square);
+  match a {
+    u32:0 => b[0],
+    _ => a + b[1] + b[2],
+  }
+}
+)";
+
+  auto import_data = CreateImportDataForTest();
+  XLS_ASSERT_OK_AND_ASSIGN(
+      TypecheckedModule tm,
+      ParseAndTypecheck(kProgram, "test.x", "test", &import_data));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, tm.module->GetFunctionOrError("main"));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<BytecodeFunction> bf,
+      BytecodeEmitter::Emit(&import_data, tm.type_info, f, SymbolicBindings()));
+  ASSERT_NE(bf->lowered(), nullptr);
+
+  for (uint32_t n = 0; n < 10; ++n) {
+    uint32_t a = 0;
+    for (uint32_t i = 0; i < 8; ++i) {
+      a += (i < n ? i * i : i + 1) ^ i;
+    }
+    uint32_t expected = a == 0 ? 1 : a + 4 + 9;
+    for (BytecodeInterpreter::Dispatch dispatch :
+         {BytecodeInterpreter::Dispatch::kLowered,
+          BytecodeInterpreter::Dispatch::kBytecode}) {
+      EXPECT_THAT(BytecodeInterpreter::Interpret(
+                      &import_data, bf.get(), {InterpValue::MakeU32(n)},
+                      dispatch),
+                  IsOkAndHolds(InterpValue::MakeU32(expected)));
+    }
+  }
+}
+
+absl::Status RunTestProc(ImportData* import_data, absl::string_view program,
+                         absl::string_view test_name) {
+  XLS_ASSIGN_OR_RETURN(
+      TypecheckedModule tm,
+      ParseAndTypecheck(program, "test.x", "test", import_data));
+  XLS_ASSIGN_OR_RETURN(TestProc * tp, tm.module->GetTestProc(test_name));
+  return BytecodeInterpreter::RunTestProc(import_data, tm.type_info, tp);
+}
+
+// The child only sees a value once the parent has sent it, so the child's
+// activations block on the recv until the parent runs.
+constexpr absl::string_view kProcNetworkProgram = R"(
+proc doubler {
+  input: chan in u32;
+  output: chan out u32;
+
+  config(input: chan in u32, output: chan out u32) {
+    (input, output)
+  }
+
+  next(tok: token) {
+    let (tok, x) = recv(tok, input);
+    let tok = send(tok, output, x * u32:2);
+    ()
+  }
+}
+
+#![test_proc(u32:0)]
+proc tester {
+  terminator: chan out bool;
+  to_child: chan out u32;
+  from_child: chan in u32;
+
+  config(terminator: chan out bool) {
+    let (to_child, child_input) = chan u32;
+    let (child_output, from_child) = chan u32;
+    spawn doubler(child_input, child_output)();
+    (terminator, to_child, from_child)
+  }
+
+  next(tok: token, i: u32) {
+    let tok = send(tok, to_child, i);
+    let (tok, doubled) = recv(tok, from_child);
+    let _ = assert_eq(doubled, i * u32:2);
+    let tok = send_if(tok, terminator, i == u32:3, doubled == u32:6);
+    (i + u32:1,)
+  }
+}
+)";
+
+TEST(BytecodeInterpreterTest, ProcNetwork) {
+  auto import_data = CreateImportDataForTest();
+  XLS_EXPECT_OK(RunTestProc(&import_data, kProcNetworkProgram, "tester"));
+}
+
+TEST(BytecodeInterpreterTest, ProcNetworkFailure) {
+  constexpr absl::string_view kProgram = R"(
+#![test_proc()]
+proc tester {
+  terminator: chan out bool;
+
+  config(terminator: chan out bool) {
+    (terminator,)
+  }
+
+  next(tok: token) {
+    let tok = send(tok, terminator, false);
+    ()
+  }
+}
+)";
+  auto import_data = CreateImportDataForTest();
+  EXPECT_THAT(RunTestProc(&import_data, kProgram, "tester"),
+              StatusIs(absl::StatusCode::kInternal,
+                       HasSubstr("Terminator returned false/failure.")));
+}
+
+TEST(BytecodeInterpreterTest, ProcNetworkRecvIf) {
+  // The consumer alternates between receiving and not; when it doesn't
+  // receive, recv_if yields a zero value without blocking.
+  constexpr absl::string_view kProgram = R"(
+proc producer {
+  c: chan out u32;
+
+  config(c: chan out u32) {
+    (c,)
+  }
+
+  next(tok: token, i: u32) {
+    let tok = send_if(tok, c, i % u32:2 == u32:0, i + u32:1);
+    (i + u32:1,)
+  }
+}
+
+#![test_proc(u32:0)]
+proc tester {
+  terminator: chan out bool;
+  c: chan in u32;
+
+  config(terminator: chan out bool) {
+    let (p, c) = chan u32;
+    spawn producer(p)(u32:0);
+    (terminator, c)
+  }
+
+  next(tok: token, i: u32) {
+    let (tok, x) = recv_if(tok, c, i % u32:2 == u32:0);
+    let expected = if i % u32:2 == u32:0 { i + u32:1 } else { u32:0 };
+    let _ = assert_eq(x, expected);
+    let tok = send_if(tok, terminator, i == u32:4, true);
+    (i + u32:1,)
+  }
+}
+)";
+  auto import_data = CreateImportDataForTest();
+  XLS_EXPECT_OK(RunTestProc(&import_data, kProgram, "tester"));
+}
+
+TEST(BytecodeInterpreterTest, ProcNetworkRecvIfEnum) {
+  // The zero value yielded by a recv_if that doesn't receive is the enum
+  // member whose value is zero.
+  constexpr absl::string_view kProgram = R"(
+enum MyEnum : u2 {
+  A = 0,
+  B = 1,
+  C = 2,
+}
+
+proc producer {
+  c: chan out MyEnum;
+
+  config(c: chan out MyEnum) {
+    (c,)
+  }
+
+  next(tok: token, i: u32) {
+    let tok = send_if(tok, c, i % u32:2 == u32:0, MyEnum::C);
+    (i + u32:1,)
+  }
+}
+
+#![test_proc(u32:0)]
+proc tester {
+  terminator: chan out bool;
+  c: chan in MyEnum;
+
+  config(terminator: chan out bool) {
+    let (p, c) = chan MyEnum;
+    spawn producer(p)(u32:0);
+    (terminator, c)
+  }
+
+  next(tok: token, i: u32) {
+    let (tok, x) = recv_if(tok, c, i % u32:2 == u32:0);
+    let expected = if i % u32:2 == u32:0 { MyEnum::C } else { MyEnum::A };
+    let _ = assert_eq(x, expected);
+    let tok = send_if(tok, terminator, i == u32:4, true);
+    (i + u32:1,)
+  }
+}
+)";
+  auto import_data = CreateImportDataForTest();
+  XLS_EXPECT_OK(RunTestProc(&import_data, kProgram, "tester"));
+}
+
+TEST(BytecodeInterpreterTest, ProcNetworkRecvInLoop) {
+  // Each proc exchanges one value per loop iteration, so after its first run
+  // every activation blocks at the same recv it blocked at before, having
+  // received and sent a value in between.
+  constexpr absl::string_view kProgram = R"(
+proc incrementer {
+  input: chan in u32;
+  output: chan out u32;
+
+  config(input: chan in u32, output: chan out u32) {
+    (input, output)
+  }
+
+  next(tok: token) {
+    let tok = for (i, tok): (u32, token) in range(u32:0, u32:3) {
+      let (tok, x) = recv(tok, input);
+      send(tok, output, x + u32:1)
+    }(tok);
+    ()
+  }
+}
+
+#![test_proc()]
+proc tester {
+  terminator: chan out bool;
+  to_child: chan out u32;
+  from_child: chan in u32;
+
+  config(terminator: chan out bool) {
+    let (to_child, child_input) = chan u32;
+    let (child_output, from_child) = chan u32;
+    spawn incrementer(child_input, child_output)();
+    (terminator, to_child, from_child)
+  }
+
+  next(tok: token) {
+    let (tok, sum) = for (i, (tok, sum)): (u32, (token, u32))
+        in range(u32:0, u32:3) {
+      let tok = send(tok, to_child, i);
+      let (tok, x) = recv(tok, from_child);
+      (tok, sum + x)
+    }((tok, u32:0));
+    let tok = send(tok, terminator, sum == u32:6);
+    ()
+  }
+}
+)";
+  auto import_data = CreateImportDataForTest();
+  XLS_EXPECT_OK(RunTestProc(&import_data, kProgram, "tester"));
+}
+
+TEST(BytecodeInterpreterTest, ProcNetworkDeadlock) {
+  constexpr absl::string_view kProgram = R"(
+#![test_proc()]
+proc tester {
+  terminator: chan out bool;
+  c: chan in u32;
+
+  config(terminator: chan out bool) {
+    let (p, c) = chan u32;
+    (terminator, c)
+  }
+
+  next(tok: token) {
+    let (tok, x) = recv(tok, c);
+    let tok = send(tok, terminator, true);
+    ()
+  }
+}
+)";
+  auto import_data = CreateImportDataForTest();
+  EXPECT_THAT(RunTestProc(&import_data, kProgram, "tester"),
+              StatusIs(absl::StatusCode::kInternal, HasSubstr("deadlocked")));
+}
+
 }  // namespace
 }  // namespace xls::dslx
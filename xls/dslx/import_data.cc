@@ -26,6 +26,7 @@ namespace xls::dslx {
 
 absl::StatusOr<const ModuleInfo*> ImportData::Get(
     const ImportTokens& subject) const {
+  absl::MutexLock lock(mutex_.get());
   auto it = cache_.find(subject);
   if (it == cache_.end()) {
     return absl::NotFoundError("Module information was not found for import " +
@@ -36,6 +37,7 @@ absl::StatusOr<const ModuleInfo*> ImportData::Get(
 
 absl::StatusOr<const ModuleInfo*> ImportData::Put(const ImportTokens& subject,
                                                   ModuleInfo module_info) {
+  absl::MutexLock lock(mutex_.get());
   auto it = cache_.insert({subject, std::move(module_info)});
   if (!it.second) {
     return absl::InvalidArgumentError(
@@ -44,6 +46,24 @@ absl::StatusOr<const ModuleInfo*> ImportData::Put(const ImportTokens& subject,
   return &it.first->second;
 }
 
+void ImportData::PutFailure(const ImportTokens& subject,
+                            std::unique_ptr<Module> module,
+                            absl::Status status) {
+  absl::MutexLock lock(mutex_.get());
+  failures_.insert({subject, std::move(status)});
+  failed_modules_.push_back(std::move(module));
+}
+
+absl::optional<absl::Status> ImportData::GetFailure(
+    const ImportTokens& subject) const {
+  absl::MutexLock lock(mutex_.get());
+  auto it = failures_.find(subject);
+  if (it == failures_.end()) {
+    return absl::nullopt;
+  }
+  return it->second;
+}
+
 absl::StatusOr<TypeInfo*> ImportData::GetRootTypeInfoForNode(AstNode* node) {
   XLS_RET_CHECK(node != nullptr);
   return type_info_owner().GetRootTypeInfo(node->owner());
@@ -54,6 +74,7 @@ absl::StatusOr<TypeInfo*> ImportData::GetRootTypeInfo(Module* module) {
 }
 
 InterpBindings& ImportData::GetOrCreateTopLevelBindings(Module* module) {
+  absl::MutexLock lock(mutex_.get());
   auto it = top_level_bindings_.find(module);
   if (it == top_level_bindings_.end()) {
     it = top_level_bindings_
@@ -66,6 +87,7 @@ InterpBindings& ImportData::GetOrCreateTopLevelBindings(Module* module) {
 
 void ImportData::SetTopLevelBindings(Module* module,
                                      std::unique_ptr<InterpBindings> tlb) {
+  absl::MutexLock lock(mutex_.get());
   auto it = top_level_bindings_.emplace(module, std::move(tlb));
   XLS_CHECK(it.second) << "Module already had top level bindings: "
                        << module->name();
@@ -80,4 +102,26 @@ BytecodeCacheInterface* ImportData::bytecode_cache() {
   return bytecode_cache_.get();
 }
 
+void ImportData::SetImportJobs(int64_t jobs) {
+  import_jobs_ = jobs;
+  // The thread running the outermost import works alongside the pool.
+  import_pool_ = jobs > 1 ? std::make_unique<ThreadPool>(jobs - 1) : nullptr;
+}
+
+absl::optional<absl::flat_hash_set<std::string>> ImportData::GetImportClosure(
+    absl::string_view module_name) const {
+  absl::MutexLock lock(mutex_.get());
+  auto it = import_closures_.find(module_name);
+  if (it == import_closures_.end()) {
+    return absl::nullopt;
+  }
+  return it->second;
+}
+
+void ImportData::SetImportClosure(std::string module_name,
+                                  absl::flat_hash_set<std::string> closure) {
+  absl::MutexLock lock(mutex_.get());
+  import_closures_.insert({std::move(module_name), std::move(closure)});
+}
+
 }  // namespace xls::dslx
@@ -18,6 +18,11 @@
 #include <filesystem>
 #include <memory>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/container/node_hash_map.h"
+#include "absl/synchronization/mutex.h"
+#include "xls/common/thread_pool.h"
 #include "xls/dslx/ast.h"
 #include "xls/dslx/bytecode_cache_interface.h"
 #include "xls/dslx/default_dslx_stdlib_path.h"
@@ -78,22 +83,35 @@ class ImportTokens {
 // Wrapper around a {subject: module_info} mapping that modules can be imported
 // into.
 // Use the routines in create_import_data.h to instantiate an object.
+//
+// The bookkeeping here is thread-safe, so that independent imports can be
+// typechecked concurrently (see DoConcurrentImports()).
 class ImportData {
  public:
   // All instantiations of ImportData should pass a stdlib_path as below.
   ImportData() = delete;
 
   bool Contains(const ImportTokens& target) const {
+    absl::MutexLock lock(mutex_.get());
     return cache_.find(target) != cache_.end();
   }
 
-  // Note: returned pointer is not stable across mutations.
+  // Note: returned pointer is stable for the lifetime of this object.
   absl::StatusOr<const ModuleInfo*> Get(const ImportTokens& subject) const;
 
-  // Note: returned pointer is not stable across mutations.
+  // Note: returned pointer is stable for the lifetime of this object.
   absl::StatusOr<const ModuleInfo*> Put(const ImportTokens& subject,
                                         ModuleInfo module_info);
 
+  // Notes that `module`, imported as `subject`, failed to typecheck with
+  // `status`. The module is kept alive since its type information and
+  // work-in-progress note are keyed on it.
+  void PutFailure(const ImportTokens& subject, std::unique_ptr<Module> module,
+                  absl::Status status);
+
+  // Returns the error noted by PutFailure() for `subject`, if any.
+  absl::optional<absl::Status> GetFailure(const ImportTokens& subject) const;
+
   TypeInfoOwner& type_info_owner() { return type_info_owner_; }
 
   // Helper that gets the "root" type information for the module of the given
@@ -117,12 +135,14 @@ class ImportData {
   // work-in-progress. "node" may be set as nullptr when done with the entire
   // module.
   void SetTypecheckWorkInProgress(Module* module, AstNode* node) {
+    absl::MutexLock lock(mutex_.get());
     typecheck_wip_[module] = node;
   }
 
   // Retrieves which node was noted as currently work-in-progress, getter for
   // SetTypecheckWorkInProgress() above.
   AstNode* GetTypecheckWorkInProgress(Module* module) {
+    absl::MutexLock lock(mutex_.get());
     return typecheck_wip_[module];
   }
 
@@ -132,9 +152,11 @@ class ImportData {
   // hitting a work-in-progress indicator) those completed bindings can be
   // re-used after that without any need for re-evaluation.
   bool IsTopLevelBindingsDone(Module* module) const {
+    absl::MutexLock lock(mutex_.get());
     return top_level_bindings_done_.contains(module);
   }
   void MarkTopLevelBindingsDone(Module* module) {
+    absl::MutexLock lock(mutex_.get());
     top_level_bindings_done_.insert(module);
   }
 
@@ -146,6 +168,23 @@ class ImportData {
   void SetBytecodeCache(std::unique_ptr<BytecodeCacheInterface> bytecode_cache);
   BytecodeCacheInterface* bytecode_cache();
 
+  // The number of threads on which sibling imports of a module may be
+  // typechecked concurrently; one (the default) imports strictly in order.
+  void SetImportJobs(int64_t jobs);
+  int64_t import_jobs() const { return import_jobs_; }
+
+  // Helper threads for concurrent imports, shared by the imports of all
+  // modules (however deeply nested) so that at most import_jobs() threads
+  // typecheck at once. Null when importing strictly in order.
+  ThreadPool* import_pool() { return import_pool_.get(); }
+
+  // Memoized transitive import closures, by module name, used to find
+  // independent imports (see DoConcurrentImports()).
+  absl::optional<absl::flat_hash_set<std::string>> GetImportClosure(
+      absl::string_view module_name) const;
+  void SetImportClosure(std::string module_name,
+                        absl::flat_hash_set<std::string> closure);
+
  private:
   friend ImportData CreateImportData(std::string,
                                      absl::Span<const std::filesystem::path>);
@@ -158,15 +197,25 @@ class ImportData {
       : stdlib_path_(std::move(stdlib_path)),
         additional_search_paths_(additional_search_paths) {}
 
-  absl::flat_hash_map<ImportTokens, ModuleInfo> cache_;
+  // Guards the maps below. Held by pointer so ImportData stays movable.
+  std::unique_ptr<absl::Mutex> mutex_ = std::make_unique<absl::Mutex>();
+  // Node-based so that ModuleInfo pointers remain valid across insertions.
+  absl::node_hash_map<ImportTokens, ModuleInfo> cache_;
   absl::flat_hash_map<Module*, std::unique_ptr<InterpBindings>>
       top_level_bindings_;
   absl::flat_hash_set<Module*> top_level_bindings_done_;
   absl::flat_hash_map<Module*, AstNode*> typecheck_wip_;
+  absl::flat_hash_map<ImportTokens, absl::Status> failures_;
+  std::vector<std::unique_ptr<Module>> failed_modules_;
+  absl::flat_hash_map<std::string, absl::flat_hash_set<std::string>>
+      import_closures_;
   TypeInfoOwner type_info_owner_;
   std::string stdlib_path_;
   absl::Span<const std::filesystem::path> additional_search_paths_;
   std::unique_ptr<BytecodeCacheInterface> bytecode_cache_;
+  int64_t import_jobs_ = 1;
+  // Declared last so that its threads are joined first.
+  std::unique_ptr<ThreadPool> import_pool_;
 };
 
 }  // namespace xls::dslx
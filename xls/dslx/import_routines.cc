@@ -14,12 +14,20 @@
 
 #include "xls/dslx/import_routines.h"
 
+#include <atomic>
+#include <memory>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_split.h"
+#include "absl/synchronization/mutex.h"
 #include "xls/common/config/xls_config.h"
 #include "xls/common/file/filesystem.h"
 #include "xls/common/file/get_runfile_path.h"
 #include "xls/common/status/ret_check.h"
+#include "xls/common/thread_pool.h"
 #include "xls/dslx/parser.h"
 #include "xls/dslx/scanner.h"
 
@@ -127,6 +135,9 @@ absl::StatusOr<const ModuleInfo*> DoImport(
   if (import_data->Contains(subject)) {
     return import_data->Get(subject);
   }
+  if (absl::optional<absl::Status> failure = import_data->GetFailure(subject)) {
+    return *std::move(failure);
+  }
 
   XLS_VLOG(3) << "DoImport (uncached) subject: " << subject.ToString();
 
@@ -144,8 +155,194 @@ absl::StatusOr<const ModuleInfo*> DoImport(
   Scanner scanner(found_path, contents);
   Parser parser(/*module_name=*/fully_qualified_name, &scanner);
   XLS_ASSIGN_OR_RETURN(std::unique_ptr<Module> module, parser.ParseModule());
-  XLS_ASSIGN_OR_RETURN(TypeInfo * type_info, ftypecheck(module.get()));
-  return import_data->Put(subject, ModuleInfo{std::move(module), type_info});
+  absl::StatusOr<TypeInfo*> type_info = ftypecheck(module.get());
+  if (!type_info.ok()) {
+    // Importing the subject again would register a second root TypeInfo for
+    // the same file, so the error is kept and returned from now on.
+    import_data->PutFailure(subject, std::move(module), type_info.status());
+    return type_info.status();
+  }
+  return import_data->Put(subject, ModuleInfo{std::move(module), *type_info});
+}
+
+// Returns the subjects imported by the module identified by 'subject', parsing
+// it if it has not been imported yet.
+static absl::StatusOr<std::vector<ImportTokens>> GetImportSubjects(
+    const ImportTokens& subject, ImportData* import_data,
+    const Span& import_span) {
+  std::unique_ptr<Module> parsed;
+  const Module* module;
+  if (import_data->Contains(subject)) {
+    XLS_ASSIGN_OR_RETURN(const ModuleInfo* info, import_data->Get(subject));
+    module = info->module.get();
+  } else {
+    XLS_ASSIGN_OR_RETURN(
+        std::filesystem::path found_path,
+        FindExistingPath(subject, import_data->stdlib_path(),
+                         import_data->additional_search_paths(), import_span));
+    XLS_ASSIGN_OR_RETURN(std::string contents, GetFileContents(found_path));
+    Scanner scanner(found_path, contents);
+    Parser parser(/*module_name=*/subject.ToString(), &scanner);
+    XLS_ASSIGN_OR_RETURN(parsed, parser.ParseModule());
+    module = parsed.get();
+  }
+
+  std::vector<ImportTokens> result;
+  for (const ModuleMember& member : module->top()) {
+    if (Import* const* import = absl::get_if<Import*>(&member)) {
+      result.push_back(ImportTokens((*import)->subject()));
+    }
+  }
+  return result;
+}
+
+// Returns the names of the modules transitively imported by 'subject',
+// including its own. Closures are memoized in 'import_data', so each module is
+// parsed for this at most once; 'in_progress' holds the modules whose closures
+// are being computed by callers, to detect import cycles.
+static absl::StatusOr<absl::flat_hash_set<std::string>> GetImportClosure(
+    const ImportTokens& subject, ImportData* import_data,
+    const Span& import_span, absl::flat_hash_set<std::string>* in_progress) {
+  std::string name = subject.ToString();
+  if (absl::optional<absl::flat_hash_set<std::string>> closure =
+          import_data->GetImportClosure(name)) {
+    return *std::move(closure);
+  }
+  if (!in_progress->insert(name).second) {
+    return absl::FailedPreconditionError(
+        absl::StrFormat("Import cycle through %s", name));
+  }
+  XLS_ASSIGN_OR_RETURN(std::vector<ImportTokens> imports,
+                       GetImportSubjects(subject, import_data, import_span));
+  absl::flat_hash_set<std::string> closure = {name};
+  for (const ImportTokens& import : imports) {
+    XLS_ASSIGN_OR_RETURN(
+        absl::flat_hash_set<std::string> import_closure,
+        GetImportClosure(import, import_data, import_span, in_progress));
+    closure.insert(import_closure.begin(), import_closure.end());
+  }
+  in_progress->erase(name);
+  import_data->SetImportClosure(name, closure);
+  return closure;
+}
+
+void DoConcurrentImports(
+    const TypecheckFn& ftypecheck,
+    absl::Span<const std::pair<ImportTokens, Span>> subjects,
+    absl::string_view importer, ImportData* import_data) {
+  ThreadPool* pool = import_data->import_pool();
+  if (pool == nullptr) {
+    return;
+  }
+
+  std::vector<const std::pair<ImportTokens, Span>*> pending;
+  absl::flat_hash_set<std::string> pending_names;
+  for (const auto& item : subjects) {
+    if (!import_data->Contains(item.first) &&
+        pending_names.insert(item.first.ToString()).second) {
+      pending.push_back(&item);
+    }
+  }
+  if (pending.size() < 2) {
+    return;
+  }
+
+  // Union the pending imports whose closures share a module that is not yet
+  // imported (and so would otherwise be typechecked by both). Modules that are
+  // already imported can be shared: their type information is safe to extend
+  // with instantiations from several threads. Any failure to compute a closure
+  // (missing file, parse error, import cycle) is left to the sequential imports
+  // to report.
+  std::vector<int64_t> group(pending.size());
+  auto find = [&group](int64_t i) {
+    while (group[i] != i) {
+      i = group[i] = group[group[i]];
+    }
+    return i;
+  };
+  absl::flat_hash_map<std::string, int64_t> owner;
+  for (int64_t i = 0; i < pending.size(); ++i) {
+    group[i] = i;
+    absl::flat_hash_set<std::string> in_progress;
+    absl::StatusOr<absl::flat_hash_set<std::string>> closure = GetImportClosure(
+        pending[i]->first, import_data, pending[i]->second, &in_progress);
+    if (closure.ok() && closure->contains(importer)) {
+      closure = absl::FailedPreconditionError(absl::StrFormat(
+          "Import of %s leads back to %s", pending[i]->first.ToString(),
+          importer));
+    }
+    if (!closure.ok()) {
+      XLS_VLOG(3) << "Importing sequentially: " << closure.status();
+      return;
+    }
+    for (const std::string& name : *closure) {
+      absl::StatusOr<ImportTokens> tokens = ImportTokens::FromString(name);
+      if (tokens.ok() && import_data->Contains(*tokens)) {
+        continue;
+      }
+      auto [it, inserted] = owner.emplace(name, i);
+      if (!inserted) {
+        group[find(i)] = find(it->second);
+      }
+    }
+  }
+
+  std::vector<std::vector<int64_t>> groups;
+  absl::flat_hash_map<int64_t, int64_t> group_index;
+  for (int64_t i = 0; i < pending.size(); ++i) {
+    auto [it, inserted] = group_index.emplace(find(i), groups.size());
+    if (inserted) {
+      groups.emplace_back();
+    }
+    groups[it->second].push_back(i);
+  }
+  if (groups.size() < 2) {
+    return;
+  }
+
+  XLS_VLOG(3) << "Importing " << pending.size() << " modules of " << importer
+              << " in " << groups.size() << " independent groups";
+
+  // Groups are claimed from a shared counter by this thread and by helpers on
+  // the import pool. Imports nested in these groups use the same pool, and a
+  // thread only ever waits for groups that another thread is running, so
+  // occupied pool threads cannot deadlock the import.
+  struct Progress {
+    explicit Progress(int64_t group_count) : group_count(group_count) {}
+    bool Done() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex) {
+      return finished == group_count;
+    }
+
+    const int64_t group_count;
+    std::atomic<int64_t> next = 0;
+    absl::Mutex mutex;
+    int64_t finished ABSL_GUARDED_BY(mutex) = 0;
+  };
+  auto progress = std::make_shared<Progress>(groups.size());
+  // Helpers may start after the groups are finished, so they only touch the
+  // locals captured by reference once they have claimed a group.
+  auto run_groups = [progress, &groups, &pending, &ftypecheck, import_data] {
+    for (int64_t g = progress->next++; g < progress->group_count;
+         g = progress->next++) {
+      for (int64_t i : groups[g]) {
+        // Typechecking errors are kept by DoImport; all errors are reported
+        // by the caller's own (sequential) import.
+        DoImport(ftypecheck, pending[i]->first, import_data,
+                 pending[i]->second)
+            .IgnoreError();
+      }
+      absl::MutexLock lock(&progress->mutex);
+      ++progress->finished;
+    }
+  };
+  int64_t helper_count =
+      std::min<int64_t>(pool->thread_count(), groups.size() - 1);
+  for (int64_t i = 0; i < helper_count; ++i) {
+    pool->Schedule(run_groups);
+  }
+  run_groups();
+  absl::MutexLock lock(&progress->mutex);
+  progress->mutex.Await(absl::Condition(progress.get(), &Progress::Done));
 }
 
 }  // namespace xls::dslx
@@ -17,7 +17,9 @@
 
 #include <filesystem>
 #include <string>
+#include <utility>
 
+#include "absl/types/span.h"
 #include "xls/dslx/ast.h"
 #include "xls/dslx/import_data.h"
 #include "xls/dslx/type_info.h"
@@ -48,6 +50,28 @@ absl::StatusOr<const ModuleInfo*> DoImport(
     const TypecheckFn& ftypecheck, const ImportTokens& subject,
     ImportData* import_data, const Span& import_span);
 
+// Imports the modules identified by 'subjects' (the imports of the module named
+// 'importer') that are not yet in 'import_data', typechecking them on up to
+// import_data->import_jobs() threads.
+//
+// Imports proceed concurrently unless their transitive import closures share a
+// module that is not yet imported: such imports are typechecked one after the
+// other on the same thread, so the shared module is only typechecked once.
+// Already-imported dependencies (e.g. the standard library) do not serialize
+// anything, as the parametric instantiations recorded in their type
+// information are synchronized.
+//
+// The threads come from import_data->import_pool(), which nested imports share.
+//
+// This only warms the import cache: callers are expected to DoImport() each
+// subject afterwards, in order, which reports any error exactly as a
+// sequential import would (typechecking errors are kept by DoImport rather than
+// recomputed).
+void DoConcurrentImports(
+    const TypecheckFn& ftypecheck,
+    absl::Span<const std::pair<ImportTokens, Span>> subjects,
+    absl::string_view importer, ImportData* import_data);
+
 }  // namespace xls::dslx
 
 #endif  // XLS_DSLX_IMPORT_ROUTINES_H_
@@ -66,6 +66,20 @@ std::string TagToString(InterpValueTag tag) {
                          static_cast<int64_t>(tag));
 }
 
+InterpValue::InterpValue(InterpValueTag tag, std::vector<InterpValue> values)
+    : tag_(tag) {
+  if (values.empty()) {
+    // Empty tuples (e.g. the unit value returned by tests and assertions) and
+    // arrays are common enough to share a single allocation.
+    static const auto* const kEmpty =
+        new ValuesPtr(std::make_shared<const std::vector<InterpValue>>());
+    payload_ = *kEmpty;
+  } else {
+    payload_ =
+        std::make_shared<const std::vector<InterpValue>>(std::move(values));
+  }
+}
+
 /* static */ InterpValue InterpValue::MakeTuple(
     std::vector<InterpValue> members) {
   return InterpValue{InterpValueTag::kTuple, std::move(members)};
@@ -279,13 +279,13 @@ class InterpValue {
   InterpValueTag tag() const { return tag_; }
 
   absl::StatusOr<const std::vector<InterpValue>*> GetValues() const {
-    if (!absl::holds_alternative<std::vector<InterpValue>>(payload_)) {
+    if (!absl::holds_alternative<ValuesPtr>(payload_)) {
       return absl::InvalidArgumentError("Value does not hold element values");
     }
-    return &absl::get<std::vector<InterpValue>>(payload_);
+    return absl::get<ValuesPtr>(payload_).get();
   }
   const std::vector<InterpValue>& GetValuesOrDie() const {
-    return absl::get<std::vector<InterpValue>>(payload_);
+    return *absl::get<ValuesPtr>(payload_);
   }
   absl::StatusOr<const FnData*> GetFunction() const {
     if (!absl::holds_alternative<FnData>(payload_)) {
@@ -311,7 +311,7 @@ class InterpValue {
   // apply to enum values as well.
   bool HasBits() const { return absl::holds_alternative<Bits>(payload_); }
   bool HasValues() const {
-    return absl::holds_alternative<std::vector<InterpValue>>(payload_);
+    return absl::holds_alternative<ValuesPtr>(payload_);
   }
 
   bool IsToken() const { return tag_ == InterpValueTag::kToken; }
@@ -351,28 +351,43 @@ class InterpValue {
   const InterpValue UpdateWithStructInfo(
       std::vector<std::string> struct_members) const {
     InterpValue clone = *this;
-    clone.struct_members_ = struct_members;
+    clone.struct_members_ = std::make_shared<const std::vector<std::string>>(
+        std::move(struct_members));
     return clone;
   }
 
-  std::vector<std::string> GetStructMembers() const { return struct_members_; }
+  std::vector<std::string> GetStructMembers() const {
+    if (struct_members_ == nullptr) {
+      return {};
+    }
+    return *struct_members_;
+  }
 
  private:
   friend struct InterpValuePickler;
 
+  // The elements of tuples and arrays. Values are immutable, so the elements
+  // are shared between copies of an aggregate rather than copied with it;
+  // copying a value is then at most a reference count increment (bits values
+  // of up to 64 bits are held inline by Bits).
+  using ValuesPtr = std::shared_ptr<const std::vector<InterpValue>>;
+
   // Note: currently InterpValues are not scoped to a lifetime, so we use a
   // shared_ptr for referring to token data for identity purposes.
   //
   // TODO(leary): 2020-02-10 When all Python bindings are eliminated we can more
   // easily make an interpreter scoped lifetime that InterpValues can live in.
-  using Payload =
-      absl::variant<Bits, std::vector<InterpValue>, FnData,
-                    std::shared_ptr<TokenData>, std::shared_ptr<Channel>>;
+  using Payload = absl::variant<Bits, ValuesPtr, FnData,
+                                std::shared_ptr<TokenData>,
+                                std::shared_ptr<Channel>>;
 
   InterpValue(InterpValueTag tag, Payload payload,
               const EnumDef* type = nullptr)
       : tag_(tag), payload_(std::move(payload)), type_(type) {}
 
+  // Creates an aggregate value holding the given elements.
+  InterpValue(InterpValueTag tag, std::vector<InterpValue> values);
+
   InterpValue(InterpValueTag tag, Payload payload, SymbolicType* sym)
       : tag_(tag), payload_(std::move(payload)), sym_tree_(sym) {}
 
@@ -397,8 +412,8 @@ class InterpValue {
   SymbolicType* sym_tree_ = nullptr;
 
   // Stores struct members names, used later for test case generation in the
-  // concolic engine.
-  std::vector<std::string> struct_members_;
+  // concolic engine. Shared between copies, like the elements of aggregates.
+  std::shared_ptr<const std::vector<std::string>> struct_members_;
 };
 
 // Retrieves the module associated with the function_value if it is user
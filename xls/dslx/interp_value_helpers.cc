@@ -104,6 +104,46 @@ absl::StatusOr<InterpValue> CreateZeroValue(const InterpValue& value) {
   }
 }
 
+absl::StatusOr<InterpValue> CreateZeroValueFromType(const ConcreteType& type) {
+  if (auto* bits_type = dynamic_cast<const BitsType*>(&type)) {
+    XLS_ASSIGN_OR_RETURN(int64_t bit_count, bits_type->size().GetAsInt64());
+    return InterpValue::MakeBits(bits_type->is_signed(), Bits(bit_count));
+  }
+
+  if (auto* enum_type = dynamic_cast<const EnumType*>(&type)) {
+    XLS_ASSIGN_OR_RETURN(int64_t bit_count, enum_type->size().GetAsInt64());
+    return InterpValue::MakeEnum(Bits(bit_count), &enum_type->nominal_type());
+  }
+
+  const std::vector<std::unique_ptr<ConcreteType>>* members = nullptr;
+  if (auto* tuple_type = dynamic_cast<const TupleType*>(&type)) {
+    members = &tuple_type->members();
+  } else if (auto* struct_type = dynamic_cast<const StructType*>(&type)) {
+    members = &struct_type->members();
+  }
+  if (members != nullptr) {
+    std::vector<InterpValue> zero_elements;
+    zero_elements.reserve(members->size());
+    for (const auto& member : *members) {
+      XLS_ASSIGN_OR_RETURN(InterpValue zero_element,
+                           CreateZeroValueFromType(*member));
+      zero_elements.push_back(std::move(zero_element));
+    }
+    return InterpValue::MakeTuple(std::move(zero_elements));
+  }
+
+  if (auto* array_type = dynamic_cast<const ArrayType*>(&type)) {
+    XLS_ASSIGN_OR_RETURN(int64_t size, array_type->size().GetAsInt64());
+    XLS_ASSIGN_OR_RETURN(InterpValue zero_element,
+                         CreateZeroValueFromType(array_type->element_type()));
+    return InterpValue::MakeArray(
+        std::vector<InterpValue>(size, zero_element));
+  }
+
+  return absl::InvalidArgumentError(absl::StrCat(
+      "Invalid type for zero-value generation: ", type.ToString()));
+}
+
 absl::Status FlattenTuple(const InterpValue& value,
                           std::vector<InterpValue>* result) {
   if (!value.IsTuple()) {
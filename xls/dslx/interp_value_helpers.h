@@ -32,6 +32,10 @@ absl::StatusOr<InterpValue> CastBitsToEnum(const InterpValue& bits_value,
 // Creates a zero-valued InterpValue with the same structure as the input.
 absl::StatusOr<InterpValue> CreateZeroValue(const InterpValue& value);
 
+// Creates a zero-valued InterpValue of the given bits, array, tuple or struct
+// type.
+absl::StatusOr<InterpValue> CreateZeroValueFromType(const ConcreteType& type);
+
 // Places a "flat" representation of the input value (if it's a tuple) in
 // `result`. Converts, e.g., (a, (b, c), d) into {a, b, c, d}.
 absl::Status FlattenTuple(const InterpValue& value,
@@ -77,5 +77,25 @@ TEST(InterpValueHelpersTest, CastBitsToEnum) {
   ASSERT_EQ(int_value, 11);
 }
 
+TEST(InterpValueHelpersTest, CreateZeroValueFromType) {
+  std::vector<std::unique_ptr<ConcreteType>> members;
+  members.push_back(BitsType::MakeU8());
+  members.push_back(std::make_unique<ArrayType>(
+      std::make_unique<BitsType>(/*is_signed=*/true, 4),
+      ConcreteTypeDim::CreateU32(2)));
+  TupleType tuple_type(std::move(members));
+
+  XLS_ASSERT_OK_AND_ASSIGN(InterpValue zero,
+                           CreateZeroValueFromType(tuple_type));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      InterpValue array,
+      InterpValue::MakeArray(
+          {InterpValue::MakeSBits(4, 0), InterpValue::MakeSBits(4, 0)}));
+  EXPECT_EQ(zero,
+            InterpValue::MakeTuple({InterpValue::MakeUBits(8, 0), array}));
+
+  EXPECT_FALSE(CreateZeroValueFromType(TokenType()).ok());
+}
+
 }  // namespace
 }  // namespace xls::dslx
@@ -160,5 +160,32 @@ TEST(InterpValueTest, TestPredicates) {
   EXPECT_FALSE(InterpValue::MakeU32(1).IsTrue());
 }
 
+TEST(InterpValueTest, CopiesShareAggregateStorage) {
+  auto a = InterpValue::MakeUBits(/*bit_count=*/12, /*value=*/0xf00);
+  auto b = InterpValue::MakeUBits(/*bit_count=*/12, /*value=*/0xba5);
+  InterpValue tuple = InterpValue::MakeTuple({a, b});
+  InterpValue copy = tuple;
+  EXPECT_EQ(&tuple.GetValuesOrDie(), &copy.GetValuesOrDie());
+  EXPECT_EQ(tuple, copy);
+
+  // Updating a copy must not be observable through the original.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      InterpValue array, InterpValue::MakeArray({a, b}));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      InterpValue updated,
+      array.Update(InterpValue::MakeU32(0), InterpValue::MakeUBits(12, 1)));
+  EXPECT_THAT(array.GetValuesOrDie()[0].GetBitValueUint64(),
+              IsOkAndHolds(0xf00));
+  EXPECT_THAT(updated.GetValuesOrDie()[0].GetBitValueUint64(),
+              IsOkAndHolds(1));
+}
+
+TEST(InterpValueTest, UnitValuesShareStorage) {
+  InterpValue x = InterpValue::MakeUnit();
+  InterpValue y = InterpValue::MakeUnit();
+  EXPECT_EQ(&x.GetValuesOrDie(), &y.GetValuesOrDie());
+  EXPECT_TRUE(x.GetValuesOrDie().empty());
+}
+
 }  // namespace
 }  // namespace xls::dslx
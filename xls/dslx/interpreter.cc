@@ -567,8 +567,8 @@ absl::StatusOr<InterpValue> Interpreter::EvaluateAndCompareInternal(
                              abstract_adapter_.get()));
 
   if (post_fn_eval_hook_ != nullptr) {
-    XLS_RETURN_IF_ERROR(
-        post_fn_eval_hook_(f, args, symbolic_bindings, interpreter_value));
+    XLS_RETURN_IF_ERROR(post_fn_eval_hook_(f, args, symbolic_bindings,
+                                           interpreter_value, span));
   }
 
   return interpreter_value;
@@ -31,10 +31,10 @@ class Interpreter {
   // Function signature for a "post function-evaluation hook" -- this is invoked
   // after a function is evaluated by the interpreter. This is useful for e.g.
   // externally-implementing and hooking-in comparison to the JIT execution
-  // mode.
+  // mode. `call_site` is the span of the invocation that was evaluated.
   using PostFnEvalHook = std::function<absl::Status(
       Function* f, absl::Span<const InterpValue> args, const SymbolicBindings*,
-      const InterpValue& got)>;
+      const InterpValue& got, const Span& call_site)>;
 
   // Helper used by type inference to evaluate "constexpr" expressions at type
   // checking time (e.g. derived parametric expressions, forced constexpr
@@ -36,6 +36,13 @@ ABSL_FLAG(bool, execute, true, "Execute tests within the entry module.");
 ABSL_FLAG(std::string, compare, "jit",
           "Compare DSL-interpreted results with an IR execution for each"
           " function for consistency checking; options: none|jit|interpreter.");
+ABSL_FLAG(int64_t, compare_batch_size, 0,
+          "If positive, record the calls to compare and check them in batches "
+          "of this size instead of as each call returns; mismatches are "
+          "reported at the end of the tests, at their call site.");
+ABSL_FLAG(bool, compare_in_background, false,
+          "With --compare_batch_size, check the batches on a background "
+          "thread while the tests keep running.");
 ABSL_FLAG(
     int64_t, seed, 0,
     "Seed for quickcheck random stimulus; 0 for an nondetermistic value.");
@@ -44,6 +51,13 @@ ABSL_FLAG(std::string, test_filter, "",
           "Target (currently *single*) test name to run.");
 ABSL_FLAG(bool, bytecode, true,
           "If true, use the in-development bytecode interpreter to execute.");
+ABSL_FLAG(int64_t, jobs, 1,
+          "Number of threads on which to run tests and quickchecks; results "
+          "are reported in module order regardless.");
+ABSL_FLAG(bool, execute_on_jit, false,
+          "If true, convert the module's test functions to IR and run them on "
+          "the JIT; the DSL interpreter only re-runs failing tests to report "
+          "where they failed.");
 // LINT.ThenChange(//xls/build_rules/xls_dslx_rules.bzl)
 
 namespace xls::dslx {
@@ -79,6 +93,11 @@ absl::Status RealMain(absl::string_view entry_module_path,
       run_comparator.emplace(CompareMode::kInterpreter);
       break;
   }
+  if (int64_t batch_size = absl::GetFlag(FLAGS_compare_batch_size);
+      run_comparator.has_value() && batch_size > 0) {
+    run_comparator->EnableDeferredComparison(
+        batch_size, absl::GetFlag(FLAGS_compare_in_background));
+  }
   ParseAndTestOptions options = {
       .dslx_paths = dslx_paths,
       .test_filter = test_filter,
@@ -88,6 +107,8 @@ absl::Status RealMain(absl::string_view entry_module_path,
       .execute = execute,
       .seed = seed,
       .bytecode = absl::GetFlag(FLAGS_bytecode),
+      .jobs = absl::GetFlag(FLAGS_jobs),
+      .execute_on_jit = absl::GetFlag(FLAGS_execute_on_jit),
   };
   XLS_ASSIGN_OR_RETURN(
       TestResult test_result,
@@ -351,6 +351,12 @@ class FunctionConverter {
   // Handles the fail!() builtin invocation.
   absl::Status HandleFailBuiltin(Invocation* node, BValue arg);
 
+  // Handles the assert_eq() and assert_lt() builtin invocations; `holds` is
+  // the predicate the assertion checks.
+  absl::Status HandleAssertBuiltin(Invocation* node,
+                                   absl::string_view builtin_name,
+                                   BValue holds);
+
   // Handles the cover!() builtin invocation.
   absl::Status HandleCoverBuiltin(Invocation* node, BValue condition);
 
@@ -1901,6 +1907,31 @@ absl::Status FunctionConverter::HandleFailBuiltin(Invocation* node,
   return absl::OkStatus();
 }
 
+absl::Status FunctionConverter::HandleAssertBuiltin(
+    Invocation* node, absl::string_view builtin_name, BValue holds) {
+  if (options_.emit_fail_as_assert) {
+    XLS_RET_CHECK(implicit_token_data_.has_value())
+        << "Invoking " << builtin_name
+        << "(), but no implicit token is present for caller @ "
+        << node->span();
+    XLS_RET_CHECK(implicit_token_data_->create_control_predicate != nullptr);
+    // The assertion only fires if control reaches this program point.
+    BValue control_predicate = implicit_token_data_->create_control_predicate();
+    std::string message =
+        absl::StrFormat("Assertion failure via %s @ %s", builtin_name,
+                        node->span().ToString());
+    BValue assert_result_token = function_builder_->Assert(
+        implicit_token_data_->entry_token,
+        function_builder_->Or(function_builder_->Not(control_predicate), holds),
+        message);
+    implicit_token_data_->control_tokens.push_back(assert_result_token);
+  }
+  Def(node, [&](absl::optional<SourceLocation> loc) {
+    return function_builder_->Tuple(std::vector<BValue>());
+  });
+  return absl::OkStatus();
+}
+
 absl::Status FunctionConverter::HandleFormatMacro(FormatMacro* node) {
   XLS_RET_CHECK(implicit_token_data_.has_value())
       << "Invoking trace_fmt!(), but no implicit token is present for caller @ "
@@ -1982,6 +2013,30 @@ absl::Status FunctionConverter::HandleInvocation(Invocation* node) {
     XLS_RET_CHECK_EQ(args.size(), 1)
         << called_name << " builtin only accepts a single argument";
     return HandleFailBuiltin(node, std::move(args[0]));
+  } else if (called_name == "assert_eq") {
+    XLS_ASSIGN_OR_RETURN(std::vector<BValue> args, accept_args());
+    XLS_RET_CHECK_EQ(args.size(), 2)
+        << called_name << " builtin requires two arguments";
+    absl::optional<SourceLocation> loc;
+    XLS_ASSIGN_OR_RETURN(
+        BValue holds,
+        BuildTest(args[0], args[1], Op::kAnd, Value::Bool(true), loc,
+                  [this](BValue l, BValue r) {
+                    return function_builder_->Eq(l, r);
+                  }));
+    return HandleAssertBuiltin(node, called_name, holds);
+  } else if (called_name == "assert_lt") {
+    XLS_ASSIGN_OR_RETURN(std::vector<BValue> args, accept_args());
+    XLS_RET_CHECK_EQ(args.size(), 2)
+        << called_name << " builtin requires two arguments";
+    absl::optional<const ConcreteType*> lhs_type =
+        current_type_info_->GetItem(node->args()[0]);
+    XLS_RET_CHECK(lhs_type.has_value());
+    auto* bits_type = dynamic_cast<const BitsType*>(lhs_type.value());
+    BValue holds = bits_type != nullptr && bits_type->is_signed()
+                       ? function_builder_->SLt(args[0], args[1])
+                       : function_builder_->ULt(args[0], args[1]);
+    return HandleAssertBuiltin(node, called_name, holds);
   } else if (called_name == "cover!") {
     XLS_ASSIGN_OR_RETURN(std::vector<BValue> args, accept_args());
     XLS_RET_CHECK_EQ(args.size(), 2)
@@ -3250,9 +3305,57 @@ static absl::Status ConvertCallGraph(
   return absl::OkStatus();
 }
 
-absl::Status ConvertModuleIntoPackage(Module* module, ImportData* import_data,
-                                      const ConvertOptions& options,
-                                      bool traverse_tests, Package* package) {
+// Converts the body of `test` along with those of its callees that are not in
+// `converted`, which is updated on success. On failure, the functions added to
+// the package are removed again.
+static absl::Status ConvertTestFunction(
+    TestFunction* test, Module* module, TypeInfo* root_type_info,
+    ImportData* import_data, const ConvertOptions& options,
+    PackageData& package_data,
+    absl::flat_hash_set<std::pair<Function*, SymbolicBindings>>* converted) {
+  XLS_ASSIGN_OR_RETURN(std::vector<ConversionRecord> entry_order,
+                       GetOrderForEntry(test->fn(), root_type_info));
+  // The last record is the test function itself, made for conversion as a
+  // top; tests are converted as ordinary functions.
+  entry_order.pop_back();
+  std::vector<ConversionRecord> order;
+  for (ConversionRecord& record : entry_order) {
+    if (!converted->contains({record.f(), record.symbolic_bindings()})) {
+      order.push_back(std::move(record));
+    }
+  }
+  XLS_ASSIGN_OR_RETURN(
+      ConversionRecord record,
+      ConversionRecord::Make(test->fn(), /*invocation=*/nullptr, module,
+                             root_type_info, SymbolicBindings(),
+                             /*callees=*/{}, /*proc_id=*/absl::nullopt,
+                             /*is_top=*/false));
+  order.push_back(std::move(record));
+
+  Package* package = package_data.package;
+  int64_t function_count = package->functions().size();
+  absl::Status status =
+      ConvertCallGraph(order, import_data, options, package_data);
+  if (!status.ok()) {
+    // Functions are added after their callees, so remove them in reverse.
+    while (package->functions().size() > function_count) {
+      xls::Function* f = package->functions().back().get();
+      package_data.ir_to_dslx.erase(f);
+      package_data.wrappers.erase(f);
+      XLS_RETURN_IF_ERROR(package->RemoveFunction(f));
+    }
+    return status;
+  }
+  for (const ConversionRecord& record : order) {
+    converted->insert({record.f(), record.symbolic_bindings()});
+  }
+  return absl::OkStatus();
+}
+
+absl::Status ConvertModuleIntoPackage(
+    Module* module, ImportData* import_data, const ConvertOptions& options,
+    bool traverse_tests, Package* package,
+    absl::flat_hash_map<std::string, absl::Status>* test_errors) {
   XLS_ASSIGN_OR_RETURN(TypeInfo * root_type_info,
                        import_data->GetRootTypeInfo(module));
   XLS_ASSIGN_OR_RETURN(std::vector<ConversionRecord> order,
@@ -3260,6 +3363,26 @@ absl::Status ConvertModuleIntoPackage(Module* module, ImportData* import_data,
   PackageData package_data{package};
   XLS_RETURN_IF_ERROR(
       ConvertCallGraph(order, import_data, options, package_data));
+  if (options.convert_tests) {
+    // Test functions are never called, so they go after everything else. Each
+    // is converted along with the callees it doesn't share with the module,
+    // so that a test that can't be converted only affects itself.
+    absl::flat_hash_set<std::pair<Function*, SymbolicBindings>> converted;
+    for (const ConversionRecord& record : order) {
+      converted.insert({record.f(), record.symbolic_bindings()});
+    }
+    for (TestFunction* test : module->GetFunctionTests()) {
+      absl::Status status =
+          ConvertTestFunction(test, module, root_type_info, import_data,
+                              options, package_data, &converted);
+      if (!status.ok()) {
+        if (test_errors == nullptr) {
+          return status;
+        }
+        test_errors->insert({test->identifier(), std::move(status)});
+      }
+    }
+  }
 
   XLS_RETURN_IF_ERROR(
       WrapEntryIfImplicitToken(package_data, import_data, options));
@@ -3269,10 +3392,12 @@ absl::Status ConvertModuleIntoPackage(Module* module, ImportData* import_data,
 
 absl::StatusOr<std::unique_ptr<Package>> ConvertModuleToPackage(
     Module* module, ImportData* import_data, const ConvertOptions& options,
-    bool traverse_tests) {
+    bool traverse_tests,
+    absl::flat_hash_map<std::string, absl::Status>* test_errors) {
   auto package = std::make_unique<Package>(module->name());
   XLS_RETURN_IF_ERROR(ConvertModuleIntoPackage(module, import_data, options,
-                                               traverse_tests, package.get()));
+                                               traverse_tests, package.get(),
+                                               test_errors));
   return package;
 }
 
@@ -18,6 +18,8 @@
 #include <memory>
 
 #include "absl/container/btree_set.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
 #include "xls/dslx/ast.h"
 #include "xls/dslx/builtins.h"
 #include "xls/dslx/import_routines.h"
@@ -42,6 +44,12 @@ struct ConvertOptions {
 
   // Should the generated IR be verified?
   bool verify_ir = true;
+
+  // Whether to also convert the bodies of `#[test]` functions (along with the
+  // functions they call) when converting a module, e.g. so they can be run
+  // directly on the JIT. assert_eq() and assert_lt() become assertion IR nodes,
+  // as fail!() does.
+  bool convert_tests = false;
 };
 
 // Converts the contents of a module to IR form.
@@ -51,21 +59,28 @@ struct ConvertOptions {
 //   import_data: Contains type information used in conversion.
 //   traverse_tests: Whether to convert functions called in DSLX test
 //   constructs.
-//     Note that this does NOT convert the test constructs themselves.
+//     Note that this does NOT convert the test constructs themselves; see
+//     `ConvertOptions::convert_tests` for that.
+//   test_errors: If given, a test function (see
+//     `ConvertOptions::convert_tests`) that fails to convert is left out of
+//     the package and its error is recorded here by test name, instead of
+//     failing the conversion.
 //
 // Returns:
 //   The IR package that corresponds to this module.
 absl::StatusOr<std::unique_ptr<Package>> ConvertModuleToPackage(
     Module* module, ImportData* import_data, const ConvertOptions& options,
-    bool traverse_tests = false);
+    bool traverse_tests = false,
+    absl::flat_hash_map<std::string, absl::Status>* test_errors = nullptr);
 
 // As above, but the package is provided explicitly (instead of being created).
 //
 // Package must outlive this function call -- functions from "module" are placed
 // inside of it, it may not be nullptr.
-absl::Status ConvertModuleIntoPackage(Module* module, ImportData* import_data,
-                                      const ConvertOptions& options,
-                                      bool traverse_tests, Package* package);
+absl::Status ConvertModuleIntoPackage(
+    Module* module, ImportData* import_data, const ConvertOptions& options,
+    bool traverse_tests, Package* package,
+    absl::flat_hash_map<std::string, absl::Status>* test_errors = nullptr);
 
 // Wrapper around ConvertModuleToPackage that converts to IR text.
 absl::StatusOr<std::string> ConvertModule(Module* module,
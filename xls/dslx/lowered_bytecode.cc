@@ -0,0 +1,434 @@
+// Copyright 2022 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/dslx/lowered_bytecode.h"
+
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "absl/types/optional.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+
+namespace xls::dslx {
+namespace {
+
+using Instruction = LoweredBytecodeFunction::Instruction;
+using LoweredOp = LoweredBytecodeFunction::Op;
+
+// Implementations of the binary ops (see GetBinop).
+absl::StatusOr<InterpValue> Add(const InterpValue& lhs,
+                                const InterpValue& rhs) {
+  return lhs.Add(rhs);
+}
+absl::StatusOr<InterpValue> And(const InterpValue& lhs,
+                                const InterpValue& rhs) {
+  return lhs.BitwiseAnd(rhs);
+}
+absl::StatusOr<InterpValue> Concat(const InterpValue& lhs,
+                                   const InterpValue& rhs) {
+  return lhs.Concat(rhs);
+}
+absl::StatusOr<InterpValue> Div(const InterpValue& lhs,
+                                const InterpValue& rhs) {
+  return lhs.FloorDiv(rhs);
+}
+absl::StatusOr<InterpValue> Eq(const InterpValue& lhs,
+                               const InterpValue& rhs) {
+  return InterpValue::MakeBool(lhs.Eq(rhs));
+}
+absl::StatusOr<InterpValue> Ge(const InterpValue& lhs,
+                               const InterpValue& rhs) {
+  return lhs.Ge(rhs);
+}
+absl::StatusOr<InterpValue> Gt(const InterpValue& lhs,
+                               const InterpValue& rhs) {
+  return lhs.Gt(rhs);
+}
+absl::StatusOr<InterpValue> Le(const InterpValue& lhs,
+                               const InterpValue& rhs) {
+  return lhs.Le(rhs);
+}
+absl::StatusOr<InterpValue> Lt(const InterpValue& lhs,
+                               const InterpValue& rhs) {
+  return lhs.Lt(rhs);
+}
+absl::StatusOr<InterpValue> Mul(const InterpValue& lhs,
+                                const InterpValue& rhs) {
+  return lhs.Mul(rhs);
+}
+absl::StatusOr<InterpValue> Ne(const InterpValue& lhs,
+                               const InterpValue& rhs) {
+  return InterpValue::MakeBool(lhs.Ne(rhs));
+}
+absl::StatusOr<InterpValue> Or(const InterpValue& lhs,
+                               const InterpValue& rhs) {
+  return lhs.BitwiseOr(rhs);
+}
+absl::StatusOr<InterpValue> Shl(const InterpValue& lhs,
+                                const InterpValue& rhs) {
+  return lhs.Shl(rhs);
+}
+absl::StatusOr<InterpValue> Shr(const InterpValue& lhs,
+                                const InterpValue& rhs) {
+  if (lhs.IsSigned()) {
+    return lhs.Shra(rhs);
+  }
+  return lhs.Shrl(rhs);
+}
+absl::StatusOr<InterpValue> Sub(const InterpValue& lhs,
+                                const InterpValue& rhs) {
+  return lhs.Sub(rhs);
+}
+absl::StatusOr<InterpValue> Xor(const InterpValue& lhs,
+                                const InterpValue& rhs) {
+  return lhs.BitwiseXor(rhs);
+}
+
+// Returns the slot index of the given bytecode if it is a well-formed load.
+absl::optional<int64_t> LoadSlot(const Bytecode& bytecode) {
+  if (bytecode.op() != Bytecode::Op::kLoad) {
+    return absl::nullopt;
+  }
+  absl::StatusOr<Bytecode::SlotIndex> slot = bytecode.slot_index();
+  if (!slot.ok()) {
+    return absl::nullopt;
+  }
+  return slot->value();
+}
+
+// Returns the slot index of the given bytecode if it is a well-formed store.
+absl::optional<int64_t> StoreSlot(const Bytecode& bytecode) {
+  if (bytecode.op() != Bytecode::Op::kStore) {
+    return absl::nullopt;
+  }
+  absl::StatusOr<Bytecode::SlotIndex> slot = bytecode.slot_index();
+  if (!slot.ok()) {
+    return absl::nullopt;
+  }
+  return slot->value();
+}
+
+// Returns the value pushed by the given bytecode if it is a well-formed
+// literal.
+const InterpValue* LiteralValue(const Bytecode& bytecode) {
+  if (bytecode.op() != Bytecode::Op::kLiteral || !bytecode.has_data() ||
+      !absl::holds_alternative<InterpValue>(bytecode.data().value())) {
+    return nullptr;
+  }
+  return &absl::get<InterpValue>(bytecode.data().value());
+}
+
+// Attempts to form a superinstruction from the bytecodes at the front of
+// `bytecodes`. Patterns are tried longest first. None of the patterns include
+// a kJumpDest, so no jump can land in the middle of a superinstruction.
+absl::optional<Instruction> Fuse(absl::Span<const Bytecode> bytecodes,
+                                 int64_t pc) {
+  auto at = [&](int64_t i) -> const Bytecode* {
+    return i < bytecodes.size() ? &bytecodes[i] : nullptr;
+  };
+  auto binop_at = [&](int64_t i) -> LoweredBytecodeFunction::BinopFn {
+    return at(i) == nullptr ? nullptr
+                            : LoweredBytecodeFunction::GetBinop(at(i)->op());
+  };
+
+  if (absl::optional<int64_t> a = LoadSlot(bytecodes[0]); a.has_value()) {
+    absl::optional<int64_t> b =
+        at(1) == nullptr ? absl::nullopt : LoadSlot(*at(1));
+    const InterpValue* literal =
+        at(1) == nullptr ? nullptr : LiteralValue(*at(1));
+    if (b.has_value() && binop_at(2) != nullptr) {
+      return Instruction{.op = LoweredOp::kLoadBinopLoad, .a = *a, .b = *b,
+                         .binop = binop_at(2), .pc = pc, .length = 3};
+    }
+    if (literal != nullptr && binop_at(2) != nullptr) {
+      return Instruction{.op = LoweredOp::kLoadBinopLiteral, .a = *a,
+                         .literal = literal, .binop = binop_at(2), .pc = pc,
+                         .length = 3};
+    }
+    if (b.has_value()) {
+      return Instruction{.op = LoweredOp::kLoadLoad, .a = *a, .b = *b,
+                         .pc = pc, .length = 2};
+    }
+    if (literal != nullptr) {
+      return Instruction{.op = LoweredOp::kLoadLiteral, .a = *a,
+                         .literal = literal, .pc = pc, .length = 2};
+    }
+    if (binop_at(1) != nullptr) {
+      return Instruction{.op = LoweredOp::kBinopLoad, .a = *a,
+                         .binop = binop_at(1), .pc = pc, .length = 2};
+    }
+    return absl::nullopt;
+  }
+
+  if (const InterpValue* literal = LiteralValue(bytecodes[0]);
+      literal != nullptr && binop_at(1) != nullptr) {
+    return Instruction{.op = LoweredOp::kBinopLiteral, .literal = literal,
+                       .binop = binop_at(1), .pc = pc, .length = 2};
+  }
+
+  if (absl::optional<int64_t> a = StoreSlot(bytecodes[0]); a.has_value()) {
+    absl::optional<int64_t> b =
+        at(1) == nullptr ? absl::nullopt : LoadSlot(*at(1));
+    if (b.has_value()) {
+      return Instruction{.op = LoweredOp::kStoreLoad, .a = *a, .b = *b,
+                         .pc = pc, .length = 2};
+    }
+  }
+  return absl::nullopt;
+}
+
+}  // namespace
+
+/* static */ LoweredBytecodeFunction::BinopFn
+LoweredBytecodeFunction::GetBinop(Bytecode::Op op) {
+  switch (op) {
+    case Bytecode::Op::kAdd:
+      return &Add;
+    case Bytecode::Op::kAnd:
+      return &And;
+    case Bytecode::Op::kConcat:
+      return &Concat;
+    case Bytecode::Op::kDiv:
+      return &Div;
+    case Bytecode::Op::kEq:
+      return &Eq;
+    case Bytecode::Op::kGe:
+      return &Ge;
+    case Bytecode::Op::kGt:
+      return &Gt;
+    case Bytecode::Op::kLe:
+      return &Le;
+    case Bytecode::Op::kLt:
+      return &Lt;
+    case Bytecode::Op::kMul:
+      return &Mul;
+    case Bytecode::Op::kNe:
+      return &Ne;
+    case Bytecode::Op::kOr:
+      return &Or;
+    case Bytecode::Op::kShl:
+      return &Shl;
+    case Bytecode::Op::kShr:
+      return &Shr;
+    case Bytecode::Op::kSub:
+      return &Sub;
+    case Bytecode::Op::kXor:
+      return &Xor;
+    default:
+      return nullptr;
+  }
+}
+
+/* static */ absl::StatusOr<std::unique_ptr<LoweredBytecodeFunction>>
+LoweredBytecodeFunction::Lower(const BytecodeFunction* source, bool fuse) {
+  auto lowered = absl::WrapUnique(new LoweredBytecodeFunction(source));
+  absl::Span<const Bytecode> bytecodes = source->bytecodes();
+  std::vector<Instruction>& instructions = lowered->instructions_;
+  lowered->pc_to_instruction_.resize(bytecodes.size() + 1, -1);
+
+  // Jump instructions and the source index of the bytecode they target.
+  std::vector<std::pair<int64_t, int64_t>> jumps;
+  int64_t pc = 0;
+  while (pc < bytecodes.size()) {
+    const Bytecode& bytecode = bytecodes[pc];
+    lowered->pc_to_instruction_[pc] = instructions.size();
+    if (bytecode.op() == Bytecode::Op::kJumpDest) {
+      // Jumps to this bytecode land on the next instruction.
+      ++pc;
+      continue;
+    }
+    if (fuse) {
+      absl::optional<Instruction> fused = Fuse(bytecodes.subspan(pc), pc);
+      if (fused.has_value()) {
+        instructions.push_back(*fused);
+        pc += fused->length;
+        continue;
+      }
+    }
+
+    Instruction instruction{.op = LoweredOp::kGeneric, .pc = pc, .length = 1};
+    switch (bytecode.op()) {
+      case Bytecode::Op::kLoad:
+        if (absl::optional<int64_t> slot = LoadSlot(bytecode)) {
+          instruction.op = LoweredOp::kLoad;
+          instruction.a = *slot;
+        }
+        break;
+      case Bytecode::Op::kStore:
+        if (absl::optional<int64_t> slot = StoreSlot(bytecode)) {
+          instruction.op = LoweredOp::kStore;
+          instruction.a = *slot;
+        }
+        break;
+      case Bytecode::Op::kLiteral:
+        if (const InterpValue* literal = LiteralValue(bytecode)) {
+          instruction.op = LoweredOp::kLiteral;
+          instruction.literal = literal;
+        }
+        break;
+      case Bytecode::Op::kDup:
+        instruction.op = LoweredOp::kDup;
+        break;
+      case Bytecode::Op::kPop:
+        instruction.op = LoweredOp::kPop;
+        break;
+      case Bytecode::Op::kSwap:
+        instruction.op = LoweredOp::kSwap;
+        break;
+      case Bytecode::Op::kJumpRel:
+      case Bytecode::Op::kJumpRelIf: {
+        XLS_ASSIGN_OR_RETURN(Bytecode::JumpTarget target,
+                             bytecode.jump_target());
+        instruction.op = bytecode.op() == Bytecode::Op::kJumpRel
+                             ? LoweredOp::kJump
+                             : LoweredOp::kJumpIf;
+        jumps.push_back({instructions.size(), pc + target.value()});
+        break;
+      }
+      default:
+        if (BinopFn binop = GetBinop(bytecode.op())) {
+          instruction.op = LoweredOp::kBinop;
+          instruction.binop = binop;
+        }
+        break;
+    }
+    instructions.push_back(instruction);
+    ++pc;
+  }
+  lowered->pc_to_instruction_[bytecodes.size()] = instructions.size();
+  instructions.push_back(
+      Instruction{.op = LoweredOp::kEnd, .pc = pc, .length = 0});
+
+  for (const auto& [index, target_pc] : jumps) {
+    XLS_RET_CHECK(target_pc >= 0 && target_pc < bytecodes.size() &&
+                  bytecodes[target_pc].op() == Bytecode::Op::kJumpDest)
+        << "Jump at PC " << instructions[index].pc << " to PC " << target_pc
+        << " does not land on a jump_dest.";
+    instructions[index].a = lowered->pc_to_instruction_[target_pc];
+  }
+  return lowered;
+}
+
+std::string LoweredBytecodeFunction::ToString() const {
+  absl::Span<const Bytecode> bytecodes = source_->bytecodes();
+  std::vector<std::string> lines;
+  for (int64_t i = 0; i < instructions_.size(); ++i) {
+    const Instruction& instruction = instructions_[i];
+    std::string line =
+        absl::StrFormat("%03d %s", i, LoweredOpToString(instruction.op));
+    switch (instruction.op) {
+      case LoweredOp::kGeneric:
+        absl::StrAppend(&line, " ",
+                        bytecodes[instruction.pc].ToString(
+                            /*source_locs=*/false));
+        break;
+      case LoweredOp::kLoad:
+      case LoweredOp::kStore:
+      case LoweredOp::kJump:
+      case LoweredOp::kJumpIf:
+        absl::StrAppend(&line, " ", instruction.a);
+        break;
+      case LoweredOp::kLoadLoad:
+      case LoweredOp::kStoreLoad:
+        absl::StrAppend(&line, " ", instruction.a, " ", instruction.b);
+        break;
+      case LoweredOp::kLoadLiteral:
+        absl::StrAppend(&line, " ", instruction.a, " ",
+                        instruction.literal->ToString());
+        break;
+      case LoweredOp::kLiteral:
+        absl::StrAppend(&line, " ", instruction.literal->ToString());
+        break;
+      default:
+        break;
+    }
+    if (instruction.binop != nullptr) {
+      // The binary operation is always the last bytecode of the instruction.
+      const Bytecode& binop =
+          bytecodes[instruction.pc + instruction.length - 1];
+      switch (instruction.op) {
+        case LoweredOp::kBinopLoad:
+          absl::StrAppend(&line, " ", OpToString(binop.op()), " ",
+                          instruction.a);
+          break;
+        case LoweredOp::kBinopLiteral:
+          absl::StrAppend(&line, " ", OpToString(binop.op()), " ",
+                          instruction.literal->ToString());
+          break;
+        case LoweredOp::kLoadBinopLoad:
+          absl::StrAppend(&line, " ", instruction.a, " ",
+                          OpToString(binop.op()), " ", instruction.b);
+          break;
+        case LoweredOp::kLoadBinopLiteral:
+          absl::StrAppend(&line, " ", instruction.a, " ",
+                          OpToString(binop.op()), " ",
+                          instruction.literal->ToString());
+          break;
+        default:
+          absl::StrAppend(&line, " ", OpToString(binop.op()));
+          break;
+      }
+    }
+    lines.push_back(line);
+  }
+  return absl::StrJoin(lines, "\n");
+}
+
+std::string LoweredOpToString(LoweredBytecodeFunction::Op op) {
+  switch (op) {
+    case LoweredOp::kGeneric:
+      return "generic";
+    case LoweredOp::kLoad:
+      return "load";
+    case LoweredOp::kStore:
+      return "store";
+    case LoweredOp::kLiteral:
+      return "literal";
+    case LoweredOp::kDup:
+      return "dup";
+    case LoweredOp::kPop:
+      return "pop";
+    case LoweredOp::kSwap:
+      return "swap";
+    case LoweredOp::kJump:
+      return "jump";
+    case LoweredOp::kJumpIf:
+      return "jump_if";
+    case LoweredOp::kBinop:
+      return "binop";
+    case LoweredOp::kLoadLoad:
+      return "load_load";
+    case LoweredOp::kLoadLiteral:
+      return "load_literal";
+    case LoweredOp::kStoreLoad:
+      return "store_load";
+    case LoweredOp::kBinopLoad:
+      return "binop_load";
+    case LoweredOp::kBinopLiteral:
+      return "binop_literal";
+    case LoweredOp::kLoadBinopLoad:
+      return "load_binop_load";
+    case LoweredOp::kLoadBinopLiteral:
+      return "load_binop_literal";
+    case LoweredOp::kEnd:
+      return "end";
+  }
+  return absl::StrCat("<invalid: ", static_cast<int>(op), ">");
+}
+
+}  // namespace xls::dslx
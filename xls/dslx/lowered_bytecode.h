@@ -0,0 +1,143 @@
+// Copyright 2022 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_DSLX_LOWERED_BYTECODE_H_
+#define XLS_DSLX_LOWERED_BYTECODE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "xls/dslx/bytecode.h"
+#include "xls/dslx/interp_value.h"
+
+namespace xls::dslx {
+
+// A BytecodeFunction lowered into a form that is cheaper to execute than its
+// Bytecodes:
+//  - operands are pre-resolved: slot indices are plain integers, literals are
+//    pointers to the InterpValues held by the source Bytecodes, jump targets
+//    are absolute instruction indices, and binary operations carry a pointer
+//    to their implementation, so no Bytecode::Data variant is inspected at
+//    run time;
+//  - kJumpDest markers are dropped (jump targets are checked when lowering);
+//  - common Load/Literal/binary-op sequences are fused into
+//    superinstructions, some of which operate directly on the frame's slots
+//    without going through the value stack.
+// Bytecodes without a lowered equivalent (calls, casts, matches, ...) are
+// lowered to kGeneric instructions, which the interpreter executes with its
+// regular per-Bytecode handlers.
+class LoweredBytecodeFunction {
+ public:
+  // In these descriptions, "slot A" and "slot B" are the slots given by the
+  // instruction's `a` and `b` operands, `binop` is the instruction's binary
+  // operation and `literal` its literal operand.
+  enum class Op : uint8_t {
+    // Executes the source Bytecode with the interpreter's generic handler.
+    kGeneric,
+    // Pushes slot A.
+    kLoad,
+    // Pops TOS0 into slot A.
+    kStore,
+    // Pushes the literal.
+    kLiteral,
+    // Duplicates TOS0.
+    kDup,
+    // Pops TOS0.
+    kPop,
+    // Swaps TOS0 and TOS1.
+    kSwap,
+    // Jumps to instruction A.
+    kJump,
+    // Pops TOS0 and jumps to instruction A if it is true.
+    kJumpIf,
+    // Replaces TOS1 and TOS0 with `TOS1 binop TOS0`.
+    kBinop,
+    // Pushes slot A, then slot B.
+    kLoadLoad,
+    // Pushes slot A, then the literal.
+    kLoadLiteral,
+    // Pops TOS0 into slot A, then pushes slot B.
+    kStoreLoad,
+    // Replaces TOS0 with `TOS0 binop slot A`.
+    kBinopLoad,
+    // Replaces TOS0 with `TOS0 binop literal`.
+    kBinopLiteral,
+    // Pushes `slot A binop slot B`.
+    kLoadBinopLoad,
+    // Pushes `slot A binop literal`.
+    kLoadBinopLiteral,
+    // Marks the end of the function.
+    kEnd,
+  };
+
+  using BinopFn = absl::StatusOr<InterpValue> (*)(const InterpValue& lhs,
+                                                  const InterpValue& rhs);
+
+  struct Instruction {
+    Op op;
+    int64_t a = 0;
+    int64_t b = 0;
+    const InterpValue* literal = nullptr;
+    BinopFn binop = nullptr;
+    // Index of the first source Bytecode implemented by this instruction and
+    // the number of source Bytecodes it implements.
+    int64_t pc;
+    int64_t length;
+  };
+
+  // Lowers the given function. If `fuse` is false, no superinstructions are
+  // formed. Returns an error if the bytecode is malformed in a way that is
+  // only detected at execution time by the Bytecode-at-a-time interpreter,
+  // e.g. a jump which doesn't land on a kJumpDest.
+  static absl::StatusOr<std::unique_ptr<LoweredBytecodeFunction>> Lower(
+      const BytecodeFunction* source, bool fuse = true);
+
+  // Returns the implementation of the given binary Bytecode op, or nullptr if
+  // the op is not a binary operation. These implementations are also used by
+  // the Bytecode-at-a-time interpreter, so both forms agree.
+  static BinopFn GetBinop(Bytecode::Op op);
+
+  const BytecodeFunction* source() const { return source_; }
+
+  // The lowered instructions. The last instruction is always kEnd.
+  absl::Span<const Instruction> instructions() const { return instructions_; }
+
+  // Returns the index of the instruction which starts at the given source
+  // Bytecode index, or -1 if no instruction starts there (e.g. the index is
+  // in the middle of a superinstruction). The index one past the last
+  // Bytecode maps to the kEnd instruction.
+  int64_t InstructionIndexAt(int64_t pc) const {
+    return pc_to_instruction_.at(pc);
+  }
+
+  std::string ToString() const;
+
+ private:
+  explicit LoweredBytecodeFunction(const BytecodeFunction* source)
+      : source_(source) {}
+
+  const BytecodeFunction* source_;
+  std::vector<Instruction> instructions_;
+  std::vector<int64_t> pc_to_instruction_;
+};
+
+std::string LoweredOpToString(LoweredBytecodeFunction::Op op);
+
+}  // namespace xls::dslx
+
+#endif  // XLS_DSLX_LOWERED_BYTECODE_H_
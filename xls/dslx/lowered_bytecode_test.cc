@@ -0,0 +1,193 @@
+// Copyright 2022 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/dslx/lowered_bytecode.h"
+
+#include <memory>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "xls/common/status/matchers.h"
+#include "xls/dslx/bytecode.h"
+#include "xls/dslx/bytecode_interpreter.h"
+#include "xls/dslx/interp_value.h"
+
+namespace xls::dslx {
+namespace {
+
+using status_testing::IsOkAndHolds;
+using status_testing::StatusIs;
+using testing::HasSubstr;
+
+class LoweredBytecodeTest : public ::testing::Test {
+ protected:
+  void Add(Bytecode::Op op) { bytecodes_.emplace_back(Span::Fake(), op); }
+  void AddLiteral(InterpValue value) {
+    bytecodes_.emplace_back(Span::Fake(), Bytecode::Op::kLiteral,
+                            std::move(value));
+  }
+  void AddSlotOp(Bytecode::Op op, int64_t slot) {
+    bytecodes_.emplace_back(Span::Fake(), op, Bytecode::SlotIndex(slot));
+  }
+  void AddJump(Bytecode::Op op, int64_t target) {
+    bytecodes_.emplace_back(Span::Fake(), op, Bytecode::JumpTarget(target));
+  }
+
+  absl::StatusOr<std::unique_ptr<BytecodeFunction>> Build() {
+    return BytecodeFunction::Create(/*owner=*/nullptr, /*type_info=*/nullptr,
+                                    std::move(bytecodes_));
+  }
+
+  // Interprets the function with both dispatch modes and checks that they
+  // agree.
+  absl::StatusOr<InterpValue> Interpret(BytecodeFunction* bf,
+                                        std::vector<InterpValue> args) {
+    XLS_ASSIGN_OR_RETURN(InterpValue expected,
+                         BytecodeInterpreter::Interpret(
+                             /*import_data=*/nullptr, bf, args,
+                             BytecodeInterpreter::Dispatch::kBytecode));
+    XLS_ASSIGN_OR_RETURN(InterpValue actual,
+                         BytecodeInterpreter::Interpret(
+                             /*import_data=*/nullptr, bf, args,
+                             BytecodeInterpreter::Dispatch::kLowered));
+    EXPECT_EQ(actual, expected);
+    return actual;
+  }
+
+  std::vector<Bytecode> bytecodes_;
+};
+
+TEST_F(LoweredBytecodeTest, FusesLoadsLiteralsAndBinops) {
+  // x * y + (x - 1) + 3
+  AddSlotOp(Bytecode::Op::kLoad, 0);
+  AddSlotOp(Bytecode::Op::kLoad, 1);
+  Add(Bytecode::Op::kMul);
+  AddSlotOp(Bytecode::Op::kLoad, 0);
+  AddLiteral(InterpValue::MakeU32(1));
+  Add(Bytecode::Op::kSub);
+  Add(Bytecode::Op::kAdd);
+  AddLiteral(InterpValue::MakeU32(3));
+  Add(Bytecode::Op::kAdd);
+  AddSlotOp(Bytecode::Op::kStore, 2);
+  AddSlotOp(Bytecode::Op::kLoad, 2);
+  AddSlotOp(Bytecode::Op::kLoad, 1);
+  Add(Bytecode::Op::kXor);
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<BytecodeFunction> bf, Build());
+
+  const LoweredBytecodeFunction* lowered = bf->lowered();
+  ASSERT_NE(lowered, nullptr);
+  EXPECT_EQ(lowered->ToString(),
+            R"(000 load_binop_load 0 mul 1
+001 load_binop_literal 0 sub u32:1
+002 binop add
+003 binop_literal add u32:3
+004 store_load 2 2
+005 binop_load xor 1
+006 end)");
+  EXPECT_EQ(lowered->InstructionIndexAt(0), 0);
+  EXPECT_EQ(lowered->InstructionIndexAt(1), -1);
+  EXPECT_EQ(lowered->InstructionIndexAt(3), 1);
+  EXPECT_EQ(lowered->InstructionIndexAt(13), 6);
+
+  EXPECT_THAT(
+      Interpret(bf.get(), {InterpValue::MakeU32(6), InterpValue::MakeU32(7)}),
+      IsOkAndHolds(InterpValue::MakeU32((6 * 7 + 5 + 3) ^ 7)));
+}
+
+TEST_F(LoweredBytecodeTest, WithoutFusion) {
+  AddSlotOp(Bytecode::Op::kLoad, 0);
+  AddLiteral(InterpValue::MakeU32(1));
+  Add(Bytecode::Op::kShl);
+  Add(Bytecode::Op::kDup);
+  Add(Bytecode::Op::kSwap);
+  Add(Bytecode::Op::kPop);
+  Add(Bytecode::Op::kInvert);
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<BytecodeFunction> bf, Build());
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<LoweredBytecodeFunction> lowered,
+      LoweredBytecodeFunction::Lower(bf.get(), /*fuse=*/false));
+  EXPECT_EQ(lowered->ToString(),
+            R"(000 load 0
+001 literal u32:1
+002 binop shl
+003 dup
+004 swap
+005 pop
+006 generic invert
+007 end)");
+  EXPECT_THAT(Interpret(bf.get(), {InterpValue::MakeU32(5)}),
+              IsOkAndHolds(InterpValue::MakeU32(~uint32_t{10})));
+}
+
+TEST_F(LoweredBytecodeTest, ResolvesJumpTargets) {
+  // if slot 0 { 8 } else { 7 }
+  AddSlotOp(Bytecode::Op::kLoad, 0);
+  AddJump(Bytecode::Op::kJumpRelIf, 3);
+  AddLiteral(InterpValue::MakeU32(7));
+  AddJump(Bytecode::Op::kJumpRel, 3);
+  Add(Bytecode::Op::kJumpDest);
+  AddLiteral(InterpValue::MakeU32(8));
+  Add(Bytecode::Op::kJumpDest);
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<BytecodeFunction> bf, Build());
+
+  const LoweredBytecodeFunction* lowered = bf->lowered();
+  ASSERT_NE(lowered, nullptr);
+  EXPECT_EQ(lowered->ToString(),
+            R"(000 load 0
+001 jump_if 4
+002 literal u32:7
+003 jump 5
+004 literal u32:8
+005 end)");
+  EXPECT_THAT(Interpret(bf.get(), {InterpValue::MakeBool(true)}),
+              IsOkAndHolds(InterpValue::MakeU32(8)));
+  EXPECT_THAT(Interpret(bf.get(), {InterpValue::MakeBool(false)}),
+              IsOkAndHolds(InterpValue::MakeU32(7)));
+}
+
+TEST_F(LoweredBytecodeTest, JumpMustLandOnJumpDest) {
+  AddLiteral(InterpValue::MakeBool(true));
+  AddJump(Bytecode::Op::kJumpRelIf, 2);
+  AddLiteral(InterpValue::MakeU32(7));
+  AddLiteral(InterpValue::MakeU32(8));
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<BytecodeFunction> bf, Build());
+
+  EXPECT_THAT(LoweredBytecodeFunction::Lower(bf.get()),
+              StatusIs(absl::StatusCode::kInternal,
+                       HasSubstr("does not land on a jump_dest")));
+  // Such functions are still run, one Bytecode at a time.
+  EXPECT_EQ(bf->lowered(), nullptr);
+  EXPECT_THAT(BytecodeInterpreter::Interpret(/*import_data=*/nullptr, bf.get(),
+                                             /*args=*/{}),
+              StatusIs(absl::StatusCode::kInternal, HasSubstr("jump_dest")));
+}
+
+TEST_F(LoweredBytecodeTest, MalformedOperandsAreExecutedGenerically) {
+  // A literal without a value is left to the generic handler, which reports
+  // the error when (and if) it's executed.
+  Add(Bytecode::Op::kLiteral);
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<BytecodeFunction> bf, Build());
+
+  const LoweredBytecodeFunction* lowered = bf->lowered();
+  ASSERT_NE(lowered, nullptr);
+  EXPECT_EQ(lowered->instructions().front().op,
+            LoweredBytecodeFunction::Op::kGeneric);
+  EXPECT_THAT(BytecodeInterpreter::Interpret(/*import_data=*/nullptr, bf.get(),
+                                             /*args=*/{}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace xls::dslx
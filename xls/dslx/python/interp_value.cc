@@ -56,7 +56,8 @@ struct InterpValuePickler {
     } else {
       const auto& values = std::get<2>(state);
       XLS_CHECK(values.has_value());
-      payload = values.value();
+      return InterpValue(static_cast<InterpValueTag>(std::get<0>(state)),
+                         values.value());
     }
     return InterpValue(static_cast<InterpValueTag>(std::get<0>(state)),
                        payload);
@@ -14,8 +14,12 @@
 
 #include "xls/dslx/run_routines.h"
 
+#include <atomic>
+#include <memory>
 #include <random>
 
+#include "absl/memory/memory.h"
+
 #include "xls/dslx/bindings.h"
 #include "xls/dslx/bytecode_cache.h"
 #include "xls/dslx/bytecode_emitter.h"
@@ -27,8 +31,8 @@
 #include "xls/dslx/mangle.h"
 #include "xls/dslx/parse_and_typecheck.h"
 #include "xls/dslx/typecheck.h"
+#include "xls/common/thread_pool.h"
 #include "xls/interpreter/function_interpreter.h"
-#include "xls/interpreter/random_value.h"
 
 namespace xls::dslx {
 namespace {
@@ -38,22 +42,47 @@ constexpr int kUnitSpaces = 7;
 constexpr int kQuickcheckSpaces = 15;
 }  // namespace
 
+absl::StatusOr<RunComparator::CachedJit*>
+RunComparator::GetOrCompileCachedJit(std::string ir_name,
+                                     xls::Function* ir_function) {
+  {
+    absl::MutexLock lock(&mutex_);
+    auto it = jit_cache_.find(ir_name);
+    if (it != jit_cache_.end()) {
+      return it->second.get();
+    }
+  }
+  auto cached = std::make_unique<CachedJit>();
+  XLS_ASSIGN_OR_RETURN(cached->jit, IrJit::Create(ir_function));
+  absl::MutexLock lock(&mutex_);
+  // If another thread compiled the same function in the meantime, keep the
+  // first one so previously returned pointers stay valid.
+  auto [it, inserted] =
+      jit_cache_.emplace(std::move(ir_name), std::move(cached));
+  return it->second.get();
+}
+
 absl::StatusOr<IrJit*> RunComparator::GetOrCompileJitFunction(
     std::string ir_name, xls::Function* ir_function) {
-  auto it = jit_cache_.find(ir_name);
-  if (it != jit_cache_.end()) {
-    return it->second.get();
+  XLS_ASSIGN_OR_RETURN(CachedJit * cached,
+                       GetOrCompileCachedJit(std::move(ir_name), ir_function));
+  return cached->jit.get();
+}
+
+void RunComparator::EnableDeferredComparison(int64_t batch_size,
+                                             bool background) {
+  XLS_CHECK_GT(batch_size, 0);
+  batch_size_ = batch_size;
+  if (background) {
+    // A single thread, so batches are checked in the order they were recorded.
+    background_ = std::make_unique<ThreadPool>(/*thread_count=*/1);
   }
-  XLS_ASSIGN_OR_RETURN(std::unique_ptr<IrJit> jit, IrJit::Create(ir_function));
-  IrJit* result = jit.get();
-  jit_cache_[ir_name] = std::move(jit);
-  return result;
 }
 
-absl::Status RunComparator::RunComparison(
-    Package* ir_package, bool requires_implicit_token, dslx::Function* f,
-    absl::Span<InterpValue const> args,
-    const SymbolicBindings* symbolic_bindings, const InterpValue& got) {
+/* static */ absl::StatusOr<std::pair<std::string, xls::Function*>>
+RunComparator::GetIrFunction(Package* ir_package, bool requires_implicit_token,
+                             dslx::Function* f,
+                             const SymbolicBindings* symbolic_bindings) {
   XLS_RET_CHECK(ir_package != nullptr);
 
   XLS_ASSIGN_OR_RETURN(
@@ -73,11 +102,122 @@ absl::Status RunComparator::RunComparison(
   if (!get_result.ok()) {
     XLS_LOG(WARNING) << "Could not find " << ir_name
                      << " function for JIT comparison";
+    return std::make_pair(std::move(ir_name), nullptr);
+  }
+  return std::make_pair(std::move(ir_name), get_result.value());
+}
+
+absl::Status RunComparator::RunComparison(
+    Package* ir_package, bool requires_implicit_token, dslx::Function* f,
+    absl::Span<InterpValue const> args,
+    const SymbolicBindings* symbolic_bindings, const InterpValue& got,
+    const absl::optional<Span>& call_site) {
+  if (batch_size_ > 0) {
+    std::vector<RecordedCall> batch;
+    {
+      absl::MutexLock lock(&deferred_mutex_);
+      pending_.push_back(RecordedCall{
+          ir_package, requires_implicit_token, f,
+          std::vector<InterpValue>(args.begin(), args.end()),
+          symbolic_bindings == nullptr
+              ? absl::nullopt
+              : absl::make_optional(*symbolic_bindings),
+          got, call_site});
+      if (static_cast<int64_t>(pending_.size()) < batch_size_) {
+        return absl::OkStatus();
+      }
+      batch.swap(pending_);
+    }
+    auto compare = [this, batch = std::move(batch)]() mutable {
+      absl::Status status = CompareBatch(std::move(batch));
+      absl::MutexLock lock(&deferred_mutex_);
+      deferred_status_.Update(status);
+    };
+    if (background_ != nullptr) {
+      background_->Schedule(std::move(compare));
+    } else {
+      compare();
+    }
     return absl::OkStatus();
   }
 
-  xls::Function* ir_function = get_result.value();
+  XLS_ASSIGN_OR_RETURN(auto ir_function,
+                       GetIrFunction(ir_package, requires_implicit_token, f,
+                                     symbolic_bindings));
+  if (ir_function.second == nullptr) {
+    return absl::OkStatus();
+  }
+  return CompareWithIr(ir_function.first, ir_function.second,
+                       requires_implicit_token, args, got);
+}
 
+absl::Status RunComparator::CompareBatch(std::vector<RecordedCall> batch) {
+  // Resolve each distinct IR function once per batch.
+  absl::flat_hash_map<std::pair<Function*, std::string>,
+                      std::pair<std::string, xls::Function*>>
+      ir_functions;
+  for (const RecordedCall& call : batch) {
+    const SymbolicBindings* symbolic_bindings =
+        call.symbolic_bindings.has_value() ? &call.symbolic_bindings.value()
+                                           : nullptr;
+    auto key = std::make_pair(
+        call.f, absl::StrCat(call.requires_implicit_token, ":",
+                             symbolic_bindings == nullptr
+                                 ? ""
+                                 : symbolic_bindings->ToString()));
+    auto it = ir_functions.find(key);
+    if (it == ir_functions.end()) {
+      XLS_ASSIGN_OR_RETURN(
+          auto ir_function,
+          GetIrFunction(call.ir_package, call.requires_implicit_token, call.f,
+                        symbolic_bindings));
+      it = ir_functions.emplace(std::move(key), std::move(ir_function)).first;
+    }
+    const auto& [ir_name, ir_function] = it->second;
+    if (ir_function == nullptr) {
+      continue;
+    }
+    absl::Status status =
+        CompareWithIr(ir_name, ir_function, call.requires_implicit_token,
+                      call.args, call.got);
+    if (!status.ok()) {
+      if (!call.call_site.has_value()) {
+        return status;
+      }
+      // Report the mismatch as a positional error at the call site, since the
+      // interpreter has moved on by now.
+      return absl::Status(
+          status.code(),
+          absl::StrFormat("ComparisonError: %s %s",
+                          call.call_site->ToString(), status.message()));
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status RunComparator::Flush() {
+  std::vector<RecordedCall> batch;
+  {
+    absl::MutexLock lock(&deferred_mutex_);
+    batch.swap(pending_);
+  }
+  if (background_ != nullptr) {
+    // Earlier batches go first, so the first mismatch recorded is reported.
+    background_->WaitForIdle();
+  }
+  absl::Status status = CompareBatch(std::move(batch));
+  absl::MutexLock lock(&deferred_mutex_);
+  deferred_status_.Update(status);
+  absl::Status result = deferred_status_;
+  deferred_status_ = absl::OkStatus();
+  return result;
+}
+
+absl::Status RunComparator::CompareWithIr(const std::string& ir_name,
+                                          xls::Function* ir_function,
+                                          bool requires_implicit_token,
+                                          absl::Span<InterpValue const> args,
+                                          const InterpValue& got) {
   XLS_ASSIGN_OR_RETURN(std::vector<Value> ir_args,
                        InterpValue::ConvertValuesToIr(args));
 
@@ -94,9 +234,12 @@ absl::Status RunComparator::RunComparison(
     case CompareMode::kJit: {
       // TODO(https://github.com/google/xls/issues/506): Also compare events
       // once the DSLX interpreter supports them (and the JIT supports traces).
-      XLS_ASSIGN_OR_RETURN(IrJit * jit,
-                           GetOrCompileJitFunction(ir_name, ir_function));
-      XLS_ASSIGN_OR_RETURN(ir_result, DropInterpreterEvents(jit->Run(ir_args)));
+      XLS_ASSIGN_OR_RETURN(CachedJit * cached,
+                           GetOrCompileCachedJit(ir_name, ir_function));
+      // Only runs of the same function contend; see CachedJit.
+      absl::MutexLock lock(&cached->run_mutex);
+      XLS_ASSIGN_OR_RETURN(ir_result,
+                           DropInterpreterEvents(cached->jit->Run(ir_args)));
       mode_str = "JIT";
       break;
     }
@@ -142,41 +285,128 @@ static bool TestMatchesFilter(absl::string_view test_name,
   return test_name == *test_filter;
 }
 
+// Fills the given leaves of a JIT buffer with uniformly distributed random
+// bits, leaving the bits above each leaf's width zero as LLVM requires.
+static void FillRandomBits(absl::Span<const BufferBitsSegment> segments,
+                           std::minstd_rand* engine, uint8_t* buffer) {
+  std::uniform_int_distribution<int32_t> generator(0, 255);
+  for (const BufferBitsSegment& segment : segments) {
+    int64_t byte_count = (segment.bit_count + 7) / 8;
+    for (int64_t i = 0; i < byte_count; ++i) {
+      buffer[segment.byte_offset + i] =
+          static_cast<uint8_t>(generator(*engine));
+    }
+    if (int64_t remainder_bits = segment.bit_count % 8; remainder_bits != 0) {
+      buffer[segment.msb_byte_offset] &=
+          static_cast<uint8_t>((1 << remainder_bits) - 1);
+    }
+  }
+}
+
 absl::StatusOr<QuickCheckResults> DoQuickCheck(xls::Function* xls_function,
                                                std::string ir_name,
                                                RunComparator* run_comparator,
-                                               int64_t seed,
-                                               int64_t num_tests) {
+                                               int64_t seed, int64_t num_tests,
+                                               int64_t thread_count) {
   XLS_ASSIGN_OR_RETURN(IrJit * jit, run_comparator->GetOrCompileJitFunction(
                                         std::move(ir_name), xls_function));
+  Type* return_type = xls_function->return_value()->GetType();
+  XLS_RET_CHECK(return_type->IsBits() &&
+                return_type->AsBitsOrDie()->bit_count() == 1)
+      << "QuickCheck predicate must return bits[1]; got "
+      << return_type->ToString();
+
+  // The buffer layouts are computed up front: the JIT's type conversion
+  // caches must not be touched from the shard threads.
+  absl::Span<xls::Param* const> params = xls_function->params();
+  std::vector<std::vector<BufferBitsSegment>> param_segments;
+  for (xls::Param* param : params) {
+    param_segments.push_back(
+        jit->runtime()->GetBitsSegments(param->GetType()));
+  }
+
+  // Index of the lowest falsifying sample found so far (num_tests if none).
+  std::atomic<int64_t> first_falsifying(num_tests);
+  // A falsifying sample, kept as raw buffer contents; they are converted to
+  // Values on this thread.
+  struct ShardResult {
+    int64_t index;
+    std::vector<std::vector<uint8_t>> arg_bytes;
+  };
+  std::vector<absl::optional<ShardResult>> shard_results(kQuickCheckShards);
+  XLS_RETURN_IF_ERROR(ParallelFor(
+      kQuickCheckShards, thread_count, [&](int64_t shard) -> absl::Status {
+        std::seed_seq seed_seq{static_cast<uint32_t>(seed),
+                               static_cast<uint32_t>(seed >> 32),
+                               static_cast<uint32_t>(shard)};
+        std::minstd_rand engine(seed_seq);
+        std::vector<std::unique_ptr<uint8_t[]>> arg_storage;
+        std::vector<uint8_t*> arg_buffers;
+        for (int64_t i = 0; i < params.size(); ++i) {
+          arg_storage.push_back(
+              std::make_unique<uint8_t[]>(jit->GetArgTypeSize(i)));
+          arg_buffers.push_back(arg_storage.back().get());
+        }
+        std::vector<uint8_t> result_buffer(jit->GetReturnTypeSize());
+        for (int64_t index = shard; index < num_tests;
+             index += kQuickCheckShards) {
+          if (index > first_falsifying.load(std::memory_order_relaxed)) {
+            break;
+          }
+          for (int64_t i = 0; i < params.size(); ++i) {
+            FillRandomBits(param_segments[i], &engine, arg_buffers[i]);
+          }
+          // TODO(https://github.com/google/xls/issues/506): 2021-10-15
+          // Assertion failures should work out, but we should consciously
+          // decide if/how we want to dump traces when running QuickChecks
+          // (always, for failures, flag-controlled, ...).
+          XLS_RETURN_IF_ERROR(jit->RunWithViews(
+              absl::MakeSpan(arg_buffers), absl::MakeSpan(result_buffer)));
+          if ((result_buffer[0] & 1) != 0) {
+            continue;
+          }
+          // We were able to falsify the xls_function (predicate); keep this
+          // evidence and stop the shard, since later samples can't be first.
+          ShardResult result{.index = index};
+          for (int64_t i = 0; i < params.size(); ++i) {
+            result.arg_bytes.emplace_back(
+                arg_buffers[i], arg_buffers[i] + jit->GetArgTypeSize(i));
+          }
+          shard_results[shard] = std::move(result);
+          int64_t current = first_falsifying.load();
+          while (index < current &&
+                 !first_falsifying.compare_exchange_weak(current, index)) {
+          }
+          break;
+        }
+        return absl::OkStatus();
+      }));
 
   QuickCheckResults results;
-  std::minstd_rand rng_engine(seed);
-
-  for (int i = 0; i < num_tests; i++) {
-    results.arg_sets.push_back(
-        RandomFunctionArguments(xls_function, &rng_engine));
-    // TODO(https://github.com/google/xls/issues/506): 2021-10-15
-    // Assertion failures should work out, but we should consciously decide
-    // if/how we want to dump traces when running QuickChecks (always, for
-    // failures, flag-controlled, ...).
-    XLS_ASSIGN_OR_RETURN(
-        xls::Value result,
-        DropInterpreterEvents(jit->Run(results.arg_sets.back())));
-    results.results.push_back(result);
-    if (result.IsAllZeros()) {
-      // We were able to falsify the xls_function (predicate), bail out early
-      // and present this evidence.
-      break;
+  results.test_count = num_tests;
+  const ShardResult* first = nullptr;
+  for (const absl::optional<ShardResult>& shard_result : shard_results) {
+    if (shard_result.has_value() &&
+        (first == nullptr || shard_result->index < first->index)) {
+      first = &shard_result.value();
     }
   }
-
+  if (first != nullptr) {
+    results.test_count = first->index + 1;
+    std::vector<Value> args;
+    for (int64_t i = 0; i < params.size(); ++i) {
+      args.push_back(jit->runtime()->UnpackBuffer(first->arg_bytes[i].data(),
+                                                  params[i]->GetType()));
+    }
+    results.falsifying_args = std::move(args);
+  }
   return results;
 }
 
 static absl::Status RunQuickCheck(RunComparator* run_comparator,
                                   Package* ir_package, QuickCheck* quickcheck,
-                                  TypeInfo* type_info, int64_t seed) {
+                                  TypeInfo* type_info, int64_t seed,
+                                  int64_t thread_count) {
   Function* fn = quickcheck->f();
   XLS_ASSIGN_OR_RETURN(std::string ir_name,
                        MangleDslxName(fn->owner()->name(), fn->identifier(),
@@ -188,15 +418,13 @@ static absl::Status RunQuickCheck(RunComparator* run_comparator,
   XLS_ASSIGN_OR_RETURN(
       QuickCheckResults qc_results,
       DoQuickCheck(ir_function, std::move(ir_name), run_comparator, seed,
-                   quickcheck->test_count()));
-  const auto& [arg_sets, results] = qc_results;
-  XLS_ASSIGN_OR_RETURN(Bits last_result, results.back().GetBitsWithStatus());
-  if (!last_result.IsZero()) {
+                   quickcheck->test_count(), thread_count));
+  if (!qc_results.falsifying_args.has_value()) {
     // Did not find a falsifying example.
     return absl::OkStatus();
   }
 
-  const std::vector<Value>& last_argset = arg_sets.back();
+  const std::vector<Value>& last_argset = *qc_results.falsifying_args;
   XLS_ASSIGN_OR_RETURN(FunctionType * fn_type,
                        type_info->GetItemAs<FunctionType>(fn));
   const std::vector<std::unique_ptr<ConcreteType>>& params = fn_type->params();
@@ -216,7 +444,7 @@ static absl::Status RunQuickCheck(RunComparator* run_comparator,
   return FailureErrorStatus(
       fn->span(),
       absl::StrFormat("Found falsifying example after %d tests: [%s]",
-                      results.size(), dslx_argset_str));
+                      qc_results.test_count, dslx_argset_str));
 }
 
 using HandleError = const std::function<void(
@@ -224,7 +452,7 @@ using HandleError = const std::function<void(
 
 static absl::Status RunQuickChecksIfJitEnabled(
     Module* entry_module, TypeInfo* type_info, RunComparator* run_comparator,
-    Package* ir_package, absl::optional<int64_t> seed,
+    Package* ir_package, absl::optional<int64_t> seed, int64_t jobs,
     const HandleError& handle_error) {
   if (run_comparator == nullptr) {
     std::cerr << "[ SKIPPING QUICKCHECKS  ] (JIT is disabled)" << std::endl;
@@ -238,12 +466,13 @@ static absl::Status RunQuickChecksIfJitEnabled(
   }
   std::cerr << absl::StreamFormat("[ SEED %*d ]", kQuickcheckSpaces + 1, *seed)
             << std::endl;
+  // Quickchecks run one at a time, each sharding its samples over all jobs.
   for (QuickCheck* quickcheck : entry_module->GetQuickChecks()) {
     const std::string& test_name = quickcheck->identifier();
     std::cerr << "[ RUN QUICKCHECK        ] " << test_name
               << " count: " << quickcheck->test_count() << std::endl;
-    absl::Status status =
-        RunQuickCheck(run_comparator, ir_package, quickcheck, type_info, *seed);
+    absl::Status status = RunQuickCheck(run_comparator, ir_package, quickcheck,
+                                        type_info, *seed, jobs);
     if (!status.ok()) {
       handle_error(status, test_name, /*is_quickcheck=*/true);
     } else {
@@ -257,6 +486,53 @@ static absl::Status RunQuickChecksIfJitEnabled(
   return absl::OkStatus();
 }
 
+namespace {
+
+// A test function compiled for native execution on the JIT.
+class JitTest {
+ public:
+  // Compiles the IR conversion of `f`, which must be in `ir_package`.
+  static absl::StatusOr<std::unique_ptr<JitTest>> Create(Function* f,
+                                                         TypeInfo* type_info,
+                                                         Package* ir_package) {
+    absl::optional<bool> requires_implicit_token =
+        type_info->GetRequiresImplicitToken(f);
+    XLS_RET_CHECK(requires_implicit_token.has_value());
+    XLS_ASSIGN_OR_RETURN(
+        std::string ir_name,
+        MangleDslxName(f->owner()->name(), f->identifier(),
+                       *requires_implicit_token
+                           ? CallingConvention::kImplicitToken
+                           : CallingConvention::kTypical));
+    XLS_ASSIGN_OR_RETURN(xls::Function * ir_function,
+                         ir_package->GetFunction(ir_name));
+    XLS_ASSIGN_OR_RETURN(std::unique_ptr<IrJit> jit,
+                         IrJit::Create(ir_function));
+    return absl::WrapUnique(
+        new JitTest(std::move(jit), *requires_implicit_token));
+  }
+
+  // Runs the test, returning an error if any of its assertions failed.
+  absl::Status Run() {
+    std::vector<Value> args;
+    if (requires_implicit_token_) {
+      args = {Value::Token(), Value::Bool(true)};
+    }
+    XLS_ASSIGN_OR_RETURN(InterpreterResult<Value> result, jit_->Run(args));
+    return InterpreterEventsToStatus(result.events);
+  }
+
+ private:
+  JitTest(std::unique_ptr<IrJit> jit, bool requires_implicit_token)
+      : jit_(std::move(jit)),
+        requires_implicit_token_(requires_implicit_token) {}
+
+  std::unique_ptr<IrJit> jit_;
+  bool requires_implicit_token_;
+};
+
+}  // namespace
+
 absl::StatusOr<TestResult> ParseAndTest(absl::string_view program,
                                         absl::string_view module_name,
                                         absl::string_view filename,
@@ -291,6 +567,7 @@ absl::StatusOr<TestResult> ParseAndTest(absl::string_view program,
 
   ImportData import_data(
       CreateImportData(options.stdlib_path, options.dslx_paths));
+  import_data.SetImportJobs(options.jobs);
   absl::StatusOr<TypecheckedModule> tm_or =
       ParseAndTypecheck(program, filename, module_name, &import_data);
   if (!tm_or.ok()) {
@@ -308,14 +585,18 @@ absl::StatusOr<TestResult> ParseAndTest(absl::string_view program,
   Module* entry_module = tm_or.value().module;
 
   // If JIT comparisons are "on", we register a post-evaluation hook to compare
-  // with the interpreter.
+  // with the interpreter. If tests execute on the JIT, the test bodies are
+  // converted as well; tests that fail to convert run in the interpreter.
   std::unique_ptr<Package> ir_package;
+  absl::flat_hash_map<std::string, absl::Status> test_conversion_errors;
   Interpreter::PostFnEvalHook post_fn_eval_hook;
-  if (options.run_comparator != nullptr) {
+  if (options.run_comparator != nullptr || options.execute_on_jit) {
+    ConvertOptions convert_options = options.convert_options;
+    convert_options.convert_tests = options.execute_on_jit;
     absl::StatusOr<std::unique_ptr<Package>> ir_package_or =
-        ConvertModuleToPackage(entry_module, &import_data,
-                               options.convert_options,
-                               /*traverse_tests=*/true);
+        ConvertModuleToPackage(entry_module, &import_data, convert_options,
+                               /*traverse_tests=*/true,
+                               &test_conversion_errors);
     if (!ir_package_or.ok()) {
       if (TryPrintError(ir_package_or.status())) {
         return TestResult::kSomeFailed;
@@ -323,10 +604,13 @@ absl::StatusOr<TestResult> ParseAndTest(absl::string_view program,
       return ir_package_or.status();
     }
     ir_package = std::move(ir_package_or).value();
+  }
+  if (options.run_comparator != nullptr) {
     post_fn_eval_hook = [&ir_package, &import_data, &options](
                             Function* f, absl::Span<const InterpValue> args,
                             const SymbolicBindings* symbolic_bindings,
-                            const InterpValue& got) -> absl::Status {
+                            const InterpValue& got,
+                            const Span& call_site) -> absl::Status {
       absl::optional<bool> requires_implicit_token =
           import_data.GetRootTypeInfoForNode(f)
               .value()
@@ -334,7 +618,7 @@ absl::StatusOr<TestResult> ParseAndTest(absl::string_view program,
       XLS_RET_CHECK(requires_implicit_token.has_value());
       return options.run_comparator->RunComparison(
           ir_package.get(), *requires_implicit_token, f, args,
-          symbolic_bindings, got);
+          symbolic_bindings, got, call_site);
     };
   }
 
@@ -342,48 +626,172 @@ absl::StatusOr<TestResult> ParseAndTest(absl::string_view program,
     return CheckModule(module, &import_data);
   };
 
-  Interpreter interpreter(entry_module, typecheck_callback, &import_data,
-                          options.run_concolic, options.trace_format_preference,
-                          post_fn_eval_hook);
-
-  // Run unit tests.
+  auto make_interpreter = [&]() {
+    return std::make_unique<Interpreter>(
+        entry_module, typecheck_callback, &import_data, options.run_concolic,
+        options.trace_format_preference, post_fn_eval_hook);
+  };
+  std::unique_ptr<Interpreter> interpreter = make_interpreter();
+
+  // Collect the unit tests to run, and for bytecode and JIT execution emit
+  // their entry functions up front: emission can fail for reasons that are not
+  // test failures, and the emitted functions are then shared by all workers.
+  std::vector<std::string> test_names;
+  std::vector<std::unique_ptr<BytecodeFunction>> test_bfs;
+  std::vector<std::unique_ptr<JitTest>> test_jits;
+  if (options.bytecode) {
+    import_data.SetBytecodeCache(std::make_unique<BytecodeCache>(&import_data));
+  }
   for (const std::string& test_name : entry_module->GetTestNames()) {
     if (!TestMatchesFilter(test_name, options.test_filter)) {
       skipped += 1;
       continue;
     }
-
-    ran += 1;
-    std::cerr << "[ RUN UNITTEST  ] " << test_name << std::endl;
-    absl::Status status;
+    ModuleMember* member = entry_module->FindMemberWithName(test_name).value();
+    if (!absl::holds_alternative<TestFunction*>(*member) &&
+        !absl::holds_alternative<TestProc*>(*member)) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          test_name, " was neither a test function nor a test proc."));
+    }
     if (options.bytecode) {
-      auto cache = std::make_unique<BytecodeCache>(&import_data);
-      import_data.SetBytecodeCache(std::move(cache));
-      XLS_ASSIGN_OR_RETURN(TestFunction * f, entry_module->GetTest(test_name));
-      XLS_ASSIGN_OR_RETURN(
-          std::unique_ptr<BytecodeFunction> bf,
-          BytecodeEmitter::Emit(&import_data, tm_or.value().type_info, f->fn(),
-                                absl::nullopt));
-      status =
-          BytecodeInterpreter::Interpret(&import_data, bf.get(), /*params=*/{})
-              .status();
-    } else {
-      ModuleMember* member =
-          entry_module->FindMemberWithName(test_name).value();
+      // Test procs have no single entry function; their networks are
+      // instantiated when run.
+      std::unique_ptr<BytecodeFunction> bf;
       if (absl::holds_alternative<TestFunction*>(*member)) {
-        status = interpreter.RunTest(test_name);
-      } else if (absl::holds_alternative<TestProc*>(*member)) {
-        status = interpreter.RunTestProc(test_name);
-      } else {
-        return absl::InvalidArgumentError(absl::StrCat(
-            test_name, " was neither a test function nor a test proc."));
+        XLS_ASSIGN_OR_RETURN(
+            bf, BytecodeEmitter::Emit(
+                    &import_data, tm_or.value().type_info,
+                    absl::get<TestFunction*>(*member)->fn(), absl::nullopt));
       }
+      test_bfs.push_back(std::move(bf));
     }
+    if (options.execute_on_jit) {
+      std::unique_ptr<JitTest> jit_test;
+      if (auto it = test_conversion_errors.find(test_name);
+          it != test_conversion_errors.end()) {
+        XLS_LOG(WARNING) << "Running " << test_name
+                         << " in the interpreter, as it could not be "
+                            "converted to IR: "
+                         << it->second;
+      } else if (absl::holds_alternative<TestFunction*>(*member)) {
+        XLS_ASSIGN_OR_RETURN(
+            jit_test, JitTest::Create(absl::get<TestFunction*>(*member)->fn(),
+                                      tm_or.value().type_info,
+                                      ir_package.get()));
+      }
+      test_jits.push_back(std::move(jit_test));
+    }
+    test_names.push_back(test_name);
+  }
 
+  // The AST interpreter lazily fills in the top-level bindings of modules,
+  // which are shared through the import data, so its runs are serialized.
+  absl::Mutex ast_interpreter_mutex;
+
+  // Runs the test at `index` in the DSLX interpreter; `interp` is only used
+  // when not executing bytecode.
+  auto interpret_test = [&](int64_t index,
+                            Interpreter* interp) -> absl::Status {
+    const std::string& test_name = test_names[index];
+    ModuleMember* member = entry_module->FindMemberWithName(test_name).value();
+    if (options.bytecode) {
+      if (absl::holds_alternative<TestProc*>(*member)) {
+        return BytecodeInterpreter::RunTestProc(&import_data,
+                                                tm_or.value().type_info,
+                                                absl::get<TestProc*>(*member));
+      }
+      return BytecodeInterpreter::Interpret(&import_data, test_bfs[index].get(),
+                                            /*params=*/{})
+          .status();
+    }
+    absl::MutexLock lock(&ast_interpreter_mutex);
+    if (absl::holds_alternative<TestProc*>(*member)) {
+      return interp->RunTestProc(test_name);
+    }
+    return interp->RunTest(test_name);
+  };
+  auto run_test = [&](int64_t index, Interpreter* interp) -> absl::Status {
+    if (test_jits.empty() || test_jits[index] == nullptr) {
+      return interpret_test(index, interp);
+    }
+    absl::Status status = test_jits[index]->Run();
+    if (status.ok()) {
+      return status;
+    }
+    // The IR assertion message only names the failing builtin; re-run the test
+    // in the interpreter for a positional error with the values involved.
+    absl::Status interp_status = interpret_test(index, interp);
+    if (interp_status.ok()) {
+      return absl::InternalError(absl::StrCat(
+          "Test failed on the JIT but passed in the DSLX interpreter: ",
+          status.message()));
+    }
+    return interp_status;
+  };
+  // With `name_result` the OK line names its test, as it does not directly
+  // follow the test's RUN line.
+  auto report = [&](int64_t index, const absl::Status& status,
+                    bool name_result) {
+    ran += 1;
     if (status.ok()) {
-      std::cerr << "[            OK ]" << std::endl;
+      std::cerr << "[            OK ]"
+                << (name_result ? absl::StrCat(" ", test_names[index]) : "")
+                << std::endl;
     } else {
-      handle_error(status, test_name, /*is_quickcheck=*/false);
+      handle_error(status, test_names[index], /*is_quickcheck=*/false);
+    }
+  };
+
+  // Run unit tests. Tests that only run in the AST interpreter gain nothing
+  // from running concurrently, see `ast_interpreter_mutex`.
+  const int64_t jobs = options.run_concolic ? 1 : options.jobs;
+  const int64_t test_jobs =
+      options.bytecode || options.execute_on_jit ? jobs : 1;
+  if (test_jobs <= 1) {
+    for (int64_t i = 0; i < test_names.size(); ++i) {
+      std::cerr << "[ RUN UNITTEST  ] " << test_names[i] << std::endl;
+      report(i, run_test(i, interpreter.get()), /*name_result=*/false);
+    }
+  } else {
+    // The typechecked module, import data, and bytecode cache are shared
+    // between workers; bytecode interpreter state (frames, stacks) is created
+    // per test. RUN lines are printed as tests start, but results are buffered
+    // and reported in test order once all earlier tests have finished, so the
+    // result lines do not depend on scheduling.
+    absl::Mutex report_mutex;
+    std::vector<absl::optional<absl::Status>> statuses(test_names.size());
+    int64_t next_to_report = 0;
+    auto run_and_report = [&](int64_t i) -> absl::Status {
+      {
+        absl::MutexLock lock(&report_mutex);
+        std::cerr << "[ RUN UNITTEST  ] " << test_names[i] << std::endl;
+      }
+      std::unique_ptr<Interpreter> test_interpreter;
+      if (!options.bytecode) {
+        test_interpreter = make_interpreter();
+      }
+      absl::Status status = run_test(i, test_interpreter.get());
+      absl::MutexLock lock(&report_mutex);
+      statuses[i] = std::move(status);
+      for (; next_to_report < statuses.size() &&
+             statuses[next_to_report].has_value();
+           ++next_to_report) {
+        report(next_to_report, *statuses[next_to_report],
+               /*name_result=*/true);
+      }
+      return absl::OkStatus();
+    };
+    XLS_RETURN_IF_ERROR(
+        ParallelFor(test_names.size(), test_jobs, run_and_report));
+  }
+
+  // Comparisons may have been deferred past the end of the test that made
+  // them, in which case a mismatch is reported separately, positioned at the
+  // call site that produced it.
+  if (options.run_comparator != nullptr) {
+    absl::Status status = options.run_comparator->Flush();
+    if (!status.ok()) {
+      handle_error(status, "deferred JIT comparison", /*is_quickcheck=*/false);
     }
   }
 
@@ -395,8 +803,8 @@ absl::StatusOr<TestResult> ParseAndTest(absl::string_view program,
   // Run quickchecks, but only if the JIT is enabled.
   if (!entry_module->GetQuickChecks().empty()) {
     XLS_RETURN_IF_ERROR(RunQuickChecksIfJitEnabled(
-        entry_module, interpreter.current_type_info(), options.run_comparator,
-        ir_package.get(), options.seed, handle_error));
+        entry_module, interpreter->current_type_info(), options.run_comparator,
+        ir_package.get(), options.seed, jobs, handle_error));
   }
 
   return failed == 0 ? TestResult::kAllPassed : TestResult::kSomeFailed;
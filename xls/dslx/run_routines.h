@@ -18,10 +18,18 @@
 #ifndef XLS_DSLX_RUN_ROUTINES_H_
 #define XLS_DSLX_RUN_ROUTINES_H_
 
+#include <memory>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/optional.h"
+#include "xls/common/thread_pool.h"
 #include "xls/dslx/default_dslx_stdlib_path.h"
 #include "xls/dslx/interp_value.h"
 #include "xls/dslx/interpreter.h"
 #include "xls/dslx/ir_converter.h"
+#include "xls/dslx/pos.h"
 #include "xls/dslx/symbolic_bindings.h"
 #include "xls/ir/function.h"
 #include "xls/ir/package.h"
@@ -42,23 +50,44 @@ enum class CompareMode {
 //
 // Implementation note: slightly simpler to keep in object form so we can
 // inspect cache state more easily than closing over it, e.g. for testing.
+//
+// Comparisons may be run concurrently, e.g. when tests are run with multiple
+// jobs.
+//
+// By default each comparison is run as soon as it is requested. Comparisons
+// can instead be deferred (see EnableDeferredComparison()), taking the IR
+// conversion and execution off the interpreter's critical path.
 class RunComparator {
  public:
   explicit RunComparator(CompareMode mode) : mode_(mode) {}
 
+  // Makes RunComparison() record its calls instead of checking them, and
+  // return immediately. Recorded calls are checked in batches of `batch_size`
+  // as they accumulate -- on a background thread if `background` is true --
+  // and by Flush(). Must be called before any comparison is requested.
+  void EnableDeferredComparison(int64_t batch_size, bool background);
+
   // Runs a comparison of the interpreter-determined value against the
-  // JIT-determined value.
+  // JIT-determined value. `call_site` is the span of the invocation that
+  // produced `got`, if known; deferred mismatches are reported there.
   absl::Status RunComparison(Package* ir_package, bool requires_implicit_token,
                              Function* f, absl::Span<InterpValue const> args,
                              const SymbolicBindings* symbolic_bindings,
-                             const InterpValue& got);
+                             const InterpValue& got,
+                             const absl::optional<Span>& call_site = {});
+
+  // Checks any calls recorded for deferred comparison, waiting for batches
+  // running in the background. Returns the first mismatch (in the order calls
+  // were recorded) found since the last Flush(); mismatches with a known call
+  // site are positional errors. Always OK when comparisons are not deferred.
+  absl::Status Flush();
 
   // Returns the cached or newly-compiled jit function for ir_name.  ir_name has
   // already been mangled (see MangleDslxName) so it should be unique in the
   // program and is used as the cache key.
   //
-  // Note: There is no locking in jit compilation or on the jit function cache
-  // so this function is *not* thread-safe.
+  // Thread-safe; compilation happens outside of the cache lock, so distinct
+  // functions may be compiled concurrently.
   absl::StatusOr<IrJit*> GetOrCompileJitFunction(std::string ir_name,
                                                  xls::Function* ir_function);
 
@@ -67,8 +96,57 @@ class RunComparator {
   friend class RunRoutinesTest_QuickcheckInvokedFunctionDoesJit_Test;
   friend class RunRoutinesTest_NoSeedStillQuickChecks_Test;
 
-  absl::flat_hash_map<std::string, std::unique_ptr<IrJit>> jit_cache_;
+  // A compiled function along with the lock serializing its runs: value
+  // packing in IrJit::Run lazily populates the jit's type conversion caches.
+  struct CachedJit {
+    std::unique_ptr<IrJit> jit;
+    absl::Mutex run_mutex;
+  };
+
+  // A call recorded for deferred comparison.
+  struct RecordedCall {
+    Package* ir_package;
+    bool requires_implicit_token;
+    Function* f;
+    std::vector<InterpValue> args;
+    absl::optional<SymbolicBindings> symbolic_bindings;
+    InterpValue got;
+    absl::optional<Span> call_site;
+  };
+
+  // Returns the IR function converted from `f` (with `symbolic_bindings`) and
+  // its name, or nullptr if the package doesn't contain it.
+  static absl::StatusOr<std::pair<std::string, xls::Function*>>
+  GetIrFunction(Package* ir_package, bool requires_implicit_token, Function* f,
+                const SymbolicBindings* symbolic_bindings);
+
+  // Runs `ir_function` on `args` and compares the result against `got`.
+  absl::Status CompareWithIr(const std::string& ir_name,
+                             xls::Function* ir_function,
+                             bool requires_implicit_token,
+                             absl::Span<InterpValue const> args,
+                             const InterpValue& got);
+
+  // Checks `batch` in order, returning the first mismatch.
+  absl::Status CompareBatch(std::vector<RecordedCall> batch);
+
+  // Implements GetOrCompileJitFunction, returning the whole cache entry.
+  absl::StatusOr<CachedJit*> GetOrCompileCachedJit(std::string ir_name,
+                                                   xls::Function* ir_function);
+
+  absl::Mutex mutex_;
+  absl::flat_hash_map<std::string, std::unique_ptr<CachedJit>> jit_cache_
+      ABSL_GUARDED_BY(mutex_);
   CompareMode mode_;
+
+  // Deferred comparison state; batch_size_ is zero when comparisons are run
+  // immediately.
+  int64_t batch_size_ = 0;
+  absl::Mutex deferred_mutex_;
+  std::vector<RecordedCall> pending_ ABSL_GUARDED_BY(deferred_mutex_);
+  absl::Status deferred_status_ ABSL_GUARDED_BY(deferred_mutex_);
+  // Declared last so that it is destroyed (and drained) first.
+  std::unique_ptr<ThreadPool> background_;
 };
 
 // Optional arguments to ParseAndTest (that have sensible defaults).
@@ -81,6 +159,21 @@ class RunComparator {
 //   seed: Seed for QuickCheck random input stimulus.
 //   convert_options: Options used in IR conversion, see `ConvertOptions` for
 //    details.
+//   jobs: Number of threads on which to run tests and quickchecks. Tests run
+//    concurrently in the bytecode interpreter or on the JIT, each with its own
+//    interpreter state against the shared typechecked module; results are
+//    reported in module order. The AST interpreter, which fills in shared
+//    top-level bindings as it goes, runs one test at a time. The samples of
+//    each quickcheck are sharded across the threads (see DoQuickCheck).
+//    Independent imports are also typechecked concurrently (see
+//    DoConcurrentImports). Values of one or less run everything
+//    sequentially on the calling thread. Concolic execution always runs
+//    sequentially.
+//   execute_on_jit: Whether to run test functions natively on the JIT: the
+//    module, including the test bodies, is converted to IR once up front and
+//    assert_eq()/assert_lt()/fail!() become IR assertions. The DSLX
+//    interpreter is then only used to re-run failing tests, to report where
+//    they failed. Test procs still run in the interpreter.
 struct ParseAndTestOptions {
   std::string stdlib_path = xls::kDefaultDslxStdlibPath;
   absl::Span<const std::filesystem::path> dslx_paths = {};
@@ -92,6 +185,8 @@ struct ParseAndTestOptions {
   absl::optional<int64_t> seed = absl::nullopt;
   ConvertOptions convert_options;
   bool bytecode = false;
+  int64_t jobs = 1;
+  bool execute_on_jit = false;
 };
 
 enum class TestResult {
@@ -116,21 +211,33 @@ absl::StatusOr<TestResult> ParseAndTest(absl::string_view program,
                                         const ParseAndTestOptions& options);
 
 struct QuickCheckResults {
-  std::vector<std::vector<Value>> arg_sets;
-  std::vector<Value> results;
+  // Number of argument sets evaluated, up to and including the falsifying one
+  // if one was found.
+  int64_t test_count = 0;
+  // The first (by sample index) argument set that falsified the predicate.
+  absl::optional<std::vector<Value>> falsifying_args;
 };
 
+// The number of independent random streams the samples of a quickcheck are
+// divided between. Fixed, rather than tied to the number of threads, so the
+// samples drawn for a given seed do not depend on the machine.
+constexpr int64_t kQuickCheckShards = 16;
+
 // JIT-compiles the given xls_function and invokes it with num_tests randomly
-// generated arguments -- returns `([argset, ...], [results, ...])` (i.e. in
-// structure-of-array style).
+// generated arguments, returning the first falsifying example (if any).
 //
-// xls_function is a predicate we're trying to find evidence to falsify, so if
-// this finds an example that falsifies the predicate, we early-return (i.e. the
-// length of the returned vectors may be < 1000).
+// xls_function is a predicate we're trying to find evidence to falsify. Sample
+// i is drawn from stream i % kQuickCheckShards, seeded from (seed, shard), and
+// shards are run on up to thread_count threads. Arguments are generated
+// directly into JIT argument buffers and only the falsifying example is kept,
+// so memory use does not grow with num_tests. Once a falsifying sample is
+// found, samples with a greater index are skipped; the returned example is
+// the one with the lowest index, independent of thread_count and scheduling.
 absl::StatusOr<QuickCheckResults> DoQuickCheck(xls::Function* xls_function,
                                                std::string ir_name,
                                                RunComparator* run_comparator,
-                                               int64_t seed, int64_t num_tests);
+                                               int64_t seed, int64_t num_tests,
+                                               int64_t thread_count = 1);
 
 }  // namespace xls::dslx
 
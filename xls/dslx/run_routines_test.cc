@@ -14,10 +14,18 @@
 
 #include "xls/dslx/run_routines.h"
 
+#include <unistd.h>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_split.h"
 #include "xls/common/file/temp_file.h"
+#include "xls/common/logging/capture_stream.h"
 #include "xls/common/status/matchers.h"
+#include "xls/dslx/create_import_data.h"
+#include "xls/dslx/parse_and_typecheck.h"
 #include "xls/ir/ir_parser.h"
 
 namespace xls::dslx {
@@ -105,6 +113,205 @@ fn trivial(x: u5) -> bool { false }
   EXPECT_THAT(result, status_testing::IsOkAndHolds(TestResult::kSomeFailed));
 }
 
+TEST(RunRoutinesTest, ParallelJobsReportSomeFailed) {
+  constexpr const char* kProgram = R"(
+fn double(x: u32) -> u32 { x * u32:2 }
+#[test]
+fn passes() { assert_eq(double(u32:2), u32:4) }
+#[test]
+fn fails() { assert_eq(double(u32:2), u32:5) }
+#[test]
+fn also_passes() { assert_eq(double(u32:0), u32:0) }
+#[quickcheck]
+fn doubles_are_even(x: u32) -> bool { double(x)[0:1] == u1:0 }
+)";
+  XLS_ASSERT_OK_AND_ASSIGN(auto temp_file,
+                           TempFile::CreateWithContent(kProgram, "_test.x"));
+  constexpr const char* kModuleName = "test";
+  for (bool bytecode : {false, true}) {
+    RunComparator jit_comparator(CompareMode::kJit);
+    ParseAndTestOptions options;
+    options.run_comparator = &jit_comparator;
+    options.seed = int64_t{42};
+    options.bytecode = bytecode;
+    options.jobs = 4;
+    absl::StatusOr<TestResult> result = ParseAndTest(
+        kProgram, kModuleName, std::string(temp_file.path()), options);
+    EXPECT_THAT(result, status_testing::IsOkAndHolds(TestResult::kSomeFailed));
+  }
+}
+
+TEST(RunRoutinesTest, ParallelJobsReportResultsInTestOrder) {
+  constexpr const char* kProgram = R"(
+#[test]
+fn first() { assert_eq(u32:1, u32:2) }
+#[test]
+fn second() { assert_eq(u32:1, u32:1) }
+#[test]
+fn third() { assert_eq(u32:3, u32:4) }
+#[test]
+fn fourth() { assert_eq(u32:3, u32:3) }
+)";
+  XLS_ASSERT_OK_AND_ASSIGN(auto temp_file,
+                           TempFile::CreateWithContent(kProgram, "_test.x"));
+  constexpr const char* kModuleName = "test";
+  // Tests only run concurrently in the bytecode interpreter or on the JIT; the
+  // latter re-runs failing tests in the (serialized) AST interpreter.
+  for (bool execute_on_jit : {false, true}) {
+    ParseAndTestOptions options;
+    options.bytecode = !execute_on_jit;
+    options.execute_on_jit = execute_on_jit;
+    options.jobs = 4;
+    absl::StatusOr<TestResult> result;
+    XLS_ASSERT_OK_AND_ASSIGN(
+        std::string output, testing::CaptureStream(STDERR_FILENO, [&] {
+          result = ParseAndTest(kProgram, kModuleName,
+                                std::string(temp_file.path()), options);
+        }));
+    EXPECT_THAT(result, status_testing::IsOkAndHolds(TestResult::kSomeFailed));
+
+    std::vector<std::string> result_lines;
+    for (absl::string_view line : absl::StrSplit(output, '\n')) {
+      if (absl::StartsWith(line, "[            OK ]") ||
+          absl::StrContains(line, " FAILED ]")) {
+        result_lines.push_back(std::string(line));
+      }
+    }
+    EXPECT_THAT(result_lines,
+                ::testing::ElementsAre("[       FAILED ] first",
+                                       "[            OK ] second",
+                                       "[       FAILED ] third",
+                                       "[            OK ] fourth"))
+        << output;
+  }
+}
+
+TEST(RunRoutinesTest, DeferredComparisonReportsMismatchAtCallSite) {
+  constexpr const char* kProgram = "fn double(x: u32) -> u32 { x * u32:2 }";
+  auto import_data = CreateImportDataForTest();
+  XLS_ASSERT_OK_AND_ASSIGN(
+      TypecheckedModule tm,
+      ParseAndTypecheck(kProgram, "test.x", "test", &import_data));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<Package> package,
+      ConvertModuleToPackage(tm.module, &import_data, ConvertOptions{}));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f,
+                           tm.module->GetFunctionOrError("double"));
+  const Pos kPos("test.x", 3, 4);
+  const Span kCallSite(kPos, kPos);
+
+  for (bool background : {false, true}) {
+    RunComparator comparator(CompareMode::kJit);
+    comparator.EnableDeferredComparison(/*batch_size=*/2, background);
+    for (uint32_t x = 0; x < 5; ++x) {
+      // Only the call with x == 3 gets the wrong answer.
+      uint32_t got = x == 3 ? 7 : x * 2;
+      XLS_EXPECT_OK(comparator.RunComparison(
+          package.get(), /*requires_implicit_token=*/false, f,
+          {InterpValue::MakeU32(x)}, /*symbolic_bindings=*/nullptr,
+          InterpValue::MakeU32(got), kCallSite));
+    }
+    absl::Status status = comparator.Flush();
+    EXPECT_THAT(status, status_testing::StatusIs(
+                            absl::StatusCode::kInternal,
+                            ::testing::StartsWith(absl::StrCat(
+                                "ComparisonError: ", kCallSite.ToString()))));
+    EXPECT_THAT(status.message(), ::testing::HasSubstr("bits[32]:7"));
+    // The mismatch is only reported once.
+    XLS_EXPECT_OK(comparator.Flush());
+  }
+}
+
+TEST(RunRoutinesTest, DeferredComparisonPasses) {
+  constexpr const char* kProgram = R"(
+fn double(x: u32) -> u32 { x * u32:2 }
+#[test]
+fn doubles() {
+  let _ = assert_eq(double(u32:2), u32:4);
+  assert_eq(double(u32:3), u32:6)
+}
+)";
+  constexpr const char* kModuleName = "test";
+  constexpr const char* kFilename = "test.x";
+  RunComparator jit_comparator(CompareMode::kJit);
+  jit_comparator.EnableDeferredComparison(/*batch_size=*/16,
+                                          /*background=*/true);
+  ParseAndTestOptions options;
+  options.run_comparator = &jit_comparator;
+  absl::StatusOr<TestResult> result =
+      ParseAndTest(kProgram, kModuleName, kFilename, options);
+  EXPECT_THAT(result, status_testing::IsOkAndHolds(TestResult::kAllPassed));
+}
+
+TEST(RunRoutinesTest, ExecuteOnJit) {
+  constexpr const char* kProgram = R"(
+fn double(x: u32) -> u32 { x * u32:2 }
+fn checked_double(x: u32) -> u32 {
+  if x < u32:0x80000000 { double(x) } else { fail!(u32:0) }
+}
+#[test]
+fn eq() { assert_eq(checked_double(u32:2), u32:4) }
+#[test]
+fn tuple_eq() { assert_eq((double(u32:1), u8:3), (u32:2, u8:3)) }
+#[test]
+fn signed_lt() { assert_lt(s8:-1, s8:0) }
+)";
+  constexpr const char* kModuleName = "test";
+  constexpr const char* kFilename = "test.x";
+  for (int64_t jobs : {1, 4}) {
+    ParseAndTestOptions options;
+    options.execute_on_jit = true;
+    options.jobs = jobs;
+    absl::StatusOr<TestResult> result =
+        ParseAndTest(kProgram, kModuleName, kFilename, options);
+    EXPECT_THAT(result, status_testing::IsOkAndHolds(TestResult::kAllPassed));
+  }
+}
+
+TEST(RunRoutinesTest, ExecuteOnJitReportsFailures) {
+  for (absl::string_view body :
+       {"assert_eq(u32:1, u32:2)", "assert_lt(u32:2, u32:1)",
+        "assert_lt(s8:0, s8:-1)", "fail!(())"}) {
+    std::string program = absl::StrFormat(R"(
+#[test]
+fn passes() { assert_eq(u32:1, u32:1) }
+#[test]
+fn fails() { %s }
+)",
+                                          body);
+    XLS_ASSERT_OK_AND_ASSIGN(auto temp_file,
+                             TempFile::CreateWithContent(program, "_test.x"));
+    constexpr const char* kModuleName = "test";
+    ParseAndTestOptions options;
+    options.execute_on_jit = true;
+    absl::StatusOr<TestResult> result = ParseAndTest(
+        program, kModuleName, std::string(temp_file.path()), options);
+    EXPECT_THAT(result, status_testing::IsOkAndHolds(TestResult::kSomeFailed))
+        << body;
+  }
+}
+
+TEST(RunRoutinesTest, ExecuteOnJitInterpretsUnconvertibleTests) {
+  // IR conversion only supports matches that end in an irrefutable arm.
+  constexpr const char* kProgram = R"(
+fn double(x: u32) -> u32 { x * u32:2 }
+#[test]
+fn converts() { assert_eq(double(u32:2), u32:4) }
+#[test]
+fn does_not_convert() {
+  let x = match double(u32:1) { u32:2 => u32:3 };
+  assert_eq(x, u32:3)
+}
+)";
+  constexpr const char* kModuleName = "test";
+  constexpr const char* kFilename = "test.x";
+  ParseAndTestOptions options;
+  options.execute_on_jit = true;
+  absl::StatusOr<TestResult> result =
+      ParseAndTest(kProgram, kModuleName, kFilename, options);
+  EXPECT_THAT(result, status_testing::IsOkAndHolds(TestResult::kAllPassed));
+}
+
 // Verifies that the QuickCheck mechanism can find counter-examples for a simple
 // erroneous function.
 TEST(QuickcheckTest, QuickCheckBits) {
@@ -124,9 +331,10 @@ TEST(QuickcheckTest, QuickCheckBits) {
   XLS_ASSERT_OK_AND_ASSIGN(
       auto quickcheck_info,
       DoQuickCheck(function, kFakeIrName, &jit_comparator, seed, num_tests));
-  std::vector<Value> results = quickcheck_info.results;
-  // If a counter-example was found, the last result will be 0.
-  EXPECT_EQ(results.back(), Value(UBits(0, 1)));
+  ASSERT_TRUE(quickcheck_info.falsifying_args.has_value());
+  // The counter-example must actually falsify the predicate.
+  const Bits& x = quickcheck_info.falsifying_args->at(0).bits();
+  EXPECT_NE(x.Get(0), x.Get(1));
 }
 
 TEST(QuickcheckTest, QuickCheckArray) {
@@ -148,8 +356,7 @@ TEST(QuickcheckTest, QuickCheckArray) {
   XLS_ASSERT_OK_AND_ASSIGN(
       auto quickcheck_info,
       DoQuickCheck(function, kFakeIrName, &jit_comparator, seed, num_tests));
-  std::vector<Value> results = quickcheck_info.results;
-  EXPECT_EQ(results.back(), Value(UBits(0, 1)));
+  EXPECT_TRUE(quickcheck_info.falsifying_args.has_value());
 }
 
 TEST(QuickcheckTest, QuickCheckTuple) {
@@ -169,12 +376,11 @@ TEST(QuickcheckTest, QuickCheckTuple) {
   XLS_ASSERT_OK_AND_ASSIGN(
       auto quickcheck_info,
       DoQuickCheck(function, kFakeIrName, &jit_comparator, seed, num_tests));
-  std::vector<Value> results = quickcheck_info.results;
-  EXPECT_EQ(results.back(), Value(UBits(0, 1)));
+  EXPECT_TRUE(quickcheck_info.falsifying_args.has_value());
 }
 
-// If the QuickCheck mechanism can't find a falsifying example, we expect
-// the argsets and results vectors to have lengths of 'num_tests'.
+// If the QuickCheck mechanism can't find a falsifying example, we expect all
+// 'num_tests' samples to have been run.
 TEST(QuickcheckTest, NumTests) {
   Package package("always_true");
   std::string ir_text = R"(
@@ -190,15 +396,12 @@ TEST(QuickcheckTest, NumTests) {
   XLS_ASSERT_OK_AND_ASSIGN(
       auto quickcheck_info,
       DoQuickCheck(function, kFakeIrName, &jit_comparator, seed, num_tests));
-
-  std::vector<std::vector<Value>> argsets = quickcheck_info.arg_sets;
-  std::vector<Value> results = quickcheck_info.results;
-  EXPECT_EQ(argsets.size(), 5050);
-  EXPECT_EQ(results.size(), 5050);
+  EXPECT_EQ(quickcheck_info.test_count, 5050);
+  EXPECT_FALSE(quickcheck_info.falsifying_args.has_value());
 }
 
-// Given a constant seed, we expect the same argsets and results vectors from
-// two runs through the QuickCheck mechanism.
+// Given a constant seed, we expect the same falsifying example from two runs
+// through the QuickCheck mechanism, regardless of the number of threads.
 TEST(QuickcheckTest, Seeding) {
   Package package("sometimes_false");
   std::string ir_text = R"(
@@ -217,13 +420,11 @@ TEST(QuickcheckTest, Seeding) {
       DoQuickCheck(function, kFakeIrName, &jit_comparator, seed, num_tests));
   XLS_ASSERT_OK_AND_ASSIGN(
       auto quickcheck_info2,
-      DoQuickCheck(function, kFakeIrName, &jit_comparator, seed, num_tests));
-
-  const auto& [argsets1, results1] = quickcheck_info1;
-  const auto& [argsets2, results2] = quickcheck_info2;
+      DoQuickCheck(function, kFakeIrName, &jit_comparator, seed, num_tests,
+                   /*thread_count=*/4));
 
-  EXPECT_EQ(argsets1, argsets2);
-  EXPECT_EQ(results1, results2);
+  EXPECT_EQ(quickcheck_info1.falsifying_args, quickcheck_info2.falsifying_args);
+  EXPECT_EQ(quickcheck_info1.test_count, quickcheck_info2.test_count);
 }
 
 }  // namespace xls::dslx
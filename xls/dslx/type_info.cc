@@ -14,6 +14,8 @@
 
 #include "xls/dslx/type_info.h"
 
+#include "absl/hash/hash.h"
+#include "absl/types/span.h"
 #include "xls/common/status/ret_check.h"
 
 namespace xls::dslx {
@@ -32,6 +34,7 @@ std::string InstantiationData::ToString() const {
 // -- class TypeInfoOwner
 
 absl::StatusOr<TypeInfo*> TypeInfoOwner::New(Module* module, TypeInfo* parent) {
+  absl::MutexLock lock(mutex_.get());
   // Note: private constructor so not using make_unique.
   type_infos_.push_back(absl::WrapUnique(new TypeInfo(module, parent)));
   TypeInfo* result = type_infos_.back().get();
@@ -52,6 +55,7 @@ absl::StatusOr<TypeInfo*> TypeInfoOwner::New(Module* module, TypeInfo* parent) {
 }
 
 absl::StatusOr<TypeInfo*> TypeInfoOwner::GetRootTypeInfo(Module* module) {
+  absl::MutexLock lock(mutex_.get());
   auto it = module_to_root_.find(module);
   if (it == module_to_root_.end()) {
     return absl::NotFoundError(absl::StrCat(
@@ -84,7 +88,13 @@ absl::optional<InterpValue> TypeInfo::GetConstExpr(
 
 bool TypeInfo::Contains(AstNode* key) const {
   XLS_CHECK_EQ(key->owner(), module_);
-  return dict_.contains(key) || (parent_ != nullptr && parent_->Contains(key));
+  {
+    absl::MutexLock lock(&mutex_);
+    if (dict_.contains(key)) {
+      return true;
+    }
+  }
+  return parent_ != nullptr && parent_->Contains(key);
 }
 
 std::string TypeInfo::GetImportsDebugString() const {
@@ -95,13 +105,89 @@ std::string TypeInfo::GetImportsDebugString() const {
       }));
 }
 
+namespace {
+
+// Wraps a ConcreteType for hashing consistently with its equality: structs and
+// enums hash their definitions, and parametric dimensions (which are compared
+// as expressions) all hash alike.
+struct HashedType {
+  const ConcreteType& type;
+};
+
+template <typename H>
+H HashDim(H h, const ConcreteTypeDim& dim) {
+  if (dim.IsParametric()) {
+    return H::combine(std::move(h), true);
+  }
+  absl::StatusOr<int64_t> value = dim.GetAsInt64();
+  return H::combine(std::move(h), false, value.ok() ? *value : int64_t{-1});
+}
+
+template <typename H>
+H HashMembers(H h, absl::Span<const std::unique_ptr<ConcreteType>> members) {
+  for (const std::unique_ptr<ConcreteType>& member : members) {
+    h = H::combine(std::move(h), HashedType{*member});
+  }
+  return H::combine(std::move(h), members.size());
+}
+
+template <typename H>
+H AbslHashValue(H h, const HashedType& hashed) {
+  const ConcreteType& type = hashed.type;
+  if (auto* bits = dynamic_cast<const BitsType*>(&type)) {
+    return HashDim(H::combine(std::move(h), 0, bits->is_signed()),
+                   bits->size());
+  }
+  if (auto* tuple = dynamic_cast<const TupleType*>(&type)) {
+    return HashMembers(H::combine(std::move(h), 1), tuple->members());
+  }
+  if (auto* array = dynamic_cast<const ArrayType*>(&type)) {
+    return HashDim(
+        H::combine(std::move(h), 2, HashedType{array->element_type()}),
+        array->size());
+  }
+  if (auto* s = dynamic_cast<const StructType*>(&type)) {
+    return HashMembers(H::combine(std::move(h), 3, &s->nominal_type()),
+                       s->members());
+  }
+  if (auto* e = dynamic_cast<const EnumType*>(&type)) {
+    return HashDim(H::combine(std::move(h), 4, &e->nominal_type()), e->size());
+  }
+  if (auto* f = dynamic_cast<const FunctionType*>(&type)) {
+    return HashMembers(
+        H::combine(std::move(h), 5, HashedType{f->return_type()}),
+        f->params());
+  }
+  XLS_CHECK(type.IsToken()) << type.ToString();
+  return H::combine(std::move(h), 6);
+}
+
+}  // namespace
+
+ConcreteType* TypeInfo::InternType(const ConcreteType& type) {
+  XLS_CHECK(parent_ == nullptr);
+  absl::MutexLock lock(&mutex_);
+  std::vector<std::unique_ptr<ConcreteType>>& bucket =
+      interned_types_[absl::Hash<HashedType>()(HashedType{type})];
+  for (const std::unique_ptr<ConcreteType>& interned : bucket) {
+    if (*interned == type) {
+      return interned.get();
+    }
+  }
+  bucket.push_back(type.CloneToUnique());
+  return bucket.back().get();
+}
+
 absl::optional<ConcreteType*> TypeInfo::GetItem(AstNode* key) const {
   XLS_CHECK_EQ(key->owner(), module_)
       << key->owner()->name() << " vs " << module_->name()
       << " key: " << key->ToString();
-  auto it = dict_.find(key);
-  if (it != dict_.end()) {
-    return it->second.get();
+  {
+    absl::MutexLock lock(&mutex_);
+    auto it = dict_.find(key);
+    if (it != dict_.end()) {
+      return it->second;
+    }
   }
   if (parent_ != nullptr) {
     return parent_->GetItem(key);
@@ -119,9 +205,10 @@ void TypeInfo::AddInstantiationCallBindings(Instantiation* call,
               << call->ToString() << " @ " << call->span()
               << " caller: " << caller.ToString()
               << " callee: " << callee.ToString();
+  absl::MutexLock lock(&top->mutex_);
   auto it = top->instantiations_.find(call);
   if (it == top->instantiations_.end()) {
-    absl::flat_hash_map<SymbolicBindings, SymbolicBindings> symbind_map;
+    absl::node_hash_map<SymbolicBindings, SymbolicBindings> symbind_map;
     symbind_map.emplace(std::move(caller), std::move(callee));
     top->instantiations_[call] =
         InstantiationData{call, std::move(symbind_map)};
@@ -144,6 +231,7 @@ absl::optional<bool> TypeInfo::GetRequiresImplicitToken(Function* f) const {
   XLS_CHECK_EQ(f->owner(), module_) << "function owner: " << f->owner()->name()
                                     << " module: " << module_->name();
   const TypeInfo* root = GetRoot();
+  absl::MutexLock lock(&root->mutex_);
   const absl::flat_hash_map<Function*, bool>& map =
       root->requires_implicit_token_;
   auto it = map.find(f);
@@ -162,6 +250,7 @@ void TypeInfo::NoteRequiresImplicitToken(Function* f, bool is_required) {
   XLS_VLOG(6) << absl::StreamFormat(
       "NoteRequiresImplicitToken %p: %s::%s => %s", root, f->owner()->name(),
       f->identifier(), is_required ? "true" : "false");
+  absl::MutexLock lock(&root->mutex_);
   root->requires_implicit_token_.emplace(f, is_required);
 }
 
@@ -170,6 +259,7 @@ absl::optional<TypeInfo*> TypeInfo::GetInstantiationTypeInfo(
   XLS_CHECK_EQ(instantiation->owner(), module_)
       << instantiation->owner()->name() << " vs " << module_->name();
   const TypeInfo* top = GetRoot();
+  absl::MutexLock lock(&top->mutex_);
   auto it = top->instantiations_.find(instantiation);
   if (it == top->instantiations_.end()) {
     XLS_VLOG(5) << "Could not find instantiation for invocation: "
@@ -192,6 +282,7 @@ void TypeInfo::SetInstantiationTypeInfo(Instantiation* instantiation,
                                         TypeInfo* type_info) {
   XLS_CHECK_EQ(instantiation->owner(), module_);
   TypeInfo* top = GetRoot();
+  absl::MutexLock lock(&top->mutex_);
   InstantiationData& data = top->instantiations_[instantiation];
   data.instantiations[caller] = type_info;
 }
@@ -206,8 +297,9 @@ TypeInfo::GetInstantiationCalleeBindings(Instantiation* instantiation,
       "TypeInfo %p getting instantiation symbolic bindings: %p %s @ %s %s", top,
       instantiation, instantiation->ToString(),
       instantiation->span().ToString(), caller.ToString());
-  auto it = top->instantiations().find(instantiation);
-  if (it == top->instantiations().end()) {
+  absl::MutexLock lock(&top->mutex_);
+  auto it = top->instantiations_.find(instantiation);
+  if (it == top->instantiations_.end()) {
     XLS_VLOG(3) << "Could not find instantiation " << instantiation
                 << " in top-level type info: " << top;
     return absl::nullopt;
@@ -232,6 +324,7 @@ void TypeInfo::AddSliceStartAndWidth(Slice* node,
                                      StartAndWidth start_width) {
   XLS_CHECK_EQ(node->owner(), module_);
   TypeInfo* top = GetRoot();
+  absl::MutexLock lock(&top->mutex_);
   auto it = top->slices_.find(node);
   if (it == top->slices_.end()) {
     top->slices_[node] =
@@ -246,6 +339,7 @@ absl::optional<StartAndWidth> TypeInfo::GetSliceStartAndWidth(
     Slice* node, const SymbolicBindings& symbolic_bindings) const {
   XLS_CHECK_EQ(node->owner(), module_);
   const TypeInfo* top = GetRoot();
+  absl::MutexLock lock(&top->mutex_);
   auto it = top->slices_.find(node);
   if (it == top->slices_.end()) {
     return absl::nullopt;
@@ -17,6 +17,10 @@
 #ifndef XLS_DSLX_TYPE_INFO_H_
 #define XLS_DSLX_TYPE_INFO_H_
 
+#include <memory>
+
+#include "absl/container/node_hash_map.h"
+#include "absl/synchronization/mutex.h"
 #include "xls/dslx/ast.h"
 #include "xls/dslx/concrete_type.h"
 #include "xls/dslx/symbolic_bindings.h"
@@ -51,8 +55,9 @@ struct InstantiationData {
   // Invocation/Spawn AST node.
   Instantiation* node;
   // Map from symbolic bindings in the caller to the corresponding symbolic
-  // bindings in the callee for this invocation.
-  absl::flat_hash_map<SymbolicBindings, SymbolicBindings> symbolic_bindings_map;
+  // bindings in the callee for this invocation. Node-based so that pointers
+  // handed out by GetInstantiationCalleeBindings() survive later insertions.
+  absl::node_hash_map<SymbolicBindings, SymbolicBindings> symbolic_bindings_map;
   // Type information that is specialized for a particular parametric
   // instantiation of an invocation.
   absl::flat_hash_map<SymbolicBindings, TypeInfo*> instantiations;
@@ -70,6 +75,8 @@ struct InstantiationData {
 // the program at type checking time, we place all type info objects into this
 // owned pool (arena style ownership to avoid circular references or leaks or
 // any other sort of lifetime issues).
+//
+// Thread-safe, so that independent modules can be typechecked concurrently.
 class TypeInfoOwner {
  public:
   // Returns an error status iff parent is nullptr and "module" already has a
@@ -81,6 +88,9 @@ class TypeInfoOwner {
   absl::StatusOr<TypeInfo*> GetRootTypeInfo(Module* module);
 
  private:
+  // Guards the members below. Held by pointer so TypeInfoOwner stays movable.
+  std::unique_ptr<absl::Mutex> mutex_ = std::make_unique<absl::Mutex>();
+
   // Mapping from module to the "root" (or "parentmost") type info -- these have
   // nullptr as their parent. There should only be one of these for any given
   // module.
@@ -154,9 +164,14 @@ class TypeInfo {
       Instantiation* instantiation, const SymbolicBindings& caller) const;
 
   // Sets the type associated with the given AST node.
+  //
+  // Note: types are interned in the root type info, so nodes with equal types
+  // share a single (immutable) ConcreteType object.
   void SetItem(AstNode* key, const ConcreteType& value) {
     XLS_CHECK_EQ(key->owner(), module_);
-    dict_[key] = value.CloneToUnique();
+    ConcreteType* interned = GetRoot()->InternType(value);
+    absl::MutexLock lock(&mutex_);
+    dict_[key] = interned;
   }
 
   // Attempts to resolve AST node 'key' in the node-to-type dictionary.
@@ -235,6 +250,8 @@ class TypeInfo {
   // which imported modules are present, suitable for debugging.
   std::string GetImportsDebugString() const;
 
+  // Note: not synchronized against concurrent instantiation; only for use once
+  // type checking has completed.
   const absl::flat_hash_map<Instantiation*, InstantiationData>& instantiations()
       const {
     return instantiations_;
@@ -242,8 +259,7 @@ class TypeInfo {
 
   // Returns a reference to the underlying mapping that associates an AST node
   // with its deduced type.
-  const absl::flat_hash_map<AstNode*, std::unique_ptr<ConcreteType>>& dict()
-      const {
+  const absl::flat_hash_map<AstNode*, ConcreteType*>& dict() const {
     return dict_;
   }
 
@@ -273,8 +289,21 @@ class TypeInfo {
     return const_cast<TypeInfo*>(this)->GetRoot();
   }
 
+  // Returns the canonical copy of "type" owned by this (root) type info,
+  // creating it on first use.
+  ConcreteType* InternType(const ConcreteType& type);
+
+  // Guards dict_ and, in the root, the context-free maps below: an imported
+  // module's root keeps receiving parametric instantiations from importers
+  // that may be type checking on other threads.
+  mutable absl::Mutex mutex_;
   Module* module_;
-  absl::flat_hash_map<AstNode*, std::unique_ptr<ConcreteType>> dict_;
+  absl::flat_hash_map<AstNode*, ConcreteType*> dict_;
+  // Interned types (only populated in the root), bucketed by a structural hash
+  // and disambiguated with ConcreteType equality (which is nominal for structs
+  // and enums, so same-named types from different definitions stay distinct).
+  absl::flat_hash_map<size_t, std::vector<std::unique_ptr<ConcreteType>>>
+      interned_types_;
   absl::flat_hash_map<Import*, ImportedInfo> imports_;
   absl::flat_hash_map<NameDef*, ConstantDef*> name_to_const_;
   absl::flat_hash_map<Instantiation*, InstantiationData> instantiations_;
@@ -28,5 +28,63 @@ TEST(TypeInfoTest, Instantiate) {
   EXPECT_EQ(type_info->parent(), nullptr);
 }
 
+TEST(TypeInfoTest, EqualTypesAreInterned) {
+  Module module("test");
+  const Span fake_span;
+  NameDef* a = module.Make<NameDef>(fake_span, "a", /*definer=*/nullptr);
+  NameDef* b = module.Make<NameDef>(fake_span, "b", /*definer=*/nullptr);
+  NameDef* c = module.Make<NameDef>(fake_span, "c", /*definer=*/nullptr);
+  NameDef* d = module.Make<NameDef>(fake_span, "d", /*definer=*/nullptr);
+
+  TypeInfoOwner owner;
+  XLS_ASSERT_OK_AND_ASSIGN(TypeInfo * root, owner.New(&module));
+  XLS_ASSERT_OK_AND_ASSIGN(TypeInfo * child, owner.New(&module, root));
+  root->SetItem(a, BitsType(/*is_signed=*/false, 32));
+  root->SetItem(b, BitsType(/*is_signed=*/false, 32));
+  root->SetItem(c, BitsType(/*is_signed=*/true, 32));
+  child->SetItem(d, BitsType(/*is_signed=*/false, 32));
+
+  XLS_ASSERT_OK_AND_ASSIGN(BitsType * a_type, root->GetItemAs<BitsType>(a));
+  XLS_ASSERT_OK_AND_ASSIGN(BitsType * b_type, root->GetItemAs<BitsType>(b));
+  XLS_ASSERT_OK_AND_ASSIGN(BitsType * c_type, root->GetItemAs<BitsType>(c));
+  XLS_ASSERT_OK_AND_ASSIGN(BitsType * d_type, child->GetItemAs<BitsType>(d));
+  EXPECT_EQ(a_type, b_type);
+  EXPECT_EQ(a_type, d_type);
+  EXPECT_NE(a_type, c_type);
+  EXPECT_EQ(a_type->ToString(), "uN[32]");
+  EXPECT_EQ(c_type->ToString(), "sN[32]");
+}
+
+TEST(TypeInfoTest, EqualAggregateTypesAreInterned) {
+  Module module("test");
+  const Span fake_span;
+  NameDef* a = module.Make<NameDef>(fake_span, "a", /*definer=*/nullptr);
+  NameDef* b = module.Make<NameDef>(fake_span, "b", /*definer=*/nullptr);
+  NameDef* c = module.Make<NameDef>(fake_span, "c", /*definer=*/nullptr);
+
+  auto make_array = [](int64_t size) {
+    std::vector<std::unique_ptr<ConcreteType>> members;
+    members.push_back(BitsType::MakeU8());
+    members.push_back(std::make_unique<TokenType>());
+    return ArrayType(std::make_unique<TupleType>(std::move(members)),
+                     ConcreteTypeDim::CreateU32(size));
+  };
+  TypeInfoOwner owner;
+  XLS_ASSERT_OK_AND_ASSIGN(TypeInfo * type_info, owner.New(&module));
+  type_info->SetItem(a, make_array(4));
+  type_info->SetItem(b, make_array(4));
+  type_info->SetItem(c, make_array(5));
+
+  XLS_ASSERT_OK_AND_ASSIGN(ArrayType * a_type,
+                           type_info->GetItemAs<ArrayType>(a));
+  XLS_ASSERT_OK_AND_ASSIGN(ArrayType * b_type,
+                           type_info->GetItemAs<ArrayType>(b));
+  XLS_ASSERT_OK_AND_ASSIGN(ArrayType * c_type,
+                           type_info->GetItemAs<ArrayType>(c));
+  EXPECT_EQ(a_type, b_type);
+  EXPECT_NE(a_type, c_type);
+  EXPECT_EQ(*a_type, make_array(4));
+}
+
 }  // namespace
 }  // namespace xls::dslx
@@ -323,6 +323,14 @@ static absl::StatusOr<NameDef*> InstantiateBuiltinParametric(
         higher_order_parametric_bindings = (*map_fn)->parametric_bindings();
       }
     }
+  } else if (builtin_name->identifier() == "assert_eq" ||
+             builtin_name->identifier() == "assert_lt") {
+    // Assertions can fail at runtime like fail!(), so they are converted to IR
+    // the same way: as assertion nodes threaded through the implicit token.
+    if (f != nullptr && absl::holds_alternative<Function*>(*f)) {
+      ctx->type_info()->NoteRequiresImplicitToken(absl::get<Function*>(*f),
+                                                  true);
+    }
   } else if (builtin_name->identifier() == "fail!" ||
              builtin_name->identifier() == "cover!") {
     if (f != nullptr && absl::holds_alternative<Function*>(*f)) {
@@ -975,6 +983,17 @@ absl::StatusOr<TypeInfo*> CheckModule(Module* module, ImportData* import_data) {
                        /*typecheck_module=*/ftypecheck, import_data);
   DeduceCtx* ctx = &deduce_ctx;
 
+  // Independent imports can be typechecked ahead of time on other threads;
+  // the member loop below then resolves them from the import cache.
+  std::vector<std::pair<ImportTokens, Span>> import_subjects;
+  for (const ModuleMember& member : module->top()) {
+    if (Import* const* import = absl::get_if<Import*>(&member)) {
+      import_subjects.push_back(
+          {ImportTokens((*import)->subject()), (*import)->span()});
+    }
+  }
+  DoConcurrentImports(ftypecheck, import_subjects, module->name(), import_data);
+
   // First, populate type info with constants, enums, resolved imports, and
   // non-parametric functions.
   for (const ModuleMember& member : module->top()) {
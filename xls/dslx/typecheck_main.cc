@@ -29,6 +29,8 @@ ABSL_FLAG(std::string, dslx_stdlib_path, xls::kDefaultDslxStdlibPath,
 ABSL_FLAG(std::string, output_path, "",
           "Path to dump the type information to as a protobin -- if not "
           "provided textual proto is given on stdout.");
+ABSL_FLAG(int64_t, jobs, 1,
+          "Number of threads on which independent imports are typechecked.");
 
 namespace xls::dslx {
 namespace {
@@ -41,12 +43,15 @@ was deduced.
 absl::Status RealMain(absl::Span<const std::filesystem::path> dslx_paths,
                       const std::filesystem::path& dslx_stdlib_path,
                       const std::filesystem::path& input_path,
-                      std::optional<std::filesystem::path> output_path) {
+                      std::optional<std::filesystem::path> output_path,
+                      int64_t jobs) {
   ImportData import_data(
       CreateImportData(dslx_stdlib_path,
                        /*additional_search_paths=*/dslx_paths));
+  import_data.SetImportJobs(jobs);
   XLS_ASSIGN_OR_RETURN(std::string input_contents, GetFileContents(input_path));
   XLS_ASSIGN_OR_RETURN(std::string module_name, PathToName(input_path.c_str()));
+
   absl::StatusOr<TypecheckedModule> tm_or = ParseAndTypecheck(
       input_contents, input_path.c_str(), module_name, &import_data);
   if (!tm_or.ok()) {
@@ -97,6 +102,6 @@ int main(int argc, char* argv[]) {
   std::filesystem::path dslx_stdlib_path(absl::GetFlag(FLAGS_dslx_stdlib_path));
 
   XLS_QCHECK_OK(xls::dslx::RealMain(dslx_paths, dslx_stdlib_path, input_path,
-                                    output_path));
+                                    output_path, absl::GetFlag(FLAGS_jobs)));
   return EXIT_SUCCESS;
 }
@@ -16,9 +16,13 @@
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/strings/str_format.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/file/temp_directory.h"
 #include "xls/common/status/matchers.h"
 #include "xls/dslx/ast.h"
 #include "xls/dslx/create_import_data.h"
+#include "xls/dslx/default_dslx_stdlib_path.h"
 #include "xls/dslx/parse_and_typecheck.h"
 #include "xls/dslx/type_info_to_proto.h"
 
@@ -1333,5 +1337,118 @@ fn main() {
                        HasSubstr("uN[20] vs uN[10]")));
 }
 
+constexpr const char* kImporter = R"(
+import a
+import b
+import c
+import d
+fn main() -> u32 { a::f(u32:1) + b::f(u32:2) + c::f() + d::f() }
+)";
+
+// Writes modules "a" and "b" (independent of everything else) and "c" and "d"
+// (which both instantiate parametric functions of the standard library) to
+// 'dir'. 'b_body' is the body of b::f.
+absl::Status WriteImportedModules(const std::filesystem::path& dir,
+                                  absl::string_view b_body) {
+  XLS_RETURN_IF_ERROR(SetFileContents(
+      dir / "a.x", "pub fn f<N: u32>(x: bits[N]) -> bits[N] { x }"));
+  XLS_RETURN_IF_ERROR(SetFileContents(
+      dir / "b.x",
+      absl::StrFormat("pub fn f<N: u32>(x: bits[N]) -> bits[N] { %s }",
+                      b_body)));
+  XLS_RETURN_IF_ERROR(SetFileContents(
+      dir / "c.x",
+      "import std\npub fn f() -> u32 { std::umax(u32:1, u32:2) }"));
+  return SetFileContents(
+      dir / "d.x", "import std\npub fn f() -> u32 { std::umin(u32:1, u32:2) }");
+}
+
+// Typechecks kImporter; with 'preimport_std' the standard library is already
+// imported, so "c" and "d" no longer share a pending module and are
+// typechecked concurrently.
+absl::Status TypecheckImporter(const std::filesystem::path& dir,
+                               int64_t import_jobs,
+                               bool preimport_std = false) {
+  std::vector<std::filesystem::path> search_paths = {dir};
+  ImportData import_data =
+      CreateImportData(xls::kDefaultDslxStdlibPath, search_paths);
+  import_data.SetImportJobs(import_jobs);
+  if (preimport_std) {
+    XLS_RETURN_IF_ERROR(
+        ParseAndTypecheck("import std", "first.x", "first", &import_data)
+            .status());
+  }
+  XLS_RETURN_IF_ERROR(
+      ParseAndTypecheck(kImporter, "importer.x", "importer", &import_data)
+          .status());
+  for (const char* name : {"a", "b", "c", "d", "std"}) {
+    XLS_RET_CHECK(import_data.Contains(ImportTokens({name}))) << name;
+  }
+  return absl::OkStatus();
+}
+
+TEST(TypecheckTest, ConcurrentImports) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  XLS_ASSERT_OK(WriteImportedModules(temp_dir.path(), "x"));
+  XLS_EXPECT_OK(TypecheckImporter(temp_dir.path(), /*import_jobs=*/1));
+  XLS_EXPECT_OK(TypecheckImporter(temp_dir.path(), /*import_jobs=*/4));
+}
+
+TEST(TypecheckTest, ConcurrentImportsShareImportedModule) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  XLS_ASSERT_OK(WriteImportedModules(temp_dir.path(), "x"));
+  for (int64_t i = 0; i < 8; ++i) {
+    XLS_EXPECT_OK(TypecheckImporter(temp_dir.path(), /*import_jobs=*/4,
+                                    /*preimport_std=*/true));
+  }
+}
+
+TEST(TypecheckTest, ConcurrentImportErrorMatchesSequential) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  XLS_ASSERT_OK(WriteImportedModules(temp_dir.path(), "x ++ x"));
+  absl::Status sequential =
+      TypecheckImporter(temp_dir.path(), /*import_jobs=*/1);
+  EXPECT_THAT(sequential, StatusIs(absl::StatusCode::kInvalidArgument,
+                                   HasSubstr("XlsTypeError")));
+  EXPECT_EQ(TypecheckImporter(temp_dir.path(), /*import_jobs=*/4),
+            sequential);
+}
+
+// Imports nested two deep share one pool; with two jobs, the only pool thread
+// is busy importing one of "p" and "q" while that module's own imports are
+// scheduled.
+TEST(TypecheckTest, NestedConcurrentImports) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  const std::filesystem::path& dir = temp_dir.path();
+  for (const char* name : {"p1", "p2", "q1", "q2"}) {
+    XLS_ASSERT_OK(SetFileContents(dir / absl::StrCat(name, ".x"),
+                                  "pub fn f() -> u32 { u32:1 }"));
+  }
+  for (const char* name : {"p", "q"}) {
+    XLS_ASSERT_OK(SetFileContents(
+        dir / absl::StrCat(name, ".x"),
+        absl::StrFormat("import %s1\nimport %s2\n"
+                        "pub fn f() -> u32 { %s1::f() + %s2::f() }",
+                        name, name, name, name)));
+  }
+  constexpr const char* kProgram = R"(
+import p
+import q
+fn main() -> u32 { p::f() + q::f() }
+)";
+  for (int64_t import_jobs : {2, 4}) {
+    std::vector<std::filesystem::path> search_paths = {dir};
+    ImportData import_data =
+        CreateImportData(xls::kDefaultDslxStdlibPath, search_paths);
+    import_data.SetImportJobs(import_jobs);
+    XLS_ASSERT_OK(
+        ParseAndTypecheck(kProgram, "importer.x", "importer", &import_data)
+            .status());
+    for (const char* name : {"p", "q", "p1", "p2", "q1", "q2"}) {
+      EXPECT_TRUE(import_data.Contains(ImportTokens({name}))) << name;
+    }
+  }
+}
+
 }  // namespace
 }  // namespace xls::dslx
@@ -22,6 +22,7 @@
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/types/optional.h"
 #include "xls/common/iterator_range.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/ir/dfs_visitor.h"
@@ -130,6 +131,16 @@ class FunctionBase {
     return node_name_uniquer_.GetSanitizedUniqueName(name);
   }
 
+  // Returns a new node id which is unique within the package. While the
+  // function base is being modified concurrently with others (see
+  // Package::BeginConcurrentModification) the id is provisional.
+  int64_t AllocateNodeId() {
+    if (provisional_node_id_base_.has_value()) {
+      return *provisional_node_id_base_ + provisional_node_id_count_++;
+    }
+    return package_->GetNextNodeId();
+  }
+
   // Returns whether this FunctionBase is a function, proc, or block.
   bool IsFunction() const;
   bool IsProc() const;
@@ -169,6 +180,14 @@ class FunctionBase {
 
   NameUniquer node_name_uniquer_ =
       NameUniquer(/*separator=*/"__", GetIrReservedWords());
+
+ private:
+  friend class Package;
+
+  // The start of the range of provisional node ids and the number of ids
+  // allocated from it, set during concurrent modification.
+  absl::optional<int64_t> provisional_node_id_base_;
+  int64_t provisional_node_id_count_ = 0;
 };
 
 std::ostream& operator<<(std::ostream& os, const FunctionBase& function);
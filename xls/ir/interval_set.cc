@@ -17,11 +17,13 @@
 #include <algorithm>
 #include <cstdint>
 #include <functional>
+#include <iterator>
 #include <list>
 #include <random>
 #include <string>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "absl/types/optional.h"
@@ -63,31 +65,48 @@ void IntervalSet::SetIntervals(absl::Span<const Interval> intervals) {
 }
 
 void IntervalSet::Normalize() {
-  Bits zero(BitCount());
-  Bits max = Bits::AllOnes(BitCount());
-  std::vector<Interval> expand_improper;
-  for (const Interval& interval : intervals_) {
-    if (interval.IsImproper()) {
-      expand_improper.push_back(Interval(zero, interval.UpperBound()));
-      expand_improper.push_back(Interval(interval.LowerBound(), max));
-    } else {
-      expand_improper.push_back(interval);
+  if (is_normalized_) {
+    return;
+  }
+
+  // Improper intervals wrap around and are split in two. Most interval sets
+  // contain none, in which case the intervals are normalized in place.
+  if (absl::c_any_of(intervals_,
+                     [](const Interval& i) { return i.IsImproper(); })) {
+    Bits zero(BitCount());
+    Bits max = Bits::AllOnes(BitCount());
+    std::vector<Interval> expand_improper;
+    expand_improper.reserve(intervals_.size() + 1);
+    for (const Interval& interval : intervals_) {
+      if (interval.IsImproper()) {
+        expand_improper.push_back(Interval(zero, interval.UpperBound()));
+        expand_improper.push_back(Interval(interval.LowerBound(), max));
+      } else {
+        expand_improper.push_back(interval);
+      }
     }
+    intervals_ = std::move(expand_improper);
   }
 
-  std::sort(expand_improper.begin(), expand_improper.end());
+  // Interval sets are frequently built in order (e.g., by `Combine` and
+  // `Intersect`), so avoid sorting when possible.
+  if (!std::is_sorted(intervals_.begin(), intervals_.end())) {
+    std::sort(intervals_.begin(), intervals_.end());
+  }
 
-  intervals_.clear();
-  for (int32_t i = 0; i < expand_improper.size();) {
-    Interval interval = expand_improper[i];
-    while ((i < expand_improper.size()) &&
-           (Interval::Overlaps(interval, expand_improper[i]) ||
-            Interval::Abuts(interval, expand_improper[i]))) {
-      interval = Interval::ConvexHull(interval, expand_improper[i]);
+  // Merge overlapping and abutting intervals in place.
+  int64_t merged = 0;
+  for (int64_t i = 0; i < intervals_.size();) {
+    Interval interval = intervals_[i];
+    while ((i < intervals_.size()) &&
+           (Interval::Overlaps(interval, intervals_[i]) ||
+            Interval::Abuts(interval, intervals_[i]))) {
+      interval = Interval::ConvexHull(interval, intervals_[i]);
       ++i;
     }
-    intervals_.push_back(interval);
+    intervals_[merged++] = std::move(interval);
   }
+  intervals_.resize(merged);
 
   is_normalized_ = true;
 }
@@ -144,12 +163,21 @@ IntervalSet IntervalSet::Combine(const IntervalSet& lhs,
                                  const IntervalSet& rhs) {
   XLS_CHECK_EQ(lhs.BitCount(), rhs.BitCount());
   IntervalSet combined(lhs.BitCount());
-  for (const Interval& interval : lhs.intervals_) {
-    combined.AddInterval(interval);
-  }
-  for (const Interval& interval : rhs.intervals_) {
-    combined.AddInterval(interval);
+  if (lhs.is_normalized_ && rhs.is_normalized_) {
+    // Merging the sorted inputs lets `Normalize` skip sorting.
+    combined.intervals_.reserve(lhs.intervals_.size() + rhs.intervals_.size());
+    std::merge(lhs.intervals_.begin(), lhs.intervals_.end(),
+               rhs.intervals_.begin(), rhs.intervals_.end(),
+               std::back_inserter(combined.intervals_));
+  } else {
+    for (const Interval& interval : lhs.intervals_) {
+      combined.AddInterval(interval);
+    }
+    for (const Interval& interval : rhs.intervals_) {
+      combined.AddInterval(interval);
+    }
   }
+  combined.is_normalized_ = false;
   combined.Normalize();
   return combined;
 }
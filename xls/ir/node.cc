@@ -37,7 +37,7 @@ namespace xls {
 Node::Node(Op op, Type* type, absl::optional<SourceLocation> loc,
            absl::string_view name, FunctionBase* function_base)
     : function_base_(function_base),
-      id_(function_base_->package()->GetNextNodeId()),
+      id_(function_base_->AllocateNodeId()),
       op_(op),
       type_(type),
       loc_(loc),
@@ -226,7 +226,8 @@ class Node {
 
   // Sets the id of the node. Mutates the user sets of the operands of the node
   // because user sets are sorted by id.  Note: this should only be used by the
-  // parser and ideally not even there.
+  // parser (and Package when finalizing provisional ids) and ideally not even
+  // there.
   // TODO(meheff): 2021/05/05 Remove this method.
   void SetId(int64_t id);
 
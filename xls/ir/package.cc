@@ -14,9 +14,12 @@
 
 #include "xls/ir/package.h"
 
+#include <algorithm>
 #include <utility>
 
 #include "absl/status/statusor.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
@@ -34,6 +37,7 @@
 namespace xls {
 
 Package::Package(absl::string_view name) : name_(name) {
+  absl::MutexLock lock(&types_mutex_);
   owned_types_.insert(&token_type_);
 }
 
@@ -259,6 +263,7 @@ SourceLocation Package::AddSourceLocation(absl::string_view filename,
 }
 
 std::string Package::SourceLocationToString(const SourceLocation loc) {
+  absl::MutexLock lock(&fileno_mutex_);
   const std::string unknown = "UNKNOWN";
   absl::string_view filename =
       fileno_to_filename_.find(loc.fileno()) != fileno_to_filename_.end()
@@ -303,7 +308,18 @@ absl::StatusOr<Type*> Package::MapTypeFromOtherPackage(
   }
 }
 
+bool Package::IsOwnedType(const Type* type) {
+  absl::MutexLock lock(&types_mutex_);
+  return owned_types_.contains(type);
+}
+
+bool Package::IsOwnedFunctionType(const FunctionType* function_type) {
+  absl::MutexLock lock(&types_mutex_);
+  return owned_function_types_.contains(function_type);
+}
+
 BitsType* Package::GetBitsType(int64_t bit_count) {
+  absl::MutexLock lock(&types_mutex_);
   if (bit_count_to_type_.find(bit_count) != bit_count_to_type_.end()) {
     return &bit_count_to_type_.at(bit_count);
   }
@@ -315,10 +331,11 @@ BitsType* Package::GetBitsType(int64_t bit_count) {
 
 ArrayType* Package::GetArrayType(int64_t size, Type* element_type) {
   ArrayKey key{size, element_type};
+  absl::MutexLock lock(&types_mutex_);
   if (array_types_.find(key) != array_types_.end()) {
     return &array_types_.at(key);
   }
-  XLS_CHECK(IsOwnedType(element_type))
+  XLS_CHECK(owned_types_.contains(element_type))
       << "Type is not owned by package: " << *element_type;
   auto it = array_types_.emplace(key, ArrayType(size, element_type));
   ArrayType* new_type = &(it.first->second);
@@ -328,11 +345,12 @@ ArrayType* Package::GetArrayType(int64_t size, Type* element_type) {
 
 TupleType* Package::GetTupleType(absl::Span<Type* const> element_types) {
   TypeVec key(element_types.begin(), element_types.end());
+  absl::MutexLock lock(&types_mutex_);
   if (tuple_types_.find(key) != tuple_types_.end()) {
     return &tuple_types_.at(key);
   }
   for (const Type* element_type : element_types) {
-    XLS_CHECK(IsOwnedType(element_type))
+    XLS_CHECK(owned_types_.contains(element_type))
         << "Type is not owned by package: " << *element_type;
   }
   auto it = tuple_types_.emplace(key, TupleType(element_types));
@@ -346,11 +364,12 @@ TokenType* Package::GetTokenType() { return &token_type_; }
 FunctionType* Package::GetFunctionType(absl::Span<Type* const> args_types,
                                        Type* return_type) {
   std::string key = FunctionType(args_types, return_type).ToString();
+  absl::MutexLock lock(&types_mutex_);
   if (function_types_.find(key) != function_types_.end()) {
     return &function_types_.at(key);
   }
   for (Type* t : args_types) {
-    XLS_CHECK(IsOwnedType(t))
+    XLS_CHECK(owned_types_.contains(t))
         << "Parameter type is not owned by package: " << t->ToString();
   }
   auto it = function_types_.emplace(key, FunctionType(args_types, return_type));
@@ -440,7 +459,101 @@ Type* Package::GetTypeForValue(const Value& value) {
   XLS_LOG(FATAL) << "Invalid value for type extraction.";
 }
 
+// The size of the range from which each concurrently modified function base
+// allocates provisional node ids.
+static constexpr int64_t kProvisionalNodeIdStride = int64_t{1} << 40;
+
+void Package::BeginConcurrentModification(
+    absl::Span<FunctionBase* const> function_bases) {
+  XLS_CHECK(concurrently_modified_.empty());
+  concurrently_modified_.assign(function_bases.begin(), function_bases.end());
+  for (int64_t i = 0; i < concurrently_modified_.size(); ++i) {
+    FunctionBase* f = concurrently_modified_[i];
+    XLS_CHECK_EQ(f->package(), this);
+    XLS_CHECK(!f->provisional_node_id_base_.has_value());
+    f->provisional_node_id_base_ =
+        next_node_id_ + (i + 1) * kProvisionalNodeIdStride;
+    f->provisional_node_id_count_ = 0;
+  }
+}
+
+// Returns `name` with every embedded provisional node id in
+// [`base`, `base` + `count`) replaced by the corresponding final id starting at
+// `final_base`, or nullopt if the name contains no such id. Passes commonly
+// derive node names from the generated names (e.g., "add.1234") of nodes they
+// created, which embed the id.
+static absl::optional<std::string> FinalizeProvisionalIdsInName(
+    absl::string_view name, int64_t base, int64_t count, int64_t final_base) {
+  std::string result;
+  bool rewritten = false;
+  int64_t i = 0;
+  while (i < name.size()) {
+    if (!absl::ascii_isdigit(name[i])) {
+      result.push_back(name[i++]);
+      continue;
+    }
+    int64_t end = i;
+    while (end < name.size() && absl::ascii_isdigit(name[end])) {
+      ++end;
+    }
+    absl::string_view digits = name.substr(i, end - i);
+    int64_t id;
+    if (absl::SimpleAtoi(digits, &id) && id >= base && id < base + count) {
+      absl::StrAppend(&result, final_base + (id - base));
+      rewritten = true;
+    } else {
+      absl::StrAppend(&result, digits);
+    }
+    i = end;
+  }
+  if (!rewritten) {
+    return absl::nullopt;
+  }
+  return result;
+}
+
+void Package::EndConcurrentModification() {
+  int64_t next_id = next_node_id_;
+  for (FunctionBase* f : concurrently_modified_) {
+    int64_t base = f->provisional_node_id_base_.value();
+    XLS_CHECK_LT(f->provisional_node_id_count_, kProvisionalNodeIdStride);
+    std::vector<Node*> created;
+    for (Node* node : f->nodes()) {
+      if (node->id() >= base) {
+        created.push_back(node);
+      }
+    }
+    // Renumbering in increasing order preserves the relative order of ids
+    // within the function base.
+    std::sort(created.begin(), created.end(),
+              [](Node* a, Node* b) { return a->id() < b->id(); });
+    for (Node* node : created) {
+      node->SetId(next_id + (node->id() - base));
+    }
+    // Names derived from provisional ids are renamed as well, so that they
+    // match the names the nodes would have been given in a sequential run.
+    if (f->provisional_node_id_count_ > 0) {
+      for (Node* node : f->nodes()) {
+        if (!node->HasAssignedName()) {
+          continue;
+        }
+        absl::optional<std::string> name = FinalizeProvisionalIdsInName(
+            node->GetName(), base, f->provisional_node_id_count_, next_id);
+        if (name.has_value()) {
+          node->SetName(*name);
+        }
+      }
+    }
+    next_id += f->provisional_node_id_count_;
+    f->provisional_node_id_base_.reset();
+    f->provisional_node_id_count_ = 0;
+  }
+  concurrently_modified_.clear();
+  next_node_id_ = next_id;
+}
+
 Fileno Package::GetOrCreateFileno(absl::string_view filename) {
+  absl::MutexLock lock(&fileno_mutex_);
   // Attempt to add a new fileno/filename pair to the map.
   if (auto it = filename_to_fileno_.find(std::string(filename));
       it != filename_to_fileno_.end()) {
@@ -458,6 +571,7 @@ Fileno Package::GetOrCreateFileno(absl::string_view filename) {
 }
 
 void Package::SetFileno(Fileno file_number, absl::string_view filename) {
+  absl::MutexLock lock(&fileno_mutex_);
   maximum_fileno_ =
       maximum_fileno_.has_value()
           ? Fileno(std::max(static_cast<int32_t>(file_number),
@@ -468,6 +582,7 @@ void Package::SetFileno(Fileno file_number, absl::string_view filename) {
 }
 
 std::optional<std::string> Package::GetFilename(Fileno file_number) const {
+  absl::MutexLock lock(&fileno_mutex_);
   if (!fileno_to_filename_.contains(file_number)) {
     return std::nullopt;
   }
@@ -500,6 +615,7 @@ std::string Package::DumpIr() const {
   std::string out;
   absl::StrAppend(&out, "package ", name(), "\n\n");
 
+  absl::ReleasableMutexLock fileno_lock(&fileno_mutex_);
   if (!fileno_to_filename_.empty()) {
     std::list<xls::Fileno> filenos;
     for (const auto& [fileno, filename] : fileno_to_filename_) {
@@ -514,6 +630,7 @@ std::string Package::DumpIr() const {
     }
     absl::StrAppend(&out, "\n");
   }
+  fileno_lock.Release();
 
   if (!channels().empty()) {
     for (Channel* channel : channels()) {
@@ -20,12 +20,15 @@
 #include <string>
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/container/inlined_vector.h"
 #include "absl/container/node_hash_map.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
 #include "xls/ir/channel.h"
 #include "xls/ir/channel.pb.h"
 #include "xls/ir/channel_ops.h"
@@ -71,13 +74,8 @@ class Package {
   absl::StatusOr<Block*> GetTopAsBlock() const;
 
   // Returns whether the given type is one of the types owned by this package.
-  bool IsOwnedType(const Type* type) {
-    return owned_types_.find(type) != owned_types_.end();
-  }
-  bool IsOwnedFunctionType(const FunctionType* function_type) {
-    return owned_function_types_.find(function_type) !=
-           owned_function_types_.end();
-  }
+  bool IsOwnedType(const Type* type);
+  bool IsOwnedFunctionType(const FunctionType* function_type);
 
   BitsType* GetBitsType(int64_t bit_count);
   ArrayType* GetArrayType(int64_t size, Type* element_type);
@@ -145,9 +143,35 @@ class Package {
   std::string SourceLocationToString(const SourceLocation loc);
 
   // Retrieves the next node ID to assign to a node in the package and
-  // increments the next node counter. For use in node construction.
+  // increments the next node counter. Node construction uses
+  // FunctionBase::AllocateNodeId instead, which defers to this method outside
+  // of concurrent modification (see below).
   int64_t GetNextNodeId() { return next_node_id_++; }
 
+  // Prepares the given function bases of this package to be modified
+  // concurrently, each by at most one thread at a time. Until
+  // `EndConcurrentModification` is called, new nodes are assigned provisional
+  // ids from a range private to their function base, so node creation requires
+  // no synchronization. Type and file number lookups are always thread-safe.
+  // Other package-level state (functions, channels, etc.) must not be modified
+  // during concurrent modification.
+  void BeginConcurrentModification(
+      absl::Span<FunctionBase* const> function_bases);
+
+  // Assigns final ids to the nodes created since `BeginConcurrentModification`.
+  // Ids are assigned exactly as if the function bases had been modified
+  // sequentially in the order given to `BeginConcurrentModification`, so the
+  // resulting IR does not depend on how the modifications were interleaved.
+  // Provisional ids embedded in node names (e.g., names derived from the
+  // generated name of a new node) are replaced by the final ids likewise.
+  void EndConcurrentModification();
+
+  // Returns true between calls to `BeginConcurrentModification` and
+  // `EndConcurrentModification`.
+  bool IsConcurrentlyModified() const {
+    return !concurrently_modified_.empty();
+  }
+
   // Adds a file to the file-number table and returns its corresponding number.
   // If it already exists, returns the existing file-number entry.
   Fileno GetOrCreateFileno(absl::string_view filename);
@@ -258,46 +282,64 @@ class Package {
   // Ordinal to assign to the next node created in this package.
   int64_t next_node_id_ = 1;
 
+  // The function bases being modified concurrently, in the order in which
+  // they are assigned final node ids.
+  std::vector<FunctionBase*> concurrently_modified_;
+
   std::vector<std::unique_ptr<Function>> functions_;
   std::vector<std::unique_ptr<Proc>> procs_;
   std::vector<std::unique_ptr<Block>> blocks_;
 
+  // Guards the type tables below so types may be created by passes running
+  // concurrently on different function bases.
+  absl::Mutex types_mutex_;
+
   // Set of owned types in this package.
-  absl::flat_hash_set<const Type*> owned_types_;
+  absl::flat_hash_set<const Type*> owned_types_ ABSL_GUARDED_BY(types_mutex_);
 
   // Set of owned function types in this package.
-  absl::flat_hash_set<const FunctionType*> owned_function_types_;
+  absl::flat_hash_set<const FunctionType*> owned_function_types_
+      ABSL_GUARDED_BY(types_mutex_);
 
   // Mapping from bit count to the owned "bits" type with that many bits. Use
   // node_hash_map for pointer stability.
-  absl::node_hash_map<int64_t, BitsType> bit_count_to_type_;
+  absl::node_hash_map<int64_t, BitsType> bit_count_to_type_
+      ABSL_GUARDED_BY(types_mutex_);
 
   // Mapping from the size and element type of an array type to the owned
   // ArrayType. Use node_hash_map for pointer stability.
   using ArrayKey = std::pair<int64_t, const Type*>;
-  absl::node_hash_map<ArrayKey, ArrayType> array_types_;
+  absl::node_hash_map<ArrayKey, ArrayType> array_types_
+      ABSL_GUARDED_BY(types_mutex_);
 
   // Mapping from elements to the owned tuple type.
   //
   // Uses node_hash_map for pointer stability.
   using TypeVec = absl::InlinedVector<const Type*, 4>;
-  absl::node_hash_map<TypeVec, TupleType> tuple_types_;
+  absl::node_hash_map<TypeVec, TupleType> tuple_types_
+      ABSL_GUARDED_BY(types_mutex_);
 
   // Owned token type.
   TokenType token_type_;
 
   // Mapping from Type:ToString to the owned function type. Use
   // node_hash_map for pointer stability.
-  absl::node_hash_map<std::string, FunctionType> function_types_;
+  absl::node_hash_map<std::string, FunctionType> function_types_
+      ABSL_GUARDED_BY(types_mutex_);
+
+  // Guards the file number tables below.
+  mutable absl::Mutex fileno_mutex_;
 
   // The largest `Fileno` used in this `Package`.
-  std::optional<Fileno> maximum_fileno_;
+  std::optional<Fileno> maximum_fileno_ ABSL_GUARDED_BY(fileno_mutex_);
 
   // Mapping of Fileno ids to string filenames, and vice-versa for reverse
   // lookups. These two data structures must be updated together for consistency
   // and should always contain the same number of entries.
-  absl::flat_hash_map<Fileno, std::string> fileno_to_filename_;
-  absl::flat_hash_map<std::string, Fileno> filename_to_fileno_;
+  absl::flat_hash_map<Fileno, std::string> fileno_to_filename_
+      ABSL_GUARDED_BY(fileno_mutex_);
+  absl::flat_hash_map<std::string, Fileno> filename_to_fileno_
+      ABSL_GUARDED_BY(fileno_mutex_);
 
   // Channels owned by this package. Indexed by channel id. Stored as
   // unique_ptrs for pointer stability.
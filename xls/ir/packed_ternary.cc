@@ -0,0 +1,487 @@
+// Copyright 2022 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/ir/packed_ternary.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "absl/types/optional.h"
+#include "xls/common/bits_util.h"
+#include "xls/common/logging/logging.h"
+
+namespace xls {
+namespace {
+
+constexpr int64_t kWordBits = 64;
+
+// Returns `src` >> `start` truncated (or zero-extended) to `width` bits.
+InlineBitmap Extract(const InlineBitmap& src, int64_t start, int64_t width) {
+  InlineBitmap result(width);
+  int64_t src_words = src.word_count();
+  auto src_word = [&](int64_t wordno) -> uint64_t {
+    return wordno < src_words ? src.GetWord(wordno) : 0;
+  };
+  int64_t shift = start % kWordBits;
+  for (int64_t i = 0; i < result.word_count(); ++i) {
+    int64_t lo = start / kWordBits + i;
+    uint64_t word = src_word(lo) >> shift;
+    if (shift != 0) {
+      word |= src_word(lo + 1) << (kWordBits - shift);
+    }
+    result.SetWord(i, word);
+  }
+  return result;
+}
+
+// ORs `src` shifted left by `offset` bits into `dst`. Bits shifted beyond the
+// width of `dst` are dropped.
+void OrInto(const InlineBitmap& src, int64_t offset, InlineBitmap* dst) {
+  int64_t dst_words = dst->word_count();
+  int64_t shift = offset % kWordBits;
+  for (int64_t i = 0; i < src.word_count(); ++i) {
+    uint64_t word = src.GetWord(i);
+    int64_t d = offset / kWordBits + i;
+    if (d >= dst_words) {
+      break;
+    }
+    dst->SetWord(d, dst->GetWord(d) | (word << shift));
+    if (shift != 0 && d + 1 < dst_words) {
+      dst->SetWord(d + 1, dst->GetWord(d + 1) | (word >> (kWordBits - shift)));
+    }
+  }
+}
+
+// Sets the bits in the range [start, end) of `dst` to `value`.
+void SetRange(int64_t start, int64_t end, bool value, InlineBitmap* dst) {
+  end = std::min(end, dst->bit_count());
+  for (int64_t wordno = start / kWordBits; wordno * kWordBits < end;
+       ++wordno) {
+    int64_t word_start = wordno * kWordBits;
+    int64_t lo = std::max(start, word_start) - word_start;
+    int64_t hi = std::min(end, word_start + kWordBits) - word_start;
+    uint64_t mask = Mask(hi - lo) << lo;
+    uint64_t word = dst->GetWord(wordno);
+    dst->SetWord(wordno, value ? (word | mask) : (word & ~mask));
+  }
+}
+
+// Applies `f` word-by-word to the known and value masks of `a` and `b`. `f`
+// is called as f(known_a, value_a, known_b, value_b, &known, &value).
+template <typename F>
+PackedTernaryVector ZipWords(const PackedTernaryVector& a,
+                             const PackedTernaryVector& b, F f) {
+  XLS_CHECK_EQ(a.bit_count(), b.bit_count());
+  InlineBitmap known(a.bit_count());
+  InlineBitmap values(a.bit_count());
+  for (int64_t i = 0; i < known.word_count(); ++i) {
+    uint64_t k;
+    uint64_t v;
+    f(a.known().GetWord(i), a.values().GetWord(i), b.known().GetWord(i),
+      b.values().GetWord(i), &k, &v);
+    known.SetWord(i, k);
+    values.SetWord(i, v & k);
+  }
+  return PackedTernaryVector(std::move(known), std::move(values));
+}
+
+// Computes the carries of the addition of the two bitmaps `x` and `y`; bit i
+// of the result is the carry into bit position i.
+InlineBitmap Carries(const InlineBitmap& x, const InlineBitmap& y) {
+  InlineBitmap result(x.bit_count());
+  uint64_t carry = 0;
+  for (int64_t i = 0; i < result.word_count(); ++i) {
+    uint64_t a = x.GetWord(i);
+    uint64_t b = y.GetWord(i);
+    uint64_t sum = a + b;
+    uint64_t carry_out = sum < a ? 1 : 0;
+    sum += carry;
+    carry_out |= (carry != 0 && sum == 0) ? 1 : 0;
+    result.SetWord(i, sum ^ a ^ b);
+    carry = carry_out;
+  }
+  return result;
+}
+
+// Returns the carries of a carry chain defined by the recurrence
+//
+//   c[0] = 0
+//   c[i+1] = generate[i] | (propagate[i] & c[i])
+//
+// `generate` and `propagate` must be disjoint. This is the carry chain of the
+// sum of (generate | propagate) and generate.
+InlineBitmap CarryChain(const InlineBitmap& generate,
+                        const InlineBitmap& propagate) {
+  InlineBitmap x(generate.bit_count());
+  for (int64_t i = 0; i < x.word_count(); ++i) {
+    x.SetWord(i, generate.GetWord(i) | propagate.GetWord(i));
+  }
+  return Carries(x, generate);
+}
+
+// Calls `f` with every shift amount less than `bit_count` consistent with the
+// ternary `amount`. Returns whether some consistent amount is greater than or
+// equal to `bit_count`.
+template <typename F>
+bool ForEachShiftAmount(const PackedTernaryVector& amount, int64_t bit_count,
+                        F f) {
+  const InlineBitmap& known = amount.known();
+  const InlineBitmap& values = amount.values();
+  // Whether the bits of the amount at or above bit 64 may be (or are known to
+  // be) nonzero.
+  bool high_may_be_nonzero = false;
+  bool high_known_nonzero = false;
+  for (int64_t i = 1; i < known.word_count(); ++i) {
+    int64_t word_bits = std::min(kWordBits, amount.bit_count() - i * kWordBits);
+    high_may_be_nonzero |=
+        ((~known.GetWord(i) | values.GetWord(i)) & Mask(word_bits)) != 0;
+    high_known_nonzero |= values.GetWord(i) != 0;
+  }
+  uint64_t low_mask = Mask(std::min(kWordBits, amount.bit_count()));
+  uint64_t low_known = known.word_count() > 0 ? known.GetWord(0) : 0;
+  uint64_t low_value = values.word_count() > 0 ? values.GetWord(0) : 0;
+  if (!high_known_nonzero) {
+    for (int64_t s = 0; s < bit_count; ++s) {
+      uint64_t s_bits = static_cast<uint64_t>(s);
+      if ((s_bits & ~low_mask) != 0) {
+        break;
+      }
+      if ((s_bits & low_known) == low_value) {
+        f(s);
+      }
+    }
+  }
+  uint64_t max_low = (~low_known | low_value) & low_mask;
+  return high_may_be_nonzero || max_low >= static_cast<uint64_t>(bit_count);
+}
+
+// Shifts `a` by every amount consistent with `amount` using `shift` and
+// returns the meet of the results.
+template <typename F>
+PackedTernaryVector ShiftByTernary(const PackedTernaryVector& a,
+                                   const PackedTernaryVector& amount,
+                                   F shift) {
+  absl::optional<PackedTernaryVector> result;
+  auto add_result = [&](int64_t s) {
+    PackedTernaryVector shifted = shift(a, s);
+    result = result.has_value() ? packed_ternary_ops::Meet(*result, shifted)
+                                : std::move(shifted);
+  };
+  if (ForEachShiftAmount(amount, a.bit_count(), add_result)) {
+    add_result(a.bit_count());
+  }
+  XLS_CHECK(result.has_value());
+  return *std::move(result);
+}
+
+}  // namespace
+
+PackedTernaryVector::PackedTernaryVector(InlineBitmap known,
+                                         InlineBitmap values)
+    : known_(std::move(known)), values_(std::move(values)) {
+  XLS_CHECK_EQ(known_.bit_count(), values_.bit_count());
+  for (int64_t i = 0; i < known_.word_count(); ++i) {
+    values_.SetWord(i, values_.GetWord(i) & known_.GetWord(i));
+  }
+}
+
+PackedTernaryVector PackedTernaryVector::FromBits(const Bits& bits) {
+  return PackedTernaryVector(InlineBitmap(bits.bit_count(), /*fill=*/true),
+                             bits.bitmap());
+}
+
+PackedTernaryVector PackedTernaryVector::FromKnownBits(
+    const Bits& known_bits, const Bits& known_bits_values) {
+  return PackedTernaryVector(known_bits.bitmap(), known_bits_values.bitmap());
+}
+
+PackedTernaryVector PackedTernaryVector::FromTernaryVector(
+    const TernaryVector& vector) {
+  InlineBitmap known(vector.size());
+  InlineBitmap values(vector.size());
+  for (int64_t i = 0; i < vector.size(); ++i) {
+    known.Set(i, vector[i] != TernaryValue::kUnknown);
+    values.Set(i, vector[i] == TernaryValue::kKnownOne);
+  }
+  return PackedTernaryVector(std::move(known), std::move(values));
+}
+
+TernaryVector PackedTernaryVector::ToTernaryVector() const {
+  TernaryVector result(bit_count());
+  for (int64_t i = 0; i < bit_count(); ++i) {
+    result[i] = Get(i);
+  }
+  return result;
+}
+
+std::string ToString(const PackedTernaryVector& value) {
+  return ToString(value.ToTernaryVector());
+}
+
+namespace packed_ternary_ops {
+
+PackedTernaryVector Not(const PackedTernaryVector& a) {
+  InlineBitmap values(a.bit_count());
+  for (int64_t i = 0; i < values.word_count(); ++i) {
+    values.SetWord(i, ~a.values().GetWord(i) & a.known().GetWord(i));
+  }
+  return PackedTernaryVector(a.known(), std::move(values));
+}
+
+PackedTernaryVector And(const PackedTernaryVector& a,
+                        const PackedTernaryVector& b) {
+  return ZipWords(a, b,
+                  [](uint64_t ka, uint64_t va, uint64_t kb, uint64_t vb,
+                     uint64_t* k, uint64_t* v) {
+                    uint64_t zero = (ka & ~va) | (kb & ~vb);
+                    *v = va & vb;
+                    *k = zero | *v;
+                  });
+}
+
+PackedTernaryVector Or(const PackedTernaryVector& a,
+                       const PackedTernaryVector& b) {
+  return ZipWords(a, b,
+                  [](uint64_t ka, uint64_t va, uint64_t kb, uint64_t vb,
+                     uint64_t* k, uint64_t* v) {
+                    *v = va | vb;
+                    *k = *v | (ka & kb);
+                  });
+}
+
+PackedTernaryVector Xor(const PackedTernaryVector& a,
+                        const PackedTernaryVector& b) {
+  return ZipWords(a, b,
+                  [](uint64_t ka, uint64_t va, uint64_t kb, uint64_t vb,
+                     uint64_t* k, uint64_t* v) {
+                    *k = ka & kb;
+                    *v = va ^ vb;
+                  });
+}
+
+PackedTernaryVector NaryAnd(absl::Span<const PackedTernaryVector> inputs) {
+  XLS_CHECK(!inputs.empty());
+  PackedTernaryVector result = inputs.front();
+  for (const PackedTernaryVector& input : inputs.subspan(1)) {
+    result = And(result, input);
+  }
+  return result;
+}
+
+PackedTernaryVector NaryOr(absl::Span<const PackedTernaryVector> inputs) {
+  XLS_CHECK(!inputs.empty());
+  PackedTernaryVector result = inputs.front();
+  for (const PackedTernaryVector& input : inputs.subspan(1)) {
+    result = Or(result, input);
+  }
+  return result;
+}
+
+PackedTernaryVector NaryXor(absl::Span<const PackedTernaryVector> inputs) {
+  XLS_CHECK(!inputs.empty());
+  PackedTernaryVector result = inputs.front();
+  for (const PackedTernaryVector& input : inputs.subspan(1)) {
+    result = Xor(result, input);
+  }
+  return result;
+}
+
+PackedTernaryVector Add(const PackedTernaryVector& a,
+                        const PackedTernaryVector& b) {
+  XLS_CHECK_EQ(a.bit_count(), b.bit_count());
+  int64_t bit_count = a.bit_count();
+  // A ternary full adder computes carry[i+1] = g[i] | (p[i] & carry[i]) where
+  // g = a & b and p = a ^ b are evaluated with ternary logic. The carry is
+  // known to be one iff the chain of known-one generates and propagates
+  // produces a one. The carry is known to be zero iff the chain of
+  // "maybe-one" generates and propagates does not produce a one. Each chain
+  // is evaluated with a word-parallel binary addition.
+  InlineBitmap gen_one(bit_count);
+  InlineBitmap prop_one(bit_count);
+  InlineBitmap gen_maybe(bit_count);
+  InlineBitmap prop_maybe(bit_count);
+  for (int64_t i = 0; i < gen_one.word_count(); ++i) {
+    uint64_t ka = a.known().GetWord(i);
+    uint64_t va = a.values().GetWord(i);
+    uint64_t kb = b.known().GetWord(i);
+    uint64_t vb = b.values().GetWord(i);
+    uint64_t both_known = ka & kb;
+    gen_one.SetWord(i, va & vb);
+    prop_one.SetWord(i, both_known & (va ^ vb));
+    // g may be one iff neither operand is known zero; p may be one iff the
+    // operands are not known to be equal.
+    uint64_t g_maybe = ~((ka & ~va) | (kb & ~vb));
+    uint64_t p_maybe = ~(both_known & ~(va ^ vb));
+    gen_maybe.SetWord(i, g_maybe);
+    prop_maybe.SetWord(i, p_maybe & ~g_maybe);
+  }
+  InlineBitmap carry_one = CarryChain(gen_one, prop_one);
+  InlineBitmap carry_maybe = CarryChain(gen_maybe, prop_maybe);
+
+  InlineBitmap known(bit_count);
+  InlineBitmap values(bit_count);
+  for (int64_t i = 0; i < known.word_count(); ++i) {
+    uint64_t carry_known = carry_one.GetWord(i) | ~carry_maybe.GetWord(i);
+    uint64_t k = a.known().GetWord(i) & b.known().GetWord(i) & carry_known;
+    known.SetWord(i, k);
+    values.SetWord(i, (a.values().GetWord(i) ^ b.values().GetWord(i) ^
+                       carry_one.GetWord(i)) &
+                          k);
+  }
+  return PackedTernaryVector(std::move(known), std::move(values));
+}
+
+PackedTernaryVector Neg(const PackedTernaryVector& a) {
+  return Add(Not(a), PackedTernaryVector::FromBits(UBits(1, a.bit_count())));
+}
+
+PackedTernaryVector Sub(const PackedTernaryVector& a,
+                        const PackedTernaryVector& b) {
+  return Add(a, Neg(b));
+}
+
+PackedTernaryVector ShiftLeftLogical(const PackedTernaryVector& a,
+                                     int64_t amount) {
+  int64_t bit_count = a.bit_count();
+  InlineBitmap known(bit_count);
+  InlineBitmap values(bit_count);
+  if (amount < bit_count) {
+    OrInto(a.known(), amount, &known);
+    OrInto(a.values(), amount, &values);
+  }
+  SetRange(0, amount, /*value=*/true, &known);
+  return PackedTernaryVector(std::move(known), std::move(values));
+}
+
+PackedTernaryVector ShiftRightLogical(const PackedTernaryVector& a,
+                                      int64_t amount) {
+  int64_t bit_count = a.bit_count();
+  amount = std::min(amount, bit_count);
+  InlineBitmap known = Extract(a.known(), amount, bit_count);
+  InlineBitmap values = Extract(a.values(), amount, bit_count);
+  SetRange(bit_count - amount, bit_count, /*value=*/true, &known);
+  return PackedTernaryVector(std::move(known), std::move(values));
+}
+
+PackedTernaryVector ShiftRightArith(const PackedTernaryVector& a,
+                                    int64_t amount) {
+  int64_t bit_count = a.bit_count();
+  if (bit_count == 0) {
+    return a;
+  }
+  amount = std::min(amount, bit_count);
+  InlineBitmap known = Extract(a.known(), amount, bit_count);
+  InlineBitmap values = Extract(a.values(), amount, bit_count);
+  TernaryValue sign = a.Get(bit_count - 1);
+  SetRange(bit_count - amount, bit_count, sign != TernaryValue::kUnknown,
+           &known);
+  SetRange(bit_count - amount, bit_count, sign == TernaryValue::kKnownOne,
+           &values);
+  return PackedTernaryVector(std::move(known), std::move(values));
+}
+
+PackedTernaryVector ShiftLeftLogical(const PackedTernaryVector& a,
+                                     const PackedTernaryVector& amount) {
+  return ShiftByTernary(a, amount,
+                        [](const PackedTernaryVector& v, int64_t s) {
+                          return ShiftLeftLogical(v, s);
+                        });
+}
+
+PackedTernaryVector ShiftRightLogical(const PackedTernaryVector& a,
+                                      const PackedTernaryVector& amount) {
+  return ShiftByTernary(a, amount,
+                        [](const PackedTernaryVector& v, int64_t s) {
+                          return ShiftRightLogical(v, s);
+                        });
+}
+
+PackedTernaryVector ShiftRightArith(const PackedTernaryVector& a,
+                                    const PackedTernaryVector& amount) {
+  return ShiftByTernary(a, amount,
+                        [](const PackedTernaryVector& v, int64_t s) {
+                          return ShiftRightArith(v, s);
+                        });
+}
+
+PackedTernaryVector Concat(absl::Span<const PackedTernaryVector> inputs) {
+  int64_t bit_count = 0;
+  for (const PackedTernaryVector& input : inputs) {
+    bit_count += input.bit_count();
+  }
+  InlineBitmap known(bit_count);
+  InlineBitmap values(bit_count);
+  int64_t offset = 0;
+  for (int64_t i = inputs.size() - 1; i >= 0; --i) {
+    OrInto(inputs[i].known(), offset, &known);
+    OrInto(inputs[i].values(), offset, &values);
+    offset += inputs[i].bit_count();
+  }
+  return PackedTernaryVector(std::move(known), std::move(values));
+}
+
+PackedTernaryVector BitSlice(const PackedTernaryVector& a, int64_t start,
+                             int64_t width) {
+  XLS_CHECK_GE(start, 0);
+  XLS_CHECK_GE(width, 0);
+  XLS_CHECK_LE(start + width, a.bit_count());
+  return PackedTernaryVector(Extract(a.known(), start, width),
+                             Extract(a.values(), start, width));
+}
+
+PackedTernaryVector ZeroExtend(const PackedTernaryVector& a,
+                               int64_t new_width) {
+  XLS_CHECK_GE(new_width, a.bit_count());
+  InlineBitmap known = Extract(a.known(), 0, new_width);
+  SetRange(a.bit_count(), new_width, /*value=*/true, &known);
+  return PackedTernaryVector(std::move(known),
+                             Extract(a.values(), 0, new_width));
+}
+
+PackedTernaryVector SignExtend(const PackedTernaryVector& a,
+                               int64_t new_width) {
+  XLS_CHECK_GE(new_width, a.bit_count());
+  XLS_CHECK_GT(a.bit_count(), 0);
+  InlineBitmap known = Extract(a.known(), 0, new_width);
+  InlineBitmap values = Extract(a.values(), 0, new_width);
+  TernaryValue sign = a.Get(a.bit_count() - 1);
+  SetRange(a.bit_count(), new_width, sign != TernaryValue::kUnknown, &known);
+  SetRange(a.bit_count(), new_width, sign == TernaryValue::kKnownOne,
+           &values);
+  return PackedTernaryVector(std::move(known), std::move(values));
+}
+
+PackedTernaryVector Meet(const PackedTernaryVector& a,
+                         const PackedTernaryVector& b) {
+  return ZipWords(a, b,
+                  [](uint64_t ka, uint64_t va, uint64_t kb, uint64_t vb,
+                     uint64_t* k, uint64_t* v) {
+                    *k = ka & kb & ~(va ^ vb);
+                    *v = va;
+                  });
+}
+
+PackedTernaryVector Union(const PackedTernaryVector& a,
+                          const PackedTernaryVector& b) {
+  return ZipWords(a, b,
+                  [](uint64_t ka, uint64_t va, uint64_t kb, uint64_t vb,
+                     uint64_t* k, uint64_t* v) {
+                    XLS_DCHECK_EQ(ka & kb & (va ^ vb), 0);
+                    *k = ka | kb;
+                    *v = va | vb;
+                  });
+}
+
+}  // namespace packed_ternary_ops
+}  // namespace xls
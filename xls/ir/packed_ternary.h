@@ -0,0 +1,169 @@
+// Copyright 2022 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_IR_PACKED_TERNARY_H_
+#define XLS_IR_PACKED_TERNARY_H_
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "absl/types/span.h"
+#include "xls/data_structures/inline_bitmap.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/ternary.h"
+
+namespace xls {
+
+// A bit-packed vector of ternary values. Semantically equivalent to a
+// TernaryVector, but each ternary value is represented by a bit in a mask of
+// known bits and a bit in a mask of (known) values, 64 values to a word. This
+// enables word-parallel implementations of the common operations (see
+// packed_ternary_ops below) and is much more compact than a TernaryVector for
+// wide values.
+//
+// Invariant: bits of the value mask are zero wherever the bit is unknown.
+class PackedTernaryVector {
+ public:
+  // Creates a vector of the given width with all bits unknown.
+  explicit PackedTernaryVector(int64_t bit_count)
+      : known_(bit_count), values_(bit_count) {}
+
+  // Creates a vector from masks of known bits and their values. Bits of
+  // `values` where the respective bit in `known` is zero are ignored.
+  PackedTernaryVector(InlineBitmap known, InlineBitmap values);
+
+  // Creates a vector with all bits known to have the given values.
+  static PackedTernaryVector FromBits(const Bits& bits);
+
+  // Creates a vector from a Bits object holding a one for every known bit and a
+  // Bits object holding the values of the known bits.
+  static PackedTernaryVector FromKnownBits(const Bits& known_bits,
+                                           const Bits& known_bits_values);
+
+  static PackedTernaryVector FromTernaryVector(const TernaryVector& vector);
+
+  int64_t bit_count() const { return known_.bit_count(); }
+
+  TernaryValue Get(int64_t index) const {
+    if (!known_.Get(index)) {
+      return TernaryValue::kUnknown;
+    }
+    return values_.Get(index) ? TernaryValue::kKnownOne
+                              : TernaryValue::kKnownZero;
+  }
+
+  // The masks of known bits and their values.
+  const InlineBitmap& known() const { return known_; }
+  const InlineBitmap& values() const { return values_; }
+
+  Bits known_bits() const { return Bits::FromBitmap(known_); }
+  Bits known_bits_values() const { return Bits::FromBitmap(values_); }
+
+  bool AllKnown() const { return known_.IsAllOnes(); }
+  bool AllUnknown() const { return known_.IsAllZeroes(); }
+
+  TernaryVector ToTernaryVector() const;
+
+  bool operator==(const PackedTernaryVector& other) const {
+    return known_ == other.known_ && values_ == other.values_;
+  }
+  bool operator!=(const PackedTernaryVector& other) const {
+    return !(*this == other);
+  }
+
+ private:
+  InlineBitmap known_;
+  InlineBitmap values_;
+};
+
+// Format is the same as for TernaryVector, for example: 0b10XX1
+std::string ToString(const PackedTernaryVector& value);
+
+inline std::ostream& operator<<(std::ostream& os,
+                                const PackedTernaryVector& value) {
+  os << ToString(value);
+  return os;
+}
+
+// Word-parallel operations on packed ternary vectors. Unless otherwise noted,
+// the results are identical to those computed bit-at-a-time by the
+// AbstractEvaluator-based TernaryEvaluator.
+namespace packed_ternary_ops {
+
+PackedTernaryVector Not(const PackedTernaryVector& a);
+PackedTernaryVector And(const PackedTernaryVector& a,
+                        const PackedTernaryVector& b);
+PackedTernaryVector Or(const PackedTernaryVector& a,
+                       const PackedTernaryVector& b);
+PackedTernaryVector Xor(const PackedTernaryVector& a,
+                        const PackedTernaryVector& b);
+
+// N-ary versions of the bitwise operations. `inputs` must be non-empty.
+PackedTernaryVector NaryAnd(absl::Span<const PackedTernaryVector> inputs);
+PackedTernaryVector NaryOr(absl::Span<const PackedTernaryVector> inputs);
+PackedTernaryVector NaryXor(absl::Span<const PackedTernaryVector> inputs);
+
+// Returns the sum of `a` and `b` (which must be the same width). Computes the
+// same result as a ripple-carry adder of ternary full adders, with the carry
+// chains resolved word-parallel.
+PackedTernaryVector Add(const PackedTernaryVector& a,
+                        const PackedTernaryVector& b);
+PackedTernaryVector Neg(const PackedTernaryVector& a);
+PackedTernaryVector Sub(const PackedTernaryVector& a,
+                        const PackedTernaryVector& b);
+
+// Shifts by a constant amount. Shifting by the width of the input or more
+// results in all zeros (or all sign bits for arithmetic shifts).
+PackedTernaryVector ShiftLeftLogical(const PackedTernaryVector& a,
+                                     int64_t amount);
+PackedTernaryVector ShiftRightLogical(const PackedTernaryVector& a,
+                                      int64_t amount);
+PackedTernaryVector ShiftRightArith(const PackedTernaryVector& a,
+                                    int64_t amount);
+
+// Shifts by a ternary amount. The result is the most precise ternary vector
+// covering the shift of `a` by every amount consistent with `amount`.
+PackedTernaryVector ShiftLeftLogical(const PackedTernaryVector& a,
+                                     const PackedTernaryVector& amount);
+PackedTernaryVector ShiftRightLogical(const PackedTernaryVector& a,
+                                      const PackedTernaryVector& amount);
+PackedTernaryVector ShiftRightArith(const PackedTernaryVector& a,
+                                    const PackedTernaryVector& amount);
+
+// Concatenates the inputs. As with the concat operation, the first input
+// holds the most significant bits of the result.
+PackedTernaryVector Concat(absl::Span<const PackedTernaryVector> inputs);
+
+PackedTernaryVector BitSlice(const PackedTernaryVector& a, int64_t start,
+                             int64_t width);
+PackedTernaryVector ZeroExtend(const PackedTernaryVector& a,
+                               int64_t new_width);
+PackedTernaryVector SignExtend(const PackedTernaryVector& a,
+                               int64_t new_width);
+
+// Returns a vector in which a bit is known if it is known in both `a` and `b`
+// with the same value; i.e., the most precise vector covering both.
+PackedTernaryVector Meet(const PackedTernaryVector& a,
+                         const PackedTernaryVector& b);
+
+// Returns a vector in which a bit is known if it is known in either `a` or
+// `b`. `a` and `b` must not disagree on any bit known in both.
+PackedTernaryVector Union(const PackedTernaryVector& a,
+                          const PackedTernaryVector& b);
+
+}  // namespace packed_ternary_ops
+}  // namespace xls
+
+#endif  // XLS_IR_PACKED_TERNARY_H_
@@ -0,0 +1,240 @@
+// Copyright 2022 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/ir/packed_ternary.h"
+
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/types/optional.h"
+#include "xls/ir/abstract_evaluator.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/bits_ops.h"
+#include "xls/ir/ternary.h"
+
+namespace xls {
+namespace {
+
+namespace pt = packed_ternary_ops;
+
+// Bit-at-a-time ternary evaluator used as the reference implementation.
+class ReferenceEvaluator
+    : public AbstractEvaluator<TernaryValue, ReferenceEvaluator> {
+ public:
+  TernaryValue One() const { return TernaryValue::kKnownOne; }
+  TernaryValue Zero() const { return TernaryValue::kKnownZero; }
+  TernaryValue Not(const TernaryValue& input) const {
+    if (input == TernaryValue::kUnknown) {
+      return TernaryValue::kUnknown;
+    }
+    return input == TernaryValue::kKnownOne ? TernaryValue::kKnownZero
+                                            : TernaryValue::kKnownOne;
+  }
+  TernaryValue And(const TernaryValue& a, const TernaryValue& b) const {
+    return ternary_ops::And(a, b);
+  }
+  TernaryValue Or(const TernaryValue& a, const TernaryValue& b) const {
+    return ternary_ops::Or(a, b);
+  }
+};
+
+// Returns all ternary vectors of the given width.
+std::vector<TernaryVector> AllTernaryVectors(int64_t width) {
+  std::vector<TernaryVector> result = {TernaryVector()};
+  for (int64_t i = 0; i < width; ++i) {
+    std::vector<TernaryVector> next;
+    for (const TernaryVector& v : result) {
+      for (TernaryValue t :
+           {TernaryValue::kKnownZero, TernaryValue::kKnownOne,
+            TernaryValue::kUnknown}) {
+        next.push_back(v);
+        next.back().push_back(t);
+      }
+    }
+    result = std::move(next);
+  }
+  return result;
+}
+
+TernaryVector RandomTernaryVector(int64_t width, std::mt19937_64* rng) {
+  TernaryVector result(width);
+  std::uniform_int_distribution<int> dist(0, 2);
+  for (TernaryValue& t : result) {
+    t = static_cast<TernaryValue>(dist(*rng));
+  }
+  return result;
+}
+
+// Returns all concrete values consistent with the given ternary vector.
+std::vector<Bits> Concretize(const TernaryVector& v) {
+  std::vector<Bits> result;
+  for (int64_t i = 0; i < (int64_t{1} << v.size()); ++i) {
+    Bits bits = UBits(i, v.size());
+    bool consistent = true;
+    for (int64_t j = 0; j < v.size(); ++j) {
+      if (v[j] != TernaryValue::kUnknown &&
+          bits.Get(j) != (v[j] == TernaryValue::kKnownOne)) {
+        consistent = false;
+      }
+    }
+    if (consistent) {
+      result.push_back(bits);
+    }
+  }
+  return result;
+}
+
+// Returns the most precise ternary vector covering `f` applied to all concrete
+// values consistent with `a` and `b`.
+TernaryVector Exhaustive(const TernaryVector& a, const TernaryVector& b,
+                         std::function<Bits(const Bits&, const Bits&)> f) {
+  absl::optional<PackedTernaryVector> result;
+  for (const Bits& x : Concretize(a)) {
+    for (const Bits& y : Concretize(b)) {
+      PackedTernaryVector v = PackedTernaryVector::FromBits(f(x, y));
+      result = result.has_value() ? pt::Meet(*result, v) : v;
+    }
+  }
+  return result->ToTernaryVector();
+}
+
+PackedTernaryVector P(const TernaryVector& v) {
+  return PackedTernaryVector::FromTernaryVector(v);
+}
+
+TEST(PackedTernaryTest, RoundTrip) {
+  TernaryVector v = StringToTernaryVector("0b1X0X_X110").value();
+  PackedTernaryVector packed = P(v);
+  EXPECT_EQ(packed.bit_count(), 8);
+  EXPECT_EQ(packed.ToTernaryVector(), v);
+  EXPECT_EQ(ToString(packed), ToString(v));
+  EXPECT_EQ(packed.known_bits(), UBits(0b1010'0111, 8));
+  EXPECT_EQ(packed.known_bits_values(), UBits(0b1000'0110, 8));
+  EXPECT_EQ(PackedTernaryVector::FromKnownBits(packed.known_bits(),
+                                               packed.known_bits_values()),
+            packed);
+  EXPECT_TRUE(PackedTernaryVector(3).AllUnknown());
+  EXPECT_TRUE(PackedTernaryVector::FromBits(UBits(5, 3)).AllKnown());
+}
+
+TEST(PackedTernaryTest, ExhaustiveSmallWidths) {
+  ReferenceEvaluator eval;
+  for (int64_t width = 1; width <= 3; ++width) {
+    std::vector<TernaryVector> vectors = AllTernaryVectors(width);
+    for (const TernaryVector& a : vectors) {
+      EXPECT_EQ(pt::Not(P(a)).ToTernaryVector(), eval.BitwiseNot(a));
+      EXPECT_EQ(pt::Neg(P(a)).ToTernaryVector(), eval.Neg(a));
+      for (const TernaryVector& b : vectors) {
+        EXPECT_EQ(pt::And(P(a), P(b)).ToTernaryVector(),
+                  eval.BitwiseAnd(a, b));
+        EXPECT_EQ(pt::Or(P(a), P(b)).ToTernaryVector(), eval.BitwiseOr(a, b));
+        EXPECT_EQ(pt::Xor(P(a), P(b)).ToTernaryVector(),
+                  eval.BitwiseXor(a, b));
+        EXPECT_EQ(pt::Add(P(a), P(b)).ToTernaryVector(), eval.Add(a, b));
+        EXPECT_EQ(pt::Sub(P(a), P(b)).ToTernaryVector(),
+                  eval.Add(a, eval.Neg(b)));
+      }
+    }
+  }
+}
+
+TEST(PackedTernaryTest, ShiftsAreExact) {
+  for (int64_t width = 1; width <= 4; ++width) {
+    for (int64_t amount_width = 1; amount_width <= 3; ++amount_width) {
+      for (const TernaryVector& a : AllTernaryVectors(width)) {
+        for (const TernaryVector& amount : AllTernaryVectors(amount_width)) {
+          auto shift_amount = [](const Bits& b) {
+            return static_cast<int64_t>(b.ToUint64().value());
+          };
+          EXPECT_EQ(pt::ShiftLeftLogical(P(a), P(amount)).ToTernaryVector(),
+                    Exhaustive(a, amount,
+                               [&](const Bits& x, const Bits& y) {
+                                 return bits_ops::ShiftLeftLogical(
+                                     x, shift_amount(y));
+                               }));
+          EXPECT_EQ(pt::ShiftRightLogical(P(a), P(amount)).ToTernaryVector(),
+                    Exhaustive(a, amount,
+                               [&](const Bits& x, const Bits& y) {
+                                 return bits_ops::ShiftRightLogical(
+                                     x, shift_amount(y));
+                               }));
+          EXPECT_EQ(pt::ShiftRightArith(P(a), P(amount)).ToTernaryVector(),
+                    Exhaustive(a, amount,
+                               [&](const Bits& x, const Bits& y) {
+                                 return bits_ops::ShiftRightArith(
+                                     x, shift_amount(y));
+                               }));
+        }
+      }
+    }
+  }
+}
+
+TEST(PackedTernaryTest, WideValuesMatchReference) {
+  ReferenceEvaluator eval;
+  std::mt19937_64 rng(0);
+  for (int64_t width : {1, 63, 64, 65, 128, 200}) {
+    for (int64_t trial = 0; trial < 20; ++trial) {
+      TernaryVector a = RandomTernaryVector(width, &rng);
+      TernaryVector b = RandomTernaryVector(width, &rng);
+      // Make long carry chains likely by knowing most low bits.
+      for (int64_t i = 0; i < width && trial % 2 == 0; ++i) {
+        if (i % 17 != 0) {
+          a[i] = TernaryValue::kKnownOne;
+        }
+      }
+      EXPECT_EQ(pt::And(P(a), P(b)).ToTernaryVector(), eval.BitwiseAnd(a, b));
+      EXPECT_EQ(pt::Or(P(a), P(b)).ToTernaryVector(), eval.BitwiseOr(a, b));
+      EXPECT_EQ(pt::Xor(P(a), P(b)).ToTernaryVector(), eval.BitwiseXor(a, b));
+      EXPECT_EQ(pt::Add(P(a), P(b)).ToTernaryVector(), eval.Add(a, b));
+      EXPECT_EQ(pt::Neg(P(b)).ToTernaryVector(), eval.Neg(b));
+      EXPECT_EQ(pt::Concat({P(a), P(b)}).ToTernaryVector(),
+                eval.Concat({a, b}));
+      EXPECT_EQ(pt::ZeroExtend(P(a), width + 70).ToTernaryVector(),
+                eval.ZeroExtend(a, width + 70));
+      EXPECT_EQ(pt::SignExtend(P(a), width + 70).ToTernaryVector(),
+                eval.SignExtend(a, width + 70));
+      for (int64_t start : {int64_t{0}, width / 3, width - 1}) {
+        int64_t slice_width = width - start;
+        EXPECT_EQ(pt::BitSlice(P(a), start, slice_width).ToTernaryVector(),
+                  eval.BitSlice(a, start, slice_width));
+      }
+      for (int64_t amount :
+           {int64_t{0}, int64_t{1}, width / 2, width - 1, width, width + 5}) {
+        TernaryVector amount_vector =
+            eval.BitsToVector(UBits(amount, Bits::MinBitCountUnsigned(
+                                                width + 5)));
+        EXPECT_EQ(pt::ShiftLeftLogical(P(a), amount).ToTernaryVector(),
+                  eval.ShiftLeftLogical(a, amount_vector));
+        EXPECT_EQ(pt::ShiftRightLogical(P(a), amount).ToTernaryVector(),
+                  eval.ShiftRightLogical(a, amount_vector));
+        EXPECT_EQ(pt::ShiftRightArith(P(a), amount).ToTernaryVector(),
+                  eval.ShiftRightArith(a, amount_vector));
+      }
+    }
+  }
+}
+
+TEST(PackedTernaryTest, MeetAndUnion) {
+  TernaryVector a = StringToTernaryVector("0b10X1_X0X1").value();
+  TernaryVector b = StringToTernaryVector("0b1X01_00XX").value();
+  EXPECT_EQ(ToString(pt::Meet(P(a), P(b))), "0b1XX1_X0XX");
+  EXPECT_EQ(ToString(pt::Union(P(a), P(b))), "0b1001_00X1");
+}
+
+}  // namespace
+}  // namespace xls
@@ -28,6 +28,7 @@
 #include "xls/interpreter/ir_evaluator_test_base.h"
 #include "xls/interpreter/random_value.h"
 #include "xls/ir/function_builder.h"
+#include "xls/ir/value_helpers.h"
 #include "re2/re2.h"
 
 namespace xls {
@@ -403,6 +404,36 @@ TEST(IrJitTest, ArrayConcatArrayOfBits) {
   EXPECT_THAT(RunJitNoEvents(jit.get(), args), IsOkAndHolds(ret));
 }
 
+// Writing every byte of every segment (then masking to the leaf width) must
+// produce the all-ones value of the type.
+TEST(IrJitTest, BitsSegmentsCoverEveryLeaf) {
+  Package package("my_package");
+  std::string ir_text = R"(
+  fn f(x: (bits[3], bits[17][2], (), bits[64])) -> bits[3] {
+    ret tuple_index.1: bits[3] = tuple_index(x, index=0)
+  }
+  )";
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function,
+                           Parser::ParseFunction(ir_text, &package));
+  XLS_ASSERT_OK_AND_ASSIGN(auto jit, IrJit::Create(function));
+
+  Type* type = function->param(0)->GetType();
+  std::vector<BufferBitsSegment> segments =
+      jit->runtime()->GetBitsSegments(type);
+  ASSERT_EQ(segments.size(), 4);
+  std::vector<uint8_t> buffer(jit->GetArgTypeSize(0), 0);
+  for (const BufferBitsSegment& segment : segments) {
+    for (int64_t i = 0; i < (segment.bit_count + 7) / 8; ++i) {
+      buffer[segment.byte_offset + i] = 0xff;
+    }
+    if (segment.bit_count % 8 != 0) {
+      buffer[segment.msb_byte_offset] &= (1 << (segment.bit_count % 8)) - 1;
+    }
+  }
+  EXPECT_EQ(jit->runtime()->UnpackBuffer(buffer.data(), type),
+            AllOnesOfType(type));
+}
+
 TEST(IrJitTest, ArrayConcatArrayOfBitsMixedOperands) {
   Package package("my_package");
 
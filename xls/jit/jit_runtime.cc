@@ -164,6 +164,47 @@ void JitRuntime::BlitValueToBuffer(const Value& value, const Type* type,
   }
 }
 
+static void AppendBitsSegments(const Type* type, int64_t offset,
+                               LlvmTypeConverter* type_converter,
+                               const llvm::DataLayout& data_layout,
+                               std::vector<BufferBitsSegment>* segments) {
+  if (type->IsBits()) {
+    int64_t bit_count = type->AsBitsOrDie()->bit_count();
+    int64_t byte_count = CeilOfRatio(bit_count, kCharBit);
+    int64_t msb_byte_offset =
+        data_layout.isBigEndian() ? offset : offset + byte_count - 1;
+    segments->push_back(BufferBitsSegment{.byte_offset = offset,
+                                          .bit_count = bit_count,
+                                          .msb_byte_offset = msb_byte_offset});
+  } else if (type->IsArray()) {
+    const ArrayType* array_type = type->AsArrayOrDie();
+    int64_t element_size =
+        type_converter->GetTypeByteSize(array_type->element_type());
+    for (int64_t i = 0; i < array_type->size(); ++i) {
+      AppendBitsSegments(array_type->element_type(), offset + i * element_size,
+                         type_converter, data_layout, segments);
+    }
+  } else if (type->IsTuple()) {
+    llvm::Type* llvm_type = type_converter->ConvertToLlvmType(type);
+    const llvm::StructLayout* layout =
+        data_layout.getStructLayout(llvm::cast<llvm::StructType>(llvm_type));
+    const TupleType* tuple_type = type->AsTupleOrDie();
+    for (int64_t i = 0; i < tuple_type->size(); ++i) {
+      AppendBitsSegments(tuple_type->element_type(i),
+                         offset + layout->getElementOffset(i), type_converter,
+                         data_layout, segments);
+    }
+  }
+  // Tokens contain no data.
+}
+
+std::vector<BufferBitsSegment> JitRuntime::GetBitsSegments(const Type* type) {
+  std::vector<BufferBitsSegment> segments;
+  AppendBitsSegments(type, /*offset=*/0, type_converter_, data_layout_,
+                     &segments);
+  return segments;
+}
+
 template <typename T>
 std::string JitRuntime::DumpToString(const T& llvm_object) {
   std::string buffer;
@@ -16,6 +16,7 @@
 #define XLS_JIT_JIT_RUNTIME_H_
 
 #include <cstdint>
+#include <vector>
 
 #include "absl/status/status.h"
 #include "absl/types/span.h"
@@ -29,6 +30,17 @@
 
 namespace xls {
 
+// Location of one bits-typed leaf of a value within its JIT buffer.
+struct BufferBitsSegment {
+  // Offset of the leaf's first byte within the buffer.
+  int64_t byte_offset;
+  // Width of the leaf; its storage spans CeilOfRatio(bit_count, 8) bytes.
+  int64_t bit_count;
+  // Offset of the byte holding the most significant bits, whose bits above
+  // bit_count must be zero.
+  int64_t msb_byte_offset;
+};
+
 // JitRuntime contains routines necessary for executing code generated by the
 // IR JIT. For type resolution, the JIT packs input data into and pulls
 // data out of a flat character buffer, thus these routines are necessary.
@@ -55,6 +67,13 @@ class JitRuntime {
   void BlitValueToBuffer(const Value& value, const Type* type,
                          absl::Span<uint8_t> buffer);
 
+  // Returns the location of every bits-typed leaf of a value of the given type
+  // within its buffer, in the order BlitValueToBuffer() visits them. Lets
+  // callers write values into JIT buffers directly (e.g. random stimulus)
+  // without constructing a Value; the returned layout may be used from any
+  // thread.
+  std::vector<BufferBitsSegment> GetBitsSegments(const Type* type);
+
   // Returns a textual description of the argument LLVM object.
   template <typename T>
   static std::string DumpToString(const T& llvm_object);
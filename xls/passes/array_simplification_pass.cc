@@ -22,6 +22,7 @@
 #include "xls/ir/nodes.h"
 #include "xls/ir/type.h"
 #include "xls/ir/value_helpers.h"
+#include "xls/passes/query_engine_cache.h"
 #include "xls/passes/ternary_query_engine.h"
 
 namespace xls {
@@ -113,12 +114,13 @@ bool IndicesAreDefinitelyPrefixOf(absl::Span<Node* const> prefix,
 // replaced with a literal value equal to the maximum in-bounds index value
 // (size of array minus one). Only known-OOB are clamped. Maybe OOB indices
 // cannot be replaced because the index might be a different in-bounds value.
-absl::StatusOr<bool> ClampArrayIndexIndices(FunctionBase* func) {
+absl::StatusOr<bool> ClampArrayIndexIndices(FunctionBase* func,
+                                            QueryEngineCache* cache) {
   // This transformation may add nodes to the graph which invalidates the query
-  // engine for later use, so create a private engine for exclusive use of this
-  // transformation.
-  TernaryQueryEngine query_engine;
-  XLS_RETURN_IF_ERROR(query_engine.Populate(func).status());
+  // engine for later use, so later transformations obtain a refreshed engine
+  // from the cache.
+  XLS_ASSIGN_OR_RETURN(TernaryQueryEngine * query_engine,
+                       cache->GetTernaryQueryEngine(func));
   bool changed = false;
   for (Node* node : TopoSort(func)) {
     if (node->Is<ArrayIndex>()) {
@@ -127,7 +129,7 @@ absl::StatusOr<bool> ClampArrayIndexIndices(FunctionBase* func) {
       for (int64_t i = 0; i < array_index->indices().size(); ++i) {
         Node* index = array_index->indices()[i];
         ArrayType* array_type = subtype->AsArrayOrDie();
-        if (IndexIsDefinitelyOutOfBounds(index, array_type, query_engine)) {
+        if (IndexIsDefinitelyOutOfBounds(index, array_type, *query_engine)) {
           XLS_ASSIGN_OR_RETURN(
               Literal * new_index,
               func->MakeNode<Literal>(index->loc(),
@@ -663,9 +665,10 @@ FlattenArrayUpdateChain(ArrayUpdate* array_update,
 
 // Walk the function and replace chains of sequential array updates with kArray
 // operations with gather the update values.
-absl::StatusOr<bool> FlattenSequentialUpdates(FunctionBase* func) {
-  TernaryQueryEngine query_engine;
-  XLS_RETURN_IF_ERROR(query_engine.Populate(func).status());
+absl::StatusOr<bool> FlattenSequentialUpdates(FunctionBase* func,
+                                              QueryEngineCache* cache) {
+  XLS_ASSIGN_OR_RETURN(TernaryQueryEngine * query_engine,
+                       cache->GetTernaryQueryEngine(func));
   absl::flat_hash_set<ArrayUpdate*> flattened_updates;
   bool changed = false;
   // Perform this optimization in reverse topo sort order because we are looking
@@ -681,7 +684,7 @@ absl::StatusOr<bool> FlattenSequentialUpdates(FunctionBase* func) {
     }
     XLS_ASSIGN_OR_RETURN(
         absl::optional<std::vector<ArrayUpdate*>> flattened_vec,
-        FlattenArrayUpdateChain(array_update, query_engine));
+        FlattenArrayUpdateChain(array_update, *query_engine));
     if (flattened_vec.has_value()) {
       changed = true;
       flattened_updates.insert(flattened_vec->begin(), flattened_vec->end());
@@ -918,36 +921,41 @@ absl::StatusOr<bool> ArraySimplificationPass::RunOnFunctionBaseInternal(
     PassResults* results) const {
   bool changed = false;
 
-  XLS_ASSIGN_OR_RETURN(bool clamp_changed, ClampArrayIndexIndices(func));
+  XLS_ASSIGN_OR_RETURN(
+      bool clamp_changed,
+      ClampArrayIndexIndices(func, GetQueryEngineCache(results)));
   changed |= clamp_changed;
 
-  TernaryQueryEngine query_engine;
-  XLS_RETURN_IF_ERROR(query_engine.Populate(func).status());
+  XLS_ASSIGN_OR_RETURN(
+      TernaryQueryEngine * query_engine,
+      GetQueryEngineCache(results)->GetTernaryQueryEngine(func));
 
   for (Node* node : TopoSort(func)) {
     if (node->Is<ArrayIndex>()) {
       ArrayIndex* array_index = node->As<ArrayIndex>();
       XLS_ASSIGN_OR_RETURN(bool node_changed,
-                           SimplifyArrayIndex(array_index, query_engine));
+                           SimplifyArrayIndex(array_index, *query_engine));
       changed = changed | node_changed;
     } else if (node->Is<ArrayUpdate>()) {
       XLS_ASSIGN_OR_RETURN(
           bool node_changed,
-          SimplifyArrayUpdate(node->As<ArrayUpdate>(), query_engine));
+          SimplifyArrayUpdate(node->As<ArrayUpdate>(), *query_engine));
       changed = changed | node_changed;
     } else if (node->Is<Array>()) {
       XLS_ASSIGN_OR_RETURN(bool node_changed,
-                           SimplifyArray(node->As<Array>(), query_engine));
+                           SimplifyArray(node->As<Array>(), *query_engine));
       changed = changed | node_changed;
     } else if (IsBinarySelect(node)) {
       XLS_ASSIGN_OR_RETURN(
           bool node_changed,
-          SimplifyBinarySelect(node->As<Select>(), query_engine));
+          SimplifyBinarySelect(node->As<Select>(), *query_engine));
       changed = changed | node_changed;
     }
   }
 
-  XLS_ASSIGN_OR_RETURN(bool flatten_changed, FlattenSequentialUpdates(func));
+  XLS_ASSIGN_OR_RETURN(
+      bool flatten_changed,
+      FlattenSequentialUpdates(func, GetQueryEngineCache(results)));
   changed = changed | flatten_changed;
   return changed;
 }
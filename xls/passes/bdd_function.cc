@@ -14,6 +14,7 @@
 
 #include "xls/passes/bdd_function.h"
 
+#include <algorithm>
 #include <vector>
 
 #include "absl/container/flat_hash_set.h"
@@ -131,6 +132,9 @@ class SaturatingBddEvaluator
   BinaryDecisionDiagram* bdd_;
 };
 
+// The number of BDD nodes beyond which unused nodes are garbage collected.
+constexpr int64_t kGarbageCollectionThreshold = 64 * 1024;
+
 // Returns whether the given op should be included in BDD computations.
 bool ShouldEvaluate(Node* node) {
   if (!node->GetType()->IsBits()) {
@@ -254,7 +258,8 @@ bool ShouldEvaluate(Node* node) {
 
 /* static */ absl::StatusOr<std::unique_ptr<BddFunction>> BddFunction::Run(
     FunctionBase* f, int64_t path_limit,
-    absl::optional<std::function<bool(const Node*)>> node_filter) {
+    absl::optional<std::function<bool(const Node*)>> node_filter,
+    bool enable_sifting) {
   XLS_VLOG(1) << absl::StreamFormat("BddFunction::Run(%s):", f->name());
   XLS_VLOG_LINES(5, f->DumpIr());
 
@@ -273,6 +278,31 @@ bool ShouldEvaluate(Node* node) {
 
   XLS_VLOG(3) << "BDD expressions:";
   absl::flat_hash_map<Node*, SaturatingBddNodeVector> values;
+
+  // Intermediate BDD nodes created while evaluating an XLS node are garbage
+  // once the evaluation is complete. Reclaim them (and optionally reorder the
+  // variables) whenever the BDD grows past a threshold. The threshold grows
+  // with the number of live nodes to amortize the cost of collection.
+  int64_t collection_threshold = kGarbageCollectionThreshold;
+  auto maybe_collect_garbage = [&]() {
+    BinaryDecisionDiagram& bdd = bdd_function->bdd();
+    if (bdd.size() <= collection_threshold) {
+      return;
+    }
+    std::vector<BddNodeIndex> roots;
+    for (const auto& [node, node_values] : values) {
+      for (const SaturatingBddNodeIndex& value : node_values) {
+        roots.push_back(absl::get<BddNodeIndex>(value));
+      }
+    }
+    if (enable_sifting) {
+      bdd.Sift(roots);
+    } else {
+      bdd.GarbageCollect(roots);
+    }
+    collection_threshold =
+        std::max(kGarbageCollectionThreshold, 2 * bdd.size());
+  };
   for (Node* node : TopoSort(f)) {
     if (!node->GetType()->IsBits()) {
       continue;
@@ -304,6 +334,7 @@ bool ShouldEvaluate(Node* node) {
         }
       }
     }
+    maybe_collect_garbage();
     XLS_VLOG(5) << "  " << node->GetName() << ":";
     for (int64_t i = 0; i < node->BitCountOrDie(); ++i) {
       XLS_VLOG(5) << absl::StreamFormat(
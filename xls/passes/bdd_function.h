@@ -55,10 +55,17 @@ class BddFunction {
   // for which no information is known. If `node_filter` returns true, the node
   // still might *not* be evaluated because some kinds of nodes are never
   // evaluated for various reasons including computation expense.
+  //
+  // BDD nodes which are no longer needed are periodically garbage collected
+  // during construction. If `enable_sifting` is true, the BDD variables are
+  // also reordered by sifting at each collection, which can considerably
+  // reduce the size of the BDD (and the path counts of its expressions) at
+  // the cost of additional construction time.
   static absl::StatusOr<std::unique_ptr<BddFunction>> Run(
       FunctionBase* f, int64_t path_limit = 0,
       absl::optional<std::function<bool(const Node*)>> node_filter =
-          absl::nullopt);
+          absl::nullopt,
+      bool enable_sifting = false);
 
   // Returns the underlying BDD.
   const BinaryDecisionDiagram& bdd() const { return bdd_; }
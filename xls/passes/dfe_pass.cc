@@ -20,6 +20,7 @@
 #include "xls/ir/block.h"
 #include "xls/ir/node_util.h"
 #include "xls/ir/proc.h"
+#include "xls/passes/query_engine_cache.h"
 
 namespace xls {
 namespace {
@@ -141,6 +142,7 @@ absl::StatusOr<bool> DeadFunctionEliminationPass::RunInternal(
     if (f->IsProc()) {
       removed_procs.push_back(f->AsProcOrDie());
     }
+    InvalidateQueryEngineCache(results, f);
     XLS_RETURN_IF_ERROR(p->RemoveFunctionBase(f));
   }
 
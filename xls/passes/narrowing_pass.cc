@@ -25,6 +25,7 @@
 #include "xls/ir/ternary.h"
 #include "xls/ir/value_helpers.h"
 #include "xls/passes/query_engine.h"
+#include "xls/passes/query_engine_cache.h"
 #include "xls/passes/range_query_engine.h"
 #include "xls/passes/ternary_query_engine.h"
 #include "xls/passes/union_query_engine.h"
@@ -754,32 +755,36 @@ absl::StatusOr<bool> MaybeReplacePreciseWithLiteral(
   return true;
 }
 
-static absl::StatusOr<std::unique_ptr<QueryEngine>> GetQueryEngine(
-    FunctionBase* f, bool use_range_analysis) {
-  std::unique_ptr<QueryEngine> query_engine;
-  if (use_range_analysis) {
-    auto ternary_query_engine = std::make_unique<TernaryQueryEngine>();
-    auto range_query_engine = std::make_unique<RangeQueryEngine>();
-
-    if (XLS_VLOG_IS_ON(3)) {
-      RangeAnalysisLog(f, *ternary_query_engine, *range_query_engine);
-    }
+// Returns the query engine to use for narrowing. Engines are obtained from the
+// given cache; if range analysis is used, the union of the ternary and range
+// engines is constructed in `union_engine`.
+static absl::StatusOr<QueryEngine*> GetQueryEngine(
+    FunctionBase* f, bool use_range_analysis, QueryEngineCache* cache,
+    std::unique_ptr<QueryEngine>* union_engine) {
+  XLS_ASSIGN_OR_RETURN(TernaryQueryEngine * ternary_query_engine,
+                       cache->GetTernaryQueryEngine(f));
+  if (!use_range_analysis) {
+    return ternary_query_engine;
+  }
+  XLS_ASSIGN_OR_RETURN(RangeQueryEngine * range_query_engine,
+                       cache->GetRangeQueryEngine(f));
 
-    std::vector<std::unique_ptr<QueryEngine>> engines;
-    engines.push_back(std::move(ternary_query_engine));
-    engines.push_back(std::move(range_query_engine));
-    query_engine = std::make_unique<UnionQueryEngine>(std::move(engines));
-  } else {
-    query_engine = std::make_unique<TernaryQueryEngine>();
+  if (XLS_VLOG_IS_ON(3)) {
+    RangeAnalysisLog(f, *ternary_query_engine, *range_query_engine);
   }
-  XLS_RETURN_IF_ERROR(query_engine->Populate(f).status());
-  return std::move(query_engine);
+
+  *union_engine = std::make_unique<UnionQueryEngine>(
+      std::vector<QueryEngine*>{ternary_query_engine, range_query_engine});
+  return union_engine->get();
 }
 
 absl::StatusOr<bool> NarrowingPass::RunOnFunctionBaseInternal(
     FunctionBase* f, const PassOptions& options, PassResults* results) const {
-  XLS_ASSIGN_OR_RETURN(std::unique_ptr<QueryEngine> query_engine,
-                       GetQueryEngine(f, use_range_analysis_));
+  std::unique_ptr<QueryEngine> union_engine;
+  XLS_ASSIGN_OR_RETURN(QueryEngine * query_engine,
+                       GetQueryEngine(f, use_range_analysis_,
+                                      GetQueryEngineCache(results),
+                                      &union_engine));
 
   bool modified = false;
 
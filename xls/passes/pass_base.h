@@ -38,6 +38,8 @@
 
 namespace xls {
 
+class QueryEngineCache;
+
 // This file defines a set of base classes for building XLS compiler passes and
 // pass pipelines. The base classes are templated allowing polymorphism of the
 // data types the pass operates on.
@@ -70,6 +72,11 @@ struct PassOptions {
   // chains of selects. Otherwise, this optimization is skipped, since it can
   // sometimes reduce output quality.
   std::optional<int64_t> convert_array_index_to_select = std::nullopt;
+
+  // The number of threads on which function-local passes are run. Each
+  // function base is transformed by at most one thread at a time, and the
+  // result is identical to that of a sequential run.
+  int64_t thread_count = 1;
 };
 
 // An object containing information about the invocation of a pass (single call
@@ -90,6 +97,13 @@ struct PassInvocation {
 struct PassResults {
   // This vector contains and entry for each invocation of each pass.
   std::vector<PassInvocation> invocations;
+
+  // Query engine analyses shared across the passes of a pipeline. Passes
+  // obtain their query engines from this cache (via GetQueryEngineCache in
+  // query_engine_cache.h) rather than constructing and populating them from
+  // scratch. Created on first use; held by pointer so that the pass base does
+  // not depend on the query engines.
+  std::shared_ptr<QueryEngineCache> query_engine_cache;
 };
 
 // Base class for all compiler passes. Template parameters:
@@ -14,13 +14,92 @@
 
 #include "xls/passes/passes.h"
 
+#include <algorithm>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/cleanup/cleanup.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/common/thread_pool.h"
+#include "xls/ir/nodes.h"
 
 namespace xls {
+namespace {
+
+// Returns the function bases called by nodes of `f`.
+std::vector<FunctionBase*> GetCalledFunctionBases(FunctionBase* f) {
+  std::vector<FunctionBase*> callees;
+  for (Node* node : f->nodes()) {
+    switch (node->op()) {
+      case Op::kCountedFor:
+        callees.push_back(node->As<CountedFor>()->body());
+        break;
+      case Op::kDynamicCountedFor:
+        callees.push_back(node->As<DynamicCountedFor>()->body());
+        break;
+      case Op::kInvoke:
+        callees.push_back(node->As<Invoke>()->to_apply());
+        break;
+      case Op::kMap:
+        callees.push_back(node->As<Map>()->to_apply());
+        break;
+      default:
+        break;
+    }
+  }
+  return callees;
+}
+
+// Partitions the indices of `function_bases` into waves which may each be
+// transformed concurrently, in order. Passes may read the function bases
+// (transitively) called by the one they run on; e.g., constant folding
+// interprets invoked functions. Two function bases where one calls the other
+// are therefore placed in different waves, the one earlier in
+// `function_bases` first, so each sees the other exactly as it would in a
+// sequential run.
+std::vector<std::vector<int64_t>> GetConcurrentWaves(
+    absl::Span<FunctionBase* const> function_bases) {
+  absl::flat_hash_map<FunctionBase*, absl::flat_hash_set<FunctionBase*>>
+      reachable;
+  for (FunctionBase* f : function_bases) {
+    absl::flat_hash_set<FunctionBase*>& reached = reachable[f];
+    std::vector<FunctionBase*> worklist = GetCalledFunctionBases(f);
+    while (!worklist.empty()) {
+      FunctionBase* callee = worklist.back();
+      worklist.pop_back();
+      if (reached.insert(callee).second) {
+        for (FunctionBase* next : GetCalledFunctionBases(callee)) {
+          worklist.push_back(next);
+        }
+      }
+    }
+  }
+
+  std::vector<int64_t> wave(function_bases.size(), 0);
+  std::vector<std::vector<int64_t>> waves;
+  for (int64_t j = 0; j < function_bases.size(); ++j) {
+    for (int64_t i = 0; i < j; ++i) {
+      if (reachable[function_bases[i]].contains(function_bases[j]) ||
+          reachable[function_bases[j]].contains(function_bases[i])) {
+        wave[j] = std::max(wave[j], wave[i] + 1);
+      }
+    }
+    if (wave[j] >= waves.size()) {
+      waves.resize(wave[j] + 1);
+    }
+    waves[wave[j]].push_back(j);
+  }
+  return waves;
+}
+
+}  // namespace
 
 absl::StatusOr<bool> FunctionBasePass::RunOnFunctionBase(
     FunctionBase* f, const PassOptions& options, PassResults* results) const {
@@ -41,13 +120,37 @@ absl::StatusOr<bool> FunctionBasePass::RunOnFunctionBase(
 absl::StatusOr<bool> FunctionBasePass::RunInternal(Package* p,
                                                    const PassOptions& options,
                                                    PassResults* results) const {
-  bool changed = false;
-  for (FunctionBase* f : p->GetFunctionBases()) {
-    XLS_ASSIGN_OR_RETURN(bool function_changed,
-                         RunOnFunctionBaseInternal(f, options, results));
-    changed |= function_changed;
+  std::vector<FunctionBase*> function_bases = p->GetFunctionBases();
+  if (options.thread_count <= 1 || function_bases.size() <= 1) {
+    bool changed = false;
+    for (FunctionBase* f : function_bases) {
+      XLS_ASSIGN_OR_RETURN(bool function_changed,
+                           RunOnFunctionBaseInternal(f, options, results));
+      changed |= function_changed;
+    }
+    return changed;
   }
-  return changed;
+
+  // Function-local passes only modify the function base they are run on, so
+  // unrelated function bases can be transformed concurrently. Nodes created
+  // while doing so are given provisional ids which are renumbered afterwards
+  // such that the result is identical to that of a sequential run.
+  std::vector<std::vector<int64_t>> waves =
+      GetConcurrentWaves(function_bases);
+  p->BeginConcurrentModification(function_bases);
+  auto end_modification =
+      absl::MakeCleanup([p] { p->EndConcurrentModification(); });
+  std::vector<char> function_changed(function_bases.size(), false);
+  for (const std::vector<int64_t>& wave : waves) {
+    XLS_RETURN_IF_ERROR(ParallelFor(
+        wave.size(), options.thread_count, [&](int64_t i) -> absl::Status {
+          FunctionBase* f = function_bases[wave[i]];
+          XLS_ASSIGN_OR_RETURN(function_changed[wave[i]],
+                               RunOnFunctionBaseInternal(f, options, results));
+          return absl::OkStatus();
+        }));
+  }
+  return absl::c_linear_search(function_changed, true);
 }
 
 absl::StatusOr<bool> FunctionBasePass::TransformNodesToFixedPoint(
@@ -17,6 +17,7 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "xls/common/casts.h"
 #include "xls/common/logging/logging.h"
@@ -27,6 +28,7 @@
 #include "xls/ir/function.h"
 #include "xls/ir/function_builder.h"
 #include "xls/ir/ir_parser.h"
+#include "xls/ir/nodes.h"
 #include "xls/ir/package.h"
 #include "xls/ir/type.h"
 
@@ -432,5 +434,180 @@ TEST(PassesTest, TestTransformNodesToFixedPointWhileRemovingNodes) {
               IsOkAndHolds(false));
 }
 
+// Function-local pass which wraps the return value of each function in a
+// number of negations, creating nodes in every function base.
+class NegateReturnValuePass : public FunctionBasePass {
+ public:
+  explicit NegateReturnValuePass(int64_t count)
+      : FunctionBasePass("negate", "Negate return value"), count_(count) {}
+
+  absl::StatusOr<bool> RunOnFunctionBaseInternal(
+      FunctionBase* f, const PassOptions& options,
+      PassResults* results) const override {
+    if (!f->IsFunction() || f->name() == "fail") {
+      return absl::InternalError(
+          absl::StrFormat("Cannot run on %s", f->name()));
+    }
+    Function* function = f->AsFunctionOrDie();
+    for (int64_t i = 0; i < count_ + function->node_count(); ++i) {
+      XLS_ASSIGN_OR_RETURN(
+          Node * neg, function->MakeNode<UnOp>(absl::nullopt,
+                                               function->return_value(),
+                                               Op::kNeg));
+      XLS_RETURN_IF_ERROR(function->set_return_value(neg));
+    }
+    return true;
+  }
+
+ private:
+  int64_t count_;
+};
+
+const char kMultiFunctionPackage[] = R"(
+package multi
+
+fn a(x: bits[8]) -> bits[8] {
+  ret not.1: bits[8] = not(x)
+}
+
+fn b(x: bits[8], y: bits[8]) -> bits[8] {
+  add.4: bits[8] = add(x, y)
+  ret neg.5: bits[8] = neg(add.4)
+}
+
+fn c(x: bits[8]) -> bits[8] {
+  ret identity.7: bits[8] = identity(x)
+}
+)";
+
+TEST(PassesTest, ParallelFunctionBasePassMatchesSequential) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> expected,
+                           Parser::ParsePackage(kMultiFunctionPackage));
+  PassResults results;
+  EXPECT_THAT(NegateReturnValuePass(3).Run(expected.get(), PassOptions(),
+                                           &results),
+              IsOkAndHolds(true));
+
+  for (int64_t thread_count : {2, 3, 8}) {
+    XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> p,
+                             Parser::ParsePackage(kMultiFunctionPackage));
+    PassOptions options;
+    options.thread_count = thread_count;
+    EXPECT_THAT(NegateReturnValuePass(3).Run(p.get(), options, &results),
+                IsOkAndHolds(true));
+    EXPECT_EQ(p->DumpIr(), expected->DumpIr());
+    EXPECT_EQ(p->next_node_id(), expected->next_node_id());
+
+    // Nodes created afterwards are numbered as usual.
+    XLS_ASSERT_OK_AND_ASSIGN(Function * f, p->GetFunction("a"));
+    XLS_ASSERT_OK_AND_ASSIGN(
+        Node * lit, f->MakeNode<Literal>(absl::nullopt, Value(UBits(0, 8))));
+    EXPECT_EQ(lit->id(), expected->next_node_id());
+  }
+}
+
+// Appends a negation of the return value named after the previous return value
+// (so the name embeds its id if it was unnamed), and records the node count of
+// every invoked function in a literal; i.e., reads the callees.
+class NameAndReadCalleesPass : public FunctionBasePass {
+ public:
+  NameAndReadCalleesPass()
+      : FunctionBasePass("name_and_read", "Name and read callees") {}
+
+  absl::StatusOr<bool> RunOnFunctionBaseInternal(
+      FunctionBase* f, const PassOptions& options,
+      PassResults* results) const override {
+    Function* function = f->AsFunctionOrDie();
+    std::vector<Function*> callees;
+    for (Node* node : function->nodes()) {
+      if (node->Is<Invoke>()) {
+        callees.push_back(node->As<Invoke>()->to_apply());
+      }
+    }
+    for (Function* callee : callees) {
+      XLS_RETURN_IF_ERROR(
+          function
+              ->MakeNode<Literal>(absl::nullopt,
+                                  Value(UBits(callee->node_count(), 32)))
+              .status());
+    }
+    for (int64_t i = 0; i < 3; ++i) {
+      Node* ret = function->return_value();
+      XLS_ASSIGN_OR_RETURN(Node * neg, function->MakeNode<UnOp>(
+                                           absl::nullopt, ret, Op::kNeg));
+      neg->SetName(absl::StrCat(ret->GetName(), "_n"));
+      XLS_ASSIGN_OR_RETURN(
+          Node * unnamed,
+          function->MakeNode<UnOp>(absl::nullopt, neg, Op::kNeg));
+      XLS_RETURN_IF_ERROR(function->set_return_value(unnamed));
+    }
+    return true;
+  }
+};
+
+TEST(PassesTest, ParallelFunctionBasePassWithCallsAndNamesMatchesSequential) {
+  const char kPackage[] = R"(
+package calls
+
+fn a(x: bits[8]) -> bits[8] {
+  ret not.1: bits[8] = not(x)
+}
+
+fn b(x: bits[8]) -> bits[8] {
+  ret invoke.3: bits[8] = invoke(x, to_apply=a)
+}
+
+fn c(x: bits[8]) -> bits[8] {
+  ret identity.5: bits[8] = identity(x)
+}
+
+fn d(x: bits[8]) -> bits[8] {
+  invoke.7: bits[8] = invoke(x, to_apply=b)
+  ret invoke.8: bits[8] = invoke(invoke.7, to_apply=c)
+}
+)";
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> expected,
+                           Parser::ParsePackage(kPackage));
+  PassResults results;
+  EXPECT_THAT(
+      NameAndReadCalleesPass().Run(expected.get(), PassOptions(), &results),
+      IsOkAndHolds(true));
+
+  for (int64_t thread_count : {2, 4}) {
+    XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> p,
+                             Parser::ParsePackage(kPackage));
+    PassOptions options;
+    options.thread_count = thread_count;
+    EXPECT_THAT(NameAndReadCalleesPass().Run(p.get(), options, &results),
+                IsOkAndHolds(true));
+    EXPECT_EQ(p->DumpIr(), expected->DumpIr());
+  }
+}
+
+TEST(PassesTest, ParallelFunctionBasePassReturnsError) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> p,
+                           Parser::ParsePackage(R"(
+package fails
+
+fn fail(x: bits[8]) -> bits[8] {
+  ret not.1: bits[8] = not(x)
+}
+
+fn ok(x: bits[8]) -> bits[8] {
+  ret neg.3: bits[8] = neg(x)
+}
+)"));
+  PassOptions options;
+  options.thread_count = 2;
+  PassResults results;
+  EXPECT_THAT(NegateReturnValuePass(1).Run(p.get(), options, &results),
+              StatusIs(absl::StatusCode::kInternal,
+                       HasSubstr("Cannot run on fail")));
+  // Node ids are still renumbered into the regular range.
+  for (Node* node : p->GetFunction("ok").value()->nodes()) {
+    EXPECT_LT(node->id(), p->next_node_id());
+  }
+}
+
 }  // namespace
 }  // namespace xls
@@ -21,6 +21,7 @@
 #include "xls/ir/node_util.h"
 #include "xls/ir/op.h"
 #include "xls/ir/value_helpers.h"
+#include "xls/passes/query_engine_cache.h"
 
 namespace xls {
 namespace {
@@ -1252,6 +1253,7 @@ absl::StatusOr<bool> ProcInliningPass::RunInternal(Package* p,
 
   // Delete inlined procs.
   for (Proc* proc : procs_to_inline) {
+    InvalidateQueryEngineCache(results, proc);
     XLS_RETURN_IF_ERROR(p->RemoveProc(proc));
   }
 
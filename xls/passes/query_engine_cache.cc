@@ -0,0 +1,169 @@
+// Copyright 2022 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/passes/query_engine_cache.h"
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_format.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/status_macros.h"
+
+namespace xls {
+
+std::vector<Node*> FunctionSnapshot::Update(FunctionBase* f,
+                                            std::vector<Node*>* removed,
+                                            std::vector<Node*>* modified) {
+  absl::flat_hash_set<Node*> present;
+  std::vector<Node*> worklist;
+  for (Node* node : f->nodes()) {
+    present.insert(node);
+    auto it = signatures_.find(node);
+    if (it != signatures_.end() && it->second.id == node->id() &&
+        it->second.op == node->op() && it->second.type == node->GetType() &&
+        absl::c_equal(it->second.operands, node->operands())) {
+      continue;
+    }
+    signatures_[node] = NodeSignature{
+        node->id(), node->op(), node->GetType(),
+        std::vector<Node*>(node->operands().begin(), node->operands().end())};
+    worklist.push_back(node);
+  }
+  if (modified != nullptr) {
+    modified->insert(modified->end(), worklist.begin(), worklist.end());
+  }
+  for (auto it = signatures_.begin(); it != signatures_.end();) {
+    if (present.contains(it->first)) {
+      ++it;
+      continue;
+    }
+    removed->push_back(it->first);
+    signatures_.erase(it++);
+  }
+
+  // Everything downstream of a modified node may have a different value.
+  absl::flat_hash_set<Node*> invalidated(worklist.begin(), worklist.end());
+  while (!worklist.empty()) {
+    Node* node = worklist.back();
+    worklist.pop_back();
+    for (Node* user : node->users()) {
+      if (invalidated.insert(user).second) {
+        worklist.push_back(user);
+      }
+    }
+  }
+  return std::vector<Node*>(invalidated.begin(), invalidated.end());
+}
+
+absl::StatusOr<TernaryQueryEngine*> QueryEngineCache::GetTernaryQueryEngine(
+    FunctionBase* f) {
+  Entry<TernaryQueryEngine>& entry = GetEntry(ternary_, f);
+  if (entry.engine == nullptr) {
+    entry.engine = std::make_unique<TernaryQueryEngine>();
+  }
+  std::vector<Node*> removed;
+  std::vector<Node*> invalidated = entry.snapshot.Update(f, &removed);
+  for (Node* node : removed) {
+    entry.engine->Forget(node);
+  }
+  for (Node* node : invalidated) {
+    entry.engine->Forget(node);
+  }
+  if (!invalidated.empty()) {
+    XLS_VLOG(3) << absl::StreamFormat(
+        "Re-evaluating ternary analysis of %d nodes in %s", invalidated.size(),
+        f->name());
+    XLS_RETURN_IF_ERROR(entry.engine->PopulateUntracked(f));
+  }
+  return entry.engine.get();
+}
+
+absl::StatusOr<RangeQueryEngine*> QueryEngineCache::GetRangeQueryEngine(
+    FunctionBase* f) {
+  Entry<RangeQueryEngine>& entry = GetEntry(range_, f);
+  if (entry.engine == nullptr) {
+    entry.engine = std::make_unique<RangeQueryEngine>();
+  }
+  // The range engine propagates changes itself, so only the modified nodes
+  // need to be forgotten rather than everything downstream of them.
+  std::vector<Node*> removed;
+  std::vector<Node*> modified;
+  std::vector<Node*> invalidated =
+      entry.snapshot.Update(f, &removed, &modified);
+  for (Node* node : removed) {
+    entry.engine->Forget(node);
+  }
+  for (Node* node : modified) {
+    entry.engine->Forget(node);
+  }
+  if (!invalidated.empty()) {
+    XLS_VLOG(3) << absl::StreamFormat(
+        "Re-evaluating range analysis of %d modified nodes in %s",
+        modified.size(), f->name());
+    XLS_RETURN_IF_ERROR(entry.engine->Populate(f).status());
+  }
+  return entry.engine.get();
+}
+
+absl::StatusOr<BddQueryEngine*> QueryEngineCache::GetBddQueryEngine(
+    FunctionBase* f, int64_t path_limit,
+    absl::optional<std::function<bool(const Node*)>> node_filter,
+    absl::string_view filter_name) {
+  Entry<BddQueryEngine>& entry = GetEntry(
+      bdd_, std::make_tuple(f, path_limit, std::string(filter_name)));
+  std::vector<Node*> removed;
+  std::vector<Node*> invalidated = entry.snapshot.Update(f, &removed);
+  if (entry.engine == nullptr || !invalidated.empty()) {
+    entry.engine = std::make_unique<BddQueryEngine>(path_limit, node_filter);
+    XLS_RETURN_IF_ERROR(entry.engine->Populate(f).status());
+  }
+  return entry.engine.get();
+}
+
+void QueryEngineCache::Invalidate(FunctionBase* f) {
+  absl::MutexLock lock(&mutex_);
+  ternary_.erase(f);
+  range_.erase(f);
+  for (auto it = bdd_.begin(); it != bdd_.end();) {
+    if (std::get<0>(it->first) == f) {
+      bdd_.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void QueryEngineCache::Clear() {
+  absl::MutexLock lock(&mutex_);
+  ternary_.clear();
+  range_.clear();
+  bdd_.clear();
+}
+
+QueryEngineCache* GetQueryEngineCache(PassResults* results) {
+  static absl::Mutex* mutex = new absl::Mutex();
+  absl::MutexLock lock(mutex);
+  if (results->query_engine_cache == nullptr) {
+    results->query_engine_cache = std::make_shared<QueryEngineCache>();
+  }
+  return results->query_engine_cache.get();
+}
+
+void InvalidateQueryEngineCache(PassResults* results, FunctionBase* f) {
+  if (results->query_engine_cache != nullptr) {
+    results->query_engine_cache->Invalidate(f);
+  }
+}
+
+}  // namespace xls
@@ -0,0 +1,145 @@
+// Copyright 2022 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_PASSES_QUERY_ENGINE_CACHE_H_
+#define XLS_PASSES_QUERY_ENGINE_CACHE_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/node_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/optional.h"
+#include "xls/ir/function_base.h"
+#include "xls/ir/node.h"
+#include "xls/ir/op.h"
+#include "xls/ir/type.h"
+#include "xls/passes/bdd_query_engine.h"
+#include "xls/passes/pass_base.h"
+#include "xls/passes/range_query_engine.h"
+#include "xls/passes/ternary_query_engine.h"
+
+namespace xls {
+
+// A record of the structure of a function base (the nodes, their ops, types
+// and operands) used to determine which nodes have been modified between two
+// points in time. Nodes are never dereferenced after they have been removed
+// from the function.
+class FunctionSnapshot {
+ public:
+  // Records the current structure of `f`. Returns the nodes which were added
+  // or modified since the previous call along with all of their transitive
+  // users; these are exactly the nodes whose analysis results may have changed.
+  // Nodes which were removed from the function since the previous call are
+  // appended to `removed`. If `modified` is non-null, the added and modified
+  // nodes (without their transitive users) are appended to it.
+  std::vector<Node*> Update(FunctionBase* f, std::vector<Node*>* removed,
+                            std::vector<Node*>* modified = nullptr);
+
+ private:
+  struct NodeSignature {
+    int64_t id;
+    Op op;
+    Type* type;
+    std::vector<Node*> operands;
+  };
+
+  absl::flat_hash_map<Node*, NodeSignature> signatures_;
+};
+
+// Caches query engine analyses of function bases across pass invocations.
+// Each accessor returns a query engine which is populated for the current
+// state of the function. If the function has been modified since the engine
+// was last returned, the engine is brought up to date: the ternary engine is
+// re-evaluated for the nodes downstream of the modifications, the range engine
+// re-evaluates the modified nodes and propagates only actual changes in their
+// intervals, and other engines are recomputed when anything in the function
+// changed.
+//
+// The returned engines are owned by the cache and are *not* updated as the
+// function is modified, so passes must guard against stale (or missing)
+// information for nodes modified or created after the engine was obtained, the
+// same as with a locally constructed engine.
+//
+// The accessors may be called concurrently for different function bases (e.g.,
+// by function-local passes running in parallel), but not concurrently for the
+// same function base or with `Invalidate` or `Clear`.
+class QueryEngineCache {
+ public:
+  absl::StatusOr<TernaryQueryEngine*> GetTernaryQueryEngine(FunctionBase* f);
+  absl::StatusOr<RangeQueryEngine*> GetRangeQueryEngine(FunctionBase* f);
+
+  // Returns a BDD query engine with the given path limit (see
+  // BddQueryEngine). Engines using a node filter are cached separately for
+  // each `filter_name`; callers passing the same name must pass equivalent
+  // filters.
+  absl::StatusOr<BddQueryEngine*> GetBddQueryEngine(
+      FunctionBase* f, int64_t path_limit,
+      absl::optional<std::function<bool(const Node*)>> node_filter =
+          absl::nullopt,
+      absl::string_view filter_name = "");
+
+  // Discards all cached analyses of the given function base. Should be called
+  // before the function base is deleted.
+  void Invalidate(FunctionBase* f);
+
+  // Discards all cached analyses.
+  void Clear();
+
+ private:
+  template <typename EngineT>
+  struct Entry {
+    FunctionSnapshot snapshot;
+    std::unique_ptr<EngineT> engine;
+  };
+
+  // Returns the entry for the given key, creating it if necessary. Only the
+  // lookup is synchronized; node_hash_map keeps the entry at a stable address
+  // while other threads add entries.
+  template <typename MapT>
+  typename MapT::mapped_type& GetEntry(MapT& map,
+                                       const typename MapT::key_type& key) {
+    absl::MutexLock lock(&mutex_);
+    return map[key];
+  }
+
+  absl::Mutex mutex_;
+  absl::node_hash_map<FunctionBase*, Entry<TernaryQueryEngine>> ternary_
+      ABSL_GUARDED_BY(mutex_);
+  absl::node_hash_map<FunctionBase*, Entry<RangeQueryEngine>> range_
+      ABSL_GUARDED_BY(mutex_);
+  absl::node_hash_map<std::tuple<FunctionBase*, int64_t, std::string>,
+                      Entry<BddQueryEngine>>
+      bdd_ ABSL_GUARDED_BY(mutex_);
+};
+
+// Returns the query engine cache shared by the passes run with `results`,
+// creating it on first use. May be called concurrently.
+QueryEngineCache* GetQueryEngineCache(PassResults* results);
+
+// Discards any cached analyses of the given function base. Passes which remove
+// function bases from the package call this before removing them, so the
+// cache does not hold engines for (and node snapshots of) deleted functions.
+void InvalidateQueryEngineCache(PassResults* results, FunctionBase* f);
+
+}  // namespace xls
+
+#endif  // XLS_PASSES_QUERY_ENGINE_CACHE_H_
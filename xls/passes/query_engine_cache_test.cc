@@ -0,0 +1,165 @@
+// Copyright 2022 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/passes/query_engine_cache.h"
+
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/function.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/package.h"
+
+namespace xls {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::UnorderedElementsAre;
+
+class QueryEngineCacheTest : public IrTestBase {};
+
+TEST_F(QueryEngineCacheTest, SnapshotReportsDownstreamNodes) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue y = fb.Param("y", p->GetBitsType(8));
+  BValue a = fb.And(x, y);
+  BValue neg = fb.Negate(y);
+  BValue add = fb.Add(a, neg);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  FunctionSnapshot snapshot;
+  std::vector<Node*> removed;
+  EXPECT_EQ(snapshot.Update(f, &removed).size(), f->node_count());
+  EXPECT_THAT(snapshot.Update(f, &removed), IsEmpty());
+  EXPECT_THAT(removed, IsEmpty());
+
+  // Replacing an operand of `a` invalidates `a` and everything downstream of
+  // it, but not `neg`.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Node * lit, f->MakeNode<Literal>(absl::nullopt, Value(UBits(0x0f, 8))));
+  ASSERT_TRUE(a.node()->ReplaceOperand(x.node(), lit));
+  EXPECT_THAT(snapshot.Update(f, &removed),
+              UnorderedElementsAre(lit, a.node(), add.node()));
+  EXPECT_THAT(removed, IsEmpty());
+
+  Node* neg_node = neg.node();
+  XLS_ASSERT_OK(add.node()->ReplaceOperandNumber(1, y.node()));
+  XLS_ASSERT_OK(f->RemoveNode(neg_node));
+  EXPECT_THAT(snapshot.Update(f, &removed), ElementsAre(add.node()));
+  EXPECT_THAT(removed, ElementsAre(neg_node));
+}
+
+TEST_F(QueryEngineCacheTest, TernaryEngineIsUpdatedAfterModification) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue mask = fb.Literal(UBits(0x0f, 8));
+  BValue a = fb.And(x, mask);
+  BValue b = fb.Or(a, fb.Literal(UBits(0x01, 8)));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.BuildWithReturnValue(b));
+
+  QueryEngineCache cache;
+  XLS_ASSERT_OK_AND_ASSIGN(TernaryQueryEngine * engine,
+                           cache.GetTernaryQueryEngine(f));
+  EXPECT_EQ(engine->ToString(a.node()), "0b0000_XXXX");
+  EXPECT_EQ(engine->ToString(b.node()), "0b0000_XXX1");
+
+  // Narrow the mask; the cached engine must reflect the new values of the
+  // downstream nodes.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Node * new_mask,
+      f->MakeNode<Literal>(absl::nullopt, Value(UBits(0x03, 8))));
+  ASSERT_TRUE(a.node()->ReplaceOperand(mask.node(), new_mask));
+  XLS_ASSERT_OK(f->RemoveNode(mask.node()));
+
+  XLS_ASSERT_OK_AND_ASSIGN(TernaryQueryEngine * updated_engine,
+                           cache.GetTernaryQueryEngine(f));
+  EXPECT_EQ(updated_engine, engine);
+  EXPECT_EQ(updated_engine->ToString(a.node()), "0b0000_00XX");
+  EXPECT_EQ(updated_engine->ToString(b.node()), "0b0000_00X1");
+
+  TernaryQueryEngine fresh_engine;
+  XLS_ASSERT_OK(fresh_engine.Populate(f).status());
+  for (Node* node : f->nodes()) {
+    EXPECT_EQ(updated_engine->ToString(node), fresh_engine.ToString(node));
+  }
+}
+
+TEST_F(QueryEngineCacheTest, CacheIsCreatedOnFirstUseFromPassResults) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue a = fb.And(x, fb.Literal(UBits(0x0f, 8)));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.BuildWithReturnValue(a));
+
+  PassResults results;
+  InvalidateQueryEngineCache(&results, f);
+  EXPECT_EQ(results.query_engine_cache, nullptr);
+
+  QueryEngineCache* cache = GetQueryEngineCache(&results);
+  EXPECT_EQ(GetQueryEngineCache(&results), cache);
+  XLS_ASSERT_OK_AND_ASSIGN(TernaryQueryEngine * engine,
+                           cache->GetTernaryQueryEngine(f));
+  EXPECT_EQ(engine->ToString(a.node()), "0b0000_XXXX");
+
+  InvalidateQueryEngineCache(&results, f);
+  XLS_ASSERT_OK_AND_ASSIGN(engine, cache->GetTernaryQueryEngine(f));
+  EXPECT_EQ(engine->ToString(a.node()), "0b0000_XXXX");
+}
+
+TEST_F(QueryEngineCacheTest, RangeEngineIsUpdatedAfterModification) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue ext = fb.ZeroExtend(x, 16);
+  BValue add = fb.Add(ext, fb.Literal(UBits(1, 16)));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.BuildWithReturnValue(add));
+
+  QueryEngineCache cache;
+  XLS_ASSERT_OK_AND_ASSIGN(RangeQueryEngine * engine,
+                           cache.GetRangeQueryEngine(f));
+  EXPECT_EQ(engine->GetIntervalSetTree(add.node()).Get({}).ConvexHull(),
+            Interval(UBits(1, 16), UBits(256, 16)));
+
+  XLS_ASSERT_OK_AND_ASSIGN(TernaryQueryEngine * ternary,
+                           cache.GetTernaryQueryEngine(f));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Node * lit, f->MakeNode<Literal>(absl::nullopt, Value(UBits(7, 8))));
+  XLS_ASSERT_OK(ext.node()->ReplaceOperandNumber(0, lit));
+
+  XLS_ASSERT_OK_AND_ASSIGN(RangeQueryEngine * updated_engine,
+                           cache.GetRangeQueryEngine(f));
+  EXPECT_EQ(updated_engine, engine);
+  EXPECT_EQ(engine->GetIntervalSetTree(add.node()).Get({}).GetPreciseValue(),
+            UBits(8, 16));
+
+  RangeQueryEngine fresh_engine;
+  XLS_ASSERT_OK(fresh_engine.Populate(f).status());
+  for (Node* node : f->nodes()) {
+    EXPECT_EQ(engine->GetIntervalSetTree(node),
+              fresh_engine.GetIntervalSetTree(node));
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(ternary, cache.GetTernaryQueryEngine(f));
+  EXPECT_TRUE(ternary->AllBitsKnown(add.node()));
+}
+
+}  // namespace
+}  // namespace xls
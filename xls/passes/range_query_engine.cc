@@ -16,6 +16,8 @@
 
 #include <limits>
 
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/container/inlined_vector.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
@@ -34,16 +36,13 @@ enum class Tonicity { Monotone, Antitone, Unknown };
 
 class RangeQueryVisitor : public DfsVisitor {
  public:
-  explicit RangeQueryVisitor(RangeQueryEngine* engine)
-      : engine_(engine), rf_(ReachedFixpoint::Unchanged) {}
-
-  ReachedFixpoint GetReachedFixpoint() const { return rf_; }
+  explicit RangeQueryVisitor(RangeQueryEngine* engine) : engine_(engine) {}
 
  private:
   // The maximum size of an interval set that can be resident in memory at any
-  // one time. When accumulating a result interval set, if the set exceeds this
-  // size, `MinimizeIntervals` will be called to reduce its size at the cost of
-  // precision of the analysis.
+  // one time. When a result interval set exceeds this size, it is widened with
+  // `MinimizeIntervals` to reduce its size at the cost of precision of the
+  // analysis.
   static constexpr int64_t kMaxResIntervalSetSize = 64;
 
   // The maximum number of points covered by an interval set that can be
@@ -56,29 +55,23 @@ class RangeQueryVisitor : public DfsVisitor {
     return engine_->GetIntervalSetTree(node);
   }
 
-  // Wrapper around engine_->SetIntervalSetTree that modifies rf_ if necessary.
+  // Wrapper around engine_->IntersectIntervalSetTree which widens oversized
+  // interval sets.
   void SetIntervalSetTree(Node* node, const IntervalSetTree& interval_sets) {
-    if (!engine_->interval_sets_.contains(node)) {
-      engine_->SetIntervalSetTree(node, interval_sets);
-      for (const IntervalSet& set : interval_sets.elements()) {
-        if (!set.IsMaximal()) {
-          rf_ = ReachedFixpoint::Changed;
+    for (const IntervalSet& set : interval_sets.elements()) {
+      if (set.NumberOfIntervals() > kMaxResIntervalSetSize) {
+        IntervalSetTree widened = interval_sets;
+        for (IntervalSet& widened_set : widened.elements()) {
+          if (widened_set.NumberOfIntervals() > kMaxResIntervalSetSize) {
+            widened_set =
+                MinimizeIntervals(widened_set, kMaxResIntervalSetSize);
+          }
         }
+        engine_->IntersectIntervalSetTree(node, widened);
+        return;
       }
-      return;
-    }
-
-    // In the event of a hash collision, it is possible that this could report
-    // having reached a fixed point when it hasn't actually. However, this is
-    // fairly harmless and very unlikely.
-    size_t hash_before =
-        absl::Hash<IntervalSetTree>()(engine_->interval_sets_.at(node));
-    engine_->SetIntervalSetTree(node, interval_sets);
-    size_t hash_after =
-        absl::Hash<IntervalSetTree>()(engine_->interval_sets_.at(node));
-    if (!(hash_before == hash_after)) {
-      rf_ = ReachedFixpoint::Changed;
     }
+    engine_->IntersectIntervalSetTree(node, interval_sets);
   }
 
   // Handles an operation that is variadic and has an implementation given by
@@ -256,7 +249,6 @@ class RangeQueryVisitor : public DfsVisitor {
   absl::Status HandleZeroExtend(ExtendOp* zero_ext) override;
 
   RangeQueryEngine* engine_;
-  ReachedFixpoint rf_;
 };
 
 struct MergeInterval {
@@ -307,11 +299,16 @@ std::vector<MergeInterval> ReduceByMerging(absl::Span<Bits const> elements,
     }
   }
 
-  std::sort(elements_with_index.begin(), elements_with_index.end());
+  // Only the set of the smallest elements matters, not their order, so a
+  // linear-time selection suffices.
+  int64_t merge_count = elements.size() - desired_size;
+  std::nth_element(elements_with_index.begin(),
+                   elements_with_index.begin() + merge_count,
+                   elements_with_index.end());
 
   std::vector<int64_t> indexes_to_merge;
-  indexes_to_merge.reserve(elements.size() - desired_size);
-  for (int64_t i = 0; i < elements.size() - desired_size; ++i) {
+  indexes_to_merge.reserve(merge_count);
+  for (int64_t i = 0; i < merge_count; ++i) {
     indexes_to_merge.push_back(elements_with_index[i].index);
   }
   std::sort(indexes_to_merge.begin(), indexes_to_merge.end());
@@ -347,14 +344,22 @@ IntervalSet MinimizeIntervals(IntervalSet intervals, int64_t size) {
 
   std::vector<MergeInterval> merges = ReduceByMerging(gap_vector, size - 1);
 
-  IntervalSet result = intervals;
-
-  for (const auto& m : merges) {
-    Interval merged = intervals.Intervals()[m.start];
-    for (int64_t i = m.start; i <= m.end + 1; ++i) {
-      merged = Interval::ConvexHull(merged, intervals.Intervals()[i]);
+  // Since the intervals are sorted and disjoint, the convex hull of a run of
+  // intervals spans from the lower bound of the first to the upper bound of
+  // the last. The result is built in sorted order, so normalizing it is cheap.
+  absl::Span<const Interval> sorted = intervals.Intervals();
+  IntervalSet result(intervals.BitCount());
+  int64_t next = 0;
+  for (const MergeInterval& m : merges) {
+    for (; next < m.start; ++next) {
+      result.AddInterval(sorted[next]);
     }
-    result.AddInterval(merged);
+    result.AddInterval(
+        Interval(sorted[m.start].LowerBound(), sorted[m.end + 1].UpperBound()));
+    next = m.end + 2;
+  }
+  for (; next < sorted.size(); ++next) {
+    result.AddInterval(sorted[next]);
   }
 
   result.Normalize();
@@ -364,8 +369,56 @@ IntervalSet MinimizeIntervals(IntervalSet intervals, int64_t size) {
 
 absl::StatusOr<ReachedFixpoint> RangeQueryEngine::Populate(FunctionBase* f) {
   RangeQueryVisitor visitor(this);
-  XLS_RETURN_IF_ERROR(f->Accept(&visitor));
-  return visitor.GetReachedFixpoint();
+  ReachedFixpoint rf = ReachedFixpoint::Unchanged;
+  // The users of nodes whose intervals changed during this invocation. Nodes
+  // are visited in topological order so every node is evaluated at most once,
+  // after all of its operands have settled.
+  absl::flat_hash_set<Node*> worklist;
+  for (Node* node : TopoSort(f)) {
+    bool tracked = IsTracked(node);
+    if (tracked && !worklist.contains(node) && !pending_.contains(node)) {
+      continue;
+    }
+    pending_.erase(node);
+
+    absl::optional<IntervalSetTree> old_intervals;
+    if (tracked) {
+      old_intervals = GetIntervalSetTree(node);
+    }
+    ResetNode(node);
+    XLS_RETURN_IF_ERROR(node->VisitSingleNode(&visitor));
+
+    IntervalSetTree new_intervals = GetIntervalSetTree(node);
+    if (old_intervals.has_value() && *old_intervals == new_intervals) {
+      continue;
+    }
+    if (old_intervals.has_value() ||
+        !absl::c_all_of(new_intervals.elements(), [](const IntervalSet& set) {
+          return set.IsMaximal();
+        })) {
+      rf = ReachedFixpoint::Changed;
+    }
+    worklist.insert(node->users().begin(), node->users().end());
+  }
+  return rf;
+}
+
+void RangeQueryEngine::Forget(Node* node) {
+  known_bits_.erase(node);
+  known_bit_values_.erase(node);
+  interval_sets_.erase(node);
+  given_interval_sets_.erase(node);
+  pending_.erase(node);
+}
+
+void RangeQueryEngine::ResetNode(Node* node) {
+  known_bits_.erase(node);
+  known_bit_values_.erase(node);
+  interval_sets_.erase(node);
+  auto it = given_interval_sets_.find(node);
+  if (it != given_interval_sets_.end()) {
+    IntersectIntervalSetTree(node, it->second);
+  }
 }
 
 IntervalSetTree RangeQueryEngine::GetIntervalSetTree(Node* node) const {
@@ -392,6 +445,18 @@ IntervalSetTree RangeQueryEngine::GetIntervalSetTree(Node* node) const {
 
 void RangeQueryEngine::SetIntervalSetTree(
     Node* node, const IntervalSetTree& interval_sets) {
+  auto [it, inserted] = given_interval_sets_.insert({node, interval_sets});
+  if (!inserted) {
+    it->second = LeafTypeTree<IntervalSet>::Zip<IntervalSet, IntervalSet>(
+        IntervalSet::Intersect, it->second, interval_sets);
+  }
+  IntersectIntervalSetTree(node, interval_sets);
+  pending_.insert(node);
+  pending_.insert(node->users().begin(), node->users().end());
+}
+
+void RangeQueryEngine::IntersectIntervalSetTree(
+    Node* node, const IntervalSetTree& interval_sets) {
   IntervalSetTree old_ist = GetIntervalSetTree(node);
   IntervalSetTree new_ist =
       LeafTypeTree<IntervalSet>::Zip<IntervalSet, IntervalSet>(
@@ -19,6 +19,7 @@
 
 #include "absl/container/btree_set.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
@@ -46,9 +47,24 @@ class RangeQueryEngine : public QueryEngine {
   RangeQueryEngine() {}
 
   // Populate the data in this `RangeQueryEngine` using the
-  // given `FunctionBase*`;
+  // given `FunctionBase*`.
+  //
+  // Propagation is sparse: a node is evaluated only if it is not yet tracked
+  // (including nodes discarded with `Forget`), if intervals were given for it
+  // or one of its operands with `SetIntervalSetTree` since the last call, or if
+  // the intervals of one of its operands changed during this call. Populating
+  // a function which has not been modified since the previous call therefore
+  // performs no interval computations.
   absl::StatusOr<ReachedFixpoint> Populate(FunctionBase* f) override;
 
+  // Discards all information about the given node, including any intervals
+  // given with `SetIntervalSetTree`. The next call to `Populate` re-evaluates
+  // the node, and its users only as far as its intervals change. To update the
+  // analysis after a function has been modified, forget the added and modified
+  // nodes (those with new operands) and call `Populate` again. The node may
+  // already have been removed from its function; it is not dereferenced.
+  void Forget(Node* node);
+
   bool IsTracked(Node* node) const override {
     return known_bits_.contains(node);
   }
@@ -112,9 +128,9 @@ class RangeQueryEngine : public QueryEngine {
 
   // Set the intervals associated with the given node.
   //
-  // This is primarily intended to be used in tests. Executing `Populate` may
-  // overwrite the interval sets you define using this method, depending on what
-  // node you defined.
+  // This seeds the analysis: the given intervals are intersected with whatever
+  // `Populate` computes for the node, and the node and its users are
+  // re-evaluated by the next call to `Populate`.
   void SetIntervalSetTree(Node* node, const IntervalSetTree& interval_sets);
 
   // Initialize a node's known bits.
@@ -124,9 +140,25 @@ class RangeQueryEngine : public QueryEngine {
  private:
   friend class RangeQueryVisitor;
 
+  // Intersects the intervals associated with the given node with the given
+  // intervals and updates the known bits of the node accordingly.
+  void IntersectIntervalSetTree(Node* node,
+                                const IntervalSetTree& interval_sets);
+
+  // Resets the node to the state prior to evaluation: untracked, but
+  // constrained to any intervals given with `SetIntervalSetTree`.
+  void ResetNode(Node* node);
+
   absl::flat_hash_map<Node*, Bits> known_bits_;
   absl::flat_hash_map<Node*, Bits> known_bit_values_;
   absl::flat_hash_map<Node*, IntervalSetTree> interval_sets_;
+
+  // Intervals given with `SetIntervalSetTree`.
+  absl::flat_hash_map<Node*, IntervalSetTree> given_interval_sets_;
+
+  // Nodes which must be evaluated by the next call to `Populate` even if they
+  // are tracked.
+  absl::flat_hash_set<Node*> pending_;
 };
 
 // Reduce the size of the given `IntervalSet` to the given size.
@@ -1230,5 +1230,79 @@ TEST_F(RangeQueryEngineTest, ZeroExtend) {
             BitsLTT(expr.node(), {Interval(UBits(500, 40), UBits(700, 40))}));
 }
 
+TEST_F(RangeQueryEngineTest, RepopulateOnlyRevisitsChangedNodes) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue ext = fb.ZeroExtend(x, 16);
+  BValue add = fb.Add(ext, fb.Literal(UBits(1, 16)));
+  BValue ult = fb.ULt(add, fb.Literal(UBits(300, 16)));
+
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  RangeQueryEngine engine;
+  XLS_ASSERT_OK_AND_ASSIGN(ReachedFixpoint rf, engine.Populate(f));
+  EXPECT_EQ(rf, ReachedFixpoint::Changed);
+  EXPECT_EQ(engine.GetIntervalSetTree(add.node()),
+            BitsLTT(add.node(), {{1, 256}}));
+  EXPECT_EQ("0b1", engine.ToString(ult.node()));
+
+  // Nothing changed, so nothing is recomputed.
+  XLS_ASSERT_OK_AND_ASSIGN(rf, engine.Populate(f));
+  EXPECT_EQ(rf, ReachedFixpoint::Unchanged);
+
+  // Seeding a node after populating narrows everything downstream of it.
+  engine.SetIntervalSetTree(x.node(), BitsLTT(x.node(), {{10, 20}}));
+  XLS_ASSERT_OK_AND_ASSIGN(rf, engine.Populate(f));
+  EXPECT_EQ(rf, ReachedFixpoint::Changed);
+  EXPECT_EQ(engine.GetIntervalSetTree(add.node()),
+            BitsLTT(add.node(), {{11, 21}}));
+
+  // After a local edit only the modified node needs to be forgotten.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Node * lit, f->MakeNode<Literal>(absl::nullopt, Value(UBits(7, 8))));
+  XLS_ASSERT_OK(ext.node()->ReplaceOperandNumber(0, lit));
+  engine.Forget(ext.node());
+  XLS_ASSERT_OK_AND_ASSIGN(rf, engine.Populate(f));
+  EXPECT_EQ(rf, ReachedFixpoint::Changed);
+  EXPECT_EQ(engine.GetIntervalSetTree(add.node()),
+            BitsLTT(add.node(), {{8, 8}}));
+
+  RangeQueryEngine fresh_engine;
+  fresh_engine.SetIntervalSetTree(x.node(), BitsLTT(x.node(), {{10, 20}}));
+  XLS_ASSERT_OK(fresh_engine.Populate(f));
+  for (Node* node : f->nodes()) {
+    EXPECT_EQ(engine.GetIntervalSetTree(node),
+              fresh_engine.GetIntervalSetTree(node))
+        << node->ToString();
+    EXPECT_EQ(engine.ToString(node), fresh_engine.ToString(node));
+  }
+}
+
+TEST_F(RangeQueryEngineTest, IntervalSetSizeIsCapped) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+
+  BValue x = fb.Param("x", p->GetBitsType(16));
+  BValue tuple = fb.Tuple({x});
+
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  std::vector<std::pair<int64_t, int64_t>> evens;
+  for (int64_t i = 0; i < 1000; i += 2) {
+    evens.push_back({i, i});
+  }
+  RangeQueryEngine engine;
+  engine.SetIntervalSetTree(x.node(), BitsLTT(x.node(), evens));
+  XLS_ASSERT_OK(engine.Populate(f));
+
+  IntervalSet element = engine.GetIntervalSetTree(tuple.node()).Get({0});
+  EXPECT_LE(element.NumberOfIntervals(), 64);
+  EXPECT_EQ(element.ConvexHull(),
+            Interval(UBits(0, 16), UBits(998, 16)));
+  for (const auto& [lb, ub] : evens) {
+    EXPECT_TRUE(element.Covers(UBits(lb, 16)));
+  }
+}
+
 }  // namespace
 }  // namespace xls
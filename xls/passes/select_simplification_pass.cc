@@ -32,6 +32,7 @@
 #include "xls/ir/node_iterator.h"
 #include "xls/ir/node_util.h"
 #include "xls/ir/nodes.h"
+#include "xls/passes/query_engine_cache.h"
 #include "xls/passes/ternary_query_engine.h"
 
 namespace xls {
@@ -969,12 +970,13 @@ absl::StatusOr<bool> SimplifyNode(Node* node, const QueryEngine& query_engine,
 absl::StatusOr<bool> SelectSimplificationPass::RunOnFunctionBaseInternal(
     FunctionBase* func, const PassOptions& options,
     PassResults* results) const {
-  TernaryQueryEngine query_engine;
-  XLS_RETURN_IF_ERROR(query_engine.Populate(func).status());
+  XLS_ASSIGN_OR_RETURN(
+      TernaryQueryEngine * query_engine,
+      GetQueryEngineCache(results)->GetTernaryQueryEngine(func));
   bool changed = false;
   for (Node* node : TopoSort(func)) {
     XLS_ASSIGN_OR_RETURN(bool node_changed,
-                         SimplifyNode(node, query_engine, opt_level_));
+                         SimplifyNode(node, *query_engine, opt_level_));
     changed = changed | node_changed;
   }
 
@@ -995,7 +997,7 @@ absl::StatusOr<bool> SelectSimplificationPass::RunOnFunctionBaseInternal(
       // ok. TernaryQueryEngine::IsTracked will return false for new nodes which
       // have not been analyzed.
       XLS_ASSIGN_OR_RETURN(std::vector<OneHotSelect*> new_ohses,
-                           MaybeSplitOneHotSelect(ohs, query_engine));
+                           MaybeSplitOneHotSelect(ohs, *query_engine));
       if (!new_ohses.empty()) {
         changed = true;
         worklist.insert(worklist.end(), new_ohses.begin(), new_ohses.end());
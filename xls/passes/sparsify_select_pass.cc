@@ -28,6 +28,7 @@
 #include "xls/ir/node_iterator.h"
 #include "xls/ir/op.h"
 #include "xls/ir/type.h"
+#include "xls/passes/query_engine_cache.h"
 #include "xls/passes/range_query_engine.h"
 
 namespace xls {
@@ -153,15 +154,15 @@ absl::Status SparsifySelect(FunctionBase* f, Select* select,
 
 absl::StatusOr<bool> SparsifySelectPass::RunOnFunctionBaseInternal(
     FunctionBase* f, const PassOptions& options, PassResults* results) const {
-  RangeQueryEngine engine;
-  XLS_RETURN_IF_ERROR(engine.Populate(f).status());
+  XLS_ASSIGN_OR_RETURN(RangeQueryEngine * engine,
+                       GetQueryEngineCache(results)->GetRangeQueryEngine(f));
 
   bool changed = false;
   for (Node* node : TopoSort(f)) {
     if (node->Is<Select>()) {
       Select* select = node->As<Select>();
       Node* selector = select->selector();
-      IntervalSetTree selector_ist = engine.GetIntervalSetTree(selector);
+      IntervalSetTree selector_ist = engine->GetIntervalSetTree(selector);
       IntervalSet selector_intervals = selector_ist.Get({});
       if (absl::optional<int64_t> size = selector_intervals.Size()) {
         if (size >= select->cases().size()) {
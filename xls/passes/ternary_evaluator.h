@@ -19,10 +19,14 @@
 #include "xls/common/logging/logging.h"
 #include "xls/ir/abstract_evaluator.h"
 #include "xls/ir/bits.h"
+#include "xls/ir/packed_ternary.h"
 #include "xls/ir/ternary.h"
 
 namespace xls {
 
+// Evaluator of XLS operations using ternary logic. The arithmetic and shift
+// operations, whose bit-at-a-time evaluation is slow for wide values, are
+// computed word-parallel on packed ternary vectors.
 class TernaryEvaluator
     : public AbstractEvaluator<TernaryValue, TernaryEvaluator> {
  public:
@@ -49,6 +53,35 @@ class TernaryEvaluator
   TernaryValue Or(const TernaryValue& a, const TernaryValue& b) const {
     return ternary_ops::Or(a, b);
   }
+
+  Vector Add(const Vector& a, const Vector& b) {
+    return packed_ternary_ops::Add(PackedTernaryVector::FromTernaryVector(a),
+                                   PackedTernaryVector::FromTernaryVector(b))
+        .ToTernaryVector();
+  }
+  Vector Neg(const Vector& x) {
+    return packed_ternary_ops::Neg(PackedTernaryVector::FromTernaryVector(x))
+        .ToTernaryVector();
+  }
+
+  Vector ShiftLeftLogical(const Vector& input, const Vector& amount) {
+    return packed_ternary_ops::ShiftLeftLogical(
+               PackedTernaryVector::FromTernaryVector(input),
+               PackedTernaryVector::FromTernaryVector(amount))
+        .ToTernaryVector();
+  }
+  Vector ShiftRightLogical(const Vector& input, const Vector& amount) {
+    return packed_ternary_ops::ShiftRightLogical(
+               PackedTernaryVector::FromTernaryVector(input),
+               PackedTernaryVector::FromTernaryVector(amount))
+        .ToTernaryVector();
+  }
+  Vector ShiftRightArith(const Vector& input, const Vector& amount) {
+    return packed_ternary_ops::ShiftRightArith(
+               PackedTernaryVector::FromTernaryVector(input),
+               PackedTernaryVector::FromTernaryVector(amount))
+        .ToTernaryVector();
+  }
 };
 
 }  // namespace xls
@@ -14,104 +14,154 @@
 
 #include "xls/passes/ternary_query_engine.h"
 
-#include <limits>
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
 
-#include "absl/container/inlined_vector.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/data_structures/leaf_type_tree.h"
 #include "xls/ir/abstract_node_evaluator.h"
-#include "xls/ir/bits_ops.h"
 #include "xls/ir/dfs_visitor.h"
 #include "xls/ir/node_iterator.h"
+#include "xls/ir/packed_ternary.h"
 #include "xls/passes/ternary_evaluator.h"
 
 namespace xls {
 
-// Returns whether the operation will be computationally expensive to
-// compute. The ternary query engine is intended to be fast so the analysis of
-// these expensive operations is skipped with the effect being all bits are
-// considered unknown. Operations and limits can be added as needed when
-// pathological cases are encountered.
-static bool IsExpensiveToEvaluate(Node* node) {
-  // Shifts are quadratic in the width of the operand so wide shifts are very
-  // slow to evaluate in the abstract evaluator.
-  return (node->op() == Op::kShrl || node->op() == Op::kShra ||
-          node->op() == Op::kShll) &&
-         node->GetType()->GetFlatBitCount() > 256;
-}
+// Evaluates the given node with ternary logic. `get_operand_value` returns the
+// ternary value of a (bits-typed) operand of the node. Common operations are
+// evaluated word-parallel on the packed representation; the remaining
+// operations are evaluated bit-at-a-time with the abstract evaluator.
+static absl::StatusOr<PackedTernaryVector> EvaluateNode(
+    Node* node,
+    const std::function<const PackedTernaryVector&(Node*)>& get_operand_value,
+    TernaryEvaluator* evaluator) {
+  if (std::any_of(node->operands().begin(), node->operands().end(),
+                  [](Node* o) { return !o->GetType()->IsBits(); })) {
+    return PackedTernaryVector(node->BitCountOrDie());
+  }
 
-Bits TernaryVectorToKnownBits(const TernaryEvaluator::Vector& ternary_vector) {
-  // Use InlinedVector to avoid std::vector<bool> specialization madness.
-  absl::InlinedVector<bool, 1> bits(ternary_vector.size());
-  for (int64_t i = 0; i < bits.size(); ++i) {
-    bits[i] = (ternary_vector[i] == TernaryValue::kKnownOne ||
-               ternary_vector[i] == TernaryValue::kKnownZero);
+  std::vector<PackedTernaryVector> operands;
+  operands.reserve(node->operand_count());
+  for (Node* operand : node->operands()) {
+    operands.push_back(get_operand_value(operand));
+  }
+  switch (node->op()) {
+    case Op::kLiteral:
+      return PackedTernaryVector::FromBits(node->As<Literal>()->value().bits());
+    case Op::kAnd:
+      return packed_ternary_ops::NaryAnd(operands);
+    case Op::kOr:
+      return packed_ternary_ops::NaryOr(operands);
+    case Op::kXor:
+      return packed_ternary_ops::NaryXor(operands);
+    case Op::kNand:
+      return packed_ternary_ops::Not(packed_ternary_ops::NaryAnd(operands));
+    case Op::kNor:
+      return packed_ternary_ops::Not(packed_ternary_ops::NaryOr(operands));
+    case Op::kNot:
+      return packed_ternary_ops::Not(operands[0]);
+    case Op::kAdd:
+      return packed_ternary_ops::Add(operands[0], operands[1]);
+    case Op::kSub:
+      return packed_ternary_ops::Sub(operands[0], operands[1]);
+    case Op::kNeg:
+      return packed_ternary_ops::Neg(operands[0]);
+    case Op::kShll:
+      return packed_ternary_ops::ShiftLeftLogical(operands[0], operands[1]);
+    case Op::kShrl:
+      return packed_ternary_ops::ShiftRightLogical(operands[0], operands[1]);
+    case Op::kShra:
+      return packed_ternary_ops::ShiftRightArith(operands[0], operands[1]);
+    case Op::kConcat:
+      return packed_ternary_ops::Concat(operands);
+    case Op::kBitSlice:
+      return packed_ternary_ops::BitSlice(operands[0],
+                                          node->As<BitSlice>()->start(),
+                                          node->As<BitSlice>()->width());
+    case Op::kZeroExt:
+      return packed_ternary_ops::ZeroExtend(
+          operands[0], node->As<ExtendOp>()->new_bit_count());
+    case Op::kSignExt:
+      return packed_ternary_ops::SignExtend(
+          operands[0], node->As<ExtendOp>()->new_bit_count());
+    default:
+      break;
   }
-  return Bits(bits);
-}
 
-Bits TernaryVectorToValueBits(const TernaryEvaluator::Vector& ternary_vector) {
-  // Use InlinedVector to avoid std::vector<bool> specialization madness.
-  absl::InlinedVector<bool, 1> bits(ternary_vector.size());
-  for (int64_t i = 0; i < bits.size(); ++i) {
-    bits[i] = ternary_vector[i] == TernaryValue::kKnownOne;
+  std::vector<TernaryEvaluator::Vector> operand_values;
+  operand_values.reserve(operands.size());
+  for (const PackedTernaryVector& operand : operands) {
+    operand_values.push_back(operand.ToTernaryVector());
   }
-  return Bits(bits);
+  XLS_ASSIGN_OR_RETURN(
+      TernaryEvaluator::Vector result,
+      AbstractEvaluate(node, operand_values, evaluator,
+                       /*default_handler=*/[](Node* n) {
+                         return TernaryEvaluator::Vector(
+                             n->BitCountOrDie(), TernaryValue::kUnknown);
+                       }));
+  return PackedTernaryVector::FromTernaryVector(result);
 }
 
 absl::StatusOr<ReachedFixpoint> TernaryQueryEngine::Populate(FunctionBase* f) {
   TernaryEvaluator evaluator;
-  absl::flat_hash_map<Node*, TernaryEvaluator::Vector> values;
+  absl::flat_hash_map<Node*, PackedTernaryVector> values;
+  auto get_operand_value = [&](Node* operand) -> const PackedTernaryVector& {
+    return values.at(operand);
+  };
   for (Node* node : TopoSort(f)) {
     if (!node->GetType()->IsBits()) {
       continue;
     }
-    auto create_unknown_vector = [](Node* n) {
-      return TernaryEvaluator::Vector(n->BitCountOrDie(),
-                                      TernaryValue::kUnknown);
-    };
-    if (IsExpensiveToEvaluate(node) ||
-        std::any_of(node->operands().begin(), node->operands().end(),
-                    [](Node* o) { return !o->GetType()->IsBits(); })) {
-      values[node] = create_unknown_vector(node);
-      continue;
-    }
-
-    std::vector<TernaryEvaluator::Vector> operand_values;
-    for (Node* operand : node->operands()) {
-      operand_values.push_back(values.at(operand));
-    }
-    XLS_ASSIGN_OR_RETURN(
-        values[node],
-        AbstractEvaluate(node, operand_values, &evaluator,
-                         /*default_handler=*/create_unknown_vector));
+    XLS_ASSIGN_OR_RETURN(PackedTernaryVector value,
+                         EvaluateNode(node, get_operand_value, &evaluator));
+    values.insert_or_assign(node, std::move(value));
   }
 
   ReachedFixpoint rf = ReachedFixpoint::Unchanged;
   for (Node* node : f->nodes()) {
     // TODO(meheff): Handle types other than bits.
-    if (node->GetType()->IsBits()) {
-      if (!known_bits_.contains(node)) {
-        known_bits_[node] = Bits(values.at(node).size());
-        bits_values_[node] = Bits(values.at(node).size());
-      }
-      Bits combined_known_bits = bits_ops::Or(
-          known_bits_[node], TernaryVectorToKnownBits(values.at(node)));
-      Bits combined_bits_values = bits_ops::Or(
-          bits_values_[node], TernaryVectorToValueBits(values.at(node)));
-      if ((combined_known_bits != known_bits_[node]) ||
-          (combined_bits_values != bits_values_[node])) {
+    if (!node->GetType()->IsBits()) {
+      continue;
+    }
+    PackedTernaryVector& value = values.at(node);
+    auto it = values_.find(node);
+    if (it == values_.end()) {
+      if (!value.AllUnknown()) {
         rf = ReachedFixpoint::Changed;
       }
-      known_bits_[node] = combined_known_bits;
-      bits_values_[node] = combined_bits_values;
+      values_.emplace(node, std::move(value));
+      continue;
+    }
+    PackedTernaryVector combined = packed_ternary_ops::Union(it->second, value);
+    if (combined != it->second) {
+      rf = ReachedFixpoint::Changed;
+      it->second = std::move(combined);
     }
   }
   return rf;
 }
 
+absl::Status TernaryQueryEngine::PopulateUntracked(FunctionBase* f) {
+  TernaryEvaluator evaluator;
+  auto get_operand_value = [&](Node* operand) -> const PackedTernaryVector& {
+    return values_.at(operand);
+  };
+  for (Node* node : TopoSort(f)) {
+    if (!node->GetType()->IsBits() || IsTracked(node)) {
+      continue;
+    }
+    XLS_ASSIGN_OR_RETURN(PackedTernaryVector value,
+                         EvaluateNode(node, get_operand_value, &evaluator));
+    values_.insert_or_assign(node, std::move(value));
+  }
+  return absl::OkStatus();
+}
+
 bool TernaryQueryEngine::AtMostOneTrue(
     absl::Span<TreeBitLocation const> bits) const {
   int64_t maybe_one_count = 0;
@@ -20,6 +20,7 @@
 #include "xls/ir/bits.h"
 #include "xls/ir/function.h"
 #include "xls/ir/nodes.h"
+#include "xls/ir/packed_ternary.h"
 #include "xls/passes/query_engine.h"
 
 namespace xls {
@@ -35,8 +36,22 @@ class TernaryQueryEngine : public QueryEngine {
 
   absl::StatusOr<ReachedFixpoint> Populate(FunctionBase* f) override;
 
-  bool IsTracked(Node* node) const override {
-    return known_bits_.contains(node);
+  // Evaluates every bits-typed node in the function which is not currently
+  // tracked, reusing the information already held for tracked nodes. This is
+  // used to incrementally bring the analysis up to date after the function has
+  // been modified: the caller must first `Forget` every node whose value may
+  // have changed (i.e., all nodes downstream of any modification).
+  absl::Status PopulateUntracked(FunctionBase* f);
+
+  // Discards any information held about the given node. The node may already
+  // have been removed from its function; it is not dereferenced.
+  void Forget(Node* node) { values_.erase(node); }
+
+  bool IsTracked(Node* node) const override { return values_.contains(node); }
+
+  // Returns the packed ternary value of the given tracked bits-typed node.
+  const PackedTernaryVector& GetPackedTernary(Node* node) const {
+    return values_.at(node);
   }
 
   LeafTypeTree<TernaryVector> GetTernary(Node* node) const override {
@@ -48,10 +63,8 @@ class TernaryQueryEngine : public QueryEngine {
                                  TernaryValue::kUnknown);
           });
     }
-    TernaryVector ternary =
-        ternary_ops::FromKnownBits(known_bits_.at(node), bits_values_.at(node));
     LeafTypeTree<TernaryVector> result(node->GetType());
-    result.Set({}, ternary);
+    result.Set({}, values_.at(node).ToTernaryVector());
     return result;
   }
 
@@ -75,13 +88,9 @@ class TernaryQueryEngine : public QueryEngine {
   }
 
  private:
-  // Holds which bits values are known for nodes in the function. A one in a bit
-  // position indications the respective bit value in the respective node is
-  // statically known.
-  absl::flat_hash_map<Node*, Bits> known_bits_;
-
-  // Holds the values of statically known bits of nodes in the function.
-  absl::flat_hash_map<Node*, Bits> bits_values_;
+  // Holds the statically known bits (and their values) of the bits-typed nodes
+  // in the function.
+  absl::flat_hash_map<Node*, PackedTernaryVector> values_;
 };
 
 }  // namespace xls
@@ -130,5 +130,45 @@ TEST_F(TernaryQueryEngineTest, Ne) {
   EXPECT_THAT(RunOnBinaryOp("0b011", "0b011", make_ne), IsOkAndHolds("0b0"));
 }
 
+TEST_F(TernaryQueryEngineTest, Add) {
+  auto make_add = [](BValue lhs, BValue rhs, FunctionBuilder* fb) {
+    fb->Add(lhs, rhs);
+  };
+  EXPECT_THAT(RunOnBinaryOp("0b0X1", "0b001", make_add),
+              IsOkAndHolds("0bXX0"));
+  EXPECT_THAT(RunOnBinaryOp("0b0X1", "0b100", make_add),
+              IsOkAndHolds("0b1X1"));
+  EXPECT_THAT(RunOnBinaryOp("0b011", "0b001", make_add),
+              IsOkAndHolds("0b100"));
+}
+
+TEST_F(TernaryQueryEngineTest, Shll) {
+  auto make_shll = [](BValue lhs, BValue rhs, FunctionBuilder* fb) {
+    fb->Shll(lhs, rhs);
+  };
+  EXPECT_THAT(RunOnBinaryOp("0b1111", "0b00X", make_shll),
+              IsOkAndHolds("0b111X"));
+  EXPECT_THAT(RunOnBinaryOp("0bXX11", "0b01X", make_shll),
+              IsOkAndHolds("0b1X00"));
+  EXPECT_THAT(RunOnBinaryOp("0b1111", "0b1XX", make_shll),
+              IsOkAndHolds("0b0000"));
+}
+
+TEST_F(TernaryQueryEngineTest, WideShift) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.ZeroExtend(fb.Param("x", p->GetBitsType(8)), 512);
+  BValue shll = fb.Shll(x, fb.Literal(UBits(100, 16)));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  TernaryQueryEngine query_engine;
+  XLS_ASSERT_OK(query_engine.Populate(f).status());
+  for (int64_t i = 0; i < 512; ++i) {
+    EXPECT_EQ(query_engine.IsKnown(TreeBitLocation(shll.node(), i)),
+              i < 100 || i >= 108)
+        << i;
+    EXPECT_FALSE(query_engine.IsOne(TreeBitLocation(shll.node(), i))) << i;
+  }
+}
+
 }  // namespace
 }  // namespace xls
@@ -20,7 +20,7 @@ namespace xls {
 
 absl::StatusOr<ReachedFixpoint> UnionQueryEngine::Populate(FunctionBase* f) {
   ReachedFixpoint result = ReachedFixpoint::Unchanged;
-  for (const std::unique_ptr<QueryEngine>& engine : engines_) {
+  for (QueryEngine* engine : engines_) {
     XLS_ASSIGN_OR_RETURN(ReachedFixpoint rf, engine->Populate(f));
     // Unchanged is the top of the lattice so it's an identity
     if (result == ReachedFixpoint::Unchanged) {
@@ -38,7 +38,7 @@ absl::StatusOr<ReachedFixpoint> UnionQueryEngine::Populate(FunctionBase* f) {
 }
 
 bool UnionQueryEngine::IsTracked(Node* node) const {
-  for (const auto& engine : engines_) {
+  for (QueryEngine* engine : engines_) {
     if (engine->IsTracked(node)) {
       return true;
     }
@@ -51,7 +51,7 @@ LeafTypeTree<TernaryVector> UnionQueryEngine::GetTernary(Node* node) const {
 
   Bits known(node->GetType()->GetFlatBitCount());
   Bits known_values(node->GetType()->GetFlatBitCount());
-  for (const auto& engine : engines_) {
+  for (QueryEngine* engine : engines_) {
     if (engine->IsTracked(node)) {
       TernaryVector ternary = engine->GetTernary(node).Get({});
       known = bits_ops::Or(known, ternary_ops::ToKnownBits(ternary));
@@ -71,7 +71,7 @@ LeafTypeTree<IntervalSet> UnionQueryEngine::GetIntervals(Node* node) const {
     result.elements()[i] =
         IntervalSet::Maximal(result.leaf_types()[i]->GetFlatBitCount());
   }
-  for (const auto& engine : engines_) {
+  for (QueryEngine* engine : engines_) {
     if (engine->IsTracked(node)) {
       result = LeafTypeTree<IntervalSet>::Zip<IntervalSet, IntervalSet>(
           IntervalSet::Intersect, result, engine->GetIntervals(node));
@@ -82,7 +82,7 @@ LeafTypeTree<IntervalSet> UnionQueryEngine::GetIntervals(Node* node) const {
 
 bool UnionQueryEngine::AtMostOneTrue(
     absl::Span<TreeBitLocation const> bits) const {
-  for (const auto& engine : engines_) {
+  for (QueryEngine* engine : engines_) {
     if (engine->AtMostOneTrue(bits)) {
       return true;
     }
@@ -92,7 +92,7 @@ bool UnionQueryEngine::AtMostOneTrue(
 
 bool UnionQueryEngine::AtLeastOneTrue(
     absl::Span<TreeBitLocation const> bits) const {
-  for (const auto& engine : engines_) {
+  for (QueryEngine* engine : engines_) {
     if (engine->AtLeastOneTrue(bits)) {
       return true;
     }
@@ -102,7 +102,7 @@ bool UnionQueryEngine::AtLeastOneTrue(
 
 bool UnionQueryEngine::KnownEquals(const TreeBitLocation& a,
                                    const TreeBitLocation& b) const {
-  for (const auto& engine : engines_) {
+  for (QueryEngine* engine : engines_) {
     if (engine->KnownEquals(a, b)) {
       return true;
     }
@@ -112,7 +112,7 @@ bool UnionQueryEngine::KnownEquals(const TreeBitLocation& a,
 
 bool UnionQueryEngine::KnownNotEquals(const TreeBitLocation& a,
                                       const TreeBitLocation& b) const {
-  for (const auto& engine : engines_) {
+  for (QueryEngine* engine : engines_) {
     if (engine->KnownNotEquals(a, b)) {
       return true;
     }
@@ -122,7 +122,7 @@ bool UnionQueryEngine::KnownNotEquals(const TreeBitLocation& a,
 
 bool UnionQueryEngine::Implies(const TreeBitLocation& a,
                                const TreeBitLocation& b) const {
-  for (const auto& engine : engines_) {
+  for (QueryEngine* engine : engines_) {
     if (engine->Implies(a, b)) {
       return true;
     }
@@ -133,7 +133,7 @@ bool UnionQueryEngine::Implies(const TreeBitLocation& a,
 absl::optional<Bits> UnionQueryEngine::ImpliedNodeValue(
     absl::Span<const std::pair<TreeBitLocation, bool>> predicate_bit_values,
     Node* node) const {
-  for (const auto& engine : engines_) {
+  for (QueryEngine* engine : engines_) {
     if (auto i = engine->ImpliedNodeValue(predicate_bit_values, node)) {
       return i;
     }
@@ -19,6 +19,7 @@
 #include <vector>
 
 #include "absl/types/span.h"
+#include "xls/data_structures/min_cut.h"
 #include "xls/ir/function.h"
 #include "xls/ir/node.h"
 
@@ -53,8 +54,12 @@ namespace sched {
 //
 // Returns the two partitions as a std::pair. The first element is the
 // predecessor partition of the dicut (partition A in the example above).
+// `algorithm` selects the max-flow algorithm used to compute the min cut; the
+// result does not depend on it.
 std::pair<std::vector<Node*>, std::vector<Node*>> MinCostFunctionPartition(
-    FunctionBase* f, absl::Span<Node* const> partitionable_nodes);
+    FunctionBase* f, absl::Span<Node* const> partitionable_nodes,
+    min_cut::MaxFlowAlgorithm algorithm =
+        min_cut::MaxFlowAlgorithm::kPushRelabel);
 
 }  // namespace sched
 }  // namespace xls
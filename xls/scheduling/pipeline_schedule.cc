@@ -14,17 +14,30 @@
 
 #include "xls/scheduling/pipeline_schedule.h"
 
+#include <limits>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "absl/container/btree_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "xls/common/logging/log_lines.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/ret_check.h"
+#include "xls/common/thread_pool.h"
 #include "xls/data_structures/binary_search.h"
+#include "xls/delay_model/caching_delay_estimator.h"
 #include "xls/ir/node_iterator.h"
 #include "xls/scheduling/function_partition.h"
 #include "xls/scheduling/schedule_bounds.h"
+#include "xls/scheduling/sdc_scheduler.h"
 
 namespace xls {
 namespace {
@@ -89,13 +102,18 @@ absl::StatusOr<int64_t> CountInteriorPipelineRegisters(
   return registers;
 }
 
+// Seed from which the random orderings of min-cut cycle boundaries are
+// generated.
+constexpr uint64_t kRandomMinCutCycleOrderSeed = 0x5eed;
+
 // Schedules the given function into a pipeline with the given clock
 // period. Attempts to split nodes into stages such that the total number of
 // flops in the pipeline stages is minimized without violating the target clock
 // period.
 absl::StatusOr<ScheduleCycleMap> ScheduleToMinimizeRegisters(
     FunctionBase* f, int64_t pipeline_stages,
-    const DelayEstimator& delay_estimator, sched::ScheduleBounds* bounds) {
+    const DelayEstimator& delay_estimator, const SchedulingOptions& options,
+    sched::ScheduleBounds* bounds) {
   XLS_VLOG(3) << "ScheduleToMinimizeRegisters()";
   XLS_VLOG(3) << "  pipeline stages = " << pipeline_stages;
   XLS_VLOG_LINES(4, f->DumpIr());
@@ -103,33 +121,60 @@ absl::StatusOr<ScheduleCycleMap> ScheduleToMinimizeRegisters(
   XLS_VLOG(4) << "Initial bounds:";
   XLS_VLOG_LINES(4, bounds->ToString());
 
+  std::vector<std::vector<int64_t>> cut_orders =
+      GetMinCutCycleOrders(pipeline_stages - 1);
+  const int64_t fixed_order_count = cut_orders.size();
+  for (std::vector<int64_t>& cut_order : GetRandomMinCutCycleOrders(
+           pipeline_stages - 1, options.random_min_cut_orders(),
+           kRandomMinCutCycleOrderSeed)) {
+    cut_orders.push_back(std::move(cut_order));
+  }
+  const absl::Time random_order_deadline =
+      absl::Now() + options.random_min_cut_order_time_limit();
+
   // Try a number of different orderings of cycle boundary at which the min-cut
-  // is performed and keep the best one.
+  // is performed and keep the best one. The trials are independent so they may
+  // run concurrently. Ties are broken in favor of the earliest ordering so the
+  // result does not depend on the order in which the trials complete.
+  absl::Mutex mutex;
   int64_t best_register_count = std::numeric_limits<int64_t>::max();
+  int64_t best_order_index = -1;
   absl::optional<sched::ScheduleBounds> best_bounds;
-  for (const std::vector<int64_t>& cut_order :
-       GetMinCutCycleOrders(pipeline_stages - 1)) {
-    XLS_VLOG(3) << absl::StreamFormat("Trying cycle order: {%s}",
-                                      absl::StrJoin(cut_order, ", "));
-    sched::ScheduleBounds trial_bounds = *bounds;
-    // Partition the nodes at each cycle boundary. For each iteration, this
-    // splits the nodes into those which must be scheduled at or before the
-    // cycle and those which must be scheduled after. Upon loop completion each
-    // node will have a range of exactly one cycle.
-    for (int64_t cycle : cut_order) {
-      XLS_RETURN_IF_ERROR(
-          SplitAfterCycle(f, cycle, delay_estimator, &trial_bounds));
-      XLS_RETURN_IF_ERROR(trial_bounds.PropagateLowerBounds());
-      XLS_RETURN_IF_ERROR(trial_bounds.PropagateUpperBounds());
-    }
-    XLS_ASSIGN_OR_RETURN(int64_t trial_register_count,
-                         CountInteriorPipelineRegisters(f, trial_bounds));
-    if (!best_bounds.has_value() ||
-        best_register_count > trial_register_count) {
-      best_bounds = std::move(trial_bounds);
-      best_register_count = trial_register_count;
-    }
-  }
+  XLS_RETURN_IF_ERROR(ParallelFor(
+      cut_orders.size(), options.thread_count(),
+      [&](int64_t i) -> absl::Status {
+        if (i >= fixed_order_count && absl::Now() >= random_order_deadline) {
+          return absl::OkStatus();
+        }
+        const std::vector<int64_t>& cut_order = cut_orders[i];
+        XLS_VLOG(3) << absl::StreamFormat("Trying cycle order: {%s}",
+                                          absl::StrJoin(cut_order, ", "));
+        sched::ScheduleBounds trial_bounds = *bounds;
+        // Partition the nodes at each cycle boundary. For each iteration, this
+        // splits the nodes into those which must be scheduled at or before the
+        // cycle and those which must be scheduled after. Upon loop completion
+        // each node will have a range of exactly one cycle.
+        for (int64_t cycle : cut_order) {
+          XLS_RETURN_IF_ERROR(
+              SplitAfterCycle(f, cycle, delay_estimator, &trial_bounds));
+          XLS_RETURN_IF_ERROR(trial_bounds.PropagateLowerBounds());
+          XLS_RETURN_IF_ERROR(trial_bounds.PropagateUpperBounds());
+        }
+        XLS_ASSIGN_OR_RETURN(int64_t trial_register_count,
+                             CountInteriorPipelineRegisters(f, trial_bounds));
+        absl::MutexLock lock(&mutex);
+        if (!best_bounds.has_value() ||
+            std::make_pair(trial_register_count, i) <
+                std::make_pair(best_register_count, best_order_index)) {
+          best_bounds = std::move(trial_bounds);
+          best_register_count = trial_register_count;
+          best_order_index = i;
+        }
+        return absl::OkStatus();
+      }));
+  XLS_VLOG(3) << absl::StreamFormat(
+      "Best cycle order: {%s} (%d registers)",
+      absl::StrJoin(cut_orders[best_order_index], ", "), best_register_count);
   *bounds = std::move(*best_bounds);
 
   ScheduleCycleMap cycle_map;
@@ -141,20 +186,21 @@ absl::StatusOr<ScheduleCycleMap> ScheduleToMinimizeRegisters(
 }
 
 // Returns the nodes of `f` which must be scheduled in the first stage of a
-// pipeline. For functions this is parameters. For procs, this is receive nodes.
-// TODO(meheff): 2021/09/22 Enable receives to be scheduled in cycles other than
-// the initial cycle.
-std::vector<Node*> FirstStageNodes(FunctionBase* f) {
+// pipeline. For functions this is parameters. For procs, this is parameters
+// and, if no initiation interval is given, the receive nodes and the next state
+// node.
+std::vector<Node*> FirstStageNodes(
+    FunctionBase* f, absl::optional<int64_t> initiation_interval) {
   if (Function* function = dynamic_cast<Function*>(f)) {
     return std::vector<Node*>(function->params().begin(),
                               function->params().end());
   }
   if (Proc* proc = dynamic_cast<Proc*>(f)) {
     std::vector<Node*> nodes(proc->params().begin(), proc->params().end());
+    if (initiation_interval.has_value()) {
+      return nodes;
+    }
     for (Node* node : proc->nodes()) {
-      // TODO(tedhong): 2021/10/14 Make this more flexible (ex. for ii>N),
-      // where the next state node must be scheduled before a specific state
-      // but not necessarily the 1st stage.
       if (node->Is<Receive>() || (node == proc->NextState())) {
         nodes.push_back(node);
       }
@@ -167,10 +213,9 @@ std::vector<Node*> FirstStageNodes(FunctionBase* f) {
 
 // Returns the nodes of `f` which must be scheduled in the final stage of a
 // pipeline. For functions this is the return value. For procs, this is send
-// nodes.
-// TODO(meheff): 2021/09/22 Enable sends to be scheduled in cycles other than
-// the final cycle.
-std::vector<Node*> FinalStageNodes(FunctionBase* f) {
+// nodes if no initiation interval is given.
+std::vector<Node*> FinalStageNodes(
+    FunctionBase* f, absl::optional<int64_t> initiation_interval) {
   if (Function* function = dynamic_cast<Function*>(f)) {
     // If the return value is a parameter, then we do not force the return value
     // to be scheduled in the final stage because, as a parameter, the node must
@@ -181,6 +226,9 @@ std::vector<Node*> FinalStageNodes(FunctionBase* f) {
     return {function->return_value()};
   }
   if (Proc* proc = dynamic_cast<Proc*>(f)) {
+    if (initiation_interval.has_value()) {
+      return {};
+    }
     std::vector<Node*> nodes;
     for (Node* node : proc->nodes()) {
       if (node->Is<Send>()) {
@@ -198,10 +246,14 @@ std::vector<Node*> FinalStageNodes(FunctionBase* f) {
 // the nodes of `f`. If `schedule_length` is given then the upper bounds are
 // set on the bounds object with the maximum upper bound set to
 // `schedule_length` - 1. Otherwise, the maximum upper bound is set to the
-// maximum lower bound.
+// maximum lower bound. If `initiation_interval` is given and `f` is a proc,
+// then receives and sends may be placed in any stage, and the next state node
+// is constrained to the first `initiation_interval` stages so that a new
+// iteration of the proc can start every `initiation_interval` cycles.
 absl::StatusOr<sched::ScheduleBounds> ConstructBounds(
     FunctionBase* f, int64_t clock_period_ps, std::vector<Node*> topo_sort,
     absl::optional<int64_t> schedule_length,
+    absl::optional<int64_t> initiation_interval,
     const DelayEstimator& delay_estimator) {
   sched::ScheduleBounds bounds(f, std::move(topo_sort), clock_period_ps,
                                delay_estimator);
@@ -224,7 +276,7 @@ absl::StatusOr<sched::ScheduleBounds> ConstructBounds(
   // Set the lower bound of nodes which must be in the final stage to
   // `upper_bound`
   bool rerun_lb_propagation = false;
-  for (Node* node : FinalStageNodes(f)) {
+  for (Node* node : FinalStageNodes(f, initiation_interval)) {
     if (bounds.lb(node) != upper_bound) {
       XLS_RETURN_IF_ERROR(bounds.TightenNodeLb(node, upper_bound));
       if (!node->users().empty()) {
@@ -244,16 +296,17 @@ absl::StatusOr<sched::ScheduleBounds> ConstructBounds(
         "node(s) must be scheduled in the final cycle but that "
         "is impossible due to users of these node(s): %s",
         f->name(),
-        absl::StrJoin(FinalStageNodes(f), ", ", [](std::string* out, Node* n) {
-          absl::StrAppend(out, n->GetName());
-        })));
+        absl::StrJoin(FinalStageNodes(f, initiation_interval), ", ",
+                      [](std::string* out, Node* n) {
+                        absl::StrAppend(out, n->GetName());
+                      })));
   }
 
   // Set and propagate upper bounds.
   for (Node* node : f->nodes()) {
     XLS_RETURN_IF_ERROR(bounds.TightenNodeUb(node, upper_bound));
   }
-  for (Node* node : FirstStageNodes(f)) {
+  for (Node* node : FirstStageNodes(f, initiation_interval)) {
     if (bounds.lb(node) > 0) {
       return absl::ResourceExhaustedError(
           absl::StrFormat("Impossible to schedule Function/Proc %s; node `%s` "
@@ -263,62 +316,218 @@ absl::StatusOr<sched::ScheduleBounds> ConstructBounds(
     }
     XLS_RETURN_IF_ERROR(bounds.TightenNodeUb(node, 0));
   }
+  if (f->IsProc() && initiation_interval.has_value()) {
+    // The state register is read in the first stage, so the next state must be
+    // computed within `initiation_interval` stages of it.
+    Node* next_state = f->AsProcOrDie()->NextState();
+    if (bounds.lb(next_state) >= initiation_interval.value()) {
+      return absl::ResourceExhaustedError(absl::StrFormat(
+          "Impossible to schedule Proc %s with an initiation interval of %d; "
+          "next state node `%s` cannot be scheduled before cycle %d",
+          f->name(), initiation_interval.value(), next_state->GetName(),
+          bounds.lb(next_state)));
+    }
+    XLS_RETURN_IF_ERROR(
+        bounds.TightenNodeUb(next_state, initiation_interval.value() - 1));
+  }
   XLS_RETURN_IF_ERROR(bounds.PropagateUpperBounds());
 
   return std::move(bounds);
 }
 
-// Returns the critical path through the given nodes (ordered topologically).
-absl::StatusOr<int64_t> ComputeCriticalPath(
-    absl::Span<Node* const> topo_sort, const DelayEstimator& delay_estimator) {
-  int64_t function_cp = 0;
-  absl::flat_hash_map<Node*, int64_t> node_cp;
-  for (Node* node : topo_sort) {
-    int64_t node_start = 0;
-    for (Node* operand : node->operands()) {
-      node_start = std::max(node_start, node_cp[operand]);
+// Searches for the minimum clock periods at which a function can be scheduled
+// into pipelines of given lengths. Each probe of a clock period is first
+// answered by a cheap as-soon-as-possible stage count computed over integer
+// arrays with node delays precomputed once. Stage counts are memoized, and
+// because the stage count does not increase with the clock period, a probe is
+// often answered without any computation from earlier probes at smaller (or
+// larger) periods. Only the final candidate period is checked by constructing
+// full schedule bounds.
+class ClockPeriodSearch {
+ public:
+  static absl::StatusOr<ClockPeriodSearch> Create(
+      FunctionBase* f, absl::optional<int64_t> initiation_interval,
+      const DelayEstimator& delay_estimator) {
+    ClockPeriodSearch search(f, initiation_interval, delay_estimator);
+    auto topo_sort_it = TopoSort(f);
+    search.topo_sort_ =
+        std::vector<Node*>(topo_sort_it.begin(), topo_sort_it.end());
+    absl::flat_hash_map<Node*, int64_t> topo_index;
+    search.operand_starts_.push_back(0);
+    for (Node* node : search.topo_sort_) {
+      XLS_ASSIGN_OR_RETURN(int64_t delay,
+                           delay_estimator.GetOperationDelayInPs(node));
+      int64_t start = 0;
+      for (Node* operand : node->operands()) {
+        int64_t operand_index = topo_index.at(operand);
+        search.operands_.push_back(operand_index);
+        start = std::max(start, search.critical_path_to_[operand_index]);
+      }
+      topo_index[node] = search.delays_.size();
+      search.delays_.push_back(delay);
+      search.critical_path_to_.push_back(start + delay);
+      search.operand_starts_.push_back(search.operands_.size());
+      search.critical_path_ps_ =
+          std::max(search.critical_path_ps_, start + delay);
+      search.max_node_delay_ps_ = std::max(search.max_node_delay_ps_, delay);
     }
-    XLS_ASSIGN_OR_RETURN(int64_t node_delay,
-                         delay_estimator.GetOperationDelayInPs(node));
-    node_cp[node] = node_start + node_delay;
-    function_cp = std::max(function_cp, node_cp[node]);
+    return std::move(search);
+  }
+
+  // The critical-path delay through the entire function.
+  int64_t critical_path_ps() const { return critical_path_ps_; }
+
+  // The largest delay of any single node, a lower bound on the clock period.
+  int64_t max_node_delay_ps() const { return max_node_delay_ps_; }
+
+  // Returns the minimum clock period in the range [search_start, search_end]
+  // at which the function can be scheduled in `pipeline_stages` stages.
+  absl::StatusOr<int64_t> FindMinimumClockPeriod(int64_t pipeline_stages,
+                                                 int64_t search_start,
+                                                 int64_t search_end) {
+    XLS_VLOG(4) << absl::StreamFormat(
+        "Binary searching over interval [%d, %d] for %d stages", search_start,
+        search_end, pipeline_stages);
+    // The as-soon-as-possible stage count is a lower bound on the length of
+    // any schedule, so the minimum feasible period is at least the minimum
+    // period found by searching on stage counts alone.
+    XLS_ASSIGN_OR_RETURN(
+        int64_t min_period,
+        BinarySearchMinTrueWithStatus(
+            search_start, search_end,
+            [&](int64_t clock_period_ps) -> absl::StatusOr<bool> {
+              return AsapFitsInStages(clock_period_ps, pipeline_stages);
+            }));
+    if (IsFeasible(min_period, pipeline_stages)) {
+      return min_period;
+    }
+    // Constraints on the first and last stage can make the candidate period
+    // infeasible; fall back to searching with full bounds construction.
+    return BinarySearchMinTrueWithStatus(
+        min_period, search_end,
+        [&](int64_t clock_period_ps) -> absl::StatusOr<bool> {
+          return IsFeasible(clock_period_ps, pipeline_stages);
+        });
   }
-  return function_cp;
-}
+
+ private:
+  ClockPeriodSearch(FunctionBase* f,
+                    absl::optional<int64_t> initiation_interval,
+                    const DelayEstimator& delay_estimator)
+      : f_(f),
+        initiation_interval_(initiation_interval),
+        delay_estimator_(&delay_estimator) {}
+
+  // Returns whether the as-soon-as-possible schedule at the given clock period
+  // has at most `pipeline_stages` stages. Uses the memoized stage counts of
+  // the nearest probed periods when they decide the answer.
+  bool AsapFitsInStages(int64_t clock_period_ps, int64_t pipeline_stages) {
+    if (clock_period_ps < max_node_delay_ps_) {
+      return false;
+    }
+    auto larger = stage_counts_.lower_bound(clock_period_ps);
+    if (larger != stage_counts_.end() && larger->second > pipeline_stages) {
+      return false;
+    }
+    if (larger != stage_counts_.end() && larger->first == clock_period_ps) {
+      return true;
+    }
+    if (larger != stage_counts_.begin() &&
+        std::prev(larger)->second <= pipeline_stages) {
+      return true;
+    }
+    return AsapStageCount(clock_period_ps) <= pipeline_stages;
+  }
+
+  // Returns the number of stages of the as-soon-as-possible schedule at the
+  // given clock period, which must be at least the largest node delay.
+  // Computes the same lower bounds as ScheduleBounds::PropagateLowerBounds.
+  int64_t AsapStageCount(int64_t clock_period_ps) {
+    int64_t max_lb = 0;
+    std::vector<int64_t>& lb = lb_scratch_;
+    std::vector<int64_t>& in_cycle_delay = in_cycle_delay_scratch_;
+    lb.assign(delays_.size(), 0);
+    in_cycle_delay.assign(delays_.size(), 0);
+    for (int64_t i = 0; i < delays_.size(); ++i) {
+      for (int64_t j = operand_starts_[i]; j < operand_starts_[i + 1]; ++j) {
+        int64_t operand = operands_[j];
+        if (lb[operand] < lb[i]) {
+          continue;
+        }
+        int64_t operand_end = in_cycle_delay[operand] + delays_[operand];
+        if (lb[operand] > lb[i]) {
+          lb[i] = lb[operand];
+          in_cycle_delay[i] = operand_end;
+        } else {
+          in_cycle_delay[i] = std::max(in_cycle_delay[i], operand_end);
+        }
+      }
+      if (in_cycle_delay[i] + delays_[i] > clock_period_ps) {
+        ++lb[i];
+        in_cycle_delay[i] = 0;
+      }
+      max_lb = std::max(max_lb, lb[i]);
+    }
+    stage_counts_[clock_period_ps] = max_lb + 1;
+    return max_lb + 1;
+  }
+
+  // Returns whether schedule bounds for a pipeline of at most the given length
+  // can be constructed at the given clock period.
+  bool IsFeasible(int64_t clock_period_ps, int64_t pipeline_stages) {
+    absl::StatusOr<sched::ScheduleBounds> bounds_or =
+        ConstructBounds(f_, clock_period_ps, topo_sort_,
+                        /*schedule_length=*/absl::nullopt,
+                        initiation_interval_, *delay_estimator_);
+    if (!bounds_or.ok()) {
+      return false;
+    }
+    return bounds_or.value().max_lower_bound() < pipeline_stages;
+  }
+
+  FunctionBase* f_;
+  absl::optional<int64_t> initiation_interval_;
+  const DelayEstimator* delay_estimator_;
+  std::vector<Node*> topo_sort_;
+
+  // Node delays, and the operands of each node in compressed sparse row form,
+  // all indexed by position in `topo_sort_`.
+  std::vector<int64_t> delays_;
+  std::vector<int64_t> operand_starts_;
+  std::vector<int64_t> operands_;
+  std::vector<int64_t> critical_path_to_;
+
+  int64_t critical_path_ps_ = 0;
+  int64_t max_node_delay_ps_ = 0;
+
+  // Memoized as-soon-as-possible stage counts by clock period.
+  absl::btree_map<int64_t, int64_t> stage_counts_;
+  std::vector<int64_t> lb_scratch_;
+  std::vector<int64_t> in_cycle_delay_scratch_;
+};
 
 // Returns the minimum clock period in picoseconds for which it is feasible to
 // schedule the function into a pipeline with the given number of stages.
 absl::StatusOr<int64_t> FindMinimumClockPeriod(
     FunctionBase* f, int64_t pipeline_stages,
+    absl::optional<int64_t> initiation_interval,
     const DelayEstimator& delay_estimator) {
   XLS_VLOG(4) << "FindMinimumClockPeriod()";
   XLS_VLOG(4) << "  pipeline stages = " << pipeline_stages;
-  auto topo_sort_it = TopoSort(f);
-  std::vector<Node*> topo_sort(topo_sort_it.begin(), topo_sort_it.end());
-  XLS_ASSIGN_OR_RETURN(int64_t function_cp,
-                       ComputeCriticalPath(topo_sort, delay_estimator));
+  XLS_ASSIGN_OR_RETURN(
+      ClockPeriodSearch search,
+      ClockPeriodSearch::Create(f, initiation_interval, delay_estimator));
   // The lower bound of the search is the critical path delay evenly distributed
   // across all stages (rounded up), and the upper bound is simply the critical
   // path of the entire function. It's possible this upper bound is the best you
   // can do if there exists a single operation with delay equal to the
   // critical-path delay of the function.
+  int64_t function_cp = search.critical_path_ps();
   int64_t search_start = (function_cp + pipeline_stages - 1) / pipeline_stages;
-  int64_t search_end = function_cp;
-  XLS_VLOG(4) << absl::StreamFormat("Binary searching over interval [%d, %d]",
-                                    search_start, search_end);
   XLS_ASSIGN_OR_RETURN(
       int64_t min_period,
-      BinarySearchMinTrueWithStatus(
-          search_start, search_end,
-          [&](int64_t clk_period_ps) -> absl::StatusOr<bool> {
-            absl::StatusOr<sched::ScheduleBounds> bounds_or = ConstructBounds(
-                f, clk_period_ps, topo_sort,
-                /*schedule_length=*/absl::nullopt, delay_estimator);
-            if (!bounds_or.ok()) {
-              return false;
-            }
-            return bounds_or.value().max_lower_bound() < pipeline_stages;
-          }));
+      search.FindMinimumClockPeriod(pipeline_stages, search_start,
+                                    function_cp));
   XLS_VLOG(4) << "minimum clock period = " << min_period;
 
   return min_period;
@@ -375,6 +584,65 @@ std::vector<std::vector<int64_t>> GetMinCutCycleOrders(int64_t length) {
   return orders;
 }
 
+absl::StatusOr<std::vector<ClockPeriodAndStages>> ComputeClockPeriodCurve(
+    FunctionBase* f, int64_t max_pipeline_stages,
+    const DelayEstimator& delay_estimator,
+    absl::optional<int64_t> initiation_interval) {
+  XLS_RET_CHECK_GE(max_pipeline_stages, 1);
+  XLS_ASSIGN_OR_RETURN(
+      ClockPeriodSearch search,
+      ClockPeriodSearch::Create(f, initiation_interval, delay_estimator));
+  std::vector<ClockPeriodAndStages> curve;
+  int64_t function_cp = search.critical_path_ps();
+  int64_t search_end = function_cp;
+  for (int64_t stages = 1; stages <= max_pipeline_stages; ++stages) {
+    // No clock period is shorter than the longest node delay.
+    if (!curve.empty() &&
+        curve.back().clock_period_ps == search.max_node_delay_ps()) {
+      break;
+    }
+    int64_t search_start = std::max((function_cp + stages - 1) / stages,
+                                    search.max_node_delay_ps());
+    // A longer pipeline never requires a longer clock period, so the period
+    // found for one fewer stage bounds the search.
+    XLS_ASSIGN_OR_RETURN(
+        int64_t period,
+        search.FindMinimumClockPeriod(stages, search_start, search_end));
+    if (curve.empty() || period < curve.back().clock_period_ps) {
+      curve.push_back(ClockPeriodAndStages{.clock_period_ps = period,
+                                           .pipeline_stages = stages});
+    }
+    search_end = period;
+  }
+  return curve;
+}
+
+std::vector<std::vector<int64_t>> GetRandomMinCutCycleOrders(int64_t length,
+                                                             int64_t count,
+                                                             uint64_t seed) {
+  std::vector<std::vector<int64_t>> fixed_orders = GetMinCutCycleOrders(length);
+  absl::flat_hash_set<std::vector<int64_t>> seen(fixed_orders.begin(),
+                                                 fixed_orders.end());
+  std::vector<std::vector<int64_t>> orders;
+  std::vector<int64_t> order(length);
+  std::iota(order.begin(), order.end(), 0);
+  std::mt19937_64 rng(seed);
+  // For short lengths there may be fewer distinct orderings than requested, so
+  // bound the number of attempts.
+  for (int64_t attempt = 0; attempt < 4 * count && orders.size() < count;
+       ++attempt) {
+    // Fisher-Yates shuffle. std::shuffle is avoided because its output is
+    // implementation-defined.
+    for (int64_t i = length - 1; i > 0; --i) {
+      std::swap(order[i], order[rng() % (i + 1)]);
+    }
+    if (seen.insert(order).second) {
+      orders.push_back(order);
+    }
+  }
+  return orders;
+}
+
 PipelineSchedule::PipelineSchedule(FunctionBase* function_base,
                                    ScheduleCycleMap cycle_map,
                                    absl::optional<int64_t> length)
@@ -468,12 +736,22 @@ class DelayEstimatorWithInputDelay : public DelayEstimator {
 /*static*/ absl::StatusOr<PipelineSchedule> PipelineSchedule::Run(
     FunctionBase* f, const DelayEstimator& delay_estimator,
     const SchedulingOptions& options) {
+  if (options.initiation_interval().has_value() &&
+      options.initiation_interval().value() < 1) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Initiation interval must be positive, got %d",
+                        options.initiation_interval().value()));
+  }
+
   int64_t input_delay = options.additional_input_delay_ps().has_value()
                             ? options.additional_input_delay_ps().value()
                             : 0;
 
   DelayEstimatorWithInputDelay delay_estimator_with_delay(delay_estimator,
                                                           input_delay);
+  // Node delays are queried many times while scheduling; compute each once.
+  CachingDelayEstimator cached_delay_estimator(delay_estimator_with_delay);
+  XLS_RETURN_IF_ERROR(cached_delay_estimator.PrecomputeDelays(f));
 
   int64_t clock_period_ps;
   if (options.clock_period_ps().has_value()) {
@@ -496,9 +774,11 @@ class DelayEstimatorWithInputDelay : public DelayEstimator {
     // A pipeline length is specified, but no target clock period. Determine
     // the minimum clock period for which the function can be scheduled in the
     // given pipeline length.
-    XLS_ASSIGN_OR_RETURN(clock_period_ps,
-                         FindMinimumClockPeriod(f, *options.pipeline_stages(),
-                                                delay_estimator_with_delay));
+    XLS_ASSIGN_OR_RETURN(
+        clock_period_ps,
+        FindMinimumClockPeriod(f, *options.pipeline_stages(),
+                               options.initiation_interval(),
+                               cached_delay_estimator));
 
     if (options.period_relaxation_percent().has_value()) {
       int64_t relaxation_percent = options.period_relaxation_percent().value();
@@ -510,14 +790,23 @@ class DelayEstimatorWithInputDelay : public DelayEstimator {
   XLS_ASSIGN_OR_RETURN(
       sched::ScheduleBounds bounds,
       ConstructBounds(f, clock_period_ps, TopoSort(f).AsVector(),
-                      options.pipeline_stages(), delay_estimator_with_delay));
+                      options.pipeline_stages(), options.initiation_interval(),
+                      cached_delay_estimator));
   int64_t schedule_length = bounds.max_lower_bound() + 1;
 
   ScheduleCycleMap cycle_map;
   if (options.strategy() == SchedulingStrategy::MINIMIZE_REGISTERS) {
-    XLS_ASSIGN_OR_RETURN(cycle_map, ScheduleToMinimizeRegisters(
-                                        f, schedule_length,
-                                        delay_estimator_with_delay, &bounds));
+    XLS_ASSIGN_OR_RETURN(
+        cycle_map,
+        ScheduleToMinimizeRegisters(f, schedule_length,
+                                    cached_delay_estimator, options,
+                                    &bounds));
+  } else if (options.strategy() ==
+             SchedulingStrategy::MINIMIZE_REGISTERS_SDC) {
+    XLS_ASSIGN_OR_RETURN(
+        cycle_map,
+        ScheduleToMinimizeRegistersSdc(f, clock_period_ps,
+                                       cached_delay_estimator, bounds));
   } else {
     XLS_RET_CHECK(options.strategy() == SchedulingStrategy::ASAP);
     XLS_RET_CHECK(!options.pipeline_stages().has_value());
@@ -528,7 +817,7 @@ class DelayEstimatorWithInputDelay : public DelayEstimator {
   }
   auto schedule = PipelineSchedule(f, cycle_map, options.pipeline_stages());
   XLS_RETURN_IF_ERROR(
-      schedule.VerifyTiming(clock_period_ps, delay_estimator_with_delay));
+      schedule.VerifyTiming(clock_period_ps, cached_delay_estimator));
   XLS_VLOG_LINES(3, "Schedule\n" + schedule.ToString());
   return schedule;
 }
@@ -18,6 +18,7 @@
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/time/time.h"
 #include "xls/delay_model/delay_estimator.h"
 #include "xls/ir/function.h"
 #include "xls/ir/function_base.h"
@@ -33,7 +34,12 @@ enum class SchedulingStrategy {
   ASAP,
 
   // Minimize the number of pipeline registers when scheduling.
-  MINIMIZE_REGISTERS
+  MINIMIZE_REGISTERS,
+
+  // Minimize the number of pipeline registers by solving for all cycles
+  // jointly as a system of difference constraints (see sdc_scheduler.h).
+  // Slower than MINIMIZE_REGISTERS but produces an optimal schedule.
+  MINIMIZE_REGISTERS_SDC,
 };
 
 // Returns the list of ordering of cycles (pipeline stages) in which to compute
@@ -46,6 +52,14 @@ enum class SchedulingStrategy {
 // are tried. This function returns this set of orderings.  Exposed for testing.
 std::vector<std::vector<int64_t>> GetMinCutCycleOrders(int64_t length);
 
+// Returns up to `count` distinct pseudo-random orderings of cycles of the given
+// length which are not among those returned by GetMinCutCycleOrders. The
+// orderings are a deterministic function of the arguments. Exposed for
+// testing.
+std::vector<std::vector<int64_t>> GetRandomMinCutCycleOrders(int64_t length,
+                                                             int64_t count,
+                                                             uint64_t seed);
+
 // Options to use when generating a pipeline schedule. At least a clock period
 // or a pipeline length (or both) must be specified. If only one value is
 // specified the other value is computed as follows:
@@ -119,6 +133,49 @@ class SchedulingOptions {
     return additional_input_delay_ps_;
   }
 
+  // Sets/gets the number of threads on which the orderings of min-cut cycle
+  // boundaries are evaluated when minimizing registers. The resulting schedule
+  // does not depend on the number of threads.
+  SchedulingOptions& thread_count(int64_t value) {
+    thread_count_ = value;
+    return *this;
+  }
+  int64_t thread_count() const { return thread_count_; }
+
+  // Sets/gets the number of pseudo-randomly generated orderings of min-cut
+  // cycle boundaries to try in addition to those returned by
+  // GetMinCutCycleOrders. The orderings are generated from a fixed seed.
+  SchedulingOptions& random_min_cut_orders(int64_t value) {
+    random_min_cut_orders_ = value;
+    return *this;
+  }
+  int64_t random_min_cut_orders() const { return random_min_cut_orders_; }
+
+  // Sets/gets the wall-clock time limit for trying the random min-cut cycle
+  // orderings. Random orderings not started before the limit expires are
+  // skipped, so a finite limit makes the schedule depend on the speed of the
+  // machine. The orderings from GetMinCutCycleOrders are always tried.
+  SchedulingOptions& random_min_cut_order_time_limit(absl::Duration value) {
+    random_min_cut_order_time_limit_ = value;
+    return *this;
+  }
+  absl::Duration random_min_cut_order_time_limit() const {
+    return random_min_cut_order_time_limit_;
+  }
+
+  // Sets/gets the initiation interval of procs: the number of cycles between
+  // the starts of successive iterations. If set, receives and sends may be
+  // scheduled in any stage rather than only the first and last stage, and the
+  // next state node is scheduled in one of the first `initiation_interval`
+  // stages. Has no effect on functions.
+  SchedulingOptions& initiation_interval(int64_t value) {
+    initiation_interval_ = value;
+    return *this;
+  }
+  absl::optional<int64_t> initiation_interval() const {
+    return initiation_interval_;
+  }
+
  private:
   SchedulingStrategy strategy_;
   absl::optional<int64_t> clock_period_ps_;
@@ -126,8 +183,32 @@ class SchedulingOptions {
   absl::optional<int64_t> clock_margin_percent_;
   absl::optional<int64_t> period_relaxation_percent_;
   absl::optional<int64_t> additional_input_delay_ps_;
+  int64_t thread_count_ = 1;
+  int64_t random_min_cut_orders_ = 0;
+  absl::Duration random_min_cut_order_time_limit_ = absl::InfiniteDuration();
+  absl::optional<int64_t> initiation_interval_;
+};
+
+// A point on the trade-off curve between clock period and pipeline length.
+struct ClockPeriodAndStages {
+  int64_t clock_period_ps;
+  int64_t pipeline_stages;
 };
 
+// Returns the Pareto-optimal trade-offs between clock period and pipeline
+// length for scheduling `f` into at most `max_pipeline_stages` stages. Points
+// are ordered by increasing pipeline length and strictly decreasing clock
+// period; each holds the minimum clock period at which `f` can be scheduled
+// into that many stages. Each period is the same as the one computed when
+// scheduling with only `pipeline_stages` specified, but the whole curve is
+// computed in a single search which shares work between pipeline lengths.
+// `initiation_interval` constrains procs as in
+// SchedulingOptions::initiation_interval.
+absl::StatusOr<std::vector<ClockPeriodAndStages>> ComputeClockPeriodCurve(
+    FunctionBase* f, int64_t max_pipeline_stages,
+    const DelayEstimator& delay_estimator,
+    absl::optional<int64_t> initiation_interval = absl::nullopt);
+
 // A map from node to cycle as a bare-bones representation of a schedule.
 using ScheduleCycleMap = absl::flat_hash_map<Node*, int64_t>;
 
@@ -16,6 +16,7 @@
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "xls/common/status/matchers.h"
@@ -34,9 +35,13 @@ namespace m = ::xls::op_matchers;
 namespace xls {
 namespace {
 
+using ::testing::AllOf;
 using ::testing::ElementsAre;
+using ::testing::Field;
 using ::testing::HasSubstr;
+using ::testing::IsEmpty;
 using ::testing::UnorderedElementsAre;
+using xls::status_testing::IsOkAndHolds;
 using xls::status_testing::StatusIs;
 
 class TestDelayEstimator : public DelayEstimator {
@@ -245,6 +250,66 @@ TEST_F(PipelineScheduleTest, MinimizeRegisterBitslices) {
       UnorderedElementsAre(m::BitSlice(m::Param("x")), m::Neg(), m::Concat()));
 }
 
+TEST_F(PipelineScheduleTest, SdcMinimizeRegisterBitslices) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  auto x = fb.Param("x", p->GetBitsType(32));
+  auto y = fb.Param("y", p->GetBitsType(32));
+  auto x_slice = fb.BitSlice(x, /*start=*/8, /*width=*/8);
+  auto y_slice = fb.BitSlice(y, /*start=*/8, /*width=*/8);
+  auto neg_neg_y = fb.Negate(fb.Negate(y));
+  fb.Concat({x, x_slice, y_slice, neg_neg_y});
+
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PipelineSchedule schedule,
+      PipelineSchedule::Run(
+          f, TestDelayEstimator(),
+          SchedulingOptions(SchedulingStrategy::MINIMIZE_REGISTERS_SDC)
+              .clock_period_ps(1)));
+
+  EXPECT_EQ(schedule.length(), 2);
+  EXPECT_THAT(schedule.nodes_in_cycle(0),
+              UnorderedElementsAre(m::Param("x"), m::Param("y"),
+                                   m::BitSlice(m::Param("y")), m::Neg()));
+  EXPECT_THAT(
+      schedule.nodes_in_cycle(1),
+      UnorderedElementsAre(m::BitSlice(m::Param("x")), m::Neg(), m::Concat()));
+  EXPECT_EQ(schedule.CountFinalInteriorPipelineRegisters(), 72);
+}
+
+TEST_F(PipelineScheduleTest, SdcNoWorseThanMinCut) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(32));
+  BValue y = fb.Param("y", p->GetBitsType(32));
+  BValue value = x;
+  for (int64_t i = 0; i < 12; ++i) {
+    BValue wide = fb.Concat({value, y});
+    value = fb.Add(fb.BitSlice(fb.UMul(wide, wide), i, 32),
+                   fb.ZeroExtend(fb.BitSlice(value, i, 4), 32));
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.BuildWithReturnValue(value));
+
+  for (int64_t stages : {2, 3, 5, 8}) {
+    XLS_ASSERT_OK_AND_ASSIGN(
+        PipelineSchedule min_cut,
+        PipelineSchedule::Run(f, TestDelayEstimator(),
+                              SchedulingOptions().pipeline_stages(stages)));
+    XLS_ASSERT_OK_AND_ASSIGN(
+        PipelineSchedule sdc,
+        PipelineSchedule::Run(
+            f, TestDelayEstimator(),
+            SchedulingOptions(SchedulingStrategy::MINIMIZE_REGISTERS_SDC)
+                .pipeline_stages(stages)));
+    XLS_EXPECT_OK(sdc.Verify());
+    EXPECT_EQ(sdc.length(), stages);
+    EXPECT_LE(sdc.CountFinalInteriorPipelineRegisters(),
+              min_cut.CountFinalInteriorPipelineRegisters());
+  }
+}
+
 TEST_F(PipelineScheduleTest, AsapScheduleComplex) {
   auto p = CreatePackage();
   FunctionBuilder fb(TestName(), p.get());
@@ -406,6 +471,43 @@ TEST_F(PipelineScheduleTest, JustPipelineLengthGiven) {
   EXPECT_THAT(scheduled_ops(5), UnorderedElementsAre(Op::kConcat, Op::kNeg));
 }
 
+TEST_F(PipelineScheduleTest, ClockPeriodCurve) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue value = fb.Param("x", p->GetBitsType(32));
+  for (int64_t i = 0; i < 8; ++i) {
+    value = fb.Add(value, fb.Literal(UBits(1, 32)));
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(Function * func, fb.BuildWithReturnValue(value));
+
+  auto point = [](int64_t clock_period_ps, int64_t pipeline_stages) {
+    return AllOf(
+        Field(&ClockPeriodAndStages::clock_period_ps, clock_period_ps),
+        Field(&ClockPeriodAndStages::pipeline_stages, pipeline_stages));
+  };
+  EXPECT_THAT(ComputeClockPeriodCurve(func, 20, TestDelayEstimator()),
+              IsOkAndHolds(ElementsAre(point(8, 1), point(4, 2), point(3, 3),
+                                       point(2, 4), point(1, 8))));
+  EXPECT_THAT(ComputeClockPeriodCurve(func, 3, TestDelayEstimator()),
+              IsOkAndHolds(ElementsAre(point(8, 1), point(4, 2), point(3, 3))));
+
+  // Each point matches the period chosen when scheduling with only the
+  // pipeline length given.
+  for (int64_t stages = 1; stages <= 8; ++stages) {
+    XLS_ASSERT_OK_AND_ASSIGN(
+        PipelineSchedule schedule,
+        PipelineSchedule::Run(func, TestDelayEstimator(),
+                              SchedulingOptions().pipeline_stages(stages)));
+    int64_t expected_period = (8 + stages - 1) / stages;
+    XLS_EXPECT_OK(schedule.VerifyTiming(expected_period, TestDelayEstimator()));
+    if (expected_period > 1) {
+      EXPECT_FALSE(
+          schedule.VerifyTiming(expected_period - 1, TestDelayEstimator())
+              .ok());
+    }
+  }
+}
+
 TEST_F(PipelineScheduleTest, LongPipelineLength) {
   // Generate an absurdly long pipeline schedule. Most stages are empty, but it
   // should not crash.
@@ -554,6 +656,68 @@ TEST_F(PipelineScheduleTest, MinCutCycleOrders) {
                           std::vector<int64_t>({3, 1, 0, 2, 5, 4, 6, 7})));
 }
 
+TEST_F(PipelineScheduleTest, RandomMinCutCycleOrders) {
+  EXPECT_THAT(GetRandomMinCutCycleOrders(0, 5, /*seed=*/0), IsEmpty());
+  EXPECT_THAT(GetRandomMinCutCycleOrders(2, 5, /*seed=*/0), IsEmpty());
+  // Only three of the six orderings of length three are not fixed orders.
+  EXPECT_THAT(GetRandomMinCutCycleOrders(3, 10, /*seed=*/0),
+              UnorderedElementsAre(std::vector<int64_t>({0, 2, 1}),
+                                   std::vector<int64_t>({1, 2, 0}),
+                                   std::vector<int64_t>({2, 0, 1})));
+
+  std::vector<std::vector<int64_t>> orders =
+      GetRandomMinCutCycleOrders(10, 20, /*seed=*/42);
+  EXPECT_EQ(orders.size(), 20);
+  EXPECT_EQ(orders, GetRandomMinCutCycleOrders(10, 20, /*seed=*/42));
+  absl::flat_hash_set<std::vector<int64_t>> unique(orders.begin(),
+                                                   orders.end());
+  EXPECT_EQ(unique.size(), orders.size());
+  for (const std::vector<int64_t>& fixed_order : GetMinCutCycleOrders(10)) {
+    EXPECT_FALSE(unique.contains(fixed_order));
+  }
+  for (const std::vector<int64_t>& order : orders) {
+    EXPECT_THAT(order, UnorderedElementsAre(0, 1, 2, 3, 4, 5, 6, 7, 8, 9));
+  }
+}
+
+TEST_F(PipelineScheduleTest, ParallelMinCutOrdersMatchSequential) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(32));
+  BValue y = fb.Param("y", p->GetBitsType(32));
+  BValue value = x;
+  for (int64_t i = 0; i < 12; ++i) {
+    value = fb.Add(fb.BitSlice(fb.UMul(value, y), 0, 32),
+                   fb.ZeroExtend(fb.BitSlice(value, i, 4), 32));
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.BuildWithReturnValue(value));
+
+  auto schedule_with = [&](int64_t thread_count, int64_t random_orders) {
+    return PipelineSchedule::Run(f, TestDelayEstimator(),
+                                 SchedulingOptions()
+                                     .pipeline_stages(8)
+                                     .thread_count(thread_count)
+                                     .random_min_cut_orders(random_orders));
+  };
+  XLS_ASSERT_OK_AND_ASSIGN(PipelineSchedule sequential, schedule_with(1, 0));
+  XLS_ASSERT_OK_AND_ASSIGN(PipelineSchedule parallel, schedule_with(4, 0));
+  for (Node* node : f->nodes()) {
+    EXPECT_EQ(parallel.cycle(node), sequential.cycle(node));
+  }
+
+  // Additional random orderings can only improve the result, and the result
+  // does not depend on the number of threads.
+  XLS_ASSERT_OK_AND_ASSIGN(PipelineSchedule random_sequential,
+                           schedule_with(1, 16));
+  XLS_ASSERT_OK_AND_ASSIGN(PipelineSchedule random_parallel,
+                           schedule_with(4, 16));
+  EXPECT_LE(random_sequential.CountFinalInteriorPipelineRegisters(),
+            sequential.CountFinalInteriorPipelineRegisters());
+  for (Node* node : f->nodes()) {
+    EXPECT_EQ(random_parallel.cycle(node), random_sequential.cycle(node));
+  }
+}
+
 TEST_F(PipelineScheduleTest, SerializeAndDeserialize) {
   auto p = CreatePackage();
   FunctionBuilder fb(TestName(), p.get());
@@ -660,6 +824,126 @@ TEST_F(PipelineScheduleTest, ProcWithConditionalReceiveError) {
                          "that is impossible due to the node's operand(s)")));
 }
 
+TEST_F(PipelineScheduleTest, ProcWithConditionalReceiveAndInitiationInterval) {
+  // With an initiation interval given, the receive is not pinned to the first
+  // cycle and can be scheduled after its late condition.
+  Package p("p");
+  Type* u16 = p.GetBitsType(16);
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * in_ch,
+      p.CreateStreamingChannel("in", ChannelOps::kReceiveOnly, u16));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * out_ch,
+      p.CreateStreamingChannel("out", ChannelOps::kSendOnly, u16));
+  TokenlessProcBuilder pb("the_proc", Value(UBits(42, 16)), "tkn", "st", &p);
+  BValue cond = pb.Not(pb.Not(pb.Literal(UBits(0, 1))));
+  BValue rcv = pb.ReceiveIf(in_ch, cond);
+  BValue out = pb.Negate(pb.Not(pb.Negate(rcv)));
+  BValue send = pb.Send(out_ch, out);
+  XLS_ASSERT_OK_AND_ASSIGN(Proc * proc, pb.Build(pb.GetStateParam()));
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PipelineSchedule schedule,
+      PipelineSchedule::Run(
+          proc, TestDelayEstimator(),
+          SchedulingOptions().clock_period_ps(1).initiation_interval(1)));
+
+  EXPECT_EQ(schedule.length(), 5);
+  EXPECT_GT(schedule.cycle(rcv.node()), 0);
+  EXPECT_LE(schedule.cycle(cond.node()), schedule.cycle(rcv.node()));
+  EXPECT_EQ(schedule.cycle(send.node()), 4);
+}
+
+TEST_F(PipelineScheduleTest, ProcWithSendsInEarlyStages) {
+  // One send depends only on the received value and one on a long chain of
+  // operations. Only the latter is placed in the final cycle when sends are
+  // not pinned there.
+  Package p("p");
+  Type* u16 = p.GetBitsType(16);
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * in_ch,
+      p.CreateStreamingChannel("in", ChannelOps::kReceiveOnly, u16));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * early_ch,
+      p.CreateStreamingChannel("early", ChannelOps::kSendOnly, u16));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * late_ch,
+      p.CreateStreamingChannel("late", ChannelOps::kSendOnly, u16));
+  TokenlessProcBuilder pb("the_proc", Value::Tuple({}), "tkn", "st", &p);
+  BValue rcv = pb.Receive(in_ch);
+  BValue early_send = pb.Send(early_ch, rcv);
+  BValue late_send = pb.Send(late_ch, pb.Negate(pb.Not(pb.Negate(rcv))));
+  XLS_ASSERT_OK_AND_ASSIGN(Proc * proc, pb.Build(pb.GetStateParam()));
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PipelineSchedule pinned_schedule,
+      PipelineSchedule::Run(proc, TestDelayEstimator(),
+                            SchedulingOptions().clock_period_ps(1)));
+  EXPECT_EQ(pinned_schedule.length(), 3);
+  EXPECT_EQ(pinned_schedule.cycle(early_send.node()), 2);
+  EXPECT_EQ(pinned_schedule.cycle(late_send.node()), 2);
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PipelineSchedule schedule,
+      PipelineSchedule::Run(
+          proc, TestDelayEstimator(),
+          SchedulingOptions().clock_period_ps(1).initiation_interval(1)));
+  EXPECT_EQ(schedule.length(), 3);
+  EXPECT_EQ(schedule.cycle(rcv.node()), 0);
+  EXPECT_EQ(schedule.cycle(early_send.node()), 0);
+  EXPECT_EQ(schedule.cycle(late_send.node()), 2);
+  EXPECT_LT(schedule.CountFinalInteriorPipelineRegisters(),
+            pinned_schedule.CountFinalInteriorPipelineRegisters());
+}
+
+TEST_F(PipelineScheduleTest, ProcNextStateWithinInitiationInterval) {
+  // The next state is three operations away from the state so can only be
+  // computed in the third cycle at a clock period of one.
+  Package p("p");
+  Type* u16 = p.GetBitsType(16);
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * out_ch,
+      p.CreateStreamingChannel("out", ChannelOps::kSendOnly, u16));
+  TokenlessProcBuilder pb("the_proc", Value(UBits(42, 16)), "tkn", "st", &p);
+  BValue st = pb.GetStateParam();
+  BValue next_state = pb.Negate(pb.Not(pb.Negate(st)));
+  BValue send = pb.Send(out_ch, pb.Not(pb.Not(next_state)));
+  XLS_ASSERT_OK_AND_ASSIGN(Proc * proc, pb.Build(next_state));
+
+  EXPECT_THAT(
+      PipelineSchedule::Run(
+          proc, TestDelayEstimator(),
+          SchedulingOptions().clock_period_ps(1).initiation_interval(2))
+          .status(),
+      StatusIs(absl::StatusCode::kResourceExhausted,
+               HasSubstr("initiation interval of 2")));
+  EXPECT_THAT(
+      PipelineSchedule::Run(
+          proc, TestDelayEstimator(),
+          SchedulingOptions().clock_period_ps(1).initiation_interval(0))
+          .status(),
+      StatusIs(absl::StatusCode::kInvalidArgument,
+               HasSubstr("must be positive")));
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PipelineSchedule schedule,
+      PipelineSchedule::Run(
+          proc, TestDelayEstimator(),
+          SchedulingOptions().clock_period_ps(1).initiation_interval(3)));
+  EXPECT_EQ(schedule.length(), 5);
+  EXPECT_EQ(schedule.cycle(next_state.node()), 2);
+  EXPECT_EQ(schedule.cycle(send.node()), 4);
+
+  // With a given pipeline length the clock period search accounts for the
+  // initiation interval: a single stage must fit the state update.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PipelineSchedule ii_one_schedule,
+      PipelineSchedule::Run(
+          proc, TestDelayEstimator(),
+          SchedulingOptions().pipeline_stages(2).initiation_interval(1)));
+  EXPECT_EQ(ii_one_schedule.cycle(next_state.node()), 0);
+}
+
 TEST_F(PipelineScheduleTest, ReceiveFollowedBySend) {
   Package package = Package(TestName());
 
@@ -0,0 +1,152 @@
+// Copyright 2022 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/scheduling/sdc_scheduler.h"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_format.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/data_structures/difference_constraints.h"
+#include "xls/ir/node_iterator.h"
+
+namespace xls {
+namespace {
+
+// Adds the timing constraints of the given node: for each node v reachable
+// from `node` by a path whose combinational delay (including both endpoints)
+// exceeds the clock period, v must be scheduled at least one cycle after
+// `node`. Only the first node on each path at which the delay is exceeded is
+// constrained; constraints on the nodes beyond it are implied.
+void AddTimingConstraints(
+    Node* node, int64_t clock_period_ps,
+    const absl::flat_hash_map<Node*, int64_t>& delays,
+    const absl::flat_hash_map<Node*, int64_t>& topo_index,
+    const absl::flat_hash_map<Node*, int64_t>& cycle_variables,
+    DifferenceConstraintSystem* system) {
+  // The delay of the longest path from the start of `node` to the end of each
+  // reached node, for nodes reachable within the clock period.
+  absl::flat_hash_map<Node*, int64_t> path_delay = {{node, delays.at(node)}};
+  absl::flat_hash_set<Node*> queued;
+  std::priority_queue<std::pair<int64_t, Node*>,
+                      std::vector<std::pair<int64_t, Node*>>,
+                      std::greater<std::pair<int64_t, Node*>>>
+      queue;
+  auto enqueue_users = [&](Node* n) {
+    for (Node* user : n->users()) {
+      if (queued.insert(user).second) {
+        queue.push({topo_index.at(user), user});
+      }
+    }
+  };
+  enqueue_users(node);
+  // Nodes are visited in topological order so the delays of all operands
+  // within reach are final when a node is visited.
+  while (!queue.empty()) {
+    Node* user = queue.top().second;
+    queue.pop();
+    int64_t delay = 0;
+    for (Node* operand : user->operands()) {
+      auto it = path_delay.find(operand);
+      if (it != path_delay.end()) {
+        delay = std::max(delay, it->second + delays.at(user));
+      }
+    }
+    if (delay > clock_period_ps) {
+      system->AddConstraint(cycle_variables.at(node),
+                            cycle_variables.at(user), 1);
+      continue;
+    }
+    path_delay[user] = delay;
+    enqueue_users(user);
+  }
+}
+
+}  // namespace
+
+absl::StatusOr<absl::flat_hash_map<Node*, int64_t>>
+ScheduleToMinimizeRegistersSdc(FunctionBase* f, int64_t clock_period_ps,
+                               const DelayEstimator& delay_estimator,
+                               const sched::ScheduleBounds& bounds) {
+  XLS_VLOG(3) << "ScheduleToMinimizeRegistersSdc()";
+  DifferenceConstraintSystem system;
+  // All cycles are expressed relative to an anchor variable at cycle zero.
+  const int64_t anchor = system.AddVariable();
+
+  absl::flat_hash_map<Node*, int64_t> cycle_variables;
+  absl::flat_hash_map<Node*, int64_t> delays;
+  absl::flat_hash_map<Node*, int64_t> topo_index;
+  std::vector<Node*> topo_sort = TopoSort(f).AsVector();
+  for (Node* node : topo_sort) {
+    XLS_ASSIGN_OR_RETURN(int64_t delay,
+                         delay_estimator.GetOperationDelayInPs(node));
+    if (delay > clock_period_ps) {
+      return absl::ResourceExhaustedError(absl::StrFormat(
+          "Node %s has a greater delay (%dps) than the clock period (%dps)",
+          node->GetName(), delay, clock_period_ps));
+    }
+    delays[node] = delay;
+    topo_index[node] = topo_index.size();
+    int64_t cycle = system.AddVariable();
+    cycle_variables[node] = cycle;
+    system.AddConstraint(anchor, cycle, bounds.lb(node));
+    system.AddConstraint(cycle, anchor, -bounds.ub(node));
+    for (Node* operand : node->operands()) {
+      system.AddConstraint(cycle_variables.at(operand), cycle, 0);
+    }
+  }
+
+  for (Node* node : topo_sort) {
+    AddTimingConstraints(node, clock_period_ps, delays, topo_index,
+                         cycle_variables, &system);
+
+    // Registers: the node's value is held from its own cycle through the
+    // cycle of its last use, modeled by a variable bounded below by the cycle
+    // of every user.
+    int64_t bit_count = node->GetType()->GetFlatBitCount();
+    if (bit_count == 0 || node->users().empty()) {
+      continue;
+    }
+    int64_t cycle = cycle_variables.at(node);
+    int64_t last_use = system.AddVariable(bit_count);
+    system.AddToObjective(cycle, -bit_count);
+    system.AddConstraint(cycle, last_use, 0);
+    for (Node* user : node->users()) {
+      system.AddConstraint(cycle_variables.at(user), last_use, 0);
+    }
+  }
+  XLS_VLOG(3) << absl::StreamFormat("SDC: %d variables, %d constraints",
+                                    system.variable_count(),
+                                    system.constraint_count());
+
+  absl::StatusOr<std::vector<int64_t>> solution = system.Minimize(anchor);
+  if (!solution.ok()) {
+    return absl::ResourceExhaustedError(absl::StrFormat(
+        "Unable to schedule %s: %s", f->name(), solution.status().message()));
+  }
+  absl::flat_hash_map<Node*, int64_t> cycle_map;
+  for (Node* node : topo_sort) {
+    cycle_map[node] = solution->at(cycle_variables.at(node));
+  }
+  return cycle_map;
+}
+
+}  // namespace xls
@@ -0,0 +1,50 @@
+// Copyright 2022 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_SCHEDULING_SDC_SCHEDULER_H_
+#define XLS_SCHEDULING_SDC_SCHEDULER_H_
+
+#include <cstdint>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "xls/delay_model/delay_estimator.h"
+#include "xls/ir/function_base.h"
+#include "xls/ir/node.h"
+#include "xls/scheduling/schedule_bounds.h"
+
+namespace xls {
+
+// Schedules the nodes of `f` into cycles such that the total number of
+// pipeline register bits is minimized, where a node occupies registers for
+// each cycle boundary between its own cycle and the cycle of its last user
+// (weighted by its bit count). Unlike the min-cut heuristic, which cuts one
+// cycle boundary at a time, all cycles are solved for jointly and exactly.
+//
+// The problem is formulated as a system of difference constraints (SDC):
+//   - each node is scheduled no earlier than its operands,
+//   - each node is scheduled within its bounds in `bounds` (which encode the
+//     pipeline length and the constraints on the first and last stages),
+//   - for any two nodes u and v connected by a combinational path of delay
+//     greater than `clock_period_ps`, v is scheduled after u,
+// and the register objective is linearized with one auxiliary variable per
+// node holding the cycle of its last use.
+absl::StatusOr<absl::flat_hash_map<Node*, int64_t>>
+ScheduleToMinimizeRegistersSdc(FunctionBase* f, int64_t clock_period_ps,
+                               const DelayEstimator& delay_estimator,
+                               const sched::ScheduleBounds& bounds);
+
+}  // namespace xls
+
+#endif  // XLS_SCHEDULING_SDC_SCHEDULER_H_
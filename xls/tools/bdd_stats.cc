@@ -41,6 +41,9 @@ To gather BDD stats of a set of benchmarks:
 ABSL_FLAG(int64_t, bdd_path_limit, 0,
           "Maximum number of paths before truncating the BDD subgraph "
           "and declaring a new variable. If zero, then no limit.");
+ABSL_FLAG(bool, bdd_sifting, false,
+          "Whether to reorder the BDD variables by sifting during "
+          "construction.");
 ABSL_FLAG(std::vector<std::string>, benchmarks, {},
           "Comma-separated list of benchmarks gather BDD stats about.");
 
@@ -103,7 +106,9 @@ absl::Status RealMain(absl::string_view input_path) {
     absl::Time start = absl::Now();
     XLS_ASSIGN_OR_RETURN(
         std::unique_ptr<BddFunction> bdd_function,
-        BddFunction::Run(top.value(), absl::GetFlag(FLAGS_bdd_path_limit)));
+        BddFunction::Run(top.value(), absl::GetFlag(FLAGS_bdd_path_limit),
+                         /*node_filter=*/absl::nullopt,
+                         absl::GetFlag(FLAGS_bdd_sifting)));
     absl::Duration bdd_time = absl::Now() - start;
     total_time += bdd_time;
     std::cout << "BDD construction time: " << bdd_time << "\n";
@@ -118,9 +123,14 @@ absl::Status RealMain(absl::string_view input_path) {
     std::cout << "Bits in graph: " << number_bits << "\n";
 
     int64_t max_paths = 0;
-    for (int64_t i = 0; i < bdd_function->bdd().size(); ++i) {
-      max_paths =
-          std::max(max_paths, bdd_function->bdd().path_count(BddNodeIndex(i)));
+    for (Node* node : top.value()->nodes()) {
+      if (!node->GetType()->IsBits()) {
+        continue;
+      }
+      for (int64_t i = 0; i < node->BitCountOrDie(); ++i) {
+        max_paths = std::max(max_paths, bdd_function->bdd().path_count(
+                                            bdd_function->GetBddNode(node, i)));
+      }
     }
     if (max_paths == std::numeric_limits<int32_t>::max()) {
       std::cout << "Maximum paths of any expression: INT32_MAX\n";
@@ -27,6 +27,7 @@
 #include "xls/common/math_util.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/delay_model/analyze_critical_path.h"
+#include "xls/delay_model/caching_delay_estimator.h"
 #include "xls/delay_model/delay_estimator.h"
 #include "xls/delay_model/delay_estimators.h"
 #include "xls/ir/ir_parser.h"
@@ -80,7 +81,14 @@ ABSL_FLAG(int64_t, convert_array_index_to_select, -1,
           "equal to the given number of possible indices (by range analysis) "
           "into chains of selects. Otherwise, this optimization is skipped, "
           "since it can sometimes reduce output quality.");
+ABSL_FLAG(bool, compare_scheduling_strategies, false,
+          "If true, also schedule with each register-minimizing strategy "
+          "(min-cut and SDC) and print the resulting register counts and "
+          "scheduling times.");
 // LINT.ThenChange(//xls/build_rules/xls_ir_rules.bzl)
+ABSL_FLAG(int64_t, clock_period_curve_max_stages, 0,
+          "If positive, print the minimum clock period for each pipeline "
+          "length up to this many stages at which the clock period improves.");
 
 namespace xls {
 namespace {
@@ -257,6 +265,23 @@ absl::StatusOr<std::vector<int64_t>> GetDelayPerStageInPs(
   return delay_per_stage;
 }
 
+absl::Status PrintClockPeriodCurve(FunctionBase* f, int64_t max_stages,
+                                   const DelayEstimator& delay_estimator) {
+  absl::Time start = absl::Now();
+  XLS_ASSIGN_OR_RETURN(std::vector<ClockPeriodAndStages> curve,
+                       ComputeClockPeriodCurve(f, max_stages, delay_estimator));
+  absl::Duration total_time = absl::Now() - start;
+  std::cout << "Clock period vs. pipeline stages:\n";
+  for (const ClockPeriodAndStages& point : curve) {
+    std::cout << absl::StreamFormat("  %3d stages: %dps\n",
+                                    point.pipeline_stages,
+                                    point.clock_period_ps);
+  }
+  std::cout << absl::StreamFormat("Clock period curve time: %dms\n",
+                                  total_time / absl::Milliseconds(1));
+  return absl::OkStatus();
+}
+
 absl::StatusOr<PipelineSchedule> ScheduleAndPrintStats(
     Package* package, const DelayEstimator& delay_estimator,
     absl::optional<int64_t> clock_period_ps,
@@ -289,6 +314,33 @@ absl::StatusOr<PipelineSchedule> ScheduleAndPrintStats(
   return std::move(schedule);
 }
 
+absl::Status CompareSchedulingStrategies(
+    FunctionBase* f, const DelayEstimator& delay_estimator,
+    absl::optional<int64_t> clock_period_ps,
+    absl::optional<int64_t> pipeline_stages) {
+  std::cout << "Scheduling strategies:\n";
+  for (auto [name, strategy] :
+       {std::make_pair("min-cut", SchedulingStrategy::MINIMIZE_REGISTERS),
+        std::make_pair("sdc", SchedulingStrategy::MINIMIZE_REGISTERS_SDC)}) {
+    SchedulingOptions options(strategy);
+    if (clock_period_ps.has_value()) {
+      options.clock_period_ps(*clock_period_ps);
+    }
+    if (pipeline_stages.has_value()) {
+      options.pipeline_stages(*pipeline_stages);
+    }
+    absl::Time start = absl::Now();
+    XLS_ASSIGN_OR_RETURN(PipelineSchedule schedule,
+                         PipelineSchedule::Run(f, delay_estimator, options));
+    absl::Duration total_time = absl::Now() - start;
+    std::cout << absl::StreamFormat(
+        "  %-8s stages: %3d, interior register bits: %6d, time: %dms\n", name,
+        schedule.length(), schedule.CountFinalInteriorPipelineRegisters(),
+        total_time / absl::Milliseconds(1));
+  }
+  return absl::OkStatus();
+}
+
 absl::Status PrintCodegenInfo(FunctionBase* f, const PipelineSchedule& schedule,
                               const BddQueryEngine& bdd_query_engine,
                               const DelayEstimator& delay_estimator,
@@ -418,10 +470,16 @@ absl::Status RealMain(absl::string_view path,
     XLS_ASSIGN_OR_RETURN(pdelay_estimator,
                          GetDelayEstimator(absl::GetFlag(FLAGS_delay_model)));
   }
-  const auto& delay_estimator = *pdelay_estimator;
+  // Share the estimated delays between all of the analyses below.
+  CachingDelayEstimator delay_estimator(*pdelay_estimator);
   XLS_RETURN_IF_ERROR(PrintCriticalPath(f, query_engine, delay_estimator,
                                         effective_clock_period_ps));
   XLS_RETURN_IF_ERROR(PrintTotalDelay(f, delay_estimator));
+  if (absl::GetFlag(FLAGS_clock_period_curve_max_stages) > 0) {
+    XLS_RETURN_IF_ERROR(PrintClockPeriodCurve(
+        f, absl::GetFlag(FLAGS_clock_period_curve_max_stages),
+        delay_estimator));
+  }
 
   if (clock_period_ps.has_value() || pipeline_stages.has_value()) {
     XLS_ASSIGN_OR_RETURN(
@@ -430,6 +488,10 @@ absl::Status RealMain(absl::string_view path,
                               pipeline_stages, clock_margin_percent));
     XLS_RETURN_IF_ERROR(PrintCodegenInfo(f, schedule, query_engine,
                                          delay_estimator, clock_period_ps));
+    if (absl::GetFlag(FLAGS_compare_scheduling_strategies)) {
+      XLS_RETURN_IF_ERROR(CompareSchedulingStrategies(
+          f, delay_estimator, clock_period_ps, pipeline_stages));
+    }
   }
   return absl::OkStatus();
 }
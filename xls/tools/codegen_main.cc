@@ -12,13 +12,26 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <ostream>
+#include <string>
+#include <system_error>
+
+#include "absl/algorithm/container.h"
+#include "absl/cleanup/cleanup.h"
 #include "absl/flags/flag.h"
 #include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 #include "xls/codegen/combinational_generator.h"
 #include "xls/codegen/module_signature.pb.h"
+#include "xls/codegen/package_generator.h"
 #include "xls/codegen/pipeline_generator.h"
+#include "xls/codegen/verilog_line_map.pb.h"
 #include "xls/common/file/filesystem.h"
 #include "xls/common/init_xls.h"
 #include "xls/common/logging/logging.h"
@@ -30,6 +43,7 @@
 #include "xls/ir/verifier.h"
 #include "xls/passes/standard_pipeline.h"
 #include "xls/scheduling/pipeline_schedule.h"
+#include "xls/scheduling/pipeline_schedule.pb.h"
 
 const char kUsage[] = R"(
 Generates Verilog RTL from a given IR file. Writes a Verilog file and a module
@@ -44,6 +58,14 @@ Emit a feed-forward pipelined module:
        --clock_period_ps=500 \
        --pipeline_stages=7 \
        IR_FILE
+
+Emit a pipelined module for every function and proc of the package:
+   codegen_main --generator=pipeline \
+       --pipeline_stages=3 \
+       --generate_all \
+       --codegen_threads=8 \
+       --output_verilog_dir=DIR \
+       IR_FILE
 )";
 
 // LINT.IfChange
@@ -102,6 +124,16 @@ ABSL_FLAG(std::string, flop_outputs_kind, "flop",
 ABSL_FLAG(bool, flop_single_value_channels, true,
           "If false, flop_inputs() and flop_outputs() will not flop"
           "single value channels");
+ABSL_FLAG(bool, elastic_pipeline, false,
+          "If true, a skid buffer is added to each pipeline register of a "
+          "pipelined proc so that backpressure is registered at every stage "
+          "instead of propagating combinationally through the pipeline. "
+          "Doubles the number of pipeline registers. Only used with pipeline "
+          "generator.");
+ABSL_FLAG(bool, retime_registers, false,
+          "If true, registers are retimed across logic without delay (bit "
+          "slices, extensions, concats with constants) and registers holding "
+          "the same value are merged to reduce the number of flops.");
 ABSL_FLAG(bool, add_idle_output, false,
           "If true, an additional idle signal tied to valids of input and "
           "flops is added to the block. This output signal is not registered, "
@@ -121,8 +153,44 @@ ABSL_FLAG(int64_t, period_relaxation_percent, 0,
           "constraints will be used.  Increasing this will trade-off an "
           "increase in critical path delay in favor of decreased register "
           "count.");
+ABSL_FLAG(int64_t, initiation_interval, 0,
+          "Number of cycles between the starts of successive activations of a "
+          "pipelined proc. If set, channel operations may be scheduled in any "
+          "stage and the next state of the proc is computed within the first "
+          "initiation_interval stages. When 0 (the default), all receives "
+          "are scheduled in the first stage and all sends in the last.");
 ABSL_FLAG(int64_t, additional_input_delay_ps, 0,
           "The additional delay added to each receive node.");
+ABSL_FLAG(std::string, scheduling_strategy, "minimize_registers",
+          "Strategy used to minimize pipeline registers when scheduling. "
+          "Valid values: minimize_registers (min-cut heuristic), sdc (exact "
+          "solution of a system of difference constraints).");
+ABSL_FLAG(int64_t, scheduling_threads, 1,
+          "Number of threads on which to evaluate the orderings of pipeline "
+          "stage boundaries when minimizing registers. The schedule does not "
+          "depend on the number of threads.");
+ABSL_FLAG(int64_t, random_min_cut_orders, 0,
+          "Number of random orderings of pipeline stage boundaries to try in "
+          "addition to the default orderings when minimizing registers.");
+ABSL_FLAG(absl::Duration, random_min_cut_order_time_limit,
+          absl::InfiniteDuration(),
+          "Wall-clock time limit for trying the orderings requested with "
+          "--random_min_cut_orders. Orderings not started within the limit "
+          "are skipped.");
+ABSL_FLAG(bool, generate_all, false,
+          "If true, generate a module for every function and proc in the "
+          "package rather than only the top entity. The modules are written "
+          "to the Verilog output (or to --output_verilog_dir) and the "
+          "signature and schedule outputs hold package-level protos "
+          "(PackageSignatureProto and PackageScheduleProto).");
+ABSL_FLAG(int64_t, codegen_threads, 1,
+          "Number of threads on which to schedule and generate the modules "
+          "with --generate_all. The output does not depend on the number of "
+          "threads.");
+ABSL_FLAG(std::string, output_verilog_dir, "",
+          "With --generate_all, the directory to which to write each module "
+          "as a file of its own named after the module. If not specified all "
+          "modules are written to the Verilog output.");
 // TODO(meheff): Rather than specify all reset (or codegen options in general)
 // as a multitude of flags, these can be specified via a separate file (like a
 // options proto).
@@ -172,7 +240,17 @@ absl::StatusOr<SchedulingOptions> SetupSchedulingOptions() {
     return absl::InternalError("Scheduling only supported in pipeline mode.");
   }
 
-  SchedulingOptions scheduling_options;
+  SchedulingStrategy strategy;
+  if (absl::GetFlag(FLAGS_scheduling_strategy) == "minimize_registers") {
+    strategy = SchedulingStrategy::MINIMIZE_REGISTERS;
+  } else if (absl::GetFlag(FLAGS_scheduling_strategy) == "sdc") {
+    strategy = SchedulingStrategy::MINIMIZE_REGISTERS_SDC;
+  } else {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Invalid --scheduling_strategy: %s",
+                        absl::GetFlag(FLAGS_scheduling_strategy)));
+  }
+  SchedulingOptions scheduling_options(strategy);
 
   if (absl::GetFlag(FLAGS_pipeline_stages) != 0) {
     scheduling_options.pipeline_stages(absl::GetFlag(FLAGS_pipeline_stages));
@@ -188,10 +266,19 @@ absl::StatusOr<SchedulingOptions> SetupSchedulingOptions() {
     scheduling_options.period_relaxation_percent(
         absl::GetFlag(FLAGS_period_relaxation_percent));
   }
+  if (absl::GetFlag(FLAGS_initiation_interval) != 0) {
+    scheduling_options.initiation_interval(
+        absl::GetFlag(FLAGS_initiation_interval));
+  }
   if (absl::GetFlag(FLAGS_additional_input_delay_ps) != 0) {
     scheduling_options.additional_input_delay_ps(
         absl::GetFlag(FLAGS_additional_input_delay_ps));
   }
+  scheduling_options.thread_count(absl::GetFlag(FLAGS_scheduling_threads));
+  scheduling_options.random_min_cut_orders(
+      absl::GetFlag(FLAGS_random_min_cut_orders));
+  scheduling_options.random_min_cut_order_time_limit(
+      absl::GetFlag(FLAGS_random_min_cut_order_time_limit));
 
   return scheduling_options;
 }
@@ -249,6 +336,8 @@ absl::StatusOr<verilog::CodegenOptions> GetCodegenOptions() {
 
     options.flop_single_value_channels(
         absl::GetFlag(FLAGS_flop_single_value_channels));
+    options.elastic_pipeline(absl::GetFlag(FLAGS_elastic_pipeline));
+    options.retime_registers(absl::GetFlag(FLAGS_retime_registers));
     options.add_idle_output(absl::GetFlag(FLAGS_add_idle_output));
 
     if (!absl::GetFlag(FLAGS_reset).empty()) {
@@ -310,6 +399,91 @@ absl::StatusOr<PipelineSchedule> RunSchedulingPipeline(
   return schedule_status;
 }
 
+// Generates a module for every function and proc of the package and writes
+// the modules and the package-level signature, schedule and line map protos.
+absl::Status GenerateAllModules(Package* p,
+                                const verilog::CodegenOptions& codegen_options,
+                                std::ostream& verilog_stream,
+                                absl::string_view verilog_path,
+                                absl::string_view signature_path,
+                                absl::string_view schedule_path,
+                                absl::string_view verilog_line_map_path) {
+  verilog::PackageGeneratorOptions options;
+  options.codegen_options = codegen_options;
+  options.thread_count = absl::GetFlag(FLAGS_codegen_threads);
+  if (absl::GetFlag(FLAGS_generator) == "pipeline") {
+    XLS_QCHECK(absl::GetFlag(FLAGS_pipeline_stages) != 0 ||
+               absl::GetFlag(FLAGS_clock_period_ps) != 0)
+        << "Musts specify --pipeline_stages or --clock_period_ps (or both).";
+    XLS_ASSIGN_OR_RETURN(options.scheduling_options, SetupSchedulingOptions());
+    XLS_ASSIGN_OR_RETURN(options.delay_estimator, SetupDelayEstimator());
+  } else if (absl::GetFlag(FLAGS_generator) != "combinational") {
+    XLS_LOG(QFATAL) << absl::StreamFormat(
+        "Invalid value for --generator: %s. Expected 'pipeline' or "
+        "'combinational'",
+        absl::GetFlag(FLAGS_generator));
+  }
+  XLS_ASSIGN_OR_RETURN(verilog::PackageGeneratorResult result,
+                       verilog::GeneratePackageModules(p, options));
+
+  // Either write each module to a file of its own, or concatenate the modules
+  // separated by a blank line. In the latter case the line numbers of the line
+  // map are offset by the position of the module in the output.
+  std::string verilog_dir = absl::GetFlag(FLAGS_output_verilog_dir);
+  verilog::VerilogLineMap line_map;
+  int64_t line_offset = 0;
+  for (const verilog::PackageModule& module : result.modules) {
+    std::filesystem::path module_path;
+    if (verilog_dir.empty()) {
+      if (&module != &result.modules.front()) {
+        verilog_stream << "\n";
+        ++line_offset;
+      }
+      verilog_stream << module.result.verilog_text;
+      if (!verilog_path.empty()) {
+        module_path = std::filesystem::absolute(verilog_path);
+      }
+    } else {
+      module_path = std::filesystem::absolute(
+          std::filesystem::path(verilog_dir) /
+          absl::StrCat(module.block->name(),
+                       codegen_options.use_system_verilog() ? ".sv" : ".v"));
+      XLS_RETURN_IF_ERROR(
+          SetFileContents(module_path, module.result.verilog_text));
+    }
+    for (const verilog::VerilogLineMapping& mapping :
+         module.result.verilog_line_map.mapping()) {
+      verilog::VerilogLineMapping* new_mapping = line_map.add_mapping();
+      *new_mapping = mapping;
+      new_mapping->set_verilog_file(module_path);
+      new_mapping->mutable_verilog_span()->set_line_start(
+          mapping.verilog_span().line_start() + line_offset);
+      new_mapping->mutable_verilog_span()->set_line_end(
+          mapping.verilog_span().line_end() + line_offset);
+    }
+    if (verilog_dir.empty()) {
+      line_offset += absl::c_count(module.result.verilog_text, '\n');
+    }
+  }
+
+  if (!signature_path.empty()) {
+    XLS_RETURN_IF_ERROR(SetTextProtoFile(signature_path, result.signature));
+  }
+  if (!schedule_path.empty()) {
+    PackageScheduleProto schedules;
+    for (const verilog::PackageModule& module : result.modules) {
+      if (module.schedule.has_value()) {
+        *schedules.add_schedules() = module.schedule->ToProto();
+      }
+    }
+    XLS_RETURN_IF_ERROR(SetTextProtoFile(schedule_path, schedules));
+  }
+  if (!verilog_line_map_path.empty()) {
+    XLS_RETURN_IF_ERROR(SetTextProtoFile(verilog_line_map_path, line_map));
+  }
+  return absl::OkStatus();
+}
+
 absl::Status RealMain(absl::string_view ir_path, absl::string_view verilog_path,
                       absl::string_view signature_path,
                       absl::string_view schedule_path,
@@ -326,10 +500,70 @@ absl::Status RealMain(absl::string_view ir_path, absl::string_view verilog_path,
 
   XLS_RETURN_IF_ERROR(VerifyPackage(p.get(), /*codegen=*/true));
 
-  XLS_ASSIGN_OR_RETURN(FunctionBase * main, FindEntry(p.get()));
   XLS_ASSIGN_OR_RETURN(verilog::CodegenOptions codegen_options,
                        GetCodegenOptions());
 
+  // The Verilog text is streamed directly to its destination as it is emitted
+  // rather than being built up in memory. A regular output file is written
+  // under a temporary name and only moved into place once generation has
+  // succeeded, so a failed run leaves no empty or partial Verilog file behind.
+  // With --generate_all and --output_verilog_dir the modules are written to
+  // files of their own and `verilog_path` is not written at all.
+  bool write_verilog_file = !verilog_path.empty();
+  if (absl::GetFlag(FLAGS_generate_all) &&
+      !absl::GetFlag(FLAGS_output_verilog_dir).empty()) {
+    write_verilog_file = false;
+  }
+  std::string verilog_file_path(verilog_path);
+  if (write_verilog_file && (!std::filesystem::exists(verilog_path) ||
+                             std::filesystem::is_regular_file(verilog_path))) {
+    verilog_file_path = absl::StrCat(verilog_path, ".tmp");
+  }
+  std::ofstream verilog_file;
+  if (write_verilog_file) {
+    verilog_file.open(verilog_file_path);
+    if (!verilog_file) {
+      return absl::InternalError(absl::StrFormat(
+          "Unable to open Verilog output file `%s`", verilog_file_path));
+    }
+  }
+  auto remove_temporary_file = absl::MakeCleanup([&] {
+    if (verilog_file_path != verilog_path) {
+      std::error_code ec;
+      std::filesystem::remove(verilog_file_path, ec);
+    }
+  });
+  std::ostream& verilog_stream =
+      write_verilog_file ? verilog_file : std::cout;
+  auto finish_verilog_output = [&]() -> absl::Status {
+    verilog_stream.flush();
+    if (!verilog_stream) {
+      return absl::InternalError("Failed to write Verilog output");
+    }
+    if (write_verilog_file && verilog_file_path != verilog_path) {
+      verilog_file.close();
+      std::error_code ec;
+      std::filesystem::rename(verilog_file_path, verilog_path, ec);
+      if (ec) {
+        return absl::InternalError(
+            absl::StrFormat("Unable to move `%s` to `%s`: %s",
+                            verilog_file_path, verilog_path, ec.message()));
+      }
+    }
+    return absl::OkStatus();
+  };
+
+  if (absl::GetFlag(FLAGS_generate_all)) {
+    XLS_RETURN_IF_ERROR(GenerateAllModules(
+        p.get(), codegen_options, verilog_stream, verilog_path, signature_path,
+        schedule_path, verilog_line_map_path));
+    if (!output_block_ir_path.empty()) {
+      XLS_RETURN_IF_ERROR(SetFileContents(output_block_ir_path, p->DumpIr()));
+    }
+    return finish_verilog_output();
+  }
+
+  XLS_ASSIGN_OR_RETURN(FunctionBase * main, FindEntry(p.get()));
   if (absl::GetFlag(FLAGS_generator) == "pipeline") {
     XLS_QCHECK(absl::GetFlag(FLAGS_pipeline_stages) != 0 ||
                absl::GetFlag(FLAGS_clock_period_ps) != 0)
@@ -344,14 +578,16 @@ absl::Status RealMain(absl::string_view ir_path, absl::string_view verilog_path,
         RunSchedulingPipeline(main, scheduling_options, delay_estimator));
 
     XLS_ASSIGN_OR_RETURN(
-        result, verilog::ToPipelineModuleText(schedule, main, codegen_options));
+        result, verilog::ToPipelineModuleText(schedule, main, codegen_options,
+                                              verilog_stream, delay_estimator));
 
     if (!schedule_path.empty()) {
       XLS_RETURN_IF_ERROR(SetTextProtoFile(schedule_path, schedule.ToProto()));
     }
   } else if (absl::GetFlag(FLAGS_generator) == "combinational") {
     XLS_ASSIGN_OR_RETURN(
-        result, verilog::GenerateCombinationalModule(main, codegen_options));
+        result, verilog::GenerateCombinationalModule(main, codegen_options,
+                                                     verilog_stream));
   } else {
     XLS_LOG(QFATAL) << absl::StreamFormat(
         "Invalid value for --generator: %s. Expected 'pipeline' or "
@@ -383,12 +619,7 @@ absl::Status RealMain(absl::string_view ir_path, absl::string_view verilog_path,
         SetTextProtoFile(verilog_line_map_path, result.verilog_line_map));
   }
 
-  if (verilog_path.empty()) {
-    std::cout << result.verilog_text;
-  } else {
-    XLS_RETURN_IF_ERROR(SetFileContents(verilog_path, result.verilog_text));
-  }
-  return absl::OkStatus();
+  return finish_verilog_output();
 }
 
 }  // namespace
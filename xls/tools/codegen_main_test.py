@@ -16,6 +16,7 @@
 
 """Tests for xls.tools.codegen_main."""
 
+import os
 import subprocess
 
 from google.protobuf import text_format
@@ -86,6 +87,23 @@ class CodeGenMainTest(parameterized.TestCase):
     ]).decode('utf-8')
     self.assertIn('module not_add(', verilog)
 
+  def test_failure_leaves_verilog_output_untouched(self):
+    ir_file = self.create_tempfile(content=NOT_ADD_IR)
+    verilog_file = self.create_tempfile(content='previous contents')
+
+    # The schedule is infeasible, so codegen fails after the Verilog output
+    # path has been resolved.
+    result = subprocess.run([
+        CODEGEN_MAIN_PATH, '--generator=pipeline', '--delay_model=unit',
+        '--pipeline_stages=1', '--clock_period_ps=1', '--top=not_add',
+        '--output_verilog_path=' + verilog_file.full_path, ir_file.full_path
+    ],
+                            stderr=subprocess.PIPE,
+                            check=False)
+    self.assertNotEqual(result.returncode, 0)
+    self.assertEqual(verilog_file.read_text(), 'previous contents')
+    self.assertFalse(os.path.exists(verilog_file.full_path + '.tmp'))
+
   @parameterized.parameters(range(1, 6))
   def test_fixed_pipeline_length(self, pipeline_stages):
     signature_path = test_base.create_named_output_text_file(
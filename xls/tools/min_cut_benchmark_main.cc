@@ -0,0 +1,247 @@
+// Copyright 2022 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// Benchmarks the max-flow algorithms behind min_cut::MinCutBetweenNodes on
+// synthetic graphs shaped like scheduling min-cut graphs and on graphs
+// constructed from IR files the same way the scheduler partitions functions.
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/status/status.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_split.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/init_xls.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/data_structures/min_cut.h"
+#include "xls/ir/ir_parser.h"
+#include "xls/ir/node_iterator.h"
+#include "xls/scheduling/function_partition.h"
+
+const char kUsage[] = R"(
+Benchmarks the max-flow algorithms used to compute min cuts for scheduling.
+
+Expected invocation:
+  min_cut_benchmark_main [<IR file>...]
+where:
+  - <IR file> is the path to an input IR file. The nodes in the middle half of
+    a topological sort of each function are partitioned as the scheduler would
+    when splitting a pipeline stage.
+
+Example invocation:
+  min_cut_benchmark_main --synthetic_node_counts=1000,100000 path/to/file.ir
+)";
+
+ABSL_FLAG(std::string, synthetic_node_counts, "1000,10000,100000",
+          "Comma-separated node counts of the synthetic graphs to benchmark.");
+ABSL_FLAG(int64_t, repetitions, 3,
+          "Number of times to compute each min cut. The minimum time is "
+          "reported.");
+ABSL_FLAG(int64_t, max_augmenting_path_nodes, 20000,
+          "Graphs with more nodes than this are not benchmarked with the "
+          "augmenting path algorithm, which is quadratic or worse on them.");
+
+namespace xls {
+namespace {
+
+using min_cut::MaxFlowAlgorithm;
+
+constexpr int64_t kMaxWeight = std::numeric_limits<int64_t>::max();
+
+// Returns a graph resembling the min-cut graphs built when scheduling: a
+// chain-like DAG in which each node feeds a few nearby nodes, with each edge
+// weighted by a bit count and paired with an opposing edge of maximum weight
+// which forces the cut to be a dicut. The first and last nodes are attached to
+// the source and sink with edges of maximum weight.
+min_cut::Graph MakeSyntheticGraph(int64_t node_count, min_cut::NodeId* source,
+                                  min_cut::NodeId* sink) {
+  constexpr int64_t kTerminalFanOut = 32;
+  constexpr int64_t kFanOut = 3;
+  constexpr int64_t kMaxDistance = 32;
+  std::mt19937_64 gen(node_count);
+  std::uniform_int_distribution<int64_t> distance_dis(1, kMaxDistance);
+  std::uniform_int_distribution<int64_t> weight_dis(1, 64);
+
+  min_cut::Graph graph;
+  *source = graph.AddNode("source");
+  *sink = graph.AddNode("sink");
+  std::vector<min_cut::NodeId> nodes;
+  for (int64_t i = 0; i < node_count; ++i) {
+    nodes.push_back(graph.AddNode());
+  }
+  for (int64_t i = 0; i < node_count; ++i) {
+    if (i < kTerminalFanOut) {
+      graph.AddEdge(*source, nodes[i], kMaxWeight);
+    }
+    if (i >= node_count - kTerminalFanOut) {
+      graph.AddEdge(nodes[i], *sink, kMaxWeight);
+    }
+    for (int64_t j = 0; j < kFanOut; ++j) {
+      int64_t user = i + distance_dis(gen);
+      if (user < node_count) {
+        graph.AddEdge(nodes[i], nodes[user], weight_dis(gen));
+        graph.AddEdge(nodes[user], nodes[i], kMaxWeight);
+      }
+    }
+  }
+  return graph;
+}
+
+// Returns the minimum time taken by `f` over the configured number of
+// repetitions.
+absl::Duration MinimumTime(const std::function<void()>& f) {
+  absl::Duration best = absl::InfiniteDuration();
+  for (int64_t i = 0; i < absl::GetFlag(FLAGS_repetitions); ++i) {
+    absl::Time start = absl::Now();
+    f();
+    best = std::min(best, absl::Now() - start);
+  }
+  return best;
+}
+
+std::string FormatTime(absl::optional<absl::Duration> duration) {
+  if (!duration.has_value()) {
+    return "-";
+  }
+  return absl::StrFormat("%.3fms", absl::ToDoubleMilliseconds(*duration));
+}
+
+void PrintRow(absl::string_view name, int64_t node_count, int64_t edge_count,
+              absl::optional<absl::Duration> augmenting_path,
+              absl::optional<absl::Duration> push_relabel) {
+  std::cout << absl::StreamFormat("%-32s %10d %10d %14s %14s\n", name,
+                                  node_count, edge_count,
+                                  FormatTime(augmenting_path),
+                                  FormatTime(push_relabel));
+}
+
+bool RunAugmentingPath(int64_t node_count) {
+  return node_count <= absl::GetFlag(FLAGS_max_augmenting_path_nodes);
+}
+
+absl::Status BenchmarkSyntheticGraph(int64_t node_count) {
+  min_cut::NodeId source;
+  min_cut::NodeId sink;
+  min_cut::Graph graph = MakeSyntheticGraph(node_count, &source, &sink);
+  min_cut::GraphCut push_relabel_cut;
+  absl::Duration push_relabel_time = MinimumTime([&] {
+    push_relabel_cut = min_cut::MinCutBetweenNodes(
+        graph, source, sink, MaxFlowAlgorithm::kPushRelabel);
+  });
+  absl::optional<absl::Duration> augmenting_path_time;
+  if (RunAugmentingPath(graph.node_count())) {
+    min_cut::GraphCut augmenting_path_cut;
+    augmenting_path_time = MinimumTime([&] {
+      augmenting_path_cut = min_cut::MinCutBetweenNodes(
+          graph, source, sink, MaxFlowAlgorithm::kAugmentingPath);
+    });
+    if (augmenting_path_cut.weight != push_relabel_cut.weight) {
+      return absl::InternalError(absl::StrFormat(
+          "Min cut weights differ for synthetic graph with %d nodes: %d vs %d",
+          node_count, augmenting_path_cut.weight, push_relabel_cut.weight));
+    }
+  }
+  PrintRow(absl::StrFormat("synthetic_%d", node_count), graph.node_count(),
+           graph.edge_count(), augmenting_path_time, push_relabel_time);
+  return absl::OkStatus();
+}
+
+absl::Status BenchmarkFunction(FunctionBase* f) {
+  std::vector<Node*> topo_sort = TopoSort(f).AsVector();
+  std::vector<Node*> partitionable_nodes(
+      topo_sort.begin() + topo_sort.size() / 4,
+      topo_sort.begin() + 3 * topo_sort.size() / 4);
+  if (partitionable_nodes.empty()) {
+    return absl::OkStatus();
+  }
+  std::pair<std::vector<Node*>, std::vector<Node*>> push_relabel_partitions;
+  absl::Duration push_relabel_time = MinimumTime([&] {
+    push_relabel_partitions = sched::MinCostFunctionPartition(
+        f, partitionable_nodes, MaxFlowAlgorithm::kPushRelabel);
+  });
+  absl::optional<absl::Duration> augmenting_path_time;
+  if (RunAugmentingPath(f->node_count())) {
+    std::pair<std::vector<Node*>, std::vector<Node*>>
+        augmenting_path_partitions;
+    augmenting_path_time = MinimumTime([&] {
+      augmenting_path_partitions = sched::MinCostFunctionPartition(
+          f, partitionable_nodes, MaxFlowAlgorithm::kAugmentingPath);
+    });
+    if (augmenting_path_partitions != push_relabel_partitions) {
+      return absl::InternalError(
+          absl::StrFormat("Partitions differ for function %s", f->name()));
+    }
+  }
+  // The min-cut graph has roughly one node and two edges per IR edge; report
+  // the size of the partitioned region of the IR graph instead.
+  int64_t edge_count = 0;
+  for (Node* node : partitionable_nodes) {
+    edge_count += node->operand_count();
+  }
+  PrintRow(f->name(), partitionable_nodes.size(), edge_count,
+           augmenting_path_time, push_relabel_time);
+  return absl::OkStatus();
+}
+
+absl::Status RealMain(absl::Span<const absl::string_view> ir_paths) {
+  std::cout << absl::StreamFormat("%-32s %10s %10s %14s %14s\n", "graph",
+                                  "nodes", "edges", "augmenting",
+                                  "push-relabel");
+  for (absl::string_view count_str :
+       absl::StrSplit(absl::GetFlag(FLAGS_synthetic_node_counts), ',',
+                      absl::SkipEmpty())) {
+    int64_t node_count;
+    if (!absl::SimpleAtoi(count_str, &node_count) || node_count <= 0) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Invalid synthetic node count: %s", count_str));
+    }
+    XLS_RETURN_IF_ERROR(BenchmarkSyntheticGraph(node_count));
+  }
+  for (absl::string_view path : ir_paths) {
+    XLS_ASSIGN_OR_RETURN(std::string contents, GetFileContents(path));
+    XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
+                         Parser::ParsePackage(contents));
+    for (FunctionBase* f : package->GetFunctionBases()) {
+      XLS_RETURN_IF_ERROR(BenchmarkFunction(f));
+    }
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+}  // namespace xls
+
+int main(int argc, char** argv) {
+  std::vector<absl::string_view> positional_arguments =
+      xls::InitXls(kUsage, argc, argv);
+  XLS_QCHECK_OK(xls::RealMain(positional_arguments));
+  return EXIT_SUCCESS;
+}
@@ -50,6 +50,7 @@ absl::StatusOr<std::string> OptimizeIrForEntry(absl::string_view ir,
       .skip_passes = options.skip_passes,
       .inline_procs = options.inline_procs,
       .convert_array_index_to_select = options.convert_array_index_to_select,
+      .thread_count = options.thread_count,
   };
   PassResults results;
   XLS_RETURN_IF_ERROR(
@@ -64,6 +64,9 @@ ABSL_FLAG(int64_t, opt_level, xls::kMaxOptLevel,
                           xls::kMaxOptLevel));
 ABSL_FLAG(bool, inline_procs, false,
           "Whether to inline all procs by calling the proc inlining pass. ");
+ABSL_FLAG(int64_t, threads, 1,
+          "Number of threads on which to run function-local passes. The "
+          "optimized IR does not depend on the number of threads.");
 // LINT.ThenChange(//xls/build_rules/xls_ir_rules.bzl)
 
 namespace xls::tools {
@@ -93,6 +96,7 @@ absl::Status RealMain(absl::string_view input_path) {
               ? std::nullopt
               : std::make_optional(convert_array_index_to_select),
       .inline_procs = absl::GetFlag(FLAGS_inline_procs),
+      .thread_count = absl::GetFlag(FLAGS_threads),
   };
   XLS_ASSIGN_OR_RETURN(std::string opt_ir,
                        tools::OptimizeIrForEntry(ir, options));